@@ -0,0 +1,102 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace mcpp {
+
+namespace detail {
+
+inline std::size_t count_trailing_zeros (std::uint64_t val) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+	return std::size_t(__builtin_ctzll(val));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long retr;
+	_BitScanForward64(&retr, val);
+	return std::size_t(retr);
+#else
+	std::size_t retr(0);
+	while ((val & 1) == 0) {
+		val >>= 1;
+		++retr;
+	}
+	return retr;
+#endif
+}
+
+inline std::size_t count_leading_zeros (std::uint64_t val) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+	return std::size_t(__builtin_clzll(val));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long retr;
+	_BitScanReverse64(&retr, val);
+	return std::size_t(63 - retr);
+#else
+	std::size_t retr(0);
+	while ((val & (std::uint64_t(1) << 63)) == 0) {
+		val <<= 1;
+		++retr;
+	}
+	return retr;
+#endif
+}
+
+}
+
+/**
+ *	Determines the number of consecutive zero bits
+ *	in an unsigned integer starting with the least
+ *	significant bit.
+ *
+ *	If \em val is zero the behavior is undefined.
+ *
+ *	\tparam T
+ *		An unsigned integer type no wider than 64
+ *		bits.
+ *
+ *	\param [in] val
+ *		The integer.
+ *
+ *	\return
+ *		The number of trailing zero bits.
+ */
+template <typename T>
+std::size_t count_trailing_zeros (T val) noexcept {
+	static_assert(std::is_unsigned<T>::value, "Bit counting is for unsigned types only");
+	static_assert(std::numeric_limits<T>::digits <= 64, "Bit counting is for types no wider than 64 bits");
+	return detail::count_trailing_zeros(std::uint64_t(val));
+}
+/**
+ *	Determines the number of consecutive zero bits
+ *	in an unsigned integer starting with the most
+ *	significant bit.
+ *
+ *	If \em val is zero the behavior is undefined.
+ *
+ *	\tparam T
+ *		An unsigned integer type no wider than 64
+ *		bits.
+ *
+ *	\param [in] val
+ *		The integer.
+ *
+ *	\return
+ *		The number of leading zero bits.
+ */
+template <typename T>
+std::size_t count_leading_zeros (T val) noexcept {
+	static_assert(std::is_unsigned<T>::value, "Bit counting is for unsigned types only");
+	static_assert(std::numeric_limits<T>::digits <= 64, "Bit counting is for types no wider than 64 bits");
+	return detail::count_leading_zeros(std::uint64_t(val)) - std::size_t(64 - std::numeric_limits<T>::digits);
+}
+
+}
@@ -318,6 +318,16 @@ public:
 	void reset () noexcept(is_nothrow_destructible) {
 		destroy();
 	}
+	/**
+	 *	Destroys the managed object if there is a managed
+	 *	object and deallocates the managed storage.
+	 *
+	 *	Unlike \ref reset the next object emplaced will
+	 *	always obtain new storage.
+	 */
+	void clear () noexcept(is_nothrow_destructible) {
+		if (storage_.raw) deallocate();
+	}
 };
 
 }
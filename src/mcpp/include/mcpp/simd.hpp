@@ -0,0 +1,16 @@
+/**
+ *	\file
+ *
+ *	Detects which SIMD instruction sets may be
+ *	used unconditionally given the compiler's target
+ *	and includes the corresponding intrinsic headers.
+ *
+ *	If SSE2 is available \em MCPP_SSE2 is defined.
+ */
+
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define MCPP_SSE2
+#include <emmintrin.h>
+#endif
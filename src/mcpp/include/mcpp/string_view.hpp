@@ -0,0 +1,35 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+//	Selected by the standard the including translation
+//	unit is compiled under rather than by probing, since
+//	a probe need not be compiled under the same standard
+//	as the targets
+#if (__cplusplus >= 201703L) || (defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L))
+#include <string>
+#include <string_view>
+namespace mcpp {
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using basic_string_view = std::basic_string_view<CharT, Traits>;
+}
+#else
+#include <boost/utility/string_ref.hpp>
+#include <string>
+namespace mcpp {
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using basic_string_view = boost::basic_string_ref<CharT, Traits>;
+}
+#endif
+
+namespace mcpp {
+
+/**
+ *	A \ref basic_string_view which uses default
+ *	template parameters.
+ */
+using string_view = basic_string_view<char>;
+
+}
@@ -0,0 +1,429 @@
+/**
+ *	\file
+ *
+ *	Validation of UTF-8 and transcoding between UTF-8
+ *	and UTF-16 or UTF-32.
+ *
+ *	Text is processed in blocks of 16 bytes. Blocks
+ *	consisting entirely of ASCII are detected (and
+ *	widened or narrowed) with SIMD instructions where
+ *	available, other blocks are transcoded a character
+ *	at a time. Validation alone handles multi-byte
+ *	characters with SIMD instructions as well, see
+ *	\ref count_utf8.
+ */
+
+#pragma once
+
+#include "optional.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace mcpp {
+
+namespace detail {
+
+constexpr std::size_t utf8_block = 16;
+
+template <typename CharT>
+constexpr std::size_t utf8_block_units = utf8_block / sizeof(CharT);
+
+template <typename CharT>
+void utf_char () noexcept {
+	static_assert(
+		std::is_same<CharT, char16_t>::value || std::is_same<CharT, char32_t>::value,
+		"Transcoding is to and from char16_t and char32_t only"
+	);
+}
+
+//	Decodes the character at the beginning of a
+//	sequence of UTF-8, returns the number of bytes
+//	it occupies or zero if it is malformed
+inline std::size_t utf8_decode (const unsigned char * curr, const unsigned char * end, char32_t & cp) noexcept {
+	unsigned char c = *curr;
+	if (c < 0x80) {
+		cp = c;
+		return 1;
+	}
+	//	The number of continuation bytes and the
+	//	range the first of them must fall within
+	std::size_t n;
+	unsigned char lo = 0x80;
+	unsigned char hi = 0xBF;
+	if ((c >= 0xC2) && (c <= 0xDF)) {
+		n = 1;
+	} else if (c == 0xE0) {
+		//	Overlong
+		n = 2;
+		lo = 0xA0;
+	} else if (c == 0xED) {
+		//	Surrogates
+		n = 2;
+		hi = 0x9F;
+	} else if ((c >= 0xE1) && (c <= 0xEF)) {
+		n = 2;
+	} else if (c == 0xF0) {
+		//	Overlong
+		n = 3;
+		lo = 0x90;
+	} else if ((c >= 0xF1) && (c <= 0xF3)) {
+		n = 3;
+	} else if (c == 0xF4) {
+		//	Beyond U+10FFFF
+		n = 3;
+		hi = 0x8F;
+	} else {
+		return 0;
+	}
+	if (std::size_t(end - curr) <= n) return 0;
+	if ((curr[1] < lo) || (curr[1] > hi)) return 0;
+	char32_t retr(c & (0x3F >> n));
+	retr = (retr << 6) | (curr[1] & 0x3F);
+	for (std::size_t i = 2; i <= n; ++i) {
+		if ((curr[i] & 0xC0) != 0x80) return 0;
+		retr = (retr << 6) | (curr[i] & 0x3F);
+	}
+	cp = retr;
+	return n + 1;
+}
+
+inline std::size_t utf8_encoded_size (char32_t cp) noexcept {
+	return 1 + std::size_t(cp >= 0x80) + std::size_t(cp >= 0x800) + std::size_t(cp >= 0x10000);
+}
+
+inline std::size_t utf8_encode (char32_t cp, unsigned char * out) noexcept {
+	if (cp < 0x80) {
+		out[0] = static_cast<unsigned char>(cp);
+		return 1;
+	}
+	if (cp < 0x800) {
+		out[0] = static_cast<unsigned char>(0xC0 | (cp >> 6));
+		out[1] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+		return 2;
+	}
+	if (cp < 0x10000) {
+		out[0] = static_cast<unsigned char>(0xE0 | (cp >> 12));
+		out[1] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+		out[2] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+		return 3;
+	}
+	out[0] = static_cast<unsigned char>(0xF0 | (cp >> 18));
+	out[1] = static_cast<unsigned char>(0x80 | ((cp >> 12) & 0x3F));
+	out[2] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+	out[3] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+	return 4;
+}
+
+//	Decodes the character at the beginning of a
+//	sequence of UTF-16 or UTF-32, returns the number
+//	of code units it occupies or zero if it is an
+//	unpaired surrogate or out of range
+inline std::size_t utf_decode (const char16_t * curr, const char16_t * end, char32_t & cp) noexcept {
+	char32_t c(*curr);
+	if ((c < 0xD800) || (c > 0xDFFF)) {
+		cp = c;
+		return 1;
+	}
+	if ((c > 0xDBFF) || ((end - curr) < 2)) return 0;
+	char32_t low(curr[1]);
+	if ((low < 0xDC00) || (low > 0xDFFF)) return 0;
+	cp = 0x10000 + (((c - 0xD800) << 10) | (low - 0xDC00));
+	return 2;
+}
+inline std::size_t utf_decode (const char32_t * curr, const char32_t *, char32_t & cp) noexcept {
+	char32_t c(*curr);
+	if ((c > 0x10FFFF) || ((c >= 0xD800) && (c <= 0xDFFF))) return 0;
+	cp = c;
+	return 1;
+}
+
+inline std::size_t utf_encode (char32_t cp, char16_t * out) noexcept {
+	if (cp < 0x10000) {
+		out[0] = char16_t(cp);
+		return 1;
+	}
+	cp -= 0x10000;
+	out[0] = char16_t(0xD800 | (cp >> 10));
+	out[1] = char16_t(0xDC00 | (cp & 0x3FF));
+	return 2;
+}
+inline std::size_t utf_encode (char32_t cp, char32_t * out) noexcept {
+	out[0] = cp;
+	return 1;
+}
+
+//	Determines whether a block of UTF-8 is entirely
+//	ASCII
+inline bool utf8_is_ascii (const unsigned char * in) noexcept {
+#ifdef MCPP_SSE2
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	return _mm_movemask_epi8(v) == 0;
+#else
+	std::uint64_t words [utf8_block / sizeof(std::uint64_t)];
+	std::memcpy(words, in, sizeof(words));
+	return ((words[0] | words[1]) & 0x8080808080808080) == 0;
+#endif
+}
+
+//	If a block of UTF-8 is entirely ASCII widens it
+//	into code units and returns true, otherwise
+//	returns false
+inline bool utf8_widen_ascii (const unsigned char * in, char16_t * out) noexcept {
+#ifdef MCPP_SSE2
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	if (_mm_movemask_epi8(v) != 0) return false;
+	auto zero = _mm_setzero_si128();
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi8(v, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpackhi_epi8(v, zero));
+	return true;
+#else
+	if (!detail::utf8_is_ascii(in)) return false;
+	for (std::size_t i = 0; i < utf8_block; ++i) out[i] = char16_t(in[i]);
+	return true;
+#endif
+}
+inline bool utf8_widen_ascii (const unsigned char * in, char32_t * out) noexcept {
+#ifdef MCPP_SSE2
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	if (_mm_movemask_epi8(v) != 0) return false;
+	auto zero = _mm_setzero_si128();
+	auto lo = _mm_unpacklo_epi8(v, zero);
+	auto hi = _mm_unpackhi_epi8(v, zero);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4), _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm_unpackhi_epi16(hi, zero));
+	return true;
+#else
+	if (!detail::utf8_is_ascii(in)) return false;
+	for (std::size_t i = 0; i < utf8_block; ++i) out[i] = char32_t(in[i]);
+	return true;
+#endif
+}
+
+//	If a block of code units is entirely ASCII narrows
+//	it into UTF-8 and returns true, otherwise returns
+//	false
+inline bool utf8_narrow_ascii (const char16_t * in, unsigned char * out) noexcept {
+#ifdef MCPP_SSE2
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	auto high = _mm_and_si128(v, _mm_set1_epi16(short(0xFF80)));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF) return false;
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(v, v));
+	return true;
+#else
+	for (std::size_t i = 0; i < utf8_block_units<char16_t>; ++i) if (in[i] >= 0x80) return false;
+	for (std::size_t i = 0; i < utf8_block_units<char16_t>; ++i) out[i] = static_cast<unsigned char>(in[i]);
+	return true;
+#endif
+}
+inline bool utf8_narrow_ascii (const char32_t * in, unsigned char * out) noexcept {
+#ifdef MCPP_SSE2
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	auto high = _mm_and_si128(v, _mm_set1_epi32(int(0xFFFFFF80)));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xFFFF) return false;
+	auto narrow = _mm_packs_epi32(v, v);
+	auto bytes = _mm_cvtsi128_si32(_mm_packus_epi16(narrow, narrow));
+	std::memcpy(out, &bytes, utf8_block_units<char32_t>);
+	return true;
+#else
+	for (std::size_t i = 0; i < utf8_block_units<char32_t>; ++i) if (in[i] >= 0x80) return false;
+	for (std::size_t i = 0; i < utf8_block_units<char32_t>; ++i) out[i] = static_cast<unsigned char>(in[i]);
+	return true;
+#endif
+}
+
+}
+
+/**
+ *	Validates a sequence of bytes as UTF-8 and counts
+ *	the code points it encodes in a single pass.
+ *
+ *	Overlong encodings, encoded surrogates, and code
+ *	points beyond U+10FFFF are rejected.
+ *
+ *	Where the processor supports it whole blocks are
+ *	validated at once using SIMD table lookups whether
+ *	or not they contain multi-byte characters. The
+ *	instruction set is selected at runtime the first
+ *	time this function is called.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first byte.
+ *	\param [in] size
+ *		The number of bytes.
+ *
+ *	\return
+ *		The number of code points if the bytes are
+ *		UTF-8, an empty optional otherwise.
+ */
+optional<std::size_t> count_utf8 (const void * ptr, std::size_t size) noexcept;
+/**
+ *	Obtains the name of the instruction set \ref count_utf8
+ *	selected for this processor.
+ *
+ *	\return
+ *		"avx2", "ssse3", or "scalar".
+ */
+const char * count_utf8_implementation () noexcept;
+/**
+ *	Determines whether a sequence of bytes is well
+ *	formed UTF-8.
+ *
+ *	Overlong encodings, encoded surrogates, and code
+ *	points beyond U+10FFFF are rejected.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first byte.
+ *	\param [in] size
+ *		The number of bytes.
+ *
+ *	\return
+ *		\em true if the bytes are UTF-8, \em false
+ *		otherwise.
+ */
+inline bool validate_utf8 (const void * ptr, std::size_t size) noexcept {
+	return bool(mcpp::count_utf8(ptr, size));
+}
+/**
+ *	Transcodes UTF-8 to UTF-16 or UTF-32.
+ *
+ *	No character of UTF-8 encodes to more code units
+ *	than it occupies bytes, therefore an output buffer
+ *	with room for \em size code units always suffices.
+ *
+ *	\tparam CharT
+ *		`char16_t` to produce UTF-16, `char32_t` to
+ *		produce UTF-32.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first byte of UTF-8.
+ *	\param [in] size
+ *		The number of bytes.
+ *	\param [out] out
+ *		A pointer to a buffer with room for at least
+ *		\em size code units. If the UTF-8 is malformed
+ *		its contents are unspecified.
+ *
+ *	\return
+ *		The number of code units written if the bytes
+ *		are UTF-8, an empty optional otherwise.
+ */
+template <typename CharT>
+optional<std::size_t> decode_utf8 (const void * ptr, std::size_t size, CharT * out) noexcept {
+	detail::utf_char<CharT>();
+	auto curr = static_cast<const unsigned char *>(ptr);
+	auto end = curr + size;
+	auto begin = out;
+	while (curr != end) {
+		std::size_t avail(end - curr);
+		if ((avail >= detail::utf8_block) && detail::utf8_widen_ascii(curr, out)) {
+			curr += detail::utf8_block;
+			out += detail::utf8_block;
+			continue;
+		}
+		auto stop = curr + std::min(avail, detail::utf8_block);
+		while (curr < stop) {
+			char32_t cp;
+			auto n = detail::utf8_decode(curr, end, cp);
+			if (n == 0) return nullopt;
+			curr += n;
+			out += detail::utf_encode(cp, out);
+		}
+	}
+	return std::size_t(out - begin);
+}
+/**
+ *	Validates UTF-16 or UTF-32 and determines the
+ *	number of bytes it occupies when encoded as UTF-8.
+ *
+ *	\tparam CharT
+ *		`char16_t` for UTF-16, `char32_t` for UTF-32.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first code unit.
+ *	\param [in] size
+ *		The number of code units.
+ *
+ *	\return
+ *		The number of bytes if the code units are
+ *		valid (i.e. contain no unpaired surrogates or
+ *		values beyond U+10FFFF), an empty optional
+ *		otherwise.
+ */
+template <typename CharT>
+optional<std::size_t> utf8_size (const CharT * ptr, std::size_t size) noexcept {
+	detail::utf_char<CharT>();
+	constexpr std::size_t units = detail::utf8_block_units<CharT>;
+	auto end = ptr + size;
+	std::size_t retr(0);
+	unsigned char scratch [units];
+	while (ptr != end) {
+		std::size_t avail(end - ptr);
+		if ((avail >= units) && detail::utf8_narrow_ascii(ptr, scratch)) {
+			ptr += units;
+			retr += units;
+			continue;
+		}
+		auto stop = ptr + std::min(avail, units);
+		while (ptr < stop) {
+			char32_t cp;
+			auto n = detail::utf_decode(ptr, end, cp);
+			if (n == 0) return nullopt;
+			ptr += n;
+			retr += detail::utf8_encoded_size(cp);
+		}
+	}
+	return retr;
+}
+/**
+ *	Transcodes UTF-16 or UTF-32 to UTF-8.
+ *
+ *	\tparam CharT
+ *		`char16_t` for UTF-16, `char32_t` for UTF-32.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first code unit.
+ *	\param [in] size
+ *		The number of code units.
+ *	\param [out] out
+ *		A pointer to a buffer with room for at least
+ *		as many bytes as \ref utf8_size reports. If
+ *		the code units are invalid its contents are
+ *		unspecified.
+ *
+ *	\return
+ *		The number of bytes written if the code units
+ *		are valid, an empty optional otherwise.
+ */
+template <typename CharT>
+optional<std::size_t> encode_utf8 (const CharT * ptr, std::size_t size, void * out) noexcept {
+	detail::utf_char<CharT>();
+	constexpr std::size_t units = detail::utf8_block_units<CharT>;
+	auto end = ptr + size;
+	auto begin = static_cast<unsigned char *>(out);
+	auto o = begin;
+	while (ptr != end) {
+		std::size_t avail(end - ptr);
+		if ((avail >= units) && detail::utf8_narrow_ascii(ptr, o)) {
+			ptr += units;
+			o += units;
+			continue;
+		}
+		auto stop = ptr + std::min(avail, units);
+		while (ptr < stop) {
+			char32_t cp;
+			auto n = detail::utf_decode(ptr, end, cp);
+			if (n == 0) return nullopt;
+			ptr += n;
+			o += detail::utf8_encode(cp, o);
+		}
+	}
+	return std::size_t(o - begin);
+}
+
+}
@@ -0,0 +1,72 @@
+#include <mcpp/bit.hpp>
+#include <cstdint>
+#include <limits>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace tests {
+namespace {
+
+SCENARIO("The number of trailing zero bits in an integer may be determined", "[mcpp][bit]") {
+	GIVEN("An integer whose least significant bit is set") {
+		std::uint32_t i(0b10101);
+		WHEN("The number of trailing zero bits is determined") {
+			auto n = count_trailing_zeros(i);
+			THEN("It is zero") {
+				CHECK(n == 0);
+			}
+		}
+	}
+	GIVEN("An integer whose only set bit is its most significant bit") {
+		auto i = std::uint64_t(1) << 63;
+		WHEN("The number of trailing zero bits is determined") {
+			auto n = count_trailing_zeros(i);
+			THEN("It is one less than the width of the integer") {
+				CHECK(n == 63);
+			}
+		}
+	}
+	GIVEN("A narrow integer") {
+		std::uint8_t i(0b10000);
+		WHEN("The number of trailing zero bits is determined") {
+			auto n = count_trailing_zeros(i);
+			THEN("The correct number is determined") {
+				CHECK(n == 4);
+			}
+		}
+	}
+}
+
+SCENARIO("The number of leading zero bits in an integer may be determined", "[mcpp][bit]") {
+	GIVEN("An integer whose most significant bit is set") {
+		auto i = std::numeric_limits<std::uint32_t>::max();
+		WHEN("The number of leading zero bits is determined") {
+			auto n = count_leading_zeros(i);
+			THEN("It is zero") {
+				CHECK(n == 0);
+			}
+		}
+	}
+	GIVEN("An integer whose only set bit is its least significant bit") {
+		std::uint64_t i(1);
+		WHEN("The number of leading zero bits is determined") {
+			auto n = count_leading_zeros(i);
+			THEN("It is one less than the width of the integer") {
+				CHECK(n == 63);
+			}
+		}
+	}
+	GIVEN("A narrow integer") {
+		std::uint16_t i(0b10000);
+		WHEN("The number of leading zero bits is determined") {
+			auto n = count_leading_zeros(i);
+			THEN("The number is relative to the width of that integer") {
+				CHECK(n == 11);
+			}
+		}
+	}
+}
+
+}
+}
+}
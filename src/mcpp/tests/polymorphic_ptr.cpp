@@ -225,6 +225,22 @@ SCENARIO("mcpp::polymorphic_ptr may use custom allocators to obtain memory", "[m
 					}
 				}
 			}
+			AND_WHEN("The managed object is destroyed and the managed memory released") {
+				ptr->clear();
+				THEN("It does not manage an object") {
+					CHECK_FALSE(*ptr);
+				}
+				THEN("The managed object's lifetime ends") {
+					CHECK(ostate.destruct == 1);
+				}
+				THEN("It does not manage memory") {
+					CHECK(ptr->capacity() == 0);
+				}
+				THEN("The managed memory is deallocated") {
+					CHECK(state.deallocations == 1);
+					CHECK(state.deallocated == state.allocated);
+				}
+			}
 			AND_WHEN("The lifetime of the mcpp::polymorphic_ptr ends") {
 				ptr = nullopt;
 				THEN("The managed object's lifetime ends") {
@@ -0,0 +1,217 @@
+#include <mcpp/utf8.hpp>
+#include <mcpp/optional.hpp>
+#include <cstddef>
+#include <string>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace tests {
+namespace {
+
+//	Long enough that some blocks are entirely ASCII
+//	and that characters straddle block boundaries
+const std::string utf8_text = [] () {
+	std::string retr;
+	for (std::size_t i = 0; i < 10; ++i) {
+		retr += "The quick brown fox ";
+		retr += "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+	}
+	return retr;
+}();
+const std::u16string utf16_text = [] () {
+	std::u16string retr;
+	for (std::size_t i = 0; i < 10; ++i) {
+		retr += u"The quick brown fox ";
+		retr += u"\u00E9\u20AC\U0001F600";
+	}
+	return retr;
+}();
+const std::u32string utf32_text = [] () {
+	std::u32string retr;
+	for (std::size_t i = 0; i < 10; ++i) {
+		retr += U"The quick brown fox ";
+		retr += U"\u00E9\u20AC\U0001F600";
+	}
+	return retr;
+}();
+
+template <typename CharT>
+std::basic_string<CharT> decode (const std::string & str) {
+	std::basic_string<CharT> retr(str.size(), CharT());
+	auto units = decode_utf8(str.data(), str.size(), &retr[0]);
+	REQUIRE(units);
+	retr.resize(*units);
+	return retr;
+}
+
+template <typename CharT>
+std::string encode (const std::basic_string<CharT> & str) {
+	auto size = utf8_size(str.data(), str.size());
+	REQUIRE(size);
+	std::string retr(*size, '\0');
+	auto written = encode_utf8(str.data(), str.size(), &retr[0]);
+	REQUIRE(written);
+	CHECK(*written == *size);
+	return retr;
+}
+
+SCENARIO("Sequences of bytes may be validated as UTF-8", "[mcpp][utf8]") {
+	GIVEN("A well formed sequence containing characters of every length") {
+		const char str [] = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+		THEN("It is valid") {
+			CHECK(validate_utf8(str, sizeof(str) - 1));
+		}
+	}
+	GIVEN("A long well formed sequence") {
+		THEN("It is valid") {
+			CHECK(validate_utf8(utf8_text.data(), utf8_text.size()));
+			AND_THEN("Its code points may be counted") {
+				auto count = count_utf8(utf8_text.data(), utf8_text.size());
+				REQUIRE(count);
+				CHECK(*count == utf32_text.size());
+			}
+		}
+	}
+	GIVEN("A long sequence with a malformed byte after several ASCII blocks") {
+		std::string str(utf8_text);
+		str[70] = char(0xFF);
+		THEN("It is invalid") {
+			CHECK_FALSE(validate_utf8(str.data(), str.size()));
+			CHECK_FALSE(count_utf8(str.data(), str.size()));
+		}
+	}
+	GIVEN("An empty sequence") {
+		THEN("It is valid") {
+			CHECK(validate_utf8(nullptr, 0));
+		}
+	}
+	GIVEN("An overlong encoding") {
+		const char str [] = "\xE0\x80\xAF";
+		THEN("It is invalid") {
+			CHECK_FALSE(validate_utf8(str, sizeof(str) - 1));
+		}
+	}
+	GIVEN("An encoded surrogate") {
+		const char str [] = "\xED\xA0\x80";
+		THEN("It is invalid") {
+			CHECK_FALSE(validate_utf8(str, sizeof(str) - 1));
+		}
+	}
+	GIVEN("A code point beyond U+10FFFF") {
+		const char str [] = "\xF4\x90\x80\x80";
+		THEN("It is invalid") {
+			CHECK_FALSE(validate_utf8(str, sizeof(str) - 1));
+		}
+	}
+	GIVEN("A truncated sequence") {
+		const char str [] = "ab\xE2\x82";
+		THEN("It is invalid") {
+			CHECK_FALSE(validate_utf8(str, sizeof(str) - 1));
+		}
+	}
+	GIVEN("A stray continuation byte") {
+		const char str [] = "a\x80";
+		THEN("It is invalid") {
+			CHECK_FALSE(validate_utf8(str, sizeof(str) - 1));
+		}
+	}
+}
+
+//	Counts code points a character at a time
+optional<std::size_t> count_reference (const std::string & str) {
+	auto curr = reinterpret_cast<const unsigned char *>(str.data());
+	auto end = curr + str.size();
+	std::size_t retr(0);
+	while (curr != end) {
+		char32_t cp;
+		auto n = detail::utf8_decode(curr, end, cp);
+		if (n == 0) return nullopt;
+		curr += n;
+		++retr;
+	}
+	return retr;
+}
+
+SCENARIO("Sequences of bytes are validated as UTF-8 identically whichever instruction set is used", "[mcpp][utf8]") {
+	GIVEN("Every pair of bytes beginning with a non-ASCII byte followed by bytes of interest, at offsets within and across blocks") {
+		const unsigned char thirds [] = {0x00, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xFF};
+		const std::size_t offsets [] = {0, 13, 14, 15, 29, 30, 31, 44, 46, 47};
+		std::size_t mismatches(0);
+		for (std::size_t first = 0x80; first <= 0xFF; ++first) for (std::size_t second = 0; second <= 0xFF; ++second) {
+			for (auto third : thirds) for (auto offset : offsets) {
+				std::string str(48, 'a');
+				str[offset] = char(first);
+				if ((offset + 1) < str.size()) str[offset + 1] = char(second);
+				if ((offset + 2) < str.size()) str[offset + 2] = char(third);
+				if ((offset + 3) < str.size()) str[offset + 3] = char(0x80);
+				auto expected = count_reference(str);
+				auto actual = count_utf8(str.data(), str.size());
+				if (bool(expected) != bool(actual)) ++mismatches;
+				else if (expected && (*expected != *actual)) ++mismatches;
+			}
+		}
+		THEN("The result is the same as decoding a character at a time (using " << count_utf8_implementation() << ")") {
+			CHECK(mismatches == 0);
+		}
+	}
+	GIVEN("Well formed text truncated at every length") {
+		std::size_t mismatches(0);
+		for (std::size_t i = 0; i <= utf8_text.size(); ++i) {
+			auto str = utf8_text.substr(0, i);
+			auto expected = count_reference(str);
+			auto actual = count_utf8(str.data(), str.size());
+			if ((bool(expected) != bool(actual)) || (expected && (*expected != *actual))) ++mismatches;
+		}
+		THEN("The result is the same as decoding a character at a time") {
+			CHECK(mismatches == 0);
+		}
+	}
+}
+
+SCENARIO("UTF-8 may be transcoded to and from UTF-16 and UTF-32", "[mcpp][utf8]") {
+	GIVEN("UTF-8") {
+		THEN("It may be transcoded to UTF-16") {
+			CHECK(decode<char16_t>(utf8_text) == utf16_text);
+		}
+		THEN("It may be transcoded to UTF-32") {
+			CHECK(decode<char32_t>(utf8_text) == utf32_text);
+		}
+	}
+	GIVEN("Malformed UTF-8") {
+		std::string str("abc\xC0\x80");
+		std::u16string out(str.size(), u'\0');
+		THEN("It may not be transcoded") {
+			CHECK_FALSE(decode_utf8(str.data(), str.size(), &out[0]));
+		}
+	}
+	GIVEN("UTF-16") {
+		THEN("It may be transcoded to UTF-8") {
+			CHECK(encode(utf16_text) == utf8_text);
+		}
+	}
+	GIVEN("UTF-32") {
+		THEN("It may be transcoded to UTF-8") {
+			CHECK(encode(utf32_text) == utf8_text);
+		}
+	}
+	GIVEN("UTF-16 containing an unpaired surrogate") {
+		std::u16string str(u"abcdefghij");
+		str[9] = char16_t(0xD800);
+		THEN("It may not be transcoded") {
+			CHECK_FALSE(utf8_size(str.data(), str.size()));
+			std::string out(str.size() * 3, '\0');
+			CHECK_FALSE(encode_utf8(str.data(), str.size(), &out[0]));
+		}
+	}
+	GIVEN("UTF-32 containing a value beyond U+10FFFF") {
+		std::u32string str(U"a");
+		str[0] = char32_t(0x110000);
+		THEN("It may not be transcoded") {
+			CHECK_FALSE(utf8_size(str.data(), str.size()));
+		}
+	}
+}
+
+}
+}
+}
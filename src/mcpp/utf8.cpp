@@ -0,0 +1,281 @@
+#include <mcpp/utf8.hpp>
+#include <mcpp/optional.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+//	Kernels for instruction sets beyond the compiler's
+//	target are compiled with per function target
+//	attributes and selected by querying the processor
+//	at runtime, this is only supported on GCC and Clang
+//	for x86
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MCPP_UTF8_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace mcpp {
+
+namespace {
+
+using kernel_type = optional<std::size_t> (*) (const unsigned char *, std::size_t);
+
+optional<std::size_t> count_utf8_scalar (const unsigned char * curr, std::size_t size) noexcept {
+	auto end = curr + size;
+	std::size_t retr(0);
+	while (curr != end) {
+		std::size_t avail(end - curr);
+		if ((avail >= detail::utf8_block) && detail::utf8_is_ascii(curr)) {
+			curr += detail::utf8_block;
+			retr += detail::utf8_block;
+			continue;
+		}
+		auto stop = curr + std::min(avail, detail::utf8_block);
+		while (curr < stop) {
+			char32_t cp;
+			auto n = detail::utf8_decode(curr, end, cp);
+			if (n == 0) return nullopt;
+			curr += n;
+			++retr;
+		}
+	}
+	return retr;
+}
+
+#ifdef MCPP_UTF8_DISPATCH
+
+//	Multi-byte characters are validated by classifying
+//	each pair of adjacent bytes through three 16 entry
+//	tables indexed by the high nibble of the first byte,
+//	the low nibble of the first byte, and the high nibble
+//	of the second byte. Each bit identifies a kind of
+//	error and is set in all three entries only if the
+//	pair exhibits it (Keiser and Lemire, "Validating
+//	UTF-8 In Less Than One Instruction Per Byte")
+constexpr unsigned char too_short = 1 << 0;	//	11______ 0_______ or 11______ 11______
+constexpr unsigned char too_long = 1 << 1;	//	0_______ 10______
+constexpr unsigned char overlong_3 = 1 << 2;	//	11100000 100_____
+constexpr unsigned char too_large = 1 << 3;	//	11110100 1001____ and greater
+constexpr unsigned char surrogate = 1 << 4;	//	11101101 101_____
+constexpr unsigned char overlong_2 = 1 << 5;	//	1100000_ 10______
+constexpr unsigned char too_large_1000 = 1 << 6;	//	11110101 1000____ and greater
+constexpr unsigned char overlong_4 = 1 << 6;	//	11110000 1000____
+constexpr unsigned char two_conts = 1 << 7;	//	10______ 10______
+constexpr unsigned char carry = too_short | too_long | two_conts;
+
+alignas(16) constexpr unsigned char byte_1_high [16] = {
+	too_long, too_long, too_long, too_long,
+	too_long, too_long, too_long, too_long,
+	two_conts, two_conts, two_conts, two_conts,
+	too_short | overlong_2,
+	too_short,
+	too_short | overlong_3 | surrogate,
+	too_short | too_large | too_large_1000 | overlong_4
+};
+alignas(16) constexpr unsigned char byte_1_low [16] = {
+	carry | overlong_3 | overlong_2 | overlong_4,
+	carry | overlong_2,
+	carry,
+	carry,
+	carry | too_large,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000 | surrogate,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000
+};
+alignas(16) constexpr unsigned char byte_2_high [16] = {
+	too_short, too_short, too_short, too_short,
+	too_short, too_short, too_short, too_short,
+	too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+	too_long | overlong_2 | two_conts | overlong_3 | too_large,
+	too_long | overlong_2 | two_conts | surrogate | too_large,
+	too_long | overlong_2 | two_conts | surrogate | too_large,
+	too_short, too_short, too_short, too_short
+};
+//	Bytes which exceed these at the end of a block begin
+//	characters which continue into the next block
+alignas(16) constexpr unsigned char incomplete_max [16] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF
+};
+
+__attribute__((target("ssse3")))
+__m128i load_table (const unsigned char * table) noexcept {
+	return _mm_load_si128(reinterpret_cast<const __m128i *>(table));
+}
+
+//	Computes the errors in a block given the block which
+//	precedes it, the result is zero if there are none
+__attribute__((target("ssse3")))
+__m128i utf8_errors_ssse3 (__m128i input, __m128i prev) noexcept {
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	auto prev1 = _mm_alignr_epi8(input, prev, 15);
+	auto b1h = _mm_shuffle_epi8(load_table(byte_1_high), _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+	auto b1l = _mm_shuffle_epi8(load_table(byte_1_low), _mm_and_si128(prev1, nibble));
+	auto b2h = _mm_shuffle_epi8(load_table(byte_2_high), _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+	auto special = _mm_and_si128(_mm_and_si128(b1h, b1l), b2h);
+	//	The third and fourth bytes of characters must be
+	//	continuations, these are the only pairs of
+	//	continuations for which two_conts is not an error
+	auto third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8(char(0xE0 - 0x80)));
+	auto fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8(char(0xF0 - 0x80)));
+	auto must = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+	return _mm_xor_si128(must, special);
+}
+
+__attribute__((target("ssse3")))
+void count_utf8_ssse3_block (__m128i input, __m128i & prev, __m128i & incomplete, __m128i & error, std::size_t & count) noexcept {
+	auto mask = unsigned(_mm_movemask_epi8(input));
+	if (mask == 0) {
+		error = _mm_or_si128(error, incomplete);
+		incomplete = _mm_setzero_si128();
+		count += 16;
+	} else {
+		error = _mm_or_si128(error, utf8_errors_ssse3(input, prev));
+		incomplete = _mm_subs_epu8(input, load_table(incomplete_max));
+		//	Every byte other than a continuation begins
+		//	a code point
+		auto starts = _mm_cmpgt_epi8(input, _mm_set1_epi8(char(0xBF)));
+		count += unsigned(__builtin_popcount(unsigned(_mm_movemask_epi8(starts))));
+	}
+	prev = input;
+}
+
+__attribute__((target("ssse3")))
+optional<std::size_t> count_utf8_ssse3 (const unsigned char * curr, std::size_t size) noexcept {
+	auto prev = _mm_setzero_si128();
+	auto incomplete = _mm_setzero_si128();
+	auto error = _mm_setzero_si128();
+	std::size_t retr(0);
+	for (; size >= 16; size -= 16, curr += 16) {
+		auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(curr));
+		count_utf8_ssse3_block(input, prev, incomplete, error, retr);
+	}
+	if (size != 0) {
+		//	The tail is padded with ASCII which does not
+		//	contribute to the count
+		alignas(16) unsigned char tail [16] = {};
+		std::memcpy(tail, curr, size);
+		count_utf8_ssse3_block(_mm_load_si128(reinterpret_cast<const __m128i *>(tail)), prev, incomplete, error, retr);
+		retr -= 16 - size;
+	}
+	error = _mm_or_si128(error, incomplete);
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF) return nullopt;
+	return retr;
+}
+
+__attribute__((target("avx2")))
+__m256i load_table_avx2 (const unsigned char * table) noexcept {
+	return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(table)));
+}
+
+//	vpalignr operates within each 128 bit lane therefore
+//	the bytes which precede the upper lane are obtained
+//	by first combining the upper lane of the previous
+//	block and the lower lane of this block
+template <int N>
+__attribute__((target("avx2")))
+__m256i prev_avx2 (__m256i input, __m256i prev) noexcept {
+	return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+
+__attribute__((target("avx2")))
+__m256i utf8_errors_avx2 (__m256i input, __m256i prev) noexcept {
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	auto prev1 = prev_avx2<1>(input, prev);
+	auto b1h = _mm256_shuffle_epi8(load_table_avx2(byte_1_high), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+	auto b1l = _mm256_shuffle_epi8(load_table_avx2(byte_1_low), _mm256_and_si256(prev1, nibble));
+	auto b2h = _mm256_shuffle_epi8(load_table_avx2(byte_2_high), _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+	auto special = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+	auto third = _mm256_subs_epu8(prev_avx2<2>(input, prev), _mm256_set1_epi8(char(0xE0 - 0x80)));
+	auto fourth = _mm256_subs_epu8(prev_avx2<3>(input, prev), _mm256_set1_epi8(char(0xF0 - 0x80)));
+	auto must = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(char(0x80)));
+	return _mm256_xor_si256(must, special);
+}
+
+__attribute__((target("avx2")))
+void count_utf8_avx2_block (__m256i input, __m256i & prev, __m256i & incomplete, __m256i & error, std::size_t & count) noexcept {
+	auto mask = unsigned(_mm256_movemask_epi8(input));
+	if (mask == 0) {
+		error = _mm256_or_si256(error, incomplete);
+		incomplete = _mm256_setzero_si256();
+		count += 32;
+	} else {
+		error = _mm256_or_si256(error, utf8_errors_avx2(input, prev));
+		//	Only the upper lane may contain characters
+		//	which continue into the next block
+		auto max = _mm256_inserti128_si256(_mm256_set1_epi8(char(0xFF)), _mm_load_si128(reinterpret_cast<const __m128i *>(incomplete_max)), 1);
+		incomplete = _mm256_subs_epu8(input, max);
+		auto starts = _mm256_cmpgt_epi8(input, _mm256_set1_epi8(char(0xBF)));
+		count += unsigned(__builtin_popcount(unsigned(_mm256_movemask_epi8(starts))));
+	}
+	prev = input;
+}
+
+__attribute__((target("avx2")))
+optional<std::size_t> count_utf8_avx2 (const unsigned char * curr, std::size_t size) noexcept {
+	auto prev = _mm256_setzero_si256();
+	auto incomplete = _mm256_setzero_si256();
+	auto error = _mm256_setzero_si256();
+	std::size_t retr(0);
+	for (; size >= 32; size -= 32, curr += 32) {
+		auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(curr));
+		count_utf8_avx2_block(input, prev, incomplete, error, retr);
+	}
+	if (size != 0) {
+		alignas(32) unsigned char tail [32] = {};
+		std::memcpy(tail, curr, size);
+		count_utf8_avx2_block(_mm256_load_si256(reinterpret_cast<const __m256i *>(tail)), prev, incomplete, error, retr);
+		retr -= 32 - size;
+	}
+	error = _mm256_or_si256(error, incomplete);
+	if (!_mm256_testz_si256(error, error)) return nullopt;
+	return retr;
+}
+
+#endif
+
+class count_utf8_kernel {
+public:
+	kernel_type kernel;
+	const char * name;
+	count_utf8_kernel () noexcept
+		:	kernel(&count_utf8_scalar),
+			name("scalar")
+	{
+#ifdef MCPP_UTF8_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			kernel = &count_utf8_avx2;
+			name = "avx2";
+		} else if (__builtin_cpu_supports("ssse3")) {
+			kernel = &count_utf8_ssse3;
+			name = "ssse3";
+		}
+#endif
+	}
+};
+
+const count_utf8_kernel & get_kernel () noexcept {
+	static const count_utf8_kernel retr;
+	return retr;
+}
+
+}
+
+optional<std::size_t> count_utf8 (const void * ptr, std::size_t size) noexcept {
+	return get_kernel().kernel(static_cast<const unsigned char *>(ptr), size);
+}
+
+const char * count_utf8_implementation () noexcept {
+	return get_kernel().name;
+}
+
+}
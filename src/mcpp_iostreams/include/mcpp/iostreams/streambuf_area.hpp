@@ -0,0 +1,251 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <streambuf>
+#include <type_traits>
+#include <utility>
+
+namespace mcpp {
+namespace iostreams {
+
+namespace detail {
+
+template <typename CharT, typename Traits>
+std::true_type is_streambuf (const std::basic_streambuf<CharT, Traits> *);
+std::false_type is_streambuf (const void *);
+
+//	Pointers to protected members formed through a
+//	derived class may be used on any object of the
+//	base class, this allows the get and put areas of
+//	arbitrary std::basic_streambuf objects to be
+//	manipulated without a cast
+template <typename CharT, typename Traits>
+class streambuf_area : public std::basic_streambuf<CharT, Traits> {
+private:
+	using base = std::basic_streambuf<CharT, Traits>;
+public:
+	static CharT * get_current (const base & sb) noexcept {
+		return (sb.*&streambuf_area::gptr)();
+	}
+	static CharT * get_end (const base & sb) noexcept {
+		return (sb.*&streambuf_area::egptr)();
+	}
+	static void get_advance (base & sb, std::size_t n) noexcept {
+		for (; n > std::size_t(INT_MAX); n -= std::size_t(INT_MAX)) (sb.*&streambuf_area::gbump)(INT_MAX);
+		(sb.*&streambuf_area::gbump)(int(n));
+	}
+	static CharT * put_current (const base & sb) noexcept {
+		return (sb.*&streambuf_area::pptr)();
+	}
+	static CharT * put_end (const base & sb) noexcept {
+		return (sb.*&streambuf_area::epptr)();
+	}
+	static void put_advance (base & sb, std::size_t n) noexcept {
+		for (; n > std::size_t(INT_MAX); n -= std::size_t(INT_MAX)) (sb.*&streambuf_area::pbump)(INT_MAX);
+		(sb.*&streambuf_area::pbump)(int(n));
+	}
+};
+
+}
+
+/**
+ *	`std::true_type` if \em T is derived from a
+ *	specialization of `std::basic_streambuf`,
+ *	`std::false_type` otherwise.
+ *
+ *	\tparam T
+ *		The type to test.
+ */
+template <typename T>
+using is_streambuf_t = decltype(detail::is_streambuf(std::declval<T *>()));
+
+/**
+ *	\em true if \em T is derived from a specialization
+ *	of `std::basic_streambuf`, \em false otherwise.
+ *
+ *	\tparam T
+ *		The type to test.
+ */
+template <typename T>
+constexpr bool is_streambuf_v = is_streambuf_t<T>::value;
+
+/**
+ *	Obtains a pointer to the next character in the
+ *	get area of a `std::basic_streambuf`.
+ *
+ *	This allows characters which are already buffered
+ *	to be examined in place without virtual calls.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		A pointer which is equivalent to the value
+ *		\em sb would return from `gptr`.
+ */
+template <typename CharT, typename Traits>
+CharT * gptr (const std::basic_streambuf<CharT, Traits> & sb) noexcept {
+	return detail::streambuf_area<CharT, Traits>::get_current(sb);
+}
+/**
+ *	Obtains a pointer to one past the last character
+ *	in the get area of a `std::basic_streambuf`.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		A pointer which is equivalent to the value
+ *		\em sb would return from `egptr`.
+ */
+template <typename CharT, typename Traits>
+CharT * egptr (const std::basic_streambuf<CharT, Traits> & sb) noexcept {
+	return detail::streambuf_area<CharT, Traits>::get_end(sb);
+}
+/**
+ *	Determines the number of characters which may be
+ *	read from a `std::basic_streambuf` without
+ *	underflowing its get area.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		The number of characters.
+ */
+template <typename CharT, typename Traits>
+std::size_t get_available (const std::basic_streambuf<CharT, Traits> & sb) noexcept {
+	return std::size_t(iostreams::egptr(sb) - iostreams::gptr(sb));
+}
+/**
+ *	Consumes characters from the get area of a
+ *	`std::basic_streambuf` which were examined by
+ *	way of \ref gptr.
+ *
+ *	If \em n is greater than the value returned by
+ *	\ref get_available the behavior is undefined.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *	\param [in] n
+ *		The number of characters to consume.
+ */
+template <typename CharT, typename Traits>
+void gbump (std::basic_streambuf<CharT, Traits> & sb, std::size_t n) noexcept {
+	detail::streambuf_area<CharT, Traits>::get_advance(sb, n);
+}
+
+/**
+ *	Obtains a pointer to the next character in the
+ *	put area of a `std::basic_streambuf`.
+ *
+ *	This allows characters to be written directly
+ *	into space the `std::basic_streambuf` has already
+ *	made available without virtual calls.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		A pointer which is equivalent to the value
+ *		\em sb would return from `pptr`.
+ */
+template <typename CharT, typename Traits>
+CharT * pptr (const std::basic_streambuf<CharT, Traits> & sb) noexcept {
+	return detail::streambuf_area<CharT, Traits>::put_current(sb);
+}
+/**
+ *	Obtains a pointer to one past the last character
+ *	in the put area of a `std::basic_streambuf`.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		A pointer which is equivalent to the value
+ *		\em sb would return from `epptr`.
+ */
+template <typename CharT, typename Traits>
+CharT * epptr (const std::basic_streambuf<CharT, Traits> & sb) noexcept {
+	return detail::streambuf_area<CharT, Traits>::put_end(sb);
+}
+/**
+ *	Determines the number of characters which may be
+ *	written to a `std::basic_streambuf` without
+ *	overflowing its put area.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		The number of characters.
+ */
+template <typename CharT, typename Traits>
+std::size_t put_available (const std::basic_streambuf<CharT, Traits> & sb) noexcept {
+	return std::size_t(iostreams::epptr(sb) - iostreams::pptr(sb));
+}
+/**
+ *	Commits characters which were written directly
+ *	to the put area of a `std::basic_streambuf` by
+ *	way of \ref pptr.
+ *
+ *	If \em n is greater than the value returned by
+ *	\ref put_available the behavior is undefined.
+ *
+ *	\tparam CharT
+ *		The character type of \em sb.
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *	\param [in] n
+ *		The number of characters to commit.
+ */
+template <typename CharT, typename Traits>
+void pbump (std::basic_streambuf<CharT, Traits> & sb, std::size_t n) noexcept {
+	detail::streambuf_area<CharT, Traits>::put_advance(sb, n);
+}
+
+}
+}
@@ -0,0 +1,84 @@
+#include <mcpp/iostreams/streambuf_area.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
+#include <mcpp/buffer.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace iostreams {
+namespace tests {
+namespace {
+
+static_assert(is_streambuf_v<buffer>, "mcpp::buffer not detected as a std::basic_streambuf");
+static_assert(is_streambuf_v<boost::interprocess::basic_vectorbuf<std::vector<char>>>, "boost::interprocess::basic_vectorbuf not detected as a std::basic_streambuf");
+static_assert(!is_streambuf_v<std::string>, "std::string detected as a std::basic_streambuf");
+
+SCENARIO("The get area of a std::basic_streambuf may be examined and consumed in place", "[mcpp][iostreams][streambuf_area]") {
+	GIVEN("A std::basic_streambuf with a get area") {
+		char arr [] = {'a', 'b', 'c', 'd'};
+		buffer b(arr);
+		WHEN("The get area is examined") {
+			THEN("The entire get area is available") {
+				CHECK(gptr(b) == arr);
+				CHECK(egptr(b) == (arr + sizeof(arr)));
+				CHECK(get_available(b) == sizeof(arr));
+			}
+		}
+		WHEN("Characters are consumed from the get area") {
+			gbump(b, 3);
+			THEN("The characters are no longer available") {
+				CHECK(get_available(b) == 1);
+				CHECK(b.read() == 3);
+				AND_THEN("The remaining character may be read from the std::basic_streambuf") {
+					CHECK(b.sgetc() == 'd');
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("The put area of a std::basic_streambuf may be written and committed in place", "[mcpp][iostreams][streambuf_area]") {
+	GIVEN("A std::basic_streambuf with a put area") {
+		char arr [4];
+		buffer b(arr);
+		WHEN("The put area is examined") {
+			THEN("The entire put area is available") {
+				CHECK(pptr(b) == arr);
+				CHECK(epptr(b) == (arr + sizeof(arr)));
+				CHECK(put_available(b) == sizeof(arr));
+			}
+		}
+		WHEN("Characters are written to the put area and committed") {
+			pptr(b)[0] = 'a';
+			pptr(b)[1] = 'b';
+			pbump(b, 2);
+			THEN("The characters have been written") {
+				CHECK(b.written() == 2);
+				CHECK(put_available(b) == 2);
+				CHECK(arr[0] == 'a');
+				CHECK(arr[1] == 'b');
+			}
+		}
+	}
+	GIVEN("A boost::interprocess::basic_vectorbuf") {
+		boost::interprocess::basic_vectorbuf<std::vector<char>> vb;
+		vb.reserve(16);
+		WHEN("Characters are written to the put area and committed") {
+			REQUIRE(put_available(vb) >= 2);
+			pptr(vb)[0] = 'a';
+			pptr(vb)[1] = 'b';
+			pbump(vb, 2);
+			THEN("The characters appear in the vector") {
+				std::vector<char> expected = {'a', 'b'};
+				CHECK(vb.vector() == expected);
+			}
+		}
+	}
+}
+
+}
+}
+}
+}
@@ -0,0 +1,131 @@
+#include <mcpp/protocol/arena.hpp>
+#include <mcpp/checked.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+
+namespace mcpp {
+namespace protocol {
+
+namespace {
+
+//	The size of the header at the start of each block
+//	rounded up so that the memory which follows it is
+//	suitably aligned for any fundamental type
+template <typename Block>
+constexpr std::size_t header_size = ((sizeof(Block) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t)) * alignof(std::max_align_t);
+
+template <typename Block>
+unsigned char * block_data (Block * b) noexcept {
+	return reinterpret_cast<unsigned char *>(b) + header_size<Block>;
+}
+
+}
+
+monotonic_arena::monotonic_arena (std::size_t block_size) noexcept
+	:	upstream_(default_upstream()),
+		head_(nullptr),
+		tail_(nullptr),
+		current_(nullptr),
+		offset_(0),
+		block_size_(block_size),
+		active_(0),
+		owner_(nullptr)
+{	}
+
+monotonic_arena::~monotonic_arena () noexcept {
+	for (auto b = head_; b;) {
+		auto next = b->next;
+		std::size_t size(header_size<block> + b->size);
+		b->~block();
+		upstream_->deallocate(b, size);
+		b = next;
+	}
+	if (upstream_ != default_upstream()) upstream_->destroy();
+}
+
+monotonic_arena::upstream * monotonic_arena::default_upstream () noexcept {
+	static basic_upstream<std::allocator<unsigned char>> retr{std::allocator<unsigned char>()};
+	return &retr;
+}
+
+void * monotonic_arena::allocate (std::size_t size, std::size_t alignment) {
+	assert(alignment <= alignof(std::max_align_t));
+	//	Blocks retained from before the last rewind are
+	//	tried in order, a block which cannot satisfy an
+	//	allocation is abandoned until the next rewind
+	for (; current_; current_ = current_->next, offset_ = 0) {
+		void * ptr = block_data(current_) + offset_;
+		std::size_t space = current_->size - offset_;
+		if (std::align(alignment, size, ptr, space)) {
+			offset_ = (current_->size - space) + size;
+			return ptr;
+		}
+	}
+	//	The header is followed by memory which is suitably
+	//	aligned for any fundamental type
+	auto n = std::max(block_size_, size);
+	auto total = checked::add(header_size<block>, n);
+	if (!total) throw std::bad_alloc();
+	auto b = ::new (upstream_->allocate(*total)) block{nullptr, n};
+	if (tail_) tail_->next = b;
+	else head_ = b;
+	tail_ = b;
+	current_ = b;
+	offset_ = size;
+	return block_data(b);
+}
+
+bool monotonic_arena::owns (const void * ptr) const noexcept {
+	auto p = static_cast<const unsigned char *>(ptr);
+	std::less<const unsigned char *> lt;
+	for (auto b = head_; b; b = b->next) {
+		auto begin = block_data(b);
+		if (!lt(p, begin) && lt(p, begin + b->size)) return true;
+	}
+	return false;
+}
+
+void monotonic_arena::rewind () noexcept {
+	current_ = head_;
+	offset_ = 0;
+}
+
+void monotonic_arena::activate () noexcept {
+	++active_;
+}
+
+void monotonic_arena::deactivate () noexcept {
+	assert(active_ != 0);
+	--active_;
+}
+
+bool monotonic_arena::active () const noexcept {
+	return active_ != 0;
+}
+
+std::size_t monotonic_arena::capacity () const noexcept {
+	std::size_t retr(0);
+	for (auto b = head_; b; b = b->next) retr += b->size;
+	return retr;
+}
+
+void monotonic_arena::claim (const void * owner) noexcept {
+	assert(owner);
+	assert(!owner_ || (owner_ == owner));
+	owner_ = owner;
+}
+
+void monotonic_arena::release (const void * owner) noexcept {
+	if (owner_ == owner) owner_ = nullptr;
+}
+
+const void * monotonic_arena::owner () const noexcept {
+	return owner_;
+}
+
+}
+}
@@ -0,0 +1,158 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+
+/**
+ *	The timings gathered for a single benchmark.
+ */
+class result {
+public:
+	std::string name;
+	/**
+	 *	The number of operations performed by each
+	 *	batch.
+	 */
+	std::size_t operations;
+	/**
+	 *	The number of bytes parsed or serialized by
+	 *	each batch.
+	 */
+	std::size_t bytes;
+	/**
+	 *	The wall clock duration of each batch in
+	 *	nanoseconds.
+	 */
+	std::vector<double> samples;
+};
+
+/**
+ *	Options which control how each benchmark is
+ *	run.
+ */
+class options {
+public:
+	/**
+	 *	Only benchmarks whose name contains this
+	 *	string are run.
+	 */
+	std::string filter;
+	/**
+	 *	The minimum number of seconds for which each
+	 *	benchmark is run.
+	 */
+	double min_time = 0.25;
+	/**
+	 *	The minimum number of batches timed for each
+	 *	benchmark.
+	 */
+	std::size_t min_batches = 20;
+	/**
+	 *	The maximum number of batches timed for each
+	 *	benchmark.
+	 */
+	std::size_t max_batches = 100000;
+};
+
+/**
+ *	Times batches of operations and accumulates
+ *	the results.
+ *
+ *	Each batch is timed separately so that the spread
+ *	of per operation latency may be reported as well
+ *	as throughput.
+ */
+class runner {
+private:
+	using clock = std::chrono::steady_clock;
+	options opts_;
+	std::vector<result> results_;
+public:
+	explicit runner (options opts) : opts_(std::move(opts)) {	}
+	/**
+	 *	Runs a benchmark unless it is excluded by the
+	 *	filter.
+	 *
+	 *	\param [in] name
+	 *		The name of the benchmark.
+	 *	\param [in] operations
+	 *		The number of operations performed by each
+	 *		invocation of \em func.
+	 *	\param [in] bytes
+	 *		The number of bytes parsed or serialized by
+	 *		each invocation of \em func.
+	 *	\param [in] func
+	 *		A function which performs one batch.
+	 */
+	template <typename F>
+	void measure (std::string name, std::size_t operations, std::size_t bytes, F func) {
+		if (name.find(opts_.filter) == std::string::npos) return;
+		result r;
+		r.name = std::move(name);
+		r.operations = operations;
+		r.bytes = bytes;
+		//	Warm up caches and any lazily allocated
+		//	state
+		func();
+		std::chrono::duration<double> total(0);
+		while (
+			(r.samples.size() < opts_.max_batches) &&
+			((r.samples.size() < opts_.min_batches) || (total.count() < opts_.min_time))
+		) {
+			auto start = clock::now();
+			func();
+			auto elapsed = clock::now() - start;
+			total += elapsed;
+			r.samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count());
+		}
+		results_.push_back(std::move(r));
+	}
+	const std::vector<result> & results () const noexcept {
+		return results_;
+	}
+};
+
+/**
+ *	A function which runs some number of benchmarks.
+ */
+using benchmark = void (*) (runner &);
+
+/**
+ *	Obtains all benchmarks which have been registered
+ *	by way of \ref registration.
+ *
+ *	\return
+ *		A reference to a vector of benchmarks.
+ */
+inline std::vector<benchmark> & registry () {
+	static std::vector<benchmark> retr;
+	return retr;
+}
+
+/**
+ *	Adds a benchmark to the \ref registry when
+ *	constructed, translation units declare an object
+ *	of this type at namespace scope for each of their
+ *	benchmarks.
+ */
+class registration {
+public:
+	explicit registration (benchmark b) {
+		registry().push_back(b);
+	}
+};
+
+}
+}
+}
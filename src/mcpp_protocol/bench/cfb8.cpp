@@ -0,0 +1,77 @@
+#include "bench.hpp"
+#include <mcpp/protocol/cfb8.hpp>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+namespace {
+
+//	Received in pieces of about the size of a TCP
+//	segment as when decrypting as data arrives
+constexpr std::size_t piece = 1460;
+constexpr std::size_t pieces = 64;
+
+const unsigned char key [] = {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C};
+
+class context_deleter {
+public:
+	void operator () (EVP_CIPHER_CTX * ctx) const noexcept {
+		EVP_CIPHER_CTX_free(ctx);
+	}
+};
+
+using context_ptr = std::unique_ptr<EVP_CIPHER_CTX, context_deleter>;
+
+//	The straightforward approach: OpenSSL's own CFB8
+//	mode, which performs a block operation for each
+//	byte in turn
+context_ptr make_context (int enc) {
+	context_ptr retr(EVP_CIPHER_CTX_new());
+	if (!retr || (EVP_CipherInit_ex(retr.get(), EVP_aes_128_cfb8(), nullptr, key, key, enc) != 1)) throw std::runtime_error("EVP_CipherInit_ex failed");
+	return retr;
+}
+
+void run (runner & r) {
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<unsigned> dist(0, 255);
+	std::vector<unsigned char> buf(piece * pieces);
+	for (auto && c : buf) c = static_cast<unsigned char>(dist(gen));
+	auto each = [&] (auto func) {
+		for (std::size_t i = 0; i < pieces; ++i) func(buf.data() + (i * piece), piece);
+	};
+	//	The stream never ends so the contents of the
+	//	buffer are simply encrypted or decrypted again
+	//	and again
+	auto evp = [&] (EVP_CIPHER_CTX * ctx) {
+		each([&] (unsigned char * ptr, std::size_t size) {
+			int written;
+			if (EVP_CipherUpdate(ctx, ptr, &written, ptr, int(size)) != 1) throw std::runtime_error("EVP_CipherUpdate failed");
+		});
+	};
+	auto evp_decrypt = make_context(0);
+	r.measure("cfb8/decrypt/evp", pieces, buf.size(), [&] () {	evp(evp_decrypt.get());	});
+	cfb8_decryptor d(key);
+	r.measure("cfb8/decrypt", pieces, buf.size(), [&] () {
+		each([&] (unsigned char * ptr, std::size_t size) {	d.decrypt(ptr, size);	});
+	});
+	auto evp_encrypt = make_context(1);
+	r.measure("cfb8/encrypt/evp", pieces, buf.size(), [&] () {	evp(evp_encrypt.get());	});
+	cfb8_encryptor e(key);
+	r.measure("cfb8/encrypt", pieces, buf.size(), [&] () {
+		each([&] (unsigned char * ptr, std::size_t size) {	e.encrypt(ptr, size);	});
+	});
+}
+
+const registration reg(&run);
+
+}
+}
+}
+}
@@ -0,0 +1,68 @@
+#include "bench.hpp"
+#include <mcpp/protocol/incremental_varint_parser.hpp>
+#include <mcpp/protocol/varint.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
+#include <mcpp/buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+namespace {
+
+using vectorbuf = boost::interprocess::basic_vectorbuf<std::vector<char>>;
+
+constexpr std::size_t elements = 4096;
+
+//	Packet length prefixes: most packets are small
+//	but chunk data and the like run to kilobytes
+std::vector<std::uint32_t> make_lengths () {
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<int> pick(0, 9);
+	std::uniform_int_distribution<std::uint32_t> small(1, 127);
+	std::uniform_int_distribution<std::uint32_t> large(128, 1 << 21);
+	std::vector<std::uint32_t> retr;
+	for (std::size_t i = 0; i < elements; ++i) retr.push_back((pick(gen) < 7) ? small(gen) : large(gen));
+	return retr;
+}
+
+void run (runner & r) {
+	auto lengths = make_lengths();
+	vectorbuf encoded;
+	for (auto i : lengths) serialize_varint(i, encoded);
+	auto && v = encoded.vector();
+	incremental_varint_parser<std::uint32_t> parser;
+	r.measure("incremental_varint_parser/whole", elements, v.size(), [&] () {
+		buffer b(v.data(), v.size());
+		for (std::size_t i = 0; i < elements; ++i) {
+			parser.reset();
+			auto result = parser.parse(b);
+			if (!(result && *result)) throw std::runtime_error("Parse failed");
+		}
+	});
+	//	The worst case: every byte arrives in a
+	//	separate read
+	r.measure("incremental_varint_parser/bytewise", elements, v.size(), [&] () {
+		auto ptr = v.data();
+		for (std::size_t i = 0; i < elements; ++i) {
+			parser.reset();
+			for (;;) {
+				buffer b(ptr++, 1);
+				auto result = parser.parse(b);
+				if (!result) throw std::runtime_error("Parse failed");
+				if (*result) break;
+			}
+		}
+	});
+}
+
+const registration reg(&run);
+
+}
+}
+}
+}
@@ -0,0 +1,63 @@
+#include "bench.hpp"
+#include <mcpp/protocol/int.hpp>
+#include <mcpp/protocol/span.hpp>
+#include <mcpp/buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+namespace {
+
+constexpr std::size_t elements = 4096;
+
+//	Block states and heightmaps are sent as arrays
+//	of longs, positions as single longs
+template <typename T>
+void run_type (runner & r, const char * type) {
+	std::mt19937_64 gen(0);
+	std::vector<T> values(elements);
+	for (auto && v : values) v = T(gen());
+	std::vector<char> storage(values.size() * sizeof(T));
+	std::vector<T> out(values.size());
+	std::string prefix("int/");
+	prefix += type;
+	r.measure(prefix + "/serialize/streambuf", elements, storage.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		for (auto i : values) serialize_int(i, b);
+	});
+	r.measure(prefix + "/serialize_array/streambuf", elements, storage.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		serialize_int_array(values.data(), values.size(), b);
+	});
+	r.measure(prefix + "/parse/streambuf", elements, storage.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		for (auto && i : out) if (!parse_int(b, i)) throw std::runtime_error("Parse failed");
+	});
+	r.measure(prefix + "/parse/span", elements, storage.size(), [&] () {
+		span_reader s(storage.data(), storage.size());
+		for (auto && i : out) if (!parse_int(s, i)) throw std::runtime_error("Parse failed");
+	});
+	r.measure(prefix + "/parse_array/streambuf", elements, storage.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		if (!parse_int_array(b, out.data(), out.size())) throw std::runtime_error("Parse failed");
+	});
+}
+
+void run (runner & r) {
+	run_type<std::uint16_t>(r, "u16");
+	run_type<std::int32_t>(r, "i32");
+	run_type<std::int64_t>(r, "i64");
+}
+
+const registration reg(&run);
+
+}
+}
+}
+}
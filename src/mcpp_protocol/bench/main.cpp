@@ -0,0 +1,138 @@
+#include "bench.hpp"
+#include <mcpp/protocol/byte_swap.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+namespace {
+
+class summary {
+public:
+	double ns_per_op;
+	double min_ns_per_op;
+	double p50_ns_per_op;
+	double p99_ns_per_op;
+	double ops_per_s;
+	double mb_per_s;
+};
+
+summary summarize (const result & r) {
+	auto samples = r.samples;
+	std::sort(samples.begin(), samples.end());
+	double ops(r.operations);
+	double total(0);
+	for (auto s : samples) total += s;
+	auto percentile = [&] (double p) {
+		std::size_t i(p * double(samples.size() - 1));
+		return samples[i] / ops;
+	};
+	summary retr;
+	retr.ns_per_op = total / (ops * double(samples.size()));
+	retr.min_ns_per_op = samples.front() / ops;
+	retr.p50_ns_per_op = percentile(0.5);
+	retr.p99_ns_per_op = percentile(0.99);
+	retr.ops_per_s = 1e9 / retr.ns_per_op;
+	retr.mb_per_s = (double(r.bytes) * double(samples.size()) * 1e3) / total;
+	return retr;
+}
+
+void write_text (const std::vector<result> & results) {
+	std::cout << "byte_swap: " << byte_swap_implementation() << "\n"
+		<< std::left << std::setw(48) << "benchmark"
+		<< std::right << std::setw(12) << "ns/op"
+		<< std::setw(12) << "p50"
+		<< std::setw(12) << "p99"
+		<< std::setw(12) << "MB/s"
+		<< std::setw(10) << "batches" << "\n";
+	std::cout << std::fixed << std::setprecision(2);
+	for (auto && r : results) {
+		auto s = summarize(r);
+		std::cout << std::left << std::setw(48) << r.name
+			<< std::right << std::setw(12) << s.ns_per_op
+			<< std::setw(12) << s.p50_ns_per_op
+			<< std::setw(12) << s.p99_ns_per_op
+			<< std::setw(12) << s.mb_per_s
+			<< std::setw(10) << r.samples.size() << "\n";
+	}
+	std::cout << std::flush;
+}
+
+void write_json (const std::vector<result> & results) {
+	std::cout << "{\n\t\"context\": {\n\t\t\"byte_swap\": \"" << byte_swap_implementation() << "\"\n\t},\n\t\"benchmarks\": [";
+	std::cout << std::setprecision(6);
+	bool first = true;
+	for (auto && r : results) {
+		auto s = summarize(r);
+		if (!first) std::cout << ",";
+		first = false;
+		//	Names are chosen by the benchmarks themselves
+		//	and never need escaping
+		std::cout << "\n\t\t{"
+			<< "\"name\": \"" << r.name << "\", "
+			<< "\"operations\": " << r.operations << ", "
+			<< "\"bytes\": " << r.bytes << ", "
+			<< "\"batches\": " << r.samples.size() << ", "
+			<< "\"ns_per_op\": " << s.ns_per_op << ", "
+			<< "\"min_ns_per_op\": " << s.min_ns_per_op << ", "
+			<< "\"p50_ns_per_op\": " << s.p50_ns_per_op << ", "
+			<< "\"p99_ns_per_op\": " << s.p99_ns_per_op << ", "
+			<< "\"ops_per_s\": " << s.ops_per_s << ", "
+			<< "\"mb_per_s\": " << s.mb_per_s
+			<< "}";
+	}
+	std::cout << "\n\t]\n}" << std::endl;
+}
+
+void usage (const char * name) {
+	std::cerr << "Usage: " << name << " [--format=text|json] [--filter=SUBSTRING] [--min-time=SECONDS] [--min-batches=N]" << std::endl;
+}
+
+bool starts_with (const char * str, const char * prefix, const char * & rest) noexcept {
+	std::size_t len(std::strlen(prefix));
+	if (std::strncmp(str, prefix, len) != 0) return false;
+	rest = str + len;
+	return true;
+}
+
+}
+}
+}
+}
+
+int main (int argc, char ** argv) {
+	using namespace mcpp::protocol::bench;
+	options opts;
+	bool json = false;
+	for (int i = 1; i < argc; ++i) {
+		const char * value;
+		if (starts_with(argv[i], "--format=", value)) {
+			if (std::strcmp(value, "json") == 0) json = true;
+			else if (std::strcmp(value, "text") != 0) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (starts_with(argv[i], "--filter=", value)) {
+			opts.filter = value;
+		} else if (starts_with(argv[i], "--min-time=", value)) {
+			opts.min_time = std::atof(value);
+		} else if (starts_with(argv[i], "--min-batches=", value)) {
+			opts.min_batches = std::size_t(std::atol(value));
+		} else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	runner r(opts);
+	for (auto b : registry()) b(r);
+	if (json) write_json(r.results());
+	else write_text(r.results());
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+#include "bench.hpp"
+#include <mcpp/protocol/stream_serializer.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <mcpp/buffer.hpp>
+#include <mcpp/protocol/compression_policy.hpp>
+#include <mcpp/protocol/compression_pool.hpp>
+#include <mcpp/protocol/direction.hpp>
+#include <mcpp/protocol/framed_packet.hpp>
+#include <mcpp/protocol/handshaking.hpp>
+#include <mcpp/protocol/packet_serializer_map.hpp>
+#include <mcpp/protocol/state.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+namespace {
+
+using vectorbuf = boost::interprocess::basic_vectorbuf<std::vector<char>>;
+using stream_serializer_type = stream_serializer<buffer, buffer>;
+
+constexpr std::size_t elements = 512;
+constexpr std::size_t threshold = 256;
+
+std::unique_ptr<stream_serializer_type> make_serializer (bool compressed, direction d = direction::serverbound) {
+	std::unique_ptr<stream_serializer_type> retr(new stream_serializer_type(
+		packet_serializer_map<
+			stream_serializer_type::inner_source_type,
+			stream_serializer_type::inner_sink_type
+		>(),
+		d
+	));
+	if (compressed) retr->enable_compression(threshold);
+	return retr;
+}
+
+//	Only handshakes may be serialized, their server
+//	address is varied so that packet sizes follow the
+//	same long tailed distribution as real traffic and
+//	some fraction exceed the compression threshold
+std::vector<handshaking::serverbound::handshake> make_packets () {
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<int> pick(0, 99);
+	std::uniform_int_distribution<std::size_t> small(8, 64);
+	std::uniform_int_distribution<std::size_t> medium(64, 255);
+	std::uniform_int_distribution<std::size_t> large(256, 4096);
+	std::uniform_int_distribution<int> word(0, 7);
+	static const char * const words [] = {"mc", "play", "server", "example", "net", "lobby", "eu", "node"};
+	std::vector<handshaking::serverbound::handshake> retr(elements);
+	for (auto && p : retr) {
+		auto c = pick(gen);
+		std::size_t len = (c < 70) ? small(gen) : ((c < 90) ? medium(gen) : large(gen));
+		//	Repetitive text compresses about as well as
+		//	typical packet bodies
+		while (p.server_address.size() < len) {
+			p.server_address += words[word(gen)];
+			p.server_address.push_back('.');
+		}
+		p.protocol_version = 316;
+		p.server_port = 25565;
+		p.next_state = state::login;
+	}
+	return retr;
+}
+
+void run_mode (runner & r, bool compressed) {
+	auto packets = make_packets();
+	auto ser = make_serializer(compressed);
+	std::string prefix("stream_serializer/");
+	prefix += compressed ? "compressed" : "uncompressed";
+	vectorbuf encoded;
+	{
+		std::vector<char> scratch(1 << 16);
+		for (auto && p : packets) {
+			buffer b(scratch.data(), scratch.size());
+			ser->serialize(p, b);
+			encoded.sputn(scratch.data(), std::streamsize(b.written()));
+		}
+	}
+	auto && v = encoded.vector();
+	std::vector<char> storage(v.size());
+	r.measure(prefix + "/serialize", elements, v.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		for (auto && p : packets) ser->serialize(p, b);
+	});
+	r.measure(prefix + "/serialize_batch", elements, v.size(), [&] () {
+		if (ser->serialize_batch(packets.begin(), packets.end()).bytes() != v.size()) throw std::runtime_error("Serialize failed");
+	});
+	r.measure(prefix + "/serialize_buffers", elements, v.size(), [&] () {
+		std::size_t bytes(0);
+		for (auto && p : packets) bytes += ser->serialize(p).bytes();
+		if (bytes != v.size()) throw std::runtime_error("Serialize failed");
+	});
+	auto parse = [&] () {
+		buffer b(v.data(), v.size());
+		for (std::size_t i = 0; i < elements; ++i) {
+			auto result = ser->parse(b);
+			if (!(result && *result)) throw std::runtime_error("Parse failed");
+		}
+	};
+	r.measure(prefix + "/parse", elements, v.size(), parse);
+	//	Draining everything received by a single read
+	auto parse_all = [&] () {
+		buffer b(v.data(), v.size());
+		auto result = ser->parse_all(b, [] (auto &) noexcept {	});
+		if (!(result && (*result == elements))) throw std::runtime_error("Parse failed");
+	};
+	r.measure(prefix + "/parse_all", elements, v.size(), parse_all);
+	ser->parse_in_place(true);
+	r.measure(prefix + "/parse_in_place", elements, v.size(), parse);
+	r.measure(prefix + "/parse_all_in_place", elements, v.size(), parse_all);
+	ser->parse_in_place(false);
+	//	Forwarding every packet to another connection with
+	//	the same settings, as a proxy does
+	r.measure(prefix + "/relay", elements, v.size(), [&] () {
+		buffer in(v.data(), v.size());
+		buffer out(storage.data(), storage.size());
+		for (std::size_t i = 0; i < elements; ++i) {
+			auto result = ser->parse(in);
+			if (!(result && *result)) throw std::runtime_error("Parse failed");
+			ser->serialize(ser->packet(), out);
+		}
+	});
+	r.measure(prefix + "/relay_raw", elements, v.size(), [&] () {
+		buffer in(v.data(), v.size());
+		buffer out(storage.data(), storage.size());
+		for (std::size_t i = 0; i < elements; ++i) {
+			auto result = ser->parse_raw_frame(in);
+			if (!(result && *result)) throw std::runtime_error("Parse failed");
+			ser->serialize_raw_frame(ser->parsed_raw_frame(), out);
+		}
+	});
+	//	There are no clientbound packets in the handshaking
+	//	state so a clientbound serializer parses nothing, as
+	//	a proxy does for most of the packets passing through
+	//	it
+	auto unregistered = make_serializer(compressed, direction::clientbound);
+	auto parse_unregistered = [&] () {
+		buffer b(v.data(), v.size());
+		for (std::size_t i = 0; i < elements; ++i) {
+			auto result = unregistered->parse(b);
+			if (!(result && *result)) throw std::runtime_error("Parse failed");
+		}
+	};
+	r.measure(prefix + "/parse_unregistered", elements, v.size(), parse_unregistered);
+	r.measure(prefix + "/parse_all_unregistered", elements, v.size(), [&] () {
+		buffer b(v.data(), v.size());
+		auto result = unregistered->parse_all(b, [] (auto &) noexcept {	});
+		if (!(result && (*result == elements))) throw std::runtime_error("Parse failed");
+	});
+	unregistered->parse_skip_unregistered(true);
+	r.measure(prefix + "/parse_skip_unregistered", elements, v.size(), parse_unregistered);
+	//	Writing packets which were framed up front, as
+	//	when broadcasting to many connections
+	std::vector<framed_packet> framed;
+	for (auto && p : packets) framed.push_back(ser->frame(p));
+	r.measure(prefix + "/serialize_framed", elements, v.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		for (auto && f : framed) ser->serialize(f, b);
+	});
+	if (!compressed) return;
+	//	The size of the output varies with the policy
+	//	so only the uncompressed bytes are counted
+	std::size_t uncompressed(0);
+	for (auto && p : packets) {
+		ser->serialize(p);
+		uncompressed += ser->serialized_size();
+	}
+	auto serialize = [&] () {
+		for (auto && p : packets) ser->serialize(p);
+	};
+	ser->compression_policy().set(compression_params{
+		boost::iostreams::zlib::best_speed,
+		boost::iostreams::zlib::default_strategy
+	});
+	r.measure(prefix + "/serialize_best_speed", elements, uncompressed, serialize);
+	ser->compression_policy().set(compression_params{
+		boost::iostreams::zlib::default_compression,
+		boost::iostreams::zlib::default_strategy
+	});
+	ser->compression_policy().enable_adaptive(100);
+	r.measure(prefix + "/serialize_adaptive", elements, uncompressed, serialize);
+	ser->compression_policy().disable_adaptive();
+	//	Only the large packets are offloaded, the time
+	//	includes waiting for the pool to finish
+	compression_pool pool(2);
+	ser->offload_threshold(threshold);
+	std::atomic<std::size_t> done(0);
+	std::atomic<bool> failed(false);
+	r.measure(prefix + "/serialize_async", elements, uncompressed, [&] () {
+		done = 0;
+		for (auto && p : packets) ser->serialize_async(p, pool, [&] (std::exception_ptr ex, framed_packet) {
+			if (ex) failed = true;
+			++done;
+		});
+		while (done != elements) std::this_thread::yield();
+		if (failed) throw std::runtime_error("Serialize failed");
+	});
+}
+
+void run (runner & r) {
+	run_mode(r, false);
+	run_mode(r, true);
+}
+
+const registration reg(&run);
+
+}
+}
+}
+}
@@ -0,0 +1,103 @@
+#include "bench.hpp"
+#include <mcpp/protocol/span.hpp>
+#include <mcpp/protocol/string.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
+#include <mcpp/buffer.hpp>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+namespace {
+
+using vectorbuf = boost::interprocess::basic_vectorbuf<std::vector<char>>;
+
+constexpr std::size_t elements = 1024;
+
+//	Mostly identifiers and player names, some chat
+//	messages, and the occasional JSON text component,
+//	a small fraction of which contain non-ASCII text
+std::vector<std::string> make_strings () {
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<int> pick(0, 99);
+	std::uniform_int_distribution<std::size_t> identifier(3, 16);
+	std::uniform_int_distribution<std::size_t> chat(16, 100);
+	std::uniform_int_distribution<std::size_t> component(100, 2000);
+	std::uniform_int_distribution<char> ascii('a', 'z');
+	std::vector<std::string> retr;
+	for (std::size_t i = 0; i < elements; ++i) {
+		auto p = pick(gen);
+		std::size_t len = (p < 60) ? identifier(gen) : ((p < 90) ? chat(gen) : component(gen));
+		std::string str;
+		while (str.size() < len) {
+			if (pick(gen) == 0) str += u8"é€";
+			else str.push_back(ascii(gen));
+		}
+		retr.push_back(std::move(str));
+	}
+	return retr;
+}
+
+void run (runner & r) {
+	auto strings = make_strings();
+	vectorbuf encoded;
+	for (auto && s : strings) serialize_string(s, encoded);
+	auto && v = encoded.vector();
+	std::vector<std::u16string> wide;
+	buffer wb(v.data(), v.size());
+	for (std::size_t i = 0; i < elements; ++i) {
+		auto result = parse_string<char16_t>(wb);
+		if (!result) throw std::runtime_error("Parse failed");
+		wide.push_back(std::move(*result));
+	}
+	std::vector<std::string> out(strings.size());
+	r.measure("string/parse/streambuf", elements, v.size(), [&] () {
+		buffer b(v.data(), v.size());
+		for (auto && s : out) if (!parse_string(b, s)) throw std::runtime_error("Parse failed");
+	});
+	r.measure("string/parse/span", elements, v.size(), [&] () {
+		span_reader sr(v.data(), v.size());
+		for (auto && s : out) {
+			auto result = parse_string(sr);
+			if (!result) throw std::runtime_error("Parse failed");
+			s = std::move(*result);
+		}
+	});
+	r.measure("string/parse_view/span", elements, v.size(), [&] () {
+		span_reader sr(v.data(), v.size());
+		for (std::size_t i = 0; i < elements; ++i) if (!parse_string_view(sr)) throw std::runtime_error("Parse failed");
+	});
+	std::vector<std::u16string> wide_out(wide.size());
+	r.measure("string/parse_utf16/streambuf", elements, v.size(), [&] () {
+		buffer b(v.data(), v.size());
+		for (auto && s : wide_out) {
+			auto result = parse_string<char16_t>(b);
+			if (!result) throw std::runtime_error("Parse failed");
+			s = std::move(*result);
+		}
+	});
+	std::vector<char> storage(v.size());
+	r.measure("string/serialize/streambuf", elements, v.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		for (auto && s : strings) serialize_string(s, b);
+	});
+	r.measure("string/serialize/span", elements, v.size(), [&] () {
+		span_writer sw(storage.data(), storage.size());
+		for (auto && s : strings) serialize_string(s, sw);
+	});
+	r.measure("string/serialize_utf16/streambuf", elements, v.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		for (auto && s : wide) serialize_string(s, b);
+	});
+}
+
+const registration reg(&run);
+
+}
+}
+}
+}
@@ -0,0 +1,72 @@
+#include "bench.hpp"
+#include <mcpp/protocol/span.hpp>
+#include <mcpp/protocol/varint.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
+#include <mcpp/buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+namespace bench {
+namespace {
+
+using vectorbuf = boost::interprocess::basic_vectorbuf<std::vector<char>>;
+
+constexpr std::size_t elements = 4096;
+
+//	Palette indices and entity IDs: mostly small
+//	with the occasional large value
+std::vector<std::int32_t> make_values () {
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<std::int32_t> small(0, 127);
+	std::uniform_int_distribution<std::int32_t> large(128, 1 << 24);
+	std::uniform_int_distribution<int> pick(0, 9);
+	std::vector<std::int32_t> retr;
+	for (std::size_t i = 0; i < elements; ++i) retr.push_back((pick(gen) == 0) ? large(gen) : small(gen));
+	return retr;
+}
+
+void run (runner & r) {
+	auto values = make_values();
+	vectorbuf encoded;
+	encoded.reserve(values.size() * varint_size<std::int32_t>);
+	for (auto i : values) serialize_varint(i, encoded);
+	auto && v = encoded.vector();
+	std::vector<std::int32_t> out(values.size());
+	r.measure("varint/parse/streambuf", elements, v.size(), [&] () {
+		buffer b(v.data(), v.size());
+		for (auto && i : out) if (!parse_varint(b, i)) throw std::runtime_error("Parse failed");
+	});
+	r.measure("varint/parse/span", elements, v.size(), [&] () {
+		span_reader s(v.data(), v.size());
+		for (auto && i : out) if (!parse_varint(s, i)) throw std::runtime_error("Parse failed");
+	});
+	r.measure("varint/parse_array/streambuf", elements, v.size(), [&] () {
+		buffer b(v.data(), v.size());
+		if (!parse_varint_array(b, out.data(), out.size())) throw std::runtime_error("Parse failed");
+	});
+	std::vector<char> storage(v.size());
+	r.measure("varint/serialize/streambuf", elements, v.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		for (auto i : values) serialize_varint(i, b);
+	});
+	r.measure("varint/serialize/span", elements, v.size(), [&] () {
+		span_writer s(storage.data(), storage.size());
+		for (auto i : values) serialize_varint(i, s);
+	});
+	r.measure("varint/serialize_array/streambuf", elements, v.size(), [&] () {
+		buffer b(storage.data(), storage.size());
+		serialize_varint_array(values.data(), values.size(), b);
+	});
+}
+
+const registration reg(&run);
+
+}
+}
+}
+}
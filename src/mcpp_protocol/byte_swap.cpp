@@ -0,0 +1,163 @@
+#ifdef MCPP_HAS_BOOST_ENDIAN_CONVERSION
+#include <boost/endian/conversion.hpp>
+#else
+#include <boost/endian/endian.hpp>
+#endif
+#include <mcpp/protocol/byte_swap.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+//	Kernels for instruction sets beyond the compiler's
+//	target are compiled with per function target
+//	attributes and selected by querying the processor
+//	at runtime, this is only supported on GCC and Clang
+//	for x86
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MCPP_BYTE_SWAP_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace mcpp {
+namespace protocol {
+
+namespace {
+
+using kernel_type = void (*) (const unsigned char *, unsigned char *, std::size_t);
+
+template <typename T>
+void byte_swap_scalar (const unsigned char * src, unsigned char * dst, std::size_t n) noexcept {
+	for (; n != 0; --n, src += sizeof(T), dst += sizeof(T)) {
+		T val;
+		std::memcpy(&val, src, sizeof(T));
+		boost::endian::endian_reverse_inplace(val);
+		std::memcpy(dst, &val, sizeof(T));
+	}
+}
+
+#ifdef MCPP_BYTE_SWAP_DISPATCH
+
+//	The shuffle control which reverses each object
+//	of size Size within a 16 byte lane
+template <std::size_t Size>
+struct byte_swap_mask {
+	unsigned char value [16];
+	constexpr byte_swap_mask () noexcept : value() {
+		for (std::size_t i = 0; i < 16; ++i) value[i] = static_cast<unsigned char>(((i / Size) * Size) + (Size - 1 - (i % Size)));
+	}
+};
+
+template <std::size_t Size>
+__attribute__((target("ssse3")))
+void byte_swap_ssse3 (const unsigned char * src, unsigned char * dst, std::size_t n) noexcept {
+	static constexpr byte_swap_mask<Size> mask{};
+	const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask.value));
+	constexpr std::size_t per = 16 / Size;
+	for (; n >= per; n -= per, src += 16, dst += 16) {
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(block, control));
+	}
+	using type = std::conditional_t<Size == 2, std::uint16_t, std::conditional_t<Size == 4, std::uint32_t, std::uint64_t>>;
+	byte_swap_scalar<type>(src, dst, n);
+}
+
+template <std::size_t Size>
+__attribute__((target("avx2")))
+void byte_swap_avx2 (const unsigned char * src, unsigned char * dst, std::size_t n) noexcept {
+	static constexpr byte_swap_mask<Size> mask{};
+	//	vpshufb shuffles within each 128 bit lane
+	//	independently so the same control is used
+	//	for both lanes
+	const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask.value));
+	const __m256i control = _mm256_broadcastsi128_si256(half);
+	constexpr std::size_t per = 32 / Size;
+	//	Two blocks per iteration keeps both shuffle
+	//	ports busy
+	for (; n >= (per * 2); n -= per * 2, src += 64, dst += 64) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 32));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_shuffle_epi8(a, control));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_shuffle_epi8(b, control));
+	}
+	for (; n >= per; n -= per, src += 32, dst += 32) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_shuffle_epi8(a, control));
+	}
+	if (n >= (16 / Size)) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(a, half));
+		n -= 16 / Size;
+		src += 16;
+		dst += 16;
+	}
+	using type = std::conditional_t<Size == 2, std::uint16_t, std::conditional_t<Size == 4, std::uint32_t, std::uint64_t>>;
+	byte_swap_scalar<type>(src, dst, n);
+}
+
+#endif
+
+class byte_swap_kernels {
+public:
+	kernel_type k16;
+	kernel_type k32;
+	kernel_type k64;
+	const char * name;
+	byte_swap_kernels () noexcept
+		:	k16(&byte_swap_scalar<std::uint16_t>),
+			k32(&byte_swap_scalar<std::uint32_t>),
+			k64(&byte_swap_scalar<std::uint64_t>),
+			name("scalar")
+	{
+#ifdef MCPP_BYTE_SWAP_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			k16 = &byte_swap_avx2<2>;
+			k32 = &byte_swap_avx2<4>;
+			k64 = &byte_swap_avx2<8>;
+			name = "avx2";
+		} else if (__builtin_cpu_supports("ssse3")) {
+			k16 = &byte_swap_ssse3<2>;
+			k32 = &byte_swap_ssse3<4>;
+			k64 = &byte_swap_ssse3<8>;
+			name = "ssse3";
+		}
+#endif
+	}
+};
+
+const byte_swap_kernels & get_kernels () noexcept {
+	static const byte_swap_kernels retr;
+	return retr;
+}
+
+}
+
+void byte_swap (const void * src, void * dst, std::size_t n, std::size_t size) noexcept {
+	auto s = static_cast<const unsigned char *>(src);
+	auto d = static_cast<unsigned char *>(dst);
+	auto && kernels = get_kernels();
+	switch (size) {
+	case 1:
+		if (s != d) std::memcpy(d, s, n);
+		break;
+	case 2:
+		kernels.k16(s, d, n);
+		break;
+	case 4:
+		kernels.k32(s, d, n);
+		break;
+	default:
+		assert(size == 8);
+		kernels.k64(s, d, n);
+		break;
+	}
+}
+
+const char * byte_swap_implementation () noexcept {
+	return get_kernels().name;
+}
+
+}
+}
@@ -0,0 +1,111 @@
+#include <mcpp/protocol/cfb8.hpp>
+#include <mcpp/protocol/exception.hpp>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <new>
+
+namespace mcpp {
+namespace protocol {
+
+namespace {
+
+//	OpenSSL describes the size of its buffers with
+//	int, larger buffers are supplied in pieces
+constexpr std::size_t max_chunk = std::numeric_limits<int>::max();
+//	The number of bytes decrypted by each ECB call, the
+//	inputs to their block operations occupy sixteen times
+//	as many bytes
+constexpr std::size_t decrypt_chunk = 128;
+constexpr std::size_t block_size = 16;
+
+[[noreturn]] void throw_cipher_error () {
+	auto code = ERR_get_error();
+	ERR_clear_error();
+	if (code == 0) throw cipher_error("Unknown OpenSSL error");
+	char buffer [256];
+	ERR_error_string_n(code, buffer, sizeof(buffer));
+	throw cipher_error(buffer);
+}
+
+void check (int result) {
+	if (result != 1) throw_cipher_error();
+}
+
+detail::cipher_context_ptr make_context (const EVP_CIPHER * cipher, const unsigned char * key, const unsigned char * iv) {
+	detail::cipher_context_ptr retr(EVP_CIPHER_CTX_new());
+	if (!retr) throw std::bad_alloc();
+	check(EVP_EncryptInit_ex(retr.get(), cipher, nullptr, key, iv));
+	check(EVP_CIPHER_CTX_set_padding(retr.get(), 0));
+	return retr;
+}
+
+}
+
+namespace detail {
+
+void cipher_context_deleter::operator () (evp_cipher_ctx_st * ctx) const noexcept {
+	EVP_CIPHER_CTX_free(ctx);
+}
+
+}
+
+cfb8_encryptor::cfb8_encryptor (const unsigned char (& key) [16])
+	:	cfb8_encryptor(key, key)
+{	}
+
+cfb8_encryptor::cfb8_encryptor (const unsigned char (& key) [16], const unsigned char (& iv) [16])
+	:	ctx_(make_context(EVP_aes_128_cfb8(), key, iv))
+{	}
+
+void cfb8_encryptor::encrypt (void * ptr, std::size_t size) {
+	auto p = static_cast<unsigned char *>(ptr);
+	while (size != 0) {
+		auto n = std::min(size, max_chunk);
+		int written;
+		check(EVP_EncryptUpdate(ctx_.get(), p, &written, p, int(n)));
+		p += n;
+		size -= n;
+	}
+}
+
+cfb8_decryptor::cfb8_decryptor (const unsigned char (& key) [16])
+	:	cfb8_decryptor(key, key)
+{	}
+
+cfb8_decryptor::cfb8_decryptor (const unsigned char (& key) [16], const unsigned char (& iv) [16])
+	:	ctx_(make_context(EVP_aes_128_ecb(), key, nullptr))
+{
+	std::memcpy(register_, iv, sizeof(register_));
+}
+
+void cfb8_decryptor::decrypt (void * ptr, std::size_t size) {
+	auto p = static_cast<unsigned char *>(ptr);
+	//	The ciphertext preceded by the contents of the
+	//	shift register, the input to the block operation
+	//	for the byte at offset i is the sixteen bytes at
+	//	offset i
+	unsigned char history [block_size + decrypt_chunk];
+	unsigned char blocks [block_size * decrypt_chunk];
+	std::memcpy(history, register_, block_size);
+	while (size != 0) {
+		auto n = std::min(size, decrypt_chunk);
+		std::memcpy(history + block_size, p, n);
+		for (std::size_t i = 0; i < n; ++i) std::memcpy(blocks + (i * block_size), history + i, block_size);
+		int written;
+		check(EVP_EncryptUpdate(ctx_.get(), blocks, &written, blocks, int(n * block_size)));
+		//	Only the first byte of each block's output
+		//	is used
+		for (std::size_t i = 0; i < n; ++i) p[i] ^= blocks[i * block_size];
+		std::memmove(history, history + n, block_size);
+		p += n;
+		size -= n;
+	}
+	std::memcpy(register_, history, block_size);
+}
+
+}
+}
@@ -0,0 +1,158 @@
+#include <mcpp/protocol/compression_policy.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <mcpp/protocol/packet_id.hpp>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace mcpp {
+namespace protocol {
+
+namespace {
+
+//	Each observation's weight decays by this factor
+//	with each subsequent observation
+constexpr double decay = 63.0 / 64.0;
+//	Fewer observations than this and the estimate
+//	is not trusted
+constexpr double min_weight = 8;
+//	One in this many packets below the effective
+//	threshold is deflated anyway
+constexpr std::size_t probe_interval = 32;
+
+}
+
+bool operator == (const compression_params & lhs, const compression_params & rhs) noexcept {
+	return (lhs.level == rhs.level) && (lhs.strategy == rhs.strategy);
+}
+
+bool operator != (const compression_params & lhs, const compression_params & rhs) noexcept {
+	return !(lhs == rhs);
+}
+
+compression_policy::compression_policy () noexcept
+	:	compression_policy(compression_params{
+			boost::iostreams::zlib::default_compression,
+			boost::iostreams::zlib::default_strategy
+		})
+{	}
+
+compression_policy::compression_policy (compression_params params) noexcept
+	:	default_(params),
+		adaptive_(false),
+		min_saved_per_ns_(0)
+{
+	disable_adaptive();
+}
+
+compression_policy::compression_policy (const boost::iostreams::zlib_params & params) noexcept
+	:	compression_policy(compression_params{params.level, params.strategy})
+{	}
+
+const compression_params & compression_policy::get () const noexcept {
+	return default_;
+}
+
+const compression_params & compression_policy::get (const packet_id & id) const noexcept {
+	auto iter = params_.find(id);
+	if (iter == params_.end()) return default_;
+	return iter->second;
+}
+
+void compression_policy::set (compression_params params) noexcept {
+	default_ = params;
+}
+
+void compression_policy::set (const packet_id & id, compression_params params) {
+	params_[id] = params;
+}
+
+void compression_policy::unset (const packet_id & id) noexcept {
+	params_.erase(id);
+}
+
+void compression_policy::enable_adaptive (double min_saved_per_us) noexcept {
+	adaptive_ = true;
+	min_saved_per_ns_ = min_saved_per_us / 1000.0;
+	update_threshold();
+}
+
+void compression_policy::disable_adaptive () noexcept {
+	adaptive_ = false;
+	threshold_ = 0;
+	since_probe_ = 0;
+	weight_ = 0;
+	size_ = 0;
+	time_ = 0;
+	size_size_ = 0;
+	size_time_ = 0;
+	saved_ = 0;
+}
+
+bool compression_policy::adaptive () const noexcept {
+	return adaptive_;
+}
+
+std::size_t compression_policy::effective_threshold () const noexcept {
+	return threshold_;
+}
+
+compression_params compression_policy::select (const packet_id & id, std::size_t size) noexcept {
+	auto && retr = get(id);
+	if (!adaptive_ || (size >= threshold_) || (retr.level == boost::iostreams::zlib::no_compression)) return retr;
+	if (++since_probe_ == probe_interval) {
+		since_probe_ = 0;
+		return retr;
+	}
+	return compression_params{boost::iostreams::zlib::no_compression, boost::iostreams::zlib::default_strategy};
+}
+
+void compression_policy::record (std::size_t size, std::size_t compressed, double ns) noexcept {
+	if (!adaptive_) return;
+	double n(size);
+	weight_ = (weight_ * decay) + 1;
+	size_ = (size_ * decay) + n;
+	time_ = (time_ * decay) + ns;
+	size_size_ = (size_size_ * decay) + (n * n);
+	size_time_ = (size_time_ * decay) + (n * ns);
+	saved_ = (saved_ * decay) + (n - double(compressed));
+	update_threshold();
+}
+
+void compression_policy::update_threshold () noexcept {
+	if ((weight_ < min_weight) || (size_ <= 0)) {
+		threshold_ = 0;
+		return;
+	}
+	//	The time taken to compress n bytes is modelled
+	//	as a + bn and the number of bytes saved as sn,
+	//	deflating is worthwhile if sn >= k(a + bn) where
+	//	k is the minimum number of bytes saved per
+	//	nanosecond
+	double mean_size = size_ / weight_;
+	double mean_time = time_ / weight_;
+	double variance = (size_size_ / weight_) - (mean_size * mean_size);
+	double b;
+	//	If all observations are of (nearly) the same
+	//	size the fixed and per byte costs cannot be
+	//	told apart, but then both yield the same
+	//	decision at that size
+	if (variance > (mean_size * mean_size * 1e-6)) b = ((size_time_ / weight_) - (mean_size * mean_time)) / variance;
+	else b = mean_time / mean_size;
+	if (b < 0) b = 0;
+	double a = mean_time - (b * mean_size);
+	if (a < 0) a = 0;
+	double s = saved_ / size_;
+	double k = min_saved_per_ns_;
+	double denominator = s - (k * b);
+	if (denominator <= 0) {
+		threshold_ = std::numeric_limits<std::size_t>::max();
+		return;
+	}
+	double threshold = std::ceil((k * a) / denominator);
+	if (threshold >= double(std::numeric_limits<std::size_t>::max())) threshold_ = std::numeric_limits<std::size_t>::max();
+	else threshold_ = std::size_t(threshold);
+}
+
+}
+}
@@ -0,0 +1,121 @@
+#include <mcpp/protocol/compression_pool.hpp>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+namespace mcpp {
+namespace protocol {
+
+compression_worker::compression_worker (const boost::iostreams::zlib_params & params)
+	:	deflate(params)
+{	}
+
+void compression_pool::run (const boost::iostreams::zlib_params & params) {
+	compression_worker w(params);
+	std::unique_lock<std::mutex> lock(m_);
+	for (;;) {
+		cv_.wait(lock, [&] () noexcept {	return stop_ || !jobs_.empty();	});
+		if (jobs_.empty()) return;
+		auto j = std::move(jobs_.front());
+		jobs_.pop_front();
+		lock.unlock();
+		j(w);
+		lock.lock();
+	}
+}
+
+compression_pool::compression_pool (std::size_t threads, const boost::iostreams::zlib_params & params)
+	:	stop_(false)
+{
+	assert(threads != 0);
+	threads_.reserve(threads);
+	try {
+		for (std::size_t i = 0; i < threads; ++i) threads_.emplace_back([this, params] () {	run(params);	});
+	} catch (...) {
+		{
+			std::lock_guard<std::mutex> lock(m_);
+			stop_ = true;
+		}
+		cv_.notify_all();
+		for (auto && t : threads_) t.join();
+		throw;
+	}
+}
+
+compression_pool::~compression_pool () noexcept {
+	{
+		std::lock_guard<std::mutex> lock(m_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	for (auto && t : threads_) t.join();
+}
+
+void compression_pool::post (job j) {
+	{
+		std::lock_guard<std::mutex> lock(m_);
+		jobs_.push_back(std::move(j));
+	}
+	cv_.notify_one();
+}
+
+namespace detail {
+
+completion_queue::completion_queue () noexcept
+	:	head_(0),
+		delivering_(false)
+{	}
+
+std::size_t completion_queue::push (callback cb) {
+	std::lock_guard<std::mutex> lock(m_);
+	slots_.push_back(slot{std::move(cb), false, nullptr, framed_packet()});
+	return head_ + slots_.size() - 1;
+}
+
+void completion_queue::complete (std::size_t seq, std::exception_ptr ex, framed_packet p) {
+	{
+		std::lock_guard<std::mutex> lock(m_);
+		auto && s = slots_[seq - head_];
+		s.ready = true;
+		s.ex = std::move(ex);
+		s.p = std::move(p);
+	}
+	drain();
+}
+
+void completion_queue::drain () {
+	std::unique_lock<std::mutex> lock(m_);
+	//	Only one thread delivers at a time, otherwise
+	//	callbacks could run out of order, a thread which
+	//	completes a slot while another is delivering
+	//	leaves it to that thread
+	if (delivering_) return;
+	delivering_ = true;
+	while (!slots_.empty() && slots_.front().ready) {
+		auto s = std::move(slots_.front());
+		slots_.pop_front();
+		++head_;
+		lock.unlock();
+		try {
+			s.cb(std::move(s.ex), std::move(s.p));
+		} catch (...) {
+			lock.lock();
+			delivering_ = false;
+			throw;
+		}
+		lock.lock();
+	}
+	delivering_ = false;
+}
+
+std::size_t completion_queue::pending () const {
+	std::lock_guard<std::mutex> lock(m_);
+	return slots_.size();
+}
+
+}
+
+}
+}
@@ -1,4 +1,5 @@
 #include <mcpp/protocol/error.hpp>
+#include <boost/system/error_code.hpp>
 #include <stdexcept>
 #include <string>
 #include <system_error>
@@ -15,6 +16,9 @@ const std::string & to_string (error c) {
 	static const std::string inconsistent("Body shorter than indicated by length prefix");
 	static const std::string uncompressed("Uncompressed data where compressed data was expected");
 	static const std::string compressed("Compressed data where uncompressed data was expected");
+	static const std::string encoding("Text not well formed UTF-8");
+	static const std::string too_long("Length prefixed data longer than permitted");
+	static const std::string malformed("Malformed data");
 	switch (c) {
 	case error::end_of_file:
 		return eof;
@@ -32,26 +36,52 @@ const std::string & to_string (error c) {
 		return uncompressed;
 	case error::compressed:
 		return compressed;
+	case error::encoding:
+		return encoding;
+	case error::too_long:
+		return too_long;
+	case error::malformed:
+		return malformed;
 	default:
 		break;
 	}
 	throw std::logic_error("Unrecognized error code");
 }
 
-const std::error_category & error_category () {
-	static const class final : public std::error_category {
-	public:
-		virtual const char * name () const noexcept override {
-			return "Minecraft Protocol";
-		}
-		virtual std::string message (int condition) const override {
-			error e = static_cast<error>(condition);
-			return to_string(e);
-		}
-	} retr;
+namespace {
+
+//	Serves as a boost::system::error_category as well so
+//	that errors may be reported through Asio
+class error_category_impl final : public std::error_category, public boost::system::error_category {
+public:
+	virtual const char * name () const noexcept override {
+		return "Minecraft Protocol";
+	}
+	virtual std::string message (int condition) const override {
+		error e = static_cast<error>(condition);
+		return to_string(e);
+	}
+};
+
+}
+
+static const error_category_impl & get_error_category () {
+	static const error_category_impl retr;
 	return retr;
 }
 
+const std::error_category & error_category () {
+	return get_error_category();
+}
+
+namespace detail {
+
+const boost::system::error_category & boost_error_category () {
+	return get_error_category();
+}
+
+}
+
 std::error_code make_error_code (error e) noexcept {
 	return std::error_code(
 		static_cast<int>(e),
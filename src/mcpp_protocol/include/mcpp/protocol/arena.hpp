@@ -0,0 +1,370 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <mcpp/checked.hpp>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace mcpp {
+namespace protocol {
+
+/**
+ *	Memory from which the fields of parsed packets are
+ *	bump allocated and which is reclaimed all at once.
+ *
+ *	A monotonic_arena is only used by an \ref arena_allocator
+ *	while it is active, at other times \ref arena_allocator
+ *	objects defer to their upstream allocator. A
+ *	\ref stream_serializer whose allocator is an
+ *	\ref arena_allocator activates the arena only while
+ *	a packet is being parsed, and rewinds it once that
+ *	packet is discarded at the beginning of the next
+ *	parse. This matches the lifetime of the packet
+ *	returned by \ref stream_serializer::packet, and means
+ *	that once the arena has grown large enough parsing
+ *	packets does not allocate, no matter how many strings
+ *	or collections they contain.
+ *
+ *	Blocks obtained to satisfy allocations are obtained
+ *	from an upstream `Allocator`, are retained when the
+ *	arena is rewound, and are only returned when the
+ *	arena is destroyed.
+ *
+ *	Since rewinding invalidates everything allocated from
+ *	the arena only one \ref stream_serializer may parse
+ *	into a given arena (see \ref claim). Any number may
+ *	serialize packets whose fields were allocated thereby.
+ *
+ *	Objects of this type are not safe to use concurrently.
+ *	A monotonic_arena must outlive all \ref arena_allocator
+ *	objects which refer to it and all memory allocated
+ *	therefrom.
+ */
+class monotonic_arena {
+private:
+	//	Each block begins with this header, the memory
+	//	handed out follows it
+	class block {
+	public:
+		block * next;
+		std::size_t size;
+	};
+	//	The upstream Allocator with its type erased so
+	//	that the arena need not be a template
+	class upstream {
+	protected:
+		~upstream () noexcept = default;
+		static std::size_t units (std::size_t size) noexcept {
+			return (size / sizeof(std::max_align_t)) + (((size % sizeof(std::max_align_t)) == 0) ? 0 : 1);
+		}
+	public:
+		virtual void * allocate (std::size_t size) = 0;
+		virtual void deallocate (void * ptr, std::size_t size) noexcept = 0;
+		//	Destroys this object and returns its storage
+		//	to the Allocator it was obtained from
+		virtual void destroy () noexcept = 0;
+	};
+	template <typename Allocator>
+	class basic_upstream final : public upstream {
+	private:
+		using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<std::max_align_t>;
+		using traits = std::allocator_traits<allocator_type>;
+		using self_allocator_type = typename traits::template rebind_alloc<basic_upstream>;
+		using self_traits = std::allocator_traits<self_allocator_type>;
+		allocator_type alloc_;
+	public:
+		explicit basic_upstream (const Allocator & alloc) : alloc_(alloc) {	}
+		static upstream * create (const Allocator & alloc) {
+			self_allocator_type a(alloc);
+			auto ptr = self_traits::allocate(a, 1);
+			try {
+				self_traits::construct(a, ptr, alloc);
+			} catch (...) {
+				self_traits::deallocate(a, ptr, 1);
+				throw;
+			}
+			return ptr;
+		}
+		//	Memory is allocated in units of std::max_align_t
+		//	so that it is suitably aligned for any fundamental
+		//	type
+		virtual void * allocate (std::size_t size) override {
+			return traits::allocate(alloc_, units(size));
+		}
+		virtual void deallocate (void * ptr, std::size_t size) noexcept override {
+			traits::deallocate(alloc_, static_cast<std::max_align_t *>(ptr), units(size));
+		}
+		virtual void destroy () noexcept override {
+			self_allocator_type a(alloc_);
+			self_traits::destroy(a, this);
+			self_traits::deallocate(a, this, 1);
+		}
+	};
+	upstream * upstream_;
+	block * head_;
+	block * tail_;
+	block * current_;
+	std::size_t offset_;
+	std::size_t block_size_;
+	std::size_t active_;
+	const void * owner_;
+	//	Obtains blocks from std::allocator, is never
+	//	destroyed
+	static upstream * default_upstream () noexcept;
+public:
+	monotonic_arena (const monotonic_arena &) = delete;
+	monotonic_arena & operator = (const monotonic_arena &) = delete;
+	/**
+	 *	Creates a monotonic_arena which does not hold
+	 *	any memory and which obtains blocks from
+	 *	`std::allocator`.
+	 *
+	 *	\param [in] block_size
+	 *		The minimum size of each block of memory the
+	 *		arena obtains. Defaults to 4096.
+	 */
+	explicit monotonic_arena (std::size_t block_size = 4096) noexcept;
+	/**
+	 *	Creates a monotonic_arena which does not hold
+	 *	any memory and which obtains blocks from an
+	 *	`Allocator`.
+	 *
+	 *	\tparam Allocator
+	 *		The type of `Allocator`.
+	 *
+	 *	\param [in] block_size
+	 *		The minimum size of each block of memory the
+	 *		arena obtains.
+	 *	\param [in] alloc
+	 *		The `Allocator` from which blocks (and a small
+	 *		object which holds a copy of \em alloc) shall
+	 *		be obtained.
+	 */
+	template <typename Allocator>
+	monotonic_arena (std::size_t block_size, const Allocator & alloc) : monotonic_arena(block_size) {
+		upstream_ = basic_upstream<Allocator>::create(alloc);
+	}
+	/**
+	 *	Returns all blocks to the `Allocator` from
+	 *	which they were obtained.
+	 */
+	~monotonic_arena () noexcept;
+	/**
+	 *	Allocates memory.
+	 *
+	 *	\param [in] size
+	 *		The number of bytes.
+	 *	\param [in] alignment
+	 *		The alignment in bytes. May not exceed
+	 *		`alignof(std::max_align_t)`.
+	 *
+	 *	\return
+	 *		A pointer to the memory, which remains valid
+	 *		until \ref rewind is called.
+	 */
+	void * allocate (std::size_t size, std::size_t alignment);
+	/**
+	 *	Determines whether a pointer points into memory
+	 *	held by the arena.
+	 *
+	 *	\param [in] ptr
+	 *		The pointer.
+	 *
+	 *	\return
+	 *		\em true if \em ptr points into memory held by
+	 *		the arena, \em false otherwise.
+	 */
+	bool owns (const void * ptr) const noexcept;
+	/**
+	 *	Makes all memory held by the arena available for
+	 *	reuse, invalidating all memory allocated therefrom.
+	 */
+	void rewind () noexcept;
+	/**
+	 *	Causes \ref arena_allocator objects which refer to
+	 *	this arena to allocate from it.
+	 *
+	 *	Calls may be nested, each must be matched by a call
+	 *	to \ref deactivate.
+	 */
+	void activate () noexcept;
+	/**
+	 *	Undoes a call to \ref activate.
+	 */
+	void deactivate () noexcept;
+	/**
+	 *	Determines whether \ref arena_allocator objects
+	 *	which refer to this arena allocate from it.
+	 *
+	 *	\return
+	 *		\em true if so, \em false otherwise.
+	 */
+	bool active () const noexcept;
+	/**
+	 *	Determines the number of bytes in all blocks the
+	 *	arena holds.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t capacity () const noexcept;
+	/**
+	 *	Records that an object rewinds this arena.
+	 *
+	 *	Only one object may do so at a time, it is
+	 *	asserted that no other object has claimed the
+	 *	arena and not since released it.
+	 *
+	 *	\param [in] owner
+	 *		A pointer identifying the object.
+	 */
+	void claim (const void * owner) noexcept;
+	/**
+	 *	Undoes a call to \ref claim. If \em owner has not
+	 *	claimed the arena nothing happens.
+	 *
+	 *	\param [in] owner
+	 *		A pointer identifying the object.
+	 */
+	void release (const void * owner) noexcept;
+	/**
+	 *	Retrieves the object which has claimed the arena.
+	 *
+	 *	\return
+	 *		A pointer identifying the object, or a null
+	 *		pointer if the arena is not claimed.
+	 */
+	const void * owner () const noexcept;
+};
+
+/**
+ *	Activates a \ref monotonic_arena for the duration of
+ *	its lifetime.
+ */
+class monotonic_arena_scope {
+private:
+	monotonic_arena * arena_;
+public:
+	monotonic_arena_scope (const monotonic_arena_scope &) = delete;
+	monotonic_arena_scope & operator = (const monotonic_arena_scope &) = delete;
+	/**
+	 *	Creates a monotonic_arena_scope.
+	 *
+	 *	\param [in] arena
+	 *		A pointer to the arena to activate. If null
+	 *		nothing happens.
+	 */
+	explicit monotonic_arena_scope (monotonic_arena * arena) noexcept : arena_(arena) {
+		if (arena_) arena_->activate();
+	}
+	~monotonic_arena_scope () noexcept {
+		if (arena_) arena_->deactivate();
+	}
+};
+
+/**
+ *	An `Allocator` which allocates from a \ref monotonic_arena
+ *	while it is active and otherwise from an upstream
+ *	`Allocator`.
+ *
+ *	Deallocating memory which belongs to the arena does
+ *	nothing, it is reclaimed when the arena is rewound.
+ *
+ *	Used as the `allocator_type` of a `PacketParameters`
+ *	model (and therefore as the `Allocator` of a
+ *	\ref stream_serializer) this causes the fields of
+ *	parsed packets to be allocated from the arena.
+ *
+ *	\tparam T
+ *		The type to allocate.
+ *	\tparam Allocator
+ *		The upstream `Allocator`. Defaults to
+ *		`std::allocator<T>`.
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class arena_allocator {
+template <typename, typename> friend class arena_allocator;
+private:
+	using traits = std::allocator_traits<Allocator>;
+	monotonic_arena * arena_;
+	Allocator upstream_;
+public:
+	using value_type = T;
+	template <typename U>
+	class rebind {
+	public:
+		using other = arena_allocator<U, typename traits::template rebind_alloc<U>>;
+	};
+	/**
+	 *	Creates an arena_allocator.
+	 *
+	 *	\param [in] arena
+	 *		The arena. Must outlive this object, all
+	 *		objects created therefrom, and all memory
+	 *		allocated thereby.
+	 *	\param [in] upstream
+	 *		The `Allocator` used while \em arena is not
+	 *		active. Defaults to a default constructed
+	 *		\em Allocator.
+	 */
+	explicit arena_allocator (monotonic_arena & arena, const Allocator & upstream = Allocator{}) noexcept(
+		std::is_nothrow_copy_constructible<Allocator>::value
+	)	:	arena_(&arena),
+			upstream_(upstream)
+	{	}
+	/**
+	 *	Rebinds an arena_allocator.
+	 *
+	 *	\param [in] other
+	 *		The arena_allocator to rebind.
+	 */
+	template <typename U, typename Allocator2>
+	arena_allocator (const arena_allocator<U, Allocator2> & other) noexcept
+		:	arena_(other.arena_),
+			upstream_(other.upstream_)
+	{	}
+	T * allocate (std::size_t n) {
+		if (!arena_->active()) return traits::allocate(upstream_, n);
+		auto size = checked::multiply(n, sizeof(T));
+		if (!size) throw std::bad_alloc();
+		return static_cast<T *>(arena_->allocate(*size, alignof(T)));
+	}
+	void deallocate (T * ptr, std::size_t n) noexcept {
+		if (arena_->owns(ptr)) return;
+		traits::deallocate(upstream_, ptr, n);
+	}
+	/**
+	 *	Retrieves the arena.
+	 *
+	 *	\return
+	 *		A reference to the arena.
+	 */
+	monotonic_arena & arena () const noexcept {
+		return *arena_;
+	}
+	/**
+	 *	Retrieves the upstream allocator.
+	 *
+	 *	\return
+	 *		The upstream allocator.
+	 */
+	const Allocator & upstream () const noexcept {
+		return upstream_;
+	}
+	template <typename U, typename Allocator2>
+	bool operator == (const arena_allocator<U, Allocator2> & rhs) const noexcept {
+		return (arena_ == rhs.arena_) && (upstream_ == rhs.upstream_);
+	}
+	template <typename U, typename Allocator2>
+	bool operator != (const arena_allocator<U, Allocator2> & rhs) const noexcept {
+		return !(*this == rhs);
+	}
+};
+
+}
+}
@@ -0,0 +1,849 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "cfb8.hpp"
+#include "error.hpp"
+#include "stream_serializer.hpp"
+#include <beast/core/async_result.hpp>
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/handler_ptr.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/handler_alloc_hook.hpp>
+#include <boost/asio/handler_continuation_hook.hpp>
+#include <boost/asio/handler_invoke_hook.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/expected/expected.hpp>
+#include <mcpp/buffer.hpp>
+#include <mcpp/optional.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+
+template <typename DynamicBuffer, typename Decryptor, typename Encryptor>
+class connection_state;
+
+namespace detail {
+
+//	The number of bytes requested by each read, large
+//	enough that a single read typically yields many
+//	small packets
+constexpr std::size_t read_packet_size = 16384;
+
+//	Decrypts the first size bytes of a buffer sequence
+//	in place
+template <typename Decryptor, typename MutableBufferSequence>
+void decrypt_buffers (Decryptor & decryptor, const MutableBufferSequence & buffers, std::size_t size) {
+	for (auto && b : buffers) {
+		if (size == 0) break;
+		auto n = std::min(size, boost::asio::buffer_size(b));
+		decryptor.decrypt(boost::asio::buffer_cast<void *>(b), n);
+		size -= n;
+	}
+}
+
+//	Decrypts in place the bytes of a buffer sequence
+//	which follow the first offset bytes. The bytes
+//	are owned by a DynamicBuffer and therefore may be
+//	written even though it only exposes them as constant
+template <typename Decryptor, typename ConstBufferSequence>
+void decrypt_buffered (Decryptor & decryptor, const ConstBufferSequence & buffers, std::size_t offset) {
+	for (boost::asio::const_buffer b : buffers) {
+		auto size = boost::asio::buffer_size(b);
+		if (offset >= size) {
+			offset -= size;
+			continue;
+		}
+		auto ptr = const_cast<unsigned char *>(boost::asio::buffer_cast<const unsigned char *>(b));
+		decryptor.decrypt(ptr + offset, size - offset);
+		offset = 0;
+	}
+}
+
+template <
+	typename AsyncReadStream,
+	typename DynamicBuffer,
+	typename Decryptor,
+	typename StreamSerializer,
+	typename Handler
+>
+class read_packet_op {
+private:
+	using source_type = typename StreamSerializer::source_type;
+	using result_type = boost::expected<bool, std::error_code>;
+	using buffers_type = typename DynamicBuffer::mutable_buffers_type;
+	enum class stage {
+		pending,
+		read,
+		done
+	};
+	class state {
+	public:
+		AsyncReadStream & stream;
+		DynamicBuffer & buffer;
+		//	Null unless bytes are decrypted as they are read
+		Decryptor * decryptor;
+		//	The number of bytes at the front of buffer which
+		//	belong to the frame most recently parsed, null if
+		//	they are consumed immediately
+		std::size_t * parsed;
+		StreamSerializer & serializer;
+		optional<buffers_type> prepared;
+		typename read_packet_op::stage stage;
+		state (
+			Handler &,
+			AsyncReadStream & stream,
+			DynamicBuffer & buffer,
+			Decryptor * decryptor,
+			std::size_t * parsed,
+			StreamSerializer & serializer
+		)	:	stream(stream),
+				buffer(buffer),
+				decryptor(decryptor),
+				parsed(parsed),
+				serializer(serializer),
+				stage(read_packet_op::stage::pending)
+		{	}
+	};
+	class parse_in_place_scope {
+	private:
+		StreamSerializer & serializer_;
+		bool enabled_;
+	public:
+		parse_in_place_scope (StreamSerializer & serializer, bool enable) noexcept
+			:	serializer_(serializer),
+				enabled_(serializer.parse_in_place())
+		{
+			serializer_.parse_in_place(enabled_ && enable);
+		}
+		parse_in_place_scope (const parse_in_place_scope &) = delete;
+		parse_in_place_scope & operator = (const parse_in_place_scope &) = delete;
+		~parse_in_place_scope () noexcept {
+			serializer_.parse_in_place(enabled_);
+		}
+	};
+	using pointer = beast::handler_ptr<state, Handler>;
+	pointer ptr_;
+	//	Parses from the bytes already received, only those
+	//	which belong to the frame being parsed are consumed
+	//	so that any which follow remain for the next
+	//	operation. Bytes which were copied by the serializer
+	//	are consumed immediately, those in the piece of the
+	//	buffer which completed the frame may have been
+	//	parsed in place and are consumed when the next
+	//	operation begins. When that is not possible parsing
+	//	in place is disabled for the duration of the call.
+	result_type parse () {
+		auto && s = *ptr_;
+		parse_in_place_scope scope(s.serializer, s.parsed != nullptr);
+		result_type retr(false);
+		std::size_t consumed(0);
+		for (auto && b : s.buffer.data()) {
+			source_type src(
+				boost::asio::buffer_cast<const unsigned char *>(b),
+				boost::asio::buffer_size(b)
+			);
+			retr = s.serializer.parse(src);
+			if (retr && *retr && s.parsed) {
+				*s.parsed = src.read();
+				break;
+			}
+			consumed += src.read();
+			if (!(retr && !*retr)) break;
+		}
+		s.buffer.consume(consumed);
+		return retr;
+	}
+	void read () {
+		auto && s = *ptr_;
+		try {
+			s.prepared.emplace(s.buffer.prepare(read_packet_size));
+		} catch (const std::length_error &) {
+			complete(beast::error_code(boost::asio::error::no_buffer_space));
+			return;
+		}
+		s.stage = stage::read;
+		s.stream.async_read_some(*s.prepared, std::move(*this));
+	}
+	//	The handler may not be invoked from within the
+	//	initiating function, if the operation completes
+	//	without reading (because the packet was already
+	//	buffered) completion is deferred
+	void complete (beast::error_code ec) {
+		if (ptr_->stage == stage::pending) {
+			ptr_->stage = stage::done;
+			auto && ios = ptr_->stream.get_io_service();
+			ios.post(beast::bind_handler(std::move(*this), ec, 0));
+			return;
+		}
+		ptr_.invoke(ec);
+	}
+	//	Only errors of the protocol category have a
+	//	counterpart which Asio can report, others (which
+	//	a packet_serializer may return) are reported as
+	//	malformed data
+	void complete (const std::error_code & ec) {
+		if (ec.category() != error_category()) {
+			complete(make_error_code(error::malformed));
+			return;
+		}
+		complete(beast::error_code(ec.value(), boost_error_category()));
+	}
+public:
+	read_packet_op () = delete;
+	read_packet_op (const read_packet_op &) = default;
+	read_packet_op (read_packet_op &&) = default;
+	read_packet_op & operator = (const read_packet_op &) = default;
+	read_packet_op & operator = (read_packet_op &&) = default;
+	template <typename DeducedHandler>
+	read_packet_op (
+		AsyncReadStream & stream,
+		DynamicBuffer & buffer,
+		StreamSerializer & serializer,
+		DeducedHandler && handler
+	)	:	ptr_(std::forward<DeducedHandler>(handler), stream, buffer, nullptr, nullptr, serializer)
+	{	}
+	template <typename Encryptor, typename DeducedHandler>
+	read_packet_op (
+		AsyncReadStream & stream,
+		connection_state<DynamicBuffer, Decryptor, Encryptor> & connection,
+		StreamSerializer & serializer,
+		DeducedHandler && handler
+	)	:	ptr_(
+				std::forward<DeducedHandler>(handler),
+				stream,
+				connection.buffer_,
+				connection.decryptor_ ? std::addressof(*connection.decryptor_) : nullptr,
+				&connection.parsed_,
+				serializer
+			)
+	{
+		//	The packet most recently parsed is no longer
+		//	required
+		connection.buffer_.consume(connection.parsed_);
+		connection.parsed_ = 0;
+	}
+	friend bool asio_handler_is_continuation (const read_packet_op * op) noexcept {
+		using boost::asio::asio_handler_is_continuation;
+		if (op->ptr_->stage == stage::pending) return asio_handler_is_continuation(std::addressof(op->ptr_.handler()));
+		return true;
+	}
+	friend void * asio_handler_allocate (std::size_t size, const read_packet_op * op) {
+		using boost::asio::asio_handler_allocate;
+		return asio_handler_allocate(size, std::addressof(op->ptr_.handler()));
+	}
+	friend void asio_handler_deallocate (void * ptr, std::size_t size, const read_packet_op * op) {
+		using boost::asio::asio_handler_deallocate;
+		return asio_handler_deallocate(ptr, size, std::addressof(op->ptr_.handler()));
+	}
+	template <typename F>
+	friend void asio_handler_invoke (F && f, const read_packet_op * op) {
+		using boost::asio::asio_handler_invoke;
+		return asio_handler_invoke(f, std::addressof(op->ptr_.handler()));
+	}
+	void operator () (beast::error_code ec, std::size_t num = 0) {
+		auto && s = *ptr_;
+		switch (s.stage) {
+		case stage::pending:
+			break;
+		case stage::read:
+			if (s.decryptor) decrypt_buffers(*s.decryptor, *s.prepared, num);
+			s.prepared = nullopt;
+			s.buffer.commit(num);
+			break;
+		case stage::done:
+			ptr_.invoke(ec);
+			return;
+		default:
+			throw std::logic_error("Invalid invocation of mcpp::protocol::detail::read_packet_op::operator ()");
+		}
+		if (ec) {
+			complete(ec);
+			return;
+		}
+		result_type result(false);
+		//	Malformed compressed data causes zlib to report
+		//	an error by way of an exception, as may packet
+		//	serializers, which must not escape into the
+		//	event loop
+		try {
+			result = parse();
+		} catch (const std::bad_alloc &) {
+			complete(beast::error_code(boost::asio::error::no_buffer_space));
+			return;
+		} catch (...) {
+			complete(make_error_code(error::malformed));
+			return;
+		}
+		if (!result) complete(result.error());
+		else if (*result) complete(beast::error_code{});
+		else read();
+	}
+};
+
+}
+
+/**
+ *	The state of a connection which is carried from each
+ *	asynchronous operation on it to the next.
+ *
+ *	Holds the buffer of bytes which have been read but not
+ *	yet parsed by \ref async_read_packet. The bytes of the
+ *	frame most recently parsed are only consumed therefrom
+ *	when the next read begins, so that a packet parsed in
+ *	place remains valid until then.
+ *
+ *	Once \ref enable_encryption has been called bytes are
+ *	decrypted as they are read, before they are parsed, and
+ *	the representation of each packet written by
+ *	\ref async_write_packet or \ref async_write_packets
+ *	is encrypted before it is written.
+ *
+ *	\tparam DynamicBuffer
+ *		A model of `DynamicBuffer`.
+ *	\tparam Decryptor
+ *		A type with a member function `decrypt` which
+ *		accepts a `void *` and a `std::size_t` and decrypts
+ *		that many bytes in place.
+ *	\tparam Encryptor
+ *		A type with a member function `encrypt` which
+ *		accepts a `void *` and a `std::size_t` and encrypts
+ *		that many bytes in place.
+ */
+template <
+	typename DynamicBuffer,
+	typename Decryptor = cfb8_decryptor,
+	typename Encryptor = cfb8_encryptor
+>
+class connection_state {
+template <typename, typename, typename, typename, typename> friend class detail::read_packet_op;
+public:
+	/**
+	 *	The type of the buffer.
+	 */
+	using buffer_type = DynamicBuffer;
+	/**
+	 *	The type of the decryptor.
+	 */
+	using decryptor_type = Decryptor;
+	/**
+	 *	The type of the encryptor.
+	 */
+	using encryptor_type = Encryptor;
+private:
+	DynamicBuffer buffer_;
+	std::size_t parsed_;
+	optional<Decryptor> decryptor_;
+	optional<Encryptor> encryptor_;
+	std::vector<unsigned char> write_;
+public:
+	connection_state (const connection_state &) = delete;
+	connection_state (connection_state &&) = delete;
+	connection_state & operator = (const connection_state &) = delete;
+	connection_state & operator = (connection_state &&) = delete;
+	/**
+	 *	Creates a connection_state.
+	 *
+	 *	\param [in] args
+	 *		Arguments which shall be forwarded to the
+	 *		constructor of the buffer.
+	 */
+	template <typename... Args>
+	explicit connection_state (Args &&... args)
+		:	buffer_(std::forward<Args>(args)...),
+			parsed_(0)
+	{	}
+	/**
+	 *	Retrieves the buffer.
+	 *
+	 *	\return
+	 *		A reference to the buffer.
+	 */
+	DynamicBuffer & buffer () noexcept {
+		return buffer_;
+	}
+	/**
+	 *	Enables encryption. The peer encrypts everything
+	 *	which follows the packet that enabled encryption,
+	 *	therefore bytes already buffered which follow the
+	 *	frame most recently parsed by \ref async_read_packet
+	 *	are decrypted in place immediately, and those read
+	 *	thereafter as they arrive. The result of enabling
+	 *	encryption while an asynchronous operation is in
+	 *	progress is undefined.
+	 *
+	 *	\param [in] args
+	 *		Arguments which shall be passed to the
+	 *		constructors of both the decryptor and the
+	 *		encryptor, for example the shared secret.
+	 */
+	template <typename... Args>
+	void enable_encryption (const Args &... args) {
+		decryptor_.emplace(args...);
+		encryptor_.emplace(args...);
+		detail::decrypt_buffered(*decryptor_, buffer_.data(), parsed_);
+	}
+	/**
+	 *	Determines whether encryption has been enabled.
+	 *
+	 *	\return
+	 *		\em true if encryption has been enabled,
+	 *		\em false otherwise.
+	 */
+	bool encrypted () const noexcept {
+		return bool(encryptor_);
+	}
+	/**
+	 *	Copies bytes which are to be written into a buffer
+	 *	owned by this object and encrypts them. The result
+	 *	is undefined unless encryption has been enabled.
+	 *
+	 *	\param [in] buffers
+	 *		The bytes.
+	 *
+	 *	\return
+	 *		A buffer sequence which refers to the encrypted
+	 *		bytes, it remains valid until the next call.
+	 */
+	template <typename ConstBufferSequence>
+	boost::asio::const_buffers_1 encrypt (const ConstBufferSequence & buffers) {
+		assert(encryptor_);
+		write_.clear();
+		for (boost::asio::const_buffer b : buffers) {
+			auto ptr = boost::asio::buffer_cast<const unsigned char *>(b);
+			write_.insert(write_.end(), ptr, ptr + boost::asio::buffer_size(b));
+		}
+		encryptor_->encrypt(write_.data(), write_.size());
+		return boost::asio::const_buffers_1(write_.data(), write_.size());
+	}
+};
+
+/**
+ *	Reads a frame from a model of `AsyncReadStream`
+ *	and parses it with a \ref stream_serializer.
+ *
+ *	Bytes are read into \em buffer, which is reused from
+ *	operation to operation. Any bytes read which follow the
+ *	frame are left in \em buffer and the next operation
+ *	parses them before reading from the stream, so that a
+ *	read which yields many packets is performed only once.
+ *	Accordingly the same \em buffer must be used for every
+ *	operation on a given connection.
+ *
+ *	On success the frame is available through \em serializer
+ *	exactly as if \ref stream_serializer::parse had returned
+ *	\em true. The bytes of the frame are consumed from
+ *	\em buffer before the completion handler is invoked,
+ *	therefore packets are never parsed in place by this
+ *	overload (see the overload which accepts a
+ *	\ref connection_state).
+ *
+ *	Exceptions thrown while parsing, for example by zlib
+ *	when compressed data is malformed, are not propagated
+ *	but reported to the completion handler as
+ *	\ref error::malformed.
+ *
+ *	\tparam AsyncReadStream
+ *		A model of `AsyncReadStream`.
+ *	\tparam DynamicBuffer
+ *		A model of `DynamicBuffer` which shall be used to
+ *		hold bytes which have been read but not parsed.
+ *	\tparam CharT
+ *		The character type of the `Source` of the
+ *		\ref stream_serializer.
+ *	\tparam Traits
+ *		The traits type of the `Source` of the
+ *		\ref stream_serializer.
+ *	\tparam Sink
+ *		The `Sink` of the \ref stream_serializer.
+ *	\tparam Allocator
+ *		The `Allocator` of the \ref stream_serializer.
+ *	\tparam CompletionToken
+ *		The completion handler. Note that Boost.Asio fancy
+ *		completion handlers (such as `boost::asio::use_future`)
+ *		are valid here. The completion handler accepts a single
+ *		`beast::error_code`. Errors encountered while parsing are
+ *		reported with the category returned by
+ *		`detail::boost_error_category` and the values of
+ *		\ref error.
+ *
+ *	\param [in] stream
+ *		The stream from which to read. This reference must
+ *		remain valid for the duration of the asynchronous
+ *		operation or the behavior is undefined.
+ *	\param [in] buffer
+ *		The buffer into which to read. This reference must
+ *		remain valid for the duration of the asynchronous
+ *		operation or the behavior is undefined.
+ *	\param [in] serializer
+ *		The \ref stream_serializer which shall parse the
+ *		frame. This reference must remain valid for the
+ *		duration of the asynchronous operation and may not
+ *		be used to parse until it completes or the behavior
+ *		is undefined.
+ *	\param [in] token
+ *		The completion handler.
+ *
+ *	\return
+ *		The value returned shall be appropriate given
+ *		\em CompletionToken.
+ */
+template <
+	typename AsyncReadStream,
+	typename DynamicBuffer,
+	typename CharT,
+	typename Traits,
+	typename Sink,
+	typename Allocator,
+	typename CompletionToken
+>
+beast::async_return_type<
+	CompletionToken,
+	void (beast::error_code)
+> async_read_packet (
+	AsyncReadStream & stream,
+	DynamicBuffer & buffer,
+	stream_serializer<basic_buffer<CharT, Traits>, Sink, Allocator> & serializer,
+	CompletionToken && token
+) {
+	using Signature = void (beast::error_code);
+	beast::async_completion<CompletionToken, Signature> init(token);
+	detail::read_packet_op<
+		AsyncReadStream,
+		DynamicBuffer,
+		cfb8_decryptor,
+		stream_serializer<basic_buffer<CharT, Traits>, Sink, Allocator>,
+		beast::handler_type<CompletionToken, Signature>
+	> op(
+		stream,
+		buffer,
+		serializer,
+		init.completion_handler
+	);
+	op(beast::error_code{}, 0);
+	return init.result.get();
+}
+
+/**
+ *	Reads a frame from a model of `AsyncReadStream`
+ *	and parses it with a \ref stream_serializer, as by
+ *	the overload which accepts a `DynamicBuffer`, but
+ *	using the buffer of a \ref connection_state.
+ *
+ *	If encryption has been enabled on \em connection bytes
+ *	are decrypted as they are read. If parsing in place is
+ *	enabled (see \ref stream_serializer::parse_in_place) the
+ *	parsed packet may refer to memory owned by the buffer
+ *	of \em connection, it remains valid until the next
+ *	operation begins.
+ *
+ *	\param [in] stream
+ *		The stream from which to read. This reference must
+ *		remain valid for the duration of the asynchronous
+ *		operation or the behavior is undefined.
+ *	\param [in] connection
+ *		The state of the connection. The same object must be
+ *		used for every operation on a given connection and
+ *		this reference must remain valid for the duration of
+ *		the asynchronous operation or the behavior is
+ *		undefined.
+ *	\param [in] serializer
+ *		The \ref stream_serializer which shall parse the
+ *		frame. This reference must remain valid for the
+ *		duration of the asynchronous operation and may not
+ *		be used to parse until it completes or the behavior
+ *		is undefined.
+ *	\param [in] token
+ *		The completion handler.
+ *
+ *	\return
+ *		The value returned shall be appropriate given
+ *		\em CompletionToken.
+ */
+template <
+	typename AsyncReadStream,
+	typename DynamicBuffer,
+	typename Decryptor,
+	typename Encryptor,
+	typename CharT,
+	typename Traits,
+	typename Sink,
+	typename Allocator,
+	typename CompletionToken
+>
+beast::async_return_type<
+	CompletionToken,
+	void (beast::error_code)
+> async_read_packet (
+	AsyncReadStream & stream,
+	connection_state<DynamicBuffer, Decryptor, Encryptor> & connection,
+	stream_serializer<basic_buffer<CharT, Traits>, Sink, Allocator> & serializer,
+	CompletionToken && token
+) {
+	using Signature = void (beast::error_code);
+	beast::async_completion<CompletionToken, Signature> init(token);
+	detail::read_packet_op<
+		AsyncReadStream,
+		DynamicBuffer,
+		Decryptor,
+		stream_serializer<basic_buffer<CharT, Traits>, Sink, Allocator>,
+		beast::handler_type<CompletionToken, Signature>
+	> op(
+		stream,
+		connection,
+		serializer,
+		init.completion_handler
+	);
+	op(beast::error_code{}, 0);
+	return init.result.get();
+}
+
+/**
+ *	Serializes a packet with a \ref stream_serializer
+ *	and writes it to a model of `AsyncWriteStream`.
+ *
+ *	The packet is serialized before this function returns
+ *	and the representation owned by \em serializer is
+ *	written directly without being copied.
+ *
+ *	\tparam AsyncWriteStream
+ *		A model of `AsyncWriteStream`.
+ *	\tparam Source
+ *		The `Source` of the \ref stream_serializer.
+ *	\tparam Sink
+ *		The `Sink` of the \ref stream_serializer.
+ *	\tparam Allocator
+ *		The `Allocator` of the \ref stream_serializer.
+ *	\tparam Packet
+ *		A type derived from \ref packet or \ref framed_packet.
+ *	\tparam CompletionToken
+ *		The completion handler, which accepts a
+ *		`beast::error_code` and the number of bytes written.
+ *
+ *	\param [in] stream
+ *		The stream to which to write. This reference must
+ *		remain valid for the duration of the asynchronous
+ *		operation or the behavior is undefined.
+ *	\param [in] serializer
+ *		The \ref stream_serializer which shall serialize
+ *		the packet. This reference must remain valid for the
+ *		duration of the asynchronous operation and may not
+ *		be used to serialize until it completes or the
+ *		behavior is undefined.
+ *	\param [in] p
+ *		The packet. This reference need not remain valid
+ *		after this function returns.
+ *	\param [in] token
+ *		The completion handler.
+ *
+ *	\return
+ *		The value returned shall be appropriate given
+ *		\em CompletionToken.
+ */
+template <
+	typename AsyncWriteStream,
+	typename Source,
+	typename Sink,
+	typename Allocator,
+	typename Packet,
+	typename CompletionToken
+>
+beast::async_return_type<
+	CompletionToken,
+	void (beast::error_code, std::size_t)
+> async_write_packet (
+	AsyncWriteStream & stream,
+	stream_serializer<Source, Sink, Allocator> & serializer,
+	const Packet & p,
+	CompletionToken && token
+) {
+	return boost::asio::async_write(
+		stream,
+		serializer.serialize(p),
+		std::forward<CompletionToken>(token)
+	);
+}
+
+/**
+ *	Serializes many packets with a \ref stream_serializer
+ *	and writes them to a model of `AsyncWriteStream` with a
+ *	single write.
+ *
+ *	The packets are serialized as by
+ *	\ref stream_serializer::serialize_batch before this
+ *	function returns.
+ *
+ *	\tparam AsyncWriteStream
+ *		A model of `AsyncWriteStream`.
+ *	\tparam Source
+ *		The `Source` of the \ref stream_serializer.
+ *	\tparam Sink
+ *		The `Sink` of the \ref stream_serializer.
+ *	\tparam Allocator
+ *		The `Allocator` of the \ref stream_serializer.
+ *	\tparam InputIterator
+ *		An input iterator type which dereferences to
+ *		`const packet &` or `const framed_packet &`.
+ *	\tparam CompletionToken
+ *		The completion handler, which accepts a
+ *		`beast::error_code` and the number of bytes written.
+ *
+ *	\param [in] stream
+ *		The stream to which to write. This reference must
+ *		remain valid for the duration of the asynchronous
+ *		operation or the behavior is undefined.
+ *	\param [in] serializer
+ *		The \ref stream_serializer which shall serialize
+ *		the packets. This reference must remain valid for
+ *		the duration of the asynchronous operation and may
+ *		not be used to serialize until it completes or the
+ *		behavior is undefined.
+ *	\param [in] begin
+ *		An iterator to the first packet. Any
+ *		\ref framed_packet in the range must remain
+ *		alive for the duration of the asynchronous
+ *		operation or the behavior is undefined.
+ *	\param [in] end
+ *		An iterator to one past the last packet.
+ *	\param [in] token
+ *		The completion handler.
+ *
+ *	\return
+ *		The value returned shall be appropriate given
+ *		\em CompletionToken.
+ */
+template <
+	typename AsyncWriteStream,
+	typename Source,
+	typename Sink,
+	typename Allocator,
+	typename InputIterator,
+	typename CompletionToken
+>
+beast::async_return_type<
+	CompletionToken,
+	void (beast::error_code, std::size_t)
+> async_write_packets (
+	AsyncWriteStream & stream,
+	stream_serializer<Source, Sink, Allocator> & serializer,
+	InputIterator begin,
+	InputIterator end,
+	CompletionToken && token
+) {
+	return boost::asio::async_write(
+		stream,
+		serializer.serialize_batch(begin, end),
+		std::forward<CompletionToken>(token)
+	);
+}
+
+/**
+ *	Serializes a packet with a \ref stream_serializer
+ *	and writes it to a model of `AsyncWriteStream`, as
+ *	by the overload which does not accept a
+ *	\ref connection_state, encrypting it if encryption
+ *	has been enabled on \em connection.
+ *
+ *	When encrypted the representation is copied into a
+ *	buffer owned by \em connection, which must therefore
+ *	remain valid for the duration of the asynchronous
+ *	operation or the behavior is undefined.
+ */
+template <
+	typename AsyncWriteStream,
+	typename DynamicBuffer,
+	typename Decryptor,
+	typename Encryptor,
+	typename Source,
+	typename Sink,
+	typename Allocator,
+	typename Packet,
+	typename CompletionToken
+>
+beast::async_return_type<
+	CompletionToken,
+	void (beast::error_code, std::size_t)
+> async_write_packet (
+	AsyncWriteStream & stream,
+	connection_state<DynamicBuffer, Decryptor, Encryptor> & connection,
+	stream_serializer<Source, Sink, Allocator> & serializer,
+	const Packet & p,
+	CompletionToken && token
+) {
+	if (!connection.encrypted()) return async_write_packet(
+		stream,
+		serializer,
+		p,
+		std::forward<CompletionToken>(token)
+	);
+	return boost::asio::async_write(
+		stream,
+		connection.encrypt(serializer.serialize(p)),
+		std::forward<CompletionToken>(token)
+	);
+}
+
+/**
+ *	Serializes many packets with a \ref stream_serializer
+ *	and writes them to a model of `AsyncWriteStream` with
+ *	a single write, as by the overload which does not
+ *	accept a \ref connection_state, encrypting them if
+ *	encryption has been enabled on \em connection.
+ *
+ *	When encrypted the representations are copied into a
+ *	buffer owned by \em connection, which must therefore
+ *	remain valid for the duration of the asynchronous
+ *	operation or the behavior is undefined, and the
+ *	packets need not remain alive.
+ */
+template <
+	typename AsyncWriteStream,
+	typename DynamicBuffer,
+	typename Decryptor,
+	typename Encryptor,
+	typename Source,
+	typename Sink,
+	typename Allocator,
+	typename InputIterator,
+	typename CompletionToken
+>
+beast::async_return_type<
+	CompletionToken,
+	void (beast::error_code, std::size_t)
+> async_write_packets (
+	AsyncWriteStream & stream,
+	connection_state<DynamicBuffer, Decryptor, Encryptor> & connection,
+	stream_serializer<Source, Sink, Allocator> & serializer,
+	InputIterator begin,
+	InputIterator end,
+	CompletionToken && token
+) {
+	if (!connection.encrypted()) return async_write_packets(
+		stream,
+		serializer,
+		begin,
+		end,
+		std::forward<CompletionToken>(token)
+	);
+	return boost::asio::async_write(
+		stream,
+		connection.encrypt(serializer.serialize_batch(begin, end)),
+		std::forward<CompletionToken>(token)
+	);
+}
+
+}
+}
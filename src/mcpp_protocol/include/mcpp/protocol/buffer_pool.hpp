@@ -0,0 +1,258 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+
+/**
+ *	A pool of buffers which may be shared by many
+ *	\ref stream_serializer objects (and therefore many
+ *	connections) so that the memory used to hold packets
+ *	is proportional to the number of packets being
+ *	processed at once rather than the number of
+ *	connections.
+ *
+ *	Buffers are sorted into size classes, each of which
+ *	holds buffers whose capacity is at least the next
+ *	lower power of two. Buffers of at most \ref private_limit
+ *	characters are retained by their \ref stream_serializer
+ *	between packets since they are cheap to keep and
+ *	leasing them would cost synchronization on every
+ *	packet, larger buffers are returned as soon as the
+ *	\ref stream_serializer is done with them.
+ *
+ *	Once the capacity of the buffers held by the pool
+ *	exceeds \ref high_water buffers returned to it are
+ *	released instead. Buffers of more than \ref max_size
+ *	characters are never held by the pool.
+ *
+ *	All methods are safe to call concurrently.
+ *
+ *	\tparam Vector
+ *		A specialization of `std::vector`.
+ */
+template <typename Vector>
+class buffer_pool {
+public:
+	/**
+	 *	The type of buffers held by the pool.
+	 */
+	using vector_type = Vector;
+	/**
+	 *	The type of allocator used to allocate
+	 *	buffers.
+	 */
+	using allocator_type = typename Vector::allocator_type;
+private:
+	using value_type = typename Vector::value_type;
+	using list_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<Vector>;
+	using list_type = std::vector<Vector, list_allocator_type>;
+	static constexpr std::size_t classes = std::numeric_limits<std::size_t>::digits;
+	mutable std::mutex m_;
+	allocator_type alloc_;
+	std::size_t high_water_;
+	std::size_t private_limit_;
+	std::size_t max_size_;
+	std::size_t retained_;
+	std::vector<list_type, typename std::allocator_traits<allocator_type>::template rebind_alloc<list_type>> free_;
+	static std::size_t floor_log2 (std::size_t n) noexcept {
+		assert(n != 0);
+		std::size_t retr(0);
+		while (n >>= 1) ++retr;
+		return retr;
+	}
+	static std::size_t ceil_log2 (std::size_t n) noexcept {
+		if (n <= 1) return 0;
+		return floor_log2(n - 1) + 1;
+	}
+	static std::size_t bytes (const Vector & v) noexcept {
+		return v.capacity() * sizeof(value_type);
+	}
+	//	Removes a buffer from the given size class or
+	//	the next larger, larger classes are not searched
+	//	so that small requests do not consume large
+	//	buffers
+	bool take (std::size_t c, Vector & v) {
+		std::lock_guard<std::mutex> lock(m_);
+		for (auto i = c; (i < classes) && (i <= (c + 1)); ++i) {
+			auto && list = free_[i];
+			if (list.empty()) continue;
+			v = std::move(list.back());
+			list.pop_back();
+			retained_ -= bytes(v);
+			return true;
+		}
+		return false;
+	}
+public:
+	buffer_pool (const buffer_pool &) = delete;
+	buffer_pool (buffer_pool &&) = delete;
+	buffer_pool & operator = (const buffer_pool &) = delete;
+	buffer_pool & operator = (buffer_pool &&) = delete;
+	/**
+	 *	Creates a buffer_pool.
+	 *
+	 *	\param [in] high_water
+	 *		The number of bytes the buffers held by the
+	 *		pool may occupy.
+	 *	\param [in] private_limit
+	 *		The number of characters at or below which
+	 *		buffers are retained by the \ref stream_serializer
+	 *		objects which use them. Defaults to 4096.
+	 *	\param [in] max_size
+	 *		The number of characters above which buffers
+	 *		are neither rounded up to a size class when
+	 *		acquired nor held by the pool when released.
+	 *		Defaults to 2097152, the maximum length of an
+	 *		uncompressed packet. Must not exceed half the
+	 *		maximum value of `std::size_t`.
+	 *	\param [in] alloc
+	 *		The allocator used to allocate buffers.
+	 */
+	explicit buffer_pool (
+		std::size_t high_water,
+		std::size_t private_limit = 4096,
+		std::size_t max_size = std::size_t(1) << 21,
+		const allocator_type & alloc = allocator_type()
+	)
+		:	alloc_(alloc),
+			high_water_(high_water),
+			private_limit_(private_limit),
+			max_size_(max_size),
+			retained_(0),
+			free_(classes, list_type(list_allocator_type(alloc)), typename decltype(free_)::allocator_type(alloc))
+	{
+		assert(max_size_ <= (std::numeric_limits<std::size_t>::max() / 2));
+	}
+	/**
+	 *	Obtains a buffer.
+	 *
+	 *	If \em size is greater than \ref max_size a new
+	 *	buffer of exactly \em size characters is allocated.
+	 *
+	 *	\param [in] size
+	 *		The minimum number of characters.
+	 *
+	 *	\return
+	 *		A buffer whose size is at least \em size. Its
+	 *		capacity may be greater, the characters between
+	 *		its size and capacity are not initialized. The
+	 *		contents are unspecified.
+	 */
+	Vector acquire (std::size_t size) {
+		Vector retr(alloc_);
+		if (size > max_size_) {
+			retr.resize(size);
+			return retr;
+		}
+		auto c = ceil_log2(size);
+		if (!take(c, retr)) retr.reserve(std::size_t(1) << c);
+		//	Only the characters requested are initialized
+		//	so that a buffer which is only partially used
+		//	is never filled in its entirety
+		if (retr.size() < size) retr.resize(size);
+		return retr;
+	}
+	/**
+	 *	Returns a buffer to the pool.
+	 *
+	 *	The buffer need not have been obtained from
+	 *	\ref acquire but must have been allocated by an
+	 *	allocator which compares equal to the pool's. Its
+	 *	size is retained so that the characters it holds
+	 *	need not be initialized again when it is next
+	 *	acquired. If its capacity exceeds \ref max_size
+	 *	it is released rather than held.
+	 *
+	 *	\param [in] v
+	 *		The buffer. Is left empty.
+	 */
+	void release (Vector && v) noexcept {
+		Vector tmp(std::move(v));
+		if ((tmp.capacity() == 0) || (tmp.capacity() > max_size_)) return;
+		auto c = floor_log2(tmp.capacity());
+		try {
+			std::lock_guard<std::mutex> lock(m_);
+			if ((retained_ + bytes(tmp)) > high_water_) return;
+			free_[c].push_back(std::move(tmp));
+			retained_ += bytes(free_[c].back());
+		} catch (...) {	}
+	}
+	/**
+	 *	Releases buffers held by the pool, largest first,
+	 *	until they occupy no more than a certain number of
+	 *	bytes.
+	 *
+	 *	\param [in] bytes
+	 *		The number of bytes. Defaults to zero.
+	 */
+	void trim (std::size_t bytes = 0) noexcept {
+		try {
+			std::lock_guard<std::mutex> lock(m_);
+			for (auto i = classes; (i != 0) && (retained_ > bytes); --i) {
+				auto && list = free_[i - 1];
+				while (!list.empty() && (retained_ > bytes)) {
+					retained_ -= buffer_pool::bytes(list.back());
+					list.pop_back();
+				}
+			}
+		} catch (...) {	}
+	}
+	/**
+	 *	Determines the number of bytes occupied by the
+	 *	buffers held by the pool.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t retained () const {
+		std::lock_guard<std::mutex> lock(m_);
+		return retained_;
+	}
+	/**
+	 *	Retrieves the number of bytes the buffers held
+	 *	by the pool may occupy.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t high_water () const noexcept {
+		return high_water_;
+	}
+	/**
+	 *	Retrieves the number of characters at or below
+	 *	which buffers are retained by the \ref stream_serializer
+	 *	objects which use them rather than being returned
+	 *	to the pool.
+	 *
+	 *	\return
+	 *		The number of characters.
+	 */
+	std::size_t private_limit () const noexcept {
+		return private_limit_;
+	}
+	/**
+	 *	Retrieves the number of characters above which
+	 *	buffers are not held by the pool.
+	 *
+	 *	\return
+	 *		The number of characters.
+	 */
+	std::size_t max_size () const noexcept {
+		return max_size_;
+	}
+};
+
+}
+}
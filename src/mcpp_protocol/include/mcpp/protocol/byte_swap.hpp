@@ -0,0 +1,50 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace mcpp {
+namespace protocol {
+
+/**
+ *	Reverses the order of the bytes within each of a
+ *	sequence of objects.
+ *
+ *	Where the processor supports it whole blocks of
+ *	objects are reversed at once using SIMD shuffles.
+ *	The instruction set is selected at runtime the first
+ *	time this function is called so that a single build
+ *	uses the widest shuffle available.
+ *
+ *	\param [in] src
+ *		A pointer to the first byte of the first object
+ *		to reverse. Need not be suitably aligned for
+ *		objects of size \em size.
+ *	\param [out] dst
+ *		A pointer to the first byte of the first object
+ *		to which the reversed representations shall be
+ *		written. Need not be suitably aligned for objects
+ *		of size \em size. May be equal to \em src but
+ *		must not otherwise overlap it.
+ *	\param [in] n
+ *		The number of objects.
+ *	\param [in] size
+ *		The size of each object in bytes. Must be 1, 2,
+ *		4, or 8.
+ */
+void byte_swap (const void * src, void * dst, std::size_t n, std::size_t size) noexcept;
+
+/**
+ *	Obtains the name of the instruction set \ref byte_swap
+ *	selected for this processor.
+ *
+ *	\return
+ *		"avx2", "ssse3", or "scalar".
+ */
+const char * byte_swap_implementation () noexcept;
+
+}
+}
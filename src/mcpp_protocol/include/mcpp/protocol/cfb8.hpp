@@ -0,0 +1,145 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+//	Declared by OpenSSL's headers, which are deliberately
+//	not included here
+struct evp_cipher_ctx_st;
+
+namespace mcpp {
+namespace protocol {
+
+namespace detail {
+
+class cipher_context_deleter {
+public:
+	void operator () (evp_cipher_ctx_st *) const noexcept;
+};
+
+using cipher_context_ptr = std::unique_ptr<evp_cipher_ctx_st, cipher_context_deleter>;
+
+}
+
+/**
+ *	Encrypts the byte stream of a connection using
+ *	AES-128 in 8 bit cipher feedback (CFB8) mode, as the
+ *	Minecraft protocol requires once encryption has been
+ *	enabled.
+ *
+ *	The stream is encrypted in place, once the
+ *	representation of a packet has been serialized and
+ *	before it is sent. Successive calls continue the same
+ *	stream. \ref connection_state does this for packets
+ *	written through it once encryption has been enabled.
+ *
+ *	Each byte of ciphertext feeds back into the encryption
+ *	of the next, so encryption is inherently serial and
+ *	is delegated to OpenSSL in its entirety.
+ *
+ *	Errors reported by OpenSSL cause \ref cipher_error
+ *	to be thrown.
+ */
+class cfb8_encryptor {
+private:
+	detail::cipher_context_ptr ctx_;
+public:
+	cfb8_encryptor (const cfb8_encryptor &) = delete;
+	cfb8_encryptor & operator = (const cfb8_encryptor &) = delete;
+	/**
+	 *	Creates a cfb8_encryptor whose initialization
+	 *	vector is its key, as in the Minecraft protocol.
+	 *
+	 *	\param [in] key
+	 *		The shared secret.
+	 */
+	explicit cfb8_encryptor (const unsigned char (& key) [16]);
+	/**
+	 *	Creates a cfb8_encryptor.
+	 *
+	 *	\param [in] key
+	 *		The key.
+	 *	\param [in] iv
+	 *		The initialization vector.
+	 */
+	cfb8_encryptor (const unsigned char (& key) [16], const unsigned char (& iv) [16]);
+	/**
+	 *	Encrypts bytes in place.
+	 *
+	 *	\param [in,out] ptr
+	 *		A pointer to the plaintext, which is replaced
+	 *		by the ciphertext.
+	 *	\param [in] size
+	 *		The number of bytes.
+	 */
+	void encrypt (void * ptr, std::size_t size);
+};
+
+/**
+ *	Decrypts the byte stream of a connection which was
+ *	encrypted using AES-128 in 8 bit cipher feedback
+ *	(CFB8) mode.
+ *
+ *	The stream is decrypted in place, as it is received
+ *	and before the packets within it are parsed. Each
+ *	byte must be decrypted exactly once, successive calls
+ *	continue the same stream. \ref connection_state does
+ *	this for bytes read through it once encryption has been
+ *	enabled.
+ *
+ *	Unlike encryption the input to every block operation
+ *	is known in advance when decrypting since it consists
+ *	entirely of ciphertext. Rather than performing one
+ *	block operation at a time, as OpenSSL's CFB8
+ *	implementation does, the inputs for many bytes are
+ *	gathered and encrypted in a single ECB mode call which
+ *	OpenSSL pipelines across the AES units of the processor.
+ *
+ *	Errors reported by OpenSSL cause \ref cipher_error
+ *	to be thrown.
+ */
+class cfb8_decryptor {
+private:
+	detail::cipher_context_ptr ctx_;
+	//	The last 16 bytes of ciphertext, or the
+	//	initialization vector if there have not
+	//	yet been 16 bytes
+	unsigned char register_ [16];
+public:
+	cfb8_decryptor (const cfb8_decryptor &) = delete;
+	cfb8_decryptor & operator = (const cfb8_decryptor &) = delete;
+	/**
+	 *	Creates a cfb8_decryptor whose initialization
+	 *	vector is its key, as in the Minecraft protocol.
+	 *
+	 *	\param [in] key
+	 *		The shared secret.
+	 */
+	explicit cfb8_decryptor (const unsigned char (& key) [16]);
+	/**
+	 *	Creates a cfb8_decryptor.
+	 *
+	 *	\param [in] key
+	 *		The key.
+	 *	\param [in] iv
+	 *		The initialization vector.
+	 */
+	cfb8_decryptor (const unsigned char (& key) [16], const unsigned char (& iv) [16]);
+	/**
+	 *	Decrypts bytes in place.
+	 *
+	 *	\param [in,out] ptr
+	 *		A pointer to the ciphertext, which is replaced
+	 *		by the plaintext.
+	 *	\param [in] size
+	 *		The number of bytes.
+	 */
+	void decrypt (void * ptr, std::size_t size);
+};
+
+}
+}
@@ -0,0 +1,221 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "packet_id.hpp"
+#include <boost/iostreams/filter/zlib.hpp>
+#include <cstddef>
+#include <unordered_map>
+
+namespace mcpp {
+namespace protocol {
+
+/**
+ *	The zlib settings with which a single packet
+ *	is compressed.
+ */
+class compression_params {
+public:
+	/**
+	 *	The compression level, see `boost::iostreams::zlib_params::level`.
+	 *	`boost::iostreams::zlib::no_compression` causes the
+	 *	packet to be framed as compressed but stored
+	 *	verbatim.
+	 */
+	int level;
+	/**
+	 *	The compression strategy, see `boost::iostreams::zlib_params::strategy`.
+	 */
+	int strategy;
+};
+
+bool operator == (const compression_params &, const compression_params &) noexcept;
+bool operator != (const compression_params &, const compression_params &) noexcept;
+
+/**
+ *	Chooses the settings with which each packet is
+ *	compressed.
+ *
+ *	The compression threshold negotiated with the peer
+ *	determines which packets \em must be sent compressed
+ *	and which must not. A compression_policy is consulted
+ *	only for packets which must be compressed and therefore
+ *	can never cause a protocol violation: the least it can
+ *	choose is \ref compression_params::level "level"
+ *	`boost::iostreams::zlib::no_compression` whereupon the
+ *	body is stored within a zlib stream rather than being
+ *	deflated.
+ *
+ *	Settings may be chosen for individual packet IDs
+ *	(for example a fast level for packets which are sent
+ *	often, a high level for large packets which compress
+ *	well, and no compression for packets whose contents
+ *	are known to be incompressible). All other packets
+ *	use the default settings.
+ *
+ *	In adaptive mode the policy additionally maintains an
+ *	effective threshold, at or above the negotiated one,
+ *	below which packets are stored rather than deflated.
+ *	It is derived from the compression ratio and CPU time
+ *	observed for recent packets (see \ref record) such that
+ *	packets are only deflated if doing so is expected to
+ *	save at least a certain number of bytes per microsecond
+ *	spent compressing. In order to track changes in traffic
+ *	a small fraction of packets below the effective threshold
+ *	are deflated regardless.
+ */
+class compression_policy {
+private:
+	compression_params default_;
+	std::unordered_map<packet_id, compression_params> params_;
+	bool adaptive_;
+	double min_saved_per_ns_;
+	std::size_t threshold_;
+	std::size_t since_probe_;
+	//	Exponentially decaying sums from which the cost
+	//	of compression is estimated by least squares
+	double weight_;
+	double size_;
+	double time_;
+	double size_size_;
+	double size_time_;
+	double saved_;
+	void update_threshold () noexcept;
+public:
+	/**
+	 *	Creates a compression_policy which compresses
+	 *	all packets with the default settings of zlib.
+	 */
+	compression_policy () noexcept;
+	/**
+	 *	Creates a compression_policy which compresses
+	 *	all packets with certain settings.
+	 *
+	 *	\param [in] params
+	 *		The default settings.
+	 */
+	explicit compression_policy (compression_params params) noexcept;
+	/**
+	 *	Creates a compression_policy which compresses all
+	 *	packets with the level and strategy from a set of
+	 *	zlib parameters.
+	 *
+	 *	\param [in] params
+	 *		The zlib parameters.
+	 */
+	explicit compression_policy (const boost::iostreams::zlib_params & params) noexcept;
+	/**
+	 *	Retrieves the default settings.
+	 *
+	 *	\return
+	 *		The settings used for packets for which no
+	 *		settings have been set.
+	 */
+	const compression_params & get () const noexcept;
+	/**
+	 *	Retrieves the settings for a certain packet ID.
+	 *
+	 *	\param [in] id
+	 *		The packet ID.
+	 *
+	 *	\return
+	 *		The settings set for \em id, or the default
+	 *		settings if there are none.
+	 */
+	const compression_params & get (const packet_id & id) const noexcept;
+	/**
+	 *	Sets the default settings.
+	 *
+	 *	\param [in] params
+	 *		The settings.
+	 */
+	void set (compression_params params) noexcept;
+	/**
+	 *	Sets the settings for a certain packet ID.
+	 *
+	 *	\param [in] id
+	 *		The packet ID.
+	 *	\param [in] params
+	 *		The settings.
+	 */
+	void set (const packet_id & id, compression_params params);
+	/**
+	 *	Causes a certain packet ID to use the default
+	 *	settings.
+	 *
+	 *	\param [in] id
+	 *		The packet ID.
+	 */
+	void unset (const packet_id & id) noexcept;
+	/**
+	 *	Enables adaptive mode.
+	 *
+	 *	If adaptive mode is already enabled the
+	 *	observations gathered thus far are retained.
+	 *
+	 *	\param [in] min_saved_per_us
+	 *		The minimum number of bytes deflating a packet
+	 *		must be expected to save per microsecond spent
+	 *		compressing it.
+	 */
+	void enable_adaptive (double min_saved_per_us) noexcept;
+	/**
+	 *	Disables adaptive mode and discards all
+	 *	observations.
+	 */
+	void disable_adaptive () noexcept;
+	/**
+	 *	Determines whether adaptive mode is enabled.
+	 *
+	 *	\return
+	 *		\em true if adaptive mode is enabled, \em false
+	 *		otherwise.
+	 */
+	bool adaptive () const noexcept;
+	/**
+	 *	Retrieves the effective threshold below which
+	 *	packets are stored rather than deflated.
+	 *
+	 *	Always zero unless adaptive mode is enabled.
+	 *
+	 *	\return
+	 *		The size of a packet body in bytes.
+	 */
+	std::size_t effective_threshold () const noexcept;
+	/**
+	 *	Chooses the settings for a packet which must be
+	 *	compressed.
+	 *
+	 *	\param [in] id
+	 *		The ID of the packet.
+	 *	\param [in] size
+	 *		The size of the uncompressed body of the packet
+	 *		in bytes.
+	 *
+	 *	\return
+	 *		The settings.
+	 */
+	compression_params select (const packet_id & id, std::size_t size) noexcept;
+	/**
+	 *	Informs the policy of the result of deflating a
+	 *	packet.
+	 *
+	 *	Does nothing unless adaptive mode is enabled.
+	 *	Packets which were stored rather than deflated
+	 *	should not be recorded.
+	 *
+	 *	\param [in] size
+	 *		The size of the uncompressed body in bytes.
+	 *	\param [in] compressed
+	 *		The size of the compressed body in bytes.
+	 *	\param [in] ns
+	 *		The time taken to compress the body in
+	 *		nanoseconds.
+	 */
+	void record (std::size_t size, std::size_t compressed, double ns) noexcept;
+};
+
+}
+}
@@ -0,0 +1,124 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "framed_packet.hpp"
+#include "zlib.hpp"
+#include <boost/iostreams/filter/zlib.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+
+/**
+ *	The state owned by each thread of a \ref compression_pool
+ *	and lent to each job that thread runs.
+ */
+class compression_worker {
+public:
+	compression_worker (const boost::iostreams::zlib_params & params);
+	/**
+	 *	A zlib stream which jobs may use freely.
+	 */
+	deflate_stream deflate;
+	/**
+	 *	Scratch space which jobs may use freely.
+	 */
+	std::vector<unsigned char> buffer;
+};
+
+/**
+ *	A pool of threads which compress packets on behalf
+ *	of \ref stream_serializer::serialize_async.
+ *
+ *	A single pool is intended to be shared by all the
+ *	connections of a server so that deflating large packets
+ *	does not stall the threads which perform I/O.
+ */
+class compression_pool {
+public:
+	/**
+	 *	A unit of work.
+	 */
+	using job = std::function<void (compression_worker &)>;
+private:
+	std::mutex m_;
+	std::condition_variable cv_;
+	std::deque<job> jobs_;
+	bool stop_;
+	std::vector<std::thread> threads_;
+	void run (const boost::iostreams::zlib_params & params);
+public:
+	compression_pool (const compression_pool &) = delete;
+	compression_pool (compression_pool &&) = delete;
+	compression_pool & operator = (const compression_pool &) = delete;
+	compression_pool & operator = (compression_pool &&) = delete;
+	/**
+	 *	Creates a compression_pool.
+	 *
+	 *	\param [in] threads
+	 *		The number of threads. Must not be zero.
+	 *	\param [in] params
+	 *		The parameters with which each thread's zlib
+	 *		stream shall be initialized. Only the window size
+	 *		and memory level are fixed by these, level and
+	 *		strategy are chosen per packet.
+	 */
+	explicit compression_pool (std::size_t threads, const boost::iostreams::zlib_params & params = boost::iostreams::zlib_params{});
+	/**
+	 *	Runs all jobs which have been posted and then
+	 *	stops and joins all threads.
+	 */
+	~compression_pool () noexcept;
+	/**
+	 *	Queues a job to be run by one of the threads.
+	 *
+	 *	\param [in] j
+	 *		The job. Must not throw.
+	 */
+	void post (job j);
+};
+
+namespace detail {
+
+//	Delivers the results of asynchronous serialization
+//	to their callbacks in the order in which the
+//	serializations were started, regardless of the
+//	order or thread in which they complete
+class completion_queue {
+public:
+	using callback = std::function<void (std::exception_ptr, framed_packet)>;
+private:
+	class slot {
+	public:
+		callback cb;
+		bool ready;
+		std::exception_ptr ex;
+		framed_packet p;
+	};
+	mutable std::mutex m_;
+	std::deque<slot> slots_;
+	std::size_t head_;
+	bool delivering_;
+	void drain ();
+public:
+	completion_queue () noexcept;
+	//	Returns the sequence number of the slot
+	std::size_t push (callback cb);
+	void complete (std::size_t seq, std::exception_ptr ex, framed_packet p);
+	std::size_t pending () const;
+};
+
+}
+
+}
+}
@@ -0,0 +1,210 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace mcpp {
+namespace protocol {
+
+/**
+ *	A non-owning reference to a contiguous region of
+ *	memory which is to be written.
+ *
+ *	Objects of this type convert implicitly to any type
+ *	which may be constructed from a pointer and a length,
+ *	notably `boost::asio::const_buffer`, so that a sequence
+ *	of them models Asio's `ConstBufferSequence` without
+ *	this library depending on Asio.
+ */
+class const_buffer {
+private:
+	const void * data_;
+	std::size_t size_;
+public:
+	/**
+	 *	Creates a const_buffer which refers to the
+	 *	empty region.
+	 */
+	const_buffer () noexcept
+		:	data_(nullptr),
+			size_(0)
+	{	}
+	/**
+	 *	Creates a const_buffer from a pointer and a
+	 *	length.
+	 *
+	 *	\param [in] data
+	 *		A pointer to the first byte.
+	 *	\param [in] size
+	 *		The number of bytes.
+	 */
+	const_buffer (const void * data, std::size_t size) noexcept
+		:	data_(data),
+			size_(size)
+	{	}
+	/**
+	 *	Obtains a pointer to the first byte.
+	 *
+	 *	\return
+	 *		A pointer.
+	 */
+	const void * data () const noexcept {
+		return data_;
+	}
+	/**
+	 *	Obtains the number of bytes.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t size () const noexcept {
+		return size_;
+	}
+	template <
+		typename Buffer,
+		typename = std::enable_if_t<std::is_constructible<Buffer, const void *, std::size_t>::value>
+	>
+	operator Buffer () const {
+		return Buffer(data_, size_);
+	}
+};
+
+/**
+ *	A fixed capacity sequence of \ref const_buffer
+ *	objects.
+ *
+ *	Models Asio's `ConstBufferSequence` and may therefore
+ *	be passed directly to `boost::asio::async_write` and
+ *	the like. Each element also exposes the pointer and
+ *	length required to fill an `iovec` for `writev`.
+ *
+ *	\tparam N
+ *		The maximum number of buffers.
+ */
+template <std::size_t N>
+class const_buffer_sequence {
+private:
+	const_buffer buffers_ [N];
+	std::size_t size_;
+public:
+	using value_type = const_buffer;
+	using const_iterator = const const_buffer *;
+	/**
+	 *	Creates an empty sequence.
+	 */
+	const_buffer_sequence () noexcept : size_(0) {	}
+	/**
+	 *	Appends a buffer to the sequence.
+	 *
+	 *	Empty buffers are not appended. If the sequence
+	 *	already holds \em N buffers the behavior is
+	 *	undefined.
+	 *
+	 *	\param [in] b
+	 *		The buffer.
+	 */
+	void push_back (const_buffer b) noexcept {
+		if (b.size() == 0) return;
+		assert(size_ < N);
+		buffers_[size_++] = b;
+	}
+	const_iterator begin () const noexcept {
+		return buffers_;
+	}
+	const_iterator end () const noexcept {
+		return buffers_ + size_;
+	}
+	/**
+	 *	Obtains the number of buffers in the sequence.
+	 *
+	 *	\return
+	 *		The number of buffers.
+	 */
+	std::size_t size () const noexcept {
+		return size_;
+	}
+	/**
+	 *	Obtains the total number of bytes referred to
+	 *	by all buffers in the sequence.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t bytes () const noexcept {
+		std::size_t retr(0);
+		for (auto && b : *this) retr += b.size();
+		return retr;
+	}
+};
+
+/**
+ *	A non-owning view of a contiguous array of
+ *	\ref const_buffer objects.
+ *
+ *	Like \ref const_buffer_sequence this models Asio's
+ *	`ConstBufferSequence`, but the number of buffers is
+ *	not bounded. Copying a view does not copy the buffers
+ *	to which it refers.
+ */
+class const_buffer_range {
+private:
+	const const_buffer * begin_;
+	const const_buffer * end_;
+public:
+	using value_type = const_buffer;
+	using const_iterator = const const_buffer *;
+	/**
+	 *	Creates an empty view.
+	 */
+	const_buffer_range () noexcept
+		:	begin_(nullptr),
+			end_(nullptr)
+	{	}
+	/**
+	 *	Creates a view of an array of buffers.
+	 *
+	 *	\param [in] begin
+	 *		A pointer to the first buffer.
+	 *	\param [in] end
+	 *		A pointer to one past the last buffer.
+	 */
+	const_buffer_range (const const_buffer * begin, const const_buffer * end) noexcept
+		:	begin_(begin),
+			end_(end)
+	{	}
+	const_iterator begin () const noexcept {
+		return begin_;
+	}
+	const_iterator end () const noexcept {
+		return end_;
+	}
+	/**
+	 *	Obtains the number of buffers in the view.
+	 *
+	 *	\return
+	 *		The number of buffers.
+	 */
+	std::size_t size () const noexcept {
+		return std::size_t(end_ - begin_);
+	}
+	/**
+	 *	Obtains the total number of bytes referred to
+	 *	by all buffers in the view.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t bytes () const noexcept {
+		std::size_t retr(0);
+		for (auto && b : *this) retr += b.size();
+		return retr;
+	}
+};
+
+}
+}
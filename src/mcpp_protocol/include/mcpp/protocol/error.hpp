@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <boost/system/error_code.hpp>
 #include <string>
 #include <system_error>
 #include <type_traits>
@@ -23,7 +24,10 @@ enum class error {
 	unexpected,	/**<	One of a set of values was expected but the given value was not among those	*/
 	inconsistent_length,	/**<	Length prefixed data was found to be shorter than the given length	*/
 	uncompressed,	/**<	Compressed data was expected but the input was uncompressed	*/
-	compressed	/**<	Uncompressed data was expected but the input was compressed	*/
+	compressed,	/**<	Uncompressed data was expected but the input was compressed	*/
+	encoding,	/**<	Text was not well formed UTF-8	*/
+	too_long,	/**<	Length prefixed data exceeded the maximum length permitted	*/
+	malformed	/**<	Data could not be parsed for a reason not described by any other value	*/
 };
 
 /**
@@ -50,6 +54,12 @@ const std::string & to_string (error c);
  */
 const std::error_category & error_category ();
 
+namespace detail {
+
+const boost::system::error_category & boost_error_category ();
+
+}
+
 /**
  *	Creates a `std::error_code` object from an \ref error
  *	enumeration value.
@@ -67,6 +67,26 @@ public:
 	using serialize_error::serialize_error;
 };
 
+/**
+ *	Indicates that a \ref framed_packet or raw frame was
+ *	framed for compression settings other than those in
+ *	effect.
+ */
+class framing_mismatch_error : public serialize_error {
+public:
+	using serialize_error::serialize_error;
+};
+
+/**
+ *	Indicates that OpenSSL reported an error while
+ *	encrypting or decrypting the byte stream of a
+ *	connection.
+ */
+class cipher_error : public exception {
+public:
+	using exception::exception;
+};
+
 /**
  *	Indicates that a \ref packet_serializer could not be
  *	found matching the runtime type of a \ref packet.
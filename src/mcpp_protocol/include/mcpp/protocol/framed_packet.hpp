@@ -0,0 +1,160 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "const_buffer.hpp"
+#include <mcpp/optional.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace mcpp {
+namespace protocol {
+
+namespace detail {
+
+class framed_packet_storage {
+public:
+	const void * data;
+	std::size_t size;
+	optional<std::size_t> threshold;
+};
+
+template <typename Allocator>
+class framed_packet_storage_t : public framed_packet_storage {
+private:
+	using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<unsigned char>;
+	std::vector<unsigned char, allocator_type> bytes_;
+public:
+	template <std::size_t N>
+	framed_packet_storage_t (const Allocator & alloc, const const_buffer_sequence<N> & buffers, optional<std::size_t> t)
+		:	bytes_(buffers.bytes(), allocator_type(alloc))
+	{
+		auto ptr = bytes_.data();
+		for (auto && b : buffers) {
+			std::memcpy(ptr, b.data(), b.size());
+			ptr += b.size();
+		}
+		data = bytes_.data();
+		size = bytes_.size();
+		threshold = t;
+	}
+};
+
+}
+
+/**
+ *	The complete, framed representation of a packet
+ *	(that is the length prefix, or prefixes in the case
+ *	of compressed mode, followed by the body, compressed
+ *	as applicable).
+ *
+ *	Objects of this type are obtained from \ref stream_serializer::frame
+ *	and may be written by any number of \ref stream_serializer
+ *	objects whose compression settings match those of the
+ *	\ref stream_serializer which framed them without the
+ *	packet being serialized or compressed again. This makes
+ *	sending the same packet to many connections cost a single
+ *	serialization.
+ *
+ *	The representation is immutable and shared between
+ *	copies, copying a framed_packet merely adjusts a
+ *	reference count. Copies may be used concurrently from
+ *	different threads.
+ */
+class framed_packet {
+private:
+	std::shared_ptr<const detail::framed_packet_storage> storage_;
+public:
+	/**
+	 *	Creates an empty framed_packet which does not
+	 *	hold the representation of any packet.
+	 */
+	framed_packet () = default;
+	/**
+	 *	Creates a framed_packet by copying the representation
+	 *	of a packet from a sequence of buffers.
+	 *
+	 *	\tparam Allocator
+	 *		The type of allocator used to allocate the
+	 *		shared representation.
+	 *	\tparam N
+	 *		The maximum number of buffers in \em buffers.
+	 *
+	 *	\param [in] alloc
+	 *		The allocator used to allocate the shared
+	 *		representation.
+	 *	\param [in] buffers
+	 *		The buffers which together hold the framed
+	 *		representation of the packet.
+	 *	\param [in] threshold
+	 *		The compression threshold for which the packet
+	 *		was framed, or an empty optional if it was
+	 *		framed without compression.
+	 */
+	template <typename Allocator, std::size_t N>
+	framed_packet (std::allocator_arg_t, const Allocator & alloc, const const_buffer_sequence<N> & buffers, optional<std::size_t> threshold)
+		:	storage_(std::allocate_shared<detail::framed_packet_storage_t<Allocator>>(alloc, alloc, buffers, threshold))
+	{	}
+	/**
+	 *	Determines whether this object holds the
+	 *	representation of a packet.
+	 *
+	 *	\return
+	 *		\em true if this object is empty, \em false
+	 *		otherwise.
+	 */
+	bool empty () const noexcept {
+		return !storage_;
+	}
+	/**
+	 *	Obtains the framed representation.
+	 *
+	 *	If \ref empty returns \em true the behavior
+	 *	is undefined.
+	 *
+	 *	\return
+	 *		A \ref const_buffer which remains valid for so
+	 *		long as any copy of this object exists.
+	 */
+	const_buffer buffer () const noexcept {
+		assert(!empty());
+		return const_buffer(storage_->data, storage_->size);
+	}
+	/**
+	 *	Determines whether the packet was framed with
+	 *	compression enabled.
+	 *
+	 *	If \ref empty returns \em true the behavior
+	 *	is undefined.
+	 *
+	 *	\return
+	 *		\em true if compression was enabled, \em false
+	 *		otherwise.
+	 */
+	bool compressed () const noexcept {
+		assert(!empty());
+		return bool(storage_->threshold);
+	}
+	/**
+	 *	Retrieves the compression threshold for which
+	 *	the packet was framed.
+	 *
+	 *	If \ref compressed returns \em false the behavior
+	 *	is undefined.
+	 *
+	 *	\return
+	 *		The compression threshold.
+	 */
+	std::size_t compression_threshold () const noexcept {
+		assert(compressed());
+		return *storage_->threshold;
+	}
+};
+
+}
+}
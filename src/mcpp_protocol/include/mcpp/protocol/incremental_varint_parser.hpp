@@ -5,18 +5,17 @@
 #pragma once
 
 #include "error.hpp"
+#include "span.hpp"
 #include "varint.hpp"
-#include <boost/core/ref.hpp>
 #include <boost/expected/expected.hpp>
-#include <boost/iostreams/compose.hpp>
-#include <boost/iostreams/tee.hpp>
-#include <mcpp/buffer.hpp>
-#include <mcpp/iostreams/concatenating_source.hpp>
+#include <boost/iostreams/get.hpp>
+#include <mcpp/iostreams/streambuf_area.hpp>
+#include <mcpp/iostreams/traits.hpp>
 #include <mcpp/optional.hpp>
 #include <cassert>
 #include <cstddef>
 #include <system_error>
-#include <utility>
+#include <type_traits>
 
 namespace mcpp {
 namespace protocol {
@@ -27,34 +26,82 @@ template <typename T, typename CharT>
 class incremental_varint_parser_base {
 static_assert(sizeof(CharT) == 1, "Varint serialization is byte oriented");
 private:
+	using raw_type = std::make_unsigned_t<T>;
 	static constexpr auto size = varint_size<T>;
-	CharT buffer_ [size];
-	using buffer_type = basic_buffer<CharT>;
-	buffer_type out_;
+	//	The bits of the value decoded so far and the
+	//	number of bytes they were decoded from, this
+	//	is all that is needed to resume the parse
+	raw_type value_;
+	std::size_t cached_;
+	void step (unsigned char curr) noexcept {
+		raw_type val(curr & 127);
+		auto i = cached_++;
+		//	Check for overflow on final byte
+		if ((i == (size - 1)) && (val & varint_overflow_mask<T>)) {
+			error_ = make_error_code(error::unrepresentable);
+			return;
+		}
+		value_ |= raw_type(val << (varint_bits_per_byte * i));
+		if (curr == val) {
+			//	Reject overlong encodings
+			if ((i != 0) && (curr == 0)) error_ = make_error_code(error::overlong);
+			else res_ = detail::varint_cast<T>(value_);
+			return;
+		}
+		if (cached_ == size) error_ = make_error_code(error::unrepresentable);
+	}
+	std::size_t consume (const unsigned char * begin, const unsigned char * end) noexcept {
+		auto curr = begin;
+		while ((curr != end) && !done()) step(*(curr++));
+		return std::size_t(curr - begin);
+	}
 protected:
 	optional<T> res_;
+	std::error_code error_;
+	bool done () const noexcept {
+		return res_ || error_;
+	}
+	template <typename Source>
+	void feed (Source & src, const std::false_type &) {
+		using traits_type = iostreams::traits_of_t<Source>;
+		while (!done()) {
+			auto in = boost::iostreams::get(src);
+			if ((in == traits_type::eof()) || (in == traits_type::would_block())) return;
+			step(static_cast<unsigned char>(traits_type::to_char_type(in)));
+		}
+	}
 	template <typename Source>
-	using source_type = iostreams::concatenating_source<
-		buffer_type,
-		boost::iostreams::composite<
-			boost::iostreams::tee_filter<
-				boost::reference_wrapper<buffer_type>
-			>,
-			boost::reference_wrapper<Source>
-		>
-	>;
+	void feed (Source & src, const std::true_type &) {
+		using traits_type = typename Source::traits_type;
+		while (!done()) {
+			auto begin = reinterpret_cast<const unsigned char *>(iostreams::gptr(src));
+			auto end = reinterpret_cast<const unsigned char *>(iostreams::egptr(src));
+			iostreams::gbump(src, consume(begin, end));
+			if (done()) return;
+			//	The get area is exhausted, let the
+			//	streambuf underflow
+			auto in = src.sbumpc();
+			if (traits_type::eq_int_type(in, traits_type::eof())) return;
+			step(static_cast<unsigned char>(traits_type::to_char_type(in)));
+		}
+	}
 	template <typename Source>
-	source_type<Source> make_source (Source & src) {
-		return iostreams::make_concatenating_source(
-			buffer_type(buffer_, out_.written()),
-			boost::iostreams::compose(
-				boost::iostreams::tee(boost::ref(out_)),
-				boost::ref(src)
-			)
-		);
+	void feed (Source & src) {
+		std::integral_constant<bool, iostreams::is_streambuf_v<Source>> tag;
+		feed(src, tag);
+	}
+	void feed (span_reader & src) noexcept {
+		src.advance(consume(src.current(), src.end()));
+	}
+	boost::expected<optional<T>, std::error_code> result () const {
+		if (error_) return boost::make_unexpected(error_);
+		return res_;
 	}
 public:
-	incremental_varint_parser_base () : out_(buffer_) {	}
+	incremental_varint_parser_base () noexcept
+		:	value_(0),
+			cached_(0)
+	{	}
 	incremental_varint_parser_base (const incremental_varint_parser_base &) = delete;
 	incremental_varint_parser_base (incremental_varint_parser_base &&) = delete;
 	incremental_varint_parser_base & operator = (const incremental_varint_parser_base &) = delete;
@@ -67,21 +114,23 @@ public:
 	 *	and any result.
 	 */
 	void reset () noexcept {
-		out_.assign(buffer_);
+		value_ = 0;
+		cached_ = 0;
 		res_ = nullopt;
+		error_.clear();
 	}
 	/**
-	 *	Retrieves the number of characters cached
-	 *	by the parser. After a Varint has successfully
-	 *	been parsed this shall return the length of
-	 *	the representation thereof until \ref reset
-	 *	is called.
+	 *	Retrieves the number of characters consumed
+	 *	by the parser since it was last reset. After
+	 *	a Varint has successfully been parsed this
+	 *	shall return the length of the representation
+	 *	thereof until \ref reset is called.
 	 *
 	 *	\return
 	 *		The number of characters cached.
 	 */
 	std::size_t cached () const noexcept {
-		return out_.written();
+		return cached_;
 	}
 	/**
 	 *	Determines whether or not this parser has
@@ -116,9 +165,21 @@ public:
  *	As opposed to \ref parse_varint which either
  *	parses a Varint or returns \ref error::end_of_file
  *	if there are insufficient bytes this class will
- *	retain consumed bytes between calls to \ref parse
- *	and reuse them as more bytes are made available
- *	until an entire Varint is parsed.
+ *	retain the state of the parse between calls to
+ *	\ref parse and resume it as more bytes are made
+ *	available until an entire Varint is parsed.
+ *
+ *	Only the bits decoded so far and the number of
+ *	bytes consumed are retained, each call examines
+ *	only bytes which have not yet been consumed and
+ *	nothing is allocated. If \em src is a
+ *	`std::basic_streambuf` or a \ref span_reader bytes
+ *	are examined directly in the memory they manage.
+ *
+ *	Errors are identical to those \ref parse_varint
+ *	would report given all the bytes consumed. Once an
+ *	error is reported it is reported by every subsequent
+ *	call to \ref parse until \ref reset is invoked.
  *
  *	\tparam T
  *		The type of integer to parse. Must be an integer
@@ -136,8 +197,9 @@ private:
 	using base = detail::incremental_varint_parser_base<T, CharT>;
 public:
 	/**
-	 *	Attempts to parse a Varint, caching consumed
-	 *	bytes for the next call if that is not possible.
+	 *	Attempts to parse a Varint, retaining the state
+	 *	of the parse for the next call if that is not
+	 *	possible.
 	 *
 	 *	Once an integer is returned that integer will be
 	 *	returned unconditionally and no further bytes
@@ -157,12 +219,8 @@ public:
 	 */
 	template <typename Source>
 	typename base::parse_result_type parse (Source & src) {
-		if (base::res_) return base::res_;
-		auto impl = base::make_source(src);
-		auto res = protocol::parse_varint<T>(impl);
-		if (res) return base::res_ = make_optional(*res);
-		if (res.error() == make_error_code(error::end_of_file)) return optional<T>{};
-		return res.get_unexpected();
+		if (!base::done()) base::feed(src);
+		return base::result();
 	}
 };
 
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include "byte_swap.hpp"
 #include "error.hpp"
 #include "exception.hpp"
+#include "span.hpp"
 //	In Boost 1.61.0 including boost/endian/endian.hpp
 //	is an error whereas in Boost 1.55.0 boost/endian/conversion.hpp
 //	doesn't exist apparently
@@ -17,11 +19,16 @@
 #include <boost/expected/expected.hpp>
 #include <boost/iostreams/read.hpp>
 #include <boost/iostreams/write.hpp>
+#include <mcpp/iostreams/streambuf_area.hpp>
 #include <mcpp/iostreams/traits.hpp>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <ios>
+#include <limits>
 #include <system_error>
+#include <type_traits>
 
 namespace mcpp {
 namespace protocol {
@@ -57,6 +64,34 @@ boost::expected<T, std::error_code> parse_int (Source & src) {
 	boost::endian::big_to_native_inplace(retr);
 	return retr;
 }
+/**
+ *	Parses an integer directly from the memory managed
+ *	by a \ref span_reader.
+ *
+ *	\tparam T
+ *		The type of integer to parse.
+ *
+ *	\param [in] src
+ *		The \ref span_reader from which to read.
+ *
+ *	\return
+ *		The integer which was parsed. If fewer bytes than
+ *		the size of \em T remain a `std::error_code`
+ *		object will be returned and nothing will be
+ *		consumed.
+ */
+template <typename T>
+boost::expected<T, std::error_code> parse_int (span_reader & src) {
+	constexpr std::size_t size = sizeof(T);
+	if (src.remaining() < size) return boost::make_unexpected(
+		make_error_code(error::end_of_file)
+	);
+	T retr;
+	std::memcpy(&retr, src.current(), size);
+	src.advance(size);
+	boost::endian::big_to_native_inplace(retr);
+	return retr;
+}
 /**
  *	Functions identically to \ref parse_int except assigns
  *	the parsed integer to a variable rather than transmitting
@@ -146,6 +181,342 @@ void serialize_int (T val, Sink & sink) {
 	std::size_t i(boost::iostreams::write(sink, ptr, std::streamsize(size)));
 	if (i != size) throw write_overflow_error(size, i);
 }
+/**
+ *	Serializes an integer directly to the memory managed
+ *	by a \ref span_writer.
+ *
+ *	\tparam T
+ *		The type of integer to serialize.
+ *
+ *	\param [in] val
+ *		The integer to serialize.
+ *	\param [in] sink
+ *		The \ref span_writer to write to. If there
+ *		is insufficient room nothing is written and
+ *		\ref write_overflow_error is thrown.
+ */
+template <typename T>
+void serialize_int (T val, span_writer & sink) {
+	constexpr std::size_t size = sizeof(T);
+	if (sink.remaining() < size) throw write_overflow_error(size, 0);
+	boost::endian::native_to_big_inplace(val);
+	std::memcpy(sink.current(), &val, size);
+	sink.advance(size);
+}
+
+namespace detail {
+
+template <std::size_t Size>
+void convert_big_endian (const void * src, void * dst, std::size_t n) noexcept {
+	if ((Size == 1) || (boost::endian::order::native == boost::endian::order::big)) {
+		if (src != dst) std::memcpy(dst, src, n * Size);
+		return;
+	}
+	protocol::byte_swap(src, dst, n, Size);
+}
+
+template <std::size_t Size, typename Source>
+boost::expected<void, std::error_code> parse_array (Source & src, unsigned char * ptr, std::size_t n, const std::false_type &) {
+	using pointer_type = iostreams::char_type_of_t<Source> *;
+	std::size_t size(n * Size);
+	std::size_t read(0);
+	while (read != size) {
+		auto num = boost::iostreams::read(src, reinterpret_cast<pointer_type>(ptr + read), std::streamsize(size - read));
+		if (num == -1) return boost::make_unexpected(make_error_code(error::end_of_file));
+		read += std::size_t(num);
+	}
+	detail::convert_big_endian<Size>(ptr, ptr, n);
+	return boost::expected<void, std::error_code>{};
+}
+template <std::size_t Size, typename Source>
+boost::expected<void, std::error_code> parse_array (Source & src, unsigned char * ptr, std::size_t n, const std::true_type &) {
+	//	Whatever is already buffered is converted straight
+	//	out of the get area, the remainder is read in
+	//	place and converted
+	std::size_t avail = std::min(iostreams::get_available(src) / Size, n);
+	detail::convert_big_endian<Size>(iostreams::gptr(src), ptr, avail);
+	iostreams::gbump(src, avail * Size);
+	if (avail == n) return boost::expected<void, std::error_code>{};
+	return detail::parse_array<Size>(src, ptr + (avail * Size), n - avail, std::false_type{});
+}
+template <std::size_t Size>
+boost::expected<void, std::error_code> parse_array (span_reader & src, unsigned char * ptr, std::size_t n) {
+	if ((src.remaining() / Size) < n) return boost::make_unexpected(make_error_code(error::end_of_file));
+	detail::convert_big_endian<Size>(src.current(), ptr, n);
+	src.advance(n * Size);
+	return boost::expected<void, std::error_code>{};
+}
+template <std::size_t Size, typename Source>
+boost::expected<void, std::error_code> parse_array (Source & src, unsigned char * ptr, std::size_t n) {
+	std::integral_constant<bool,
+		iostreams::is_streambuf_v<Source> &&
+		(sizeof(iostreams::char_type_of_t<Source>) == 1)
+	> tag;
+	return detail::parse_array<Size>(src, ptr, n, tag);
+}
+
+template <std::size_t Size, typename Sink>
+void serialize_array (const unsigned char * ptr, std::size_t n, Sink & sink, const std::false_type &) {
+	using pointer_type = const iostreams::char_type_of_t<Sink> *;
+	constexpr std::size_t per = 256 / Size;
+	unsigned char buffer [per * Size];
+	while (n != 0) {
+		std::size_t num = std::min(n, per);
+		std::size_t size(num * Size);
+		detail::convert_big_endian<Size>(ptr, buffer, num);
+		std::size_t written(boost::iostreams::write(sink, reinterpret_cast<pointer_type>(buffer), std::streamsize(size)));
+		if (written != size) throw write_overflow_error(size, written);
+		ptr += size;
+		n -= num;
+	}
+}
+template <std::size_t Size, typename Sink>
+void serialize_array (const unsigned char * ptr, std::size_t n, Sink & sink, const std::true_type &) {
+	std::size_t avail = std::min(iostreams::put_available(sink) / Size, n);
+	detail::convert_big_endian<Size>(ptr, iostreams::pptr(sink), avail);
+	iostreams::pbump(sink, avail * Size);
+	if (avail != n) detail::serialize_array<Size>(ptr + (avail * Size), n - avail, sink, std::false_type{});
+}
+template <std::size_t Size>
+void serialize_array (const unsigned char * ptr, std::size_t n, span_writer & sink) {
+	if ((sink.remaining() / Size) < n) throw write_overflow_error(n * Size, 0);
+	detail::convert_big_endian<Size>(ptr, sink.current(), n);
+	sink.advance(n * Size);
+}
+template <std::size_t Size, typename Sink>
+void serialize_array (const unsigned char * ptr, std::size_t n, Sink & sink) {
+	std::integral_constant<bool,
+		iostreams::is_streambuf_v<Sink> &&
+		(sizeof(iostreams::char_type_of_t<Sink>) == 1)
+	> tag;
+	detail::serialize_array<Size>(ptr, n, sink, tag);
+}
+
+template <typename T>
+using float_bits_t = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+template <typename T>
+constexpr bool is_wire_float_v = std::is_floating_point<T>::value &&
+	std::numeric_limits<T>::is_iec559 &&
+	((sizeof(T) == 4) || (sizeof(T) == 8));
+
+}
+
+/**
+ *	Parses a sequence of integers from a binary stream.
+ *
+ *	The number of integers is not read from \em src,
+ *	it is the responsibility of the caller to parse
+ *	any length prefix.
+ *
+ *	The result is identical to invoking \ref parse_int
+ *	\em n times. However the bytes are read into \em ptr
+ *	in as few operations as possible and reordered in a
+ *	single pass by \ref byte_swap. If \em src is a
+ *	`std::basic_streambuf` integers are converted directly
+ *	out of its get area, and if \em src is a \ref span_reader
+ *	directly out of the memory it manages (in which case
+ *	nothing is consumed on failure).
+ *
+ *	\tparam Source
+ *		A type which models `Source`.
+ *	\tparam T
+ *		The type of integer to parse.
+ *
+ *	\param [in] src
+ *		The `Source` from which to read.
+ *	\param [out] ptr
+ *		A pointer to the first of \em n integers to
+ *		which the parsed values shall be assigned. If
+ *		the parse fails the values of these integers
+ *		are unspecified.
+ *	\param [in] n
+ *		The number of integers to parse.
+ *
+ *	\return
+ *		Nothing on success. A `std::error_code` on failure.
+ */
+template <typename Source, typename T>
+boost::expected<void, std::error_code> parse_int_array (Source & src, T * ptr, std::size_t n) {
+	static_assert(std::is_integral<T>::value, "T must be an integer type");
+	return detail::parse_array<sizeof(T)>(src, reinterpret_cast<unsigned char *>(ptr), n);
+}
+
+/**
+ *	Serializes a sequence of integers to a binary
+ *	stream.
+ *
+ *	The number of integers is not written, it is the
+ *	responsibility of the caller to serialize any
+ *	length prefix.
+ *
+ *	The bytes written are identical to those which
+ *	would be written by invoking \ref serialize_int
+ *	\em n times. However integers are reordered by
+ *	\ref byte_swap many at a time and written to
+ *	\em sink in large chunks. If \em sink is a
+ *	`std::basic_streambuf` integers are converted directly
+ *	into its put area, and if \em sink is a \ref span_writer
+ *	directly into the memory it manages (in which case
+ *	nothing is written if there is insufficient room).
+ *
+ *	\tparam T
+ *		The type of integer to serialize.
+ *	\tparam Sink
+ *		A type which models `Sink`.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first of \em n integers to
+ *		serialize.
+ *	\param [in] n
+ *		The number of integers to serialize.
+ *	\param [in] sink
+ *		An object which models `Sink` to which
+ *		bytes shall be written.
+ */
+template <typename T, typename Sink>
+void serialize_int_array (const T * ptr, std::size_t n, Sink & sink) {
+	static_assert(std::is_integral<T>::value, "T must be an integer type");
+	detail::serialize_array<sizeof(T)>(reinterpret_cast<const unsigned char *>(ptr), n, sink);
+}
+
+/**
+ *	Parses an IEEE 754 binary32 or binary64 floating
+ *	point number from a binary stream.
+ *
+ *	The representation is the big endian representation
+ *	of the integer with the same bits.
+ *
+ *	\tparam T
+ *		`float` or `double`.
+ *	\tparam Source
+ *		A type which models `Source`.
+ *
+ *	\param [in] src
+ *		An object which models `Source` from which to
+ *		read raw bytes.
+ *
+ *	\return
+ *		The number which was parsed. If a number could
+ *		not be parsed a `std::error_code` object will
+ *		be returned encapsulating the reason for the
+ *		failure.
+ */
+template <typename T, typename Source>
+boost::expected<T, std::error_code> parse_float (Source & src) {
+	static_assert(detail::is_wire_float_v<T>, "T must be an IEEE 754 binary32 or binary64 type");
+	return protocol::parse_int<detail::float_bits_t<T>>(src).map([] (auto bits) noexcept {
+		T retr;
+		std::memcpy(&retr, &bits, sizeof(retr));
+		return retr;
+	});
+}
+/**
+ *	Functions identically to \ref parse_float except assigns
+ *	the parsed number to a variable rather than transmitting
+ *	it through its return value.
+ *
+ *	\tparam Source
+ *		A type which models `Source`.
+ *	\tparam T
+ *		`float` or `double`.
+ *
+ *	\param [in] src
+ *		An object which models `Source` from which to read raw
+ *		bytes.
+ *	\param [out] val
+ *		The variable to assign the result to. On error the value
+ *		of this variable is unspecified.
+ *
+ *	\return
+ *		Nothing on success. A `std::error_code` object if the
+ *		parse failed.
+ */
+template <typename Source, typename T>
+boost::expected<void, std::error_code> parse_float (Source & src, T & val) {
+	return protocol::parse_float<T>(src).map([&] (auto f) noexcept {	val = f;	});
+}
+
+/**
+ *	Serializes an IEEE 754 binary32 or binary64 floating
+ *	point number to a binary stream.
+ *
+ *	\tparam T
+ *		`float` or `double`.
+ *	\tparam Sink
+ *		A type which models `Sink`.
+ *
+ *	\param [in] val
+ *		The number to serialize.
+ *	\param [in] sink
+ *		An object which models `Sink` to which
+ *		bytes shall be written.
+ */
+template <typename T, typename Sink>
+void serialize_float (T val, Sink & sink) {
+	static_assert(detail::is_wire_float_v<T>, "T must be an IEEE 754 binary32 or binary64 type");
+	detail::float_bits_t<T> bits;
+	std::memcpy(&bits, &val, sizeof(bits));
+	protocol::serialize_int(bits, sink);
+}
+
+/**
+ *	Parses a sequence of floating point numbers from
+ *	a binary stream.
+ *
+ *	Behaves exactly as \ref parse_int_array does for
+ *	integers.
+ *
+ *	\tparam Source
+ *		A type which models `Source`.
+ *	\tparam T
+ *		`float` or `double`.
+ *
+ *	\param [in] src
+ *		The `Source` from which to read.
+ *	\param [out] ptr
+ *		A pointer to the first of \em n numbers to
+ *		which the parsed values shall be assigned. If
+ *		the parse fails the values of these numbers
+ *		are unspecified.
+ *	\param [in] n
+ *		The number of numbers to parse.
+ *
+ *	\return
+ *		Nothing on success. A `std::error_code` on failure.
+ */
+template <typename Source, typename T>
+boost::expected<void, std::error_code> parse_float_array (Source & src, T * ptr, std::size_t n) {
+	static_assert(detail::is_wire_float_v<T>, "T must be an IEEE 754 binary32 or binary64 type");
+	return detail::parse_array<sizeof(T)>(src, reinterpret_cast<unsigned char *>(ptr), n);
+}
+
+/**
+ *	Serializes a sequence of floating point numbers to
+ *	a binary stream.
+ *
+ *	Behaves exactly as \ref serialize_int_array does for
+ *	integers.
+ *
+ *	\tparam T
+ *		`float` or `double`.
+ *	\tparam Sink
+ *		A type which models `Sink`.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first of \em n numbers to
+ *		serialize.
+ *	\param [in] n
+ *		The number of numbers to serialize.
+ *	\param [in] sink
+ *		An object which models `Sink` to which
+ *		bytes shall be written.
+ */
+template <typename T, typename Sink>
+void serialize_float_array (const T * ptr, std::size_t n, Sink & sink) {
+	static_assert(detail::is_wire_float_v<T>, "T must be an IEEE 754 binary32 or binary64 type");
+	detail::serialize_array<sizeof(T)>(reinterpret_cast<const unsigned char *>(ptr), n, sink);
+}
 
 }
 }
@@ -31,7 +31,7 @@ void insert (packet_serializer_map_t<Source, Sink, Allocator> & map) {
 			Sink,
 			PacketParameters
 		>
-	>(map.get_allocator());
+	>(map.get_allocator(), map.get_allocator());
 	map.insert(std::move(ptr));
 }
 
@@ -0,0 +1,335 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <boost/iostreams/categories.hpp>
+#include <mcpp/iostreams/streambuf_area.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <ios>
+#include <streambuf>
+
+namespace mcpp {
+namespace protocol {
+
+/**
+ *	A cursor over a contiguous region of memory from
+ *	which the representation of values may be parsed.
+ *
+ *	Once an entire packet body is buffered parsing
+ *	through a span_reader avoids the per character
+ *	indirection of Boost.IOStreams: \ref parse_int,
+ *	\ref parse_varint, and \ref parse_string are
+ *	overloaded to work directly on the managed pointers
+ *	and check bounds against them.
+ *
+ *	Objects of this type also model `Source` so that
+ *	they may be passed to any function which parses
+ *	from a `Source`.
+ *
+ *	No copy is made of the region of memory and
+ *	therefore it must remain valid so long as the
+ *	span_reader is used.
+ */
+class span_reader {
+private:
+	const unsigned char * begin_;
+	const unsigned char * current_;
+	const unsigned char * end_;
+public:
+	class category
+		:	public boost::iostreams::device_tag,
+			public boost::iostreams::input
+	{	};
+	using char_type = char;
+	/**
+	 *	Creates a span_reader over the empty region.
+	 */
+	span_reader () noexcept
+		:	begin_(nullptr),
+			current_(nullptr),
+			end_(nullptr)
+	{	}
+	/**
+	 *	Creates a span_reader from a pointer and a
+	 *	length.
+	 *
+	 *	\param [in] ptr
+	 *		A pointer to the first byte.
+	 *	\param [in] len
+	 *		The number of bytes.
+	 */
+	span_reader (const void * ptr, std::size_t len) noexcept
+		:	begin_(static_cast<const unsigned char *>(ptr)),
+			current_(begin_),
+			end_(begin_ + len)
+	{	}
+	/**
+	 *	Creates a span_reader from a pointer to the
+	 *	first byte and a pointer to one past the last
+	 *	byte.
+	 *
+	 *	\param [in] begin
+	 *		A pointer to the first byte.
+	 *	\param [in] end
+	 *		A pointer to one past the last byte.
+	 */
+	span_reader (const void * begin, const void * end) noexcept
+		:	begin_(static_cast<const unsigned char *>(begin)),
+			current_(begin_),
+			end_(static_cast<const unsigned char *>(end))
+	{	}
+	std::streamsize read (char_type * s, std::streamsize n) noexcept {
+		if (current_ == end_) return -1;
+		std::size_t num = std::min(remaining(), std::size_t(n));
+		std::memcpy(s, current_, num);
+		current_ += num;
+		return std::streamsize(num);
+	}
+	/**
+	 *	Obtains a pointer to the next byte to be read.
+	 *
+	 *	\return
+	 *		A pointer.
+	 */
+	const unsigned char * current () const noexcept {
+		return current_;
+	}
+	/**
+	 *	Obtains a pointer to one past the last byte
+	 *	which may be read.
+	 *
+	 *	\return
+	 *		A pointer.
+	 */
+	const unsigned char * end () const noexcept {
+		return end_;
+	}
+	/**
+	 *	Determines the number of bytes which may still
+	 *	be read.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t remaining () const noexcept {
+		return std::size_t(end_ - current_);
+	}
+	/**
+	 *	Determines whether all bytes have been read.
+	 *
+	 *	\return
+	 *		\em true if no bytes remain, \em false
+	 *		otherwise.
+	 */
+	bool empty () const noexcept {
+		return current_ == end_;
+	}
+	/**
+	 *	Determines the number of bytes which have been
+	 *	read.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t consumed () const noexcept {
+		return std::size_t(current_ - begin_);
+	}
+	/**
+	 *	Consumes bytes which were examined by way of
+	 *	\ref current.
+	 *
+	 *	If \em n is greater than the value returned by
+	 *	\ref remaining the behavior is undefined.
+	 *
+	 *	\param [in] n
+	 *		The number of bytes.
+	 */
+	void advance (std::size_t n) noexcept {
+		assert(n <= remaining());
+		current_ += n;
+	}
+};
+
+/**
+ *	A cursor over a contiguous region of memory to
+ *	which the representation of values may be written.
+ *
+ *	\ref serialize_int and \ref serialize_varint are
+ *	overloaded to write directly through the managed
+ *	pointers. Writing past the end of the region throws
+ *	\ref write_overflow_error just as writing to any
+ *	other `Sink` which fills up does.
+ *
+ *	Objects of this type also model `Sink` so that
+ *	they may be passed to any function which writes
+ *	to a `Sink`.
+ *
+ *	No copy is made of the region of memory and
+ *	therefore it must remain valid so long as the
+ *	span_writer is used.
+ */
+class span_writer {
+private:
+	unsigned char * begin_;
+	unsigned char * current_;
+	unsigned char * end_;
+public:
+	class category
+		:	public boost::iostreams::device_tag,
+			public boost::iostreams::output
+	{	};
+	using char_type = char;
+	/**
+	 *	Creates a span_writer over the empty region.
+	 */
+	span_writer () noexcept
+		:	begin_(nullptr),
+			current_(nullptr),
+			end_(nullptr)
+	{	}
+	/**
+	 *	Creates a span_writer from a pointer and a
+	 *	length.
+	 *
+	 *	\param [in] ptr
+	 *		A pointer to the first byte.
+	 *	\param [in] len
+	 *		The number of bytes.
+	 */
+	span_writer (void * ptr, std::size_t len) noexcept
+		:	begin_(static_cast<unsigned char *>(ptr)),
+			current_(begin_),
+			end_(begin_ + len)
+	{	}
+	/**
+	 *	Creates a span_writer from a pointer to the
+	 *	first byte and a pointer to one past the last
+	 *	byte.
+	 *
+	 *	\param [in] begin
+	 *		A pointer to the first byte.
+	 *	\param [in] end
+	 *		A pointer to one past the last byte.
+	 */
+	span_writer (void * begin, void * end) noexcept
+		:	begin_(static_cast<unsigned char *>(begin)),
+			current_(begin_),
+			end_(static_cast<unsigned char *>(end))
+	{	}
+	std::streamsize write (const char_type * s, std::streamsize n) noexcept {
+		std::size_t num = std::min(remaining(), std::size_t(n));
+		if (num == 0) return 0;
+		std::memcpy(current_, s, num);
+		current_ += num;
+		return std::streamsize(num);
+	}
+	/**
+	 *	Obtains a pointer to the next byte to be
+	 *	written.
+	 *
+	 *	\return
+	 *		A pointer.
+	 */
+	unsigned char * current () const noexcept {
+		return current_;
+	}
+	/**
+	 *	Obtains a pointer to one past the last byte
+	 *	which may be written.
+	 *
+	 *	\return
+	 *		A pointer.
+	 */
+	unsigned char * end () const noexcept {
+		return end_;
+	}
+	/**
+	 *	Determines the number of bytes which may still
+	 *	be written.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t remaining () const noexcept {
+		return std::size_t(end_ - current_);
+	}
+	/**
+	 *	Determines the number of bytes which have been
+	 *	written.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t written () const noexcept {
+		return std::size_t(current_ - begin_);
+	}
+	/**
+	 *	Commits bytes which were written by way of
+	 *	\ref current.
+	 *
+	 *	If \em n is greater than the value returned by
+	 *	\ref remaining the behavior is undefined.
+	 *
+	 *	\param [in] n
+	 *		The number of bytes.
+	 */
+	void advance (std::size_t n) noexcept {
+		assert(n <= remaining());
+		current_ += n;
+	}
+};
+
+/**
+ *	Creates a \ref span_reader over the characters
+ *	buffered in the get area of a `std::basic_streambuf`.
+ *
+ *	Reading through the returned object does not
+ *	consume characters from \em sb, once parsing is
+ *	complete the characters may be consumed by passing
+ *	the value returned by \ref span_reader::consumed
+ *	to \ref iostreams::gbump.
+ *
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		A \ref span_reader.
+ */
+template <typename Traits>
+span_reader make_span_reader (const std::basic_streambuf<char, Traits> & sb) noexcept {
+	return span_reader(iostreams::gptr(sb), iostreams::egptr(sb));
+}
+/**
+ *	Creates a \ref span_writer over the space available
+ *	in the put area of a `std::basic_streambuf`.
+ *
+ *	Writing through the returned object does not
+ *	commit characters to \em sb, once serialization is
+ *	complete the characters may be committed by passing
+ *	the value returned by \ref span_writer::written
+ *	to \ref iostreams::pbump.
+ *
+ *	\tparam Traits
+ *		The traits type of \em sb.
+ *
+ *	\param [in] sb
+ *		The `std::basic_streambuf`.
+ *
+ *	\return
+ *		A \ref span_writer.
+ */
+template <typename Traits>
+span_writer make_span_writer (const std::basic_streambuf<char, Traits> & sb) noexcept {
+	return span_writer(iostreams::pptr(sb), iostreams::epptr(sb));
+}
+
+}
+}
@@ -4,38 +4,49 @@
 
 #pragma once
 
+#include "arena.hpp"
+#include "buffer_pool.hpp"
+#include "checked.hpp"
+#include "compression_policy.hpp"
+#include "compression_pool.hpp"
+#include "const_buffer.hpp"
 #include "direction.hpp"
 #include "error.hpp"
 #include "exception.hpp"
+#include "framed_packet.hpp"
 #include "incremental_varint_parser.hpp"
 #include "packet.hpp"
 #include "packet_id.hpp"
 #include "packet_serializer.hpp"
 #include "packet_serializer_map_t.hpp"
+#include "span.hpp"
 #include "state.hpp"
 #include "varint.hpp"
+#include "zlib.hpp"
 #include <boost/core/ref.hpp>
 #include <boost/expected/expected.hpp>
 #include <boost/interprocess/streams/vectorstream.hpp>
-#include <boost/iostreams/compose.hpp>
-#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/write.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
 #include <mcpp/buffer.hpp>
 #include <mcpp/checked.hpp>
-#include <mcpp/iostreams/concatenating_source.hpp>
 #include <mcpp/iostreams/limiting_source.hpp>
-#include <mcpp/iostreams/offset.hpp>
-#include <mcpp/iostreams/proxy_sink.hpp>
-#include <mcpp/iostreams/proxy_source.hpp>
+#include <mcpp/iostreams/streambuf_area.hpp>
 #include <mcpp/iostreams/traits.hpp>
 #include <mcpp/optional.hpp>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <exception>
 #include <ios>
 #include <memory>
 #include <sstream>
 #include <system_error>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -81,12 +92,61 @@ private:
 		iostreams::traits_of_t<Device>
 	>;
 	using size_type = std::uint32_t;
+	//	A vectorbuf whose get area is set to a view of
+	//	contiguous memory it does not own, packet bodies
+	//	are parsed from such a view so that they need not
+	//	be copied into the vector
+	template <typename VectorBuf>
+	class in_place_vectorbuf final : public VectorBuf {
+	public:
+		using char_type = typename VectorBuf::char_type;
+		using pos_type = typename VectorBuf::pos_type;
+		using off_type = typename VectorBuf::off_type;
+		template <typename VectorAllocator>
+		in_place_vectorbuf (const VectorAllocator & alloc, const char_type * ptr, std::size_t size)
+			:	VectorBuf(typename VectorBuf::vector_type(alloc), std::ios_base::in)
+		{
+			auto begin = const_cast<char_type *>(ptr);
+			this->setg(begin, begin, begin + size);
+		}
+		std::size_t read () const noexcept {
+			return std::size_t(this->gptr() - this->eback());
+		}
+	protected:
+		virtual pos_type seekoff (off_type off, std::ios_base::seekdir dir, std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out) override {
+			if (mode & std::ios_base::out) return pos_type(off_type(-1));
+			auto size = off_type(this->egptr() - this->eback());
+			off_type base(0);
+			if (dir == std::ios_base::cur) base = off_type(read());
+			else if (dir == std::ios_base::end) base = size;
+			auto pos = base + off;
+			if ((pos < 0) || (pos > size)) return pos_type(off_type(-1));
+			this->setg(this->eback(), this->eback() + pos, this->egptr());
+			return pos_type(pos);
+		}
+		virtual pos_type seekpos (pos_type pos, std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out) override {
+			return seekoff(off_type(pos), std::ios_base::beg, mode);
+		}
+	};
 public:
 	/**
 	 *	The `Source` which should be used when
 	 *	acquiring a \ref packet_serializer_map_t.
 	 */
 	using inner_source_type = vectorbuf_t<Source>;
+	/**
+	 *	The type of the `Source` from which packet
+	 *	bodies are actually parsed. It derives from
+	 *	\ref inner_source_type but rather than holding
+	 *	a copy of the body its get area views contiguous
+	 *	memory which is either owned by the stream_serializer
+	 *	or (see \ref parse_in_place) belongs to the `Source`
+	 *	passed to \ref parse. Its vector is always empty,
+	 *	therefore a \ref packet_serializer must read the
+	 *	body through the `Source` interface rather than by
+	 *	way of `vector`.
+	 */
+	using in_place_source_type = in_place_vectorbuf<inner_source_type>;
 	/**
 	 *	The `Sink` which should be used when
 	 *	acquiring a \ref packet_serializer_map_t.
@@ -103,10 +163,24 @@ public:
 		inner_allocator_type
 	>;
 private:
-	using inner_source_vector_type = typename inner_source_type::vector_type;
 	using inner_source_allocator_type = vectorbuf_allocator_t<Source>;
+	using inner_source_vector_type = typename inner_source_type::vector_type;
 	using inner_sink_vector_type = typename inner_sink_type::vector_type;
 	using inner_sink_allocator_type = vectorbuf_allocator_t<Sink>;
+public:
+	/**
+	 *	The type of \ref buffer_pool from which buffers
+	 *	used for parsing may be leased.
+	 */
+	using parse_buffer_pool_type = buffer_pool<inner_source_vector_type>;
+	/**
+	 *	The type of \ref buffer_pool from which buffers
+	 *	used for serializing may be leased. This is the same
+	 *	type as \ref parse_buffer_pool_type unless the
+	 *	character types of `Source` and `Sink` differ.
+	 */
+	using serialize_buffer_pool_type = buffer_pool<inner_sink_vector_type>;
+private:
 	packet_serializer_map_type map_;
 	protocol::direction direction_;
 	protocol::state state_;
@@ -117,15 +191,12 @@ private:
 private:
 	using source_char_type = iostreams::char_type_of_t<Source>;
 	using size_parser_type = incremental_varint_parser<size_type, source_char_type>;
+	using id_parser_type = incremental_varint_parser<packet_id::id_type, source_char_type>;
 	using pointer = typename packet_serializer<
 		inner_source_type,
 		inner_sink_type,
 		inner_allocator_type
 	>::pointer;
-	//	TODO: Make this able to accept an allocator,
-	//	currently it seems that basic_zlib_decompressor
-	//	is incapable of accepting a stateful allocator
-	using decompressor_type = boost::iostreams::zlib_decompressor;
 public:
 	/**
 	 *	The type returned by the \ref parse method.
@@ -138,113 +209,556 @@ public:
 	 *	the parse operation failed due to an error.
 	 */
 	using parse_result_type = boost::expected<bool, std::error_code>;
+	/**
+	 *	The type returned by the \ref parse_all method.
+	 *
+	 *	May hold the number of frames parsed or a
+	 *	`std::error_code` in which case a frame could
+	 *	not be parsed due to an error.
+	 */
+	using parse_all_result_type = boost::expected<std::size_t, std::error_code>;
 	/**
 	 *	A type which models `Source` an instance of which
 	 *	is returned by this \ref parsed method.
 	 */
 	using parsed_source = buffer;
+	/**
+	 *	The maximum uncompressed length of a compressed
+	 *	packet body. Compressed packets whose data length
+	 *	exceeds this are rejected with \ref error::too_long
+	 *	before they are inflated.
+	 */
+	static constexpr std::size_t max_data_length = std::size_t(1) << 21;
 private:
-	inner_source_type parse_body_;
+	//	Buffers for bodies are grown in steps of at least
+	//	this many characters as the body arrives
+	static constexpr std::size_t parse_chunk_size = 4096;
+	//	Scratch vectors are grown but never shrunk, the
+	//	number of characters they hold for the packet
+	//	currently being parsed is tracked separately so
+	//	that in the steady state they are neither
+	//	reallocated nor zero filled
+	inner_source_vector_type parse_body_;
+	std::size_t parse_body_read_;
+	std::shared_ptr<parse_buffer_pool_type> parse_pool_;
+	inner_source_vector_type parse_compressed_;
+	std::size_t parse_compressed_read_;
+	const source_char_type * parse_view_;
+	std::size_t parse_view_size_;
+	bool parse_in_place_;
+	bool parse_body_in_place_;
 	size_parser_type parse_size_a_;
 	size_parser_type parse_size_b_;
 	optional<packet_id> parse_packet_id_;
 	pointer parse_pointer_;
-	decompressor_type parse_decompressor_;
+	inflate_stream parse_inflate_;
 	std::size_t parse_body_consumed_;
 	std::size_t parse_body_compressed_size_;
-	template <typename Source2>
-	parse_result_type parse_body (Source2 & src, std::uint32_t n) {
-		//	TODO: Safe conversion to std::size_t?
-		std::size_t size(n);
-		auto limiting = iostreams::make_limiting_source(
-			boost::ref(src),
-			size - parse_body_.vector().size()
-		);
-		boost::iostreams::copy(limiting, parse_body_);
-		if (parse_body_.vector().size() < size) return false;
-		return parse_varint<packet_id::id_type>(parse_body_).bind([&] (auto id) -> parse_result_type {
+	//	When skipping the ID is parsed ahead of the
+	//	rest of the body, parse_packet_id_ is only set
+	//	once the entire packet has been consumed
+	bool parse_skip_;
+	id_parser_type parse_id_;
+	bool parse_peeked_;
+	bool parse_skipped_;
+	//	Set once a raw frame has been parsed, in which
+	//	case parse_view_ refers to the frame less its
+	//	length prefix
+	bool parse_raw_;
+	unsigned char parse_raw_prefix_ [varint_size<size_type>];
+	std::size_t parse_raw_prefix_size_;
+	template <typename T>
+	static monotonic_arena * arena_of (const T &) noexcept {
+		return nullptr;
+	}
+	template <typename T, typename Allocator2>
+	static monotonic_arena * arena_of (const arena_allocator<T, Allocator2> & a) noexcept {
+		return &a.arena();
+	}
+	//	If the Allocator is an arena_allocator the fields
+	//	of parsed packets are allocated from its arena,
+	//	which is rewound once the packet is discarded and
+	//	therefore may not be parsed into by any other
+	//	stream_serializer
+	monotonic_arena * parse_arena () const noexcept {
+		return arena_of(map_.get_allocator());
+	}
+	parse_result_type parse_body (const source_char_type * ptr, std::size_t size) {
+		parse_view_ = ptr;
+		parse_view_size_ = size;
+		in_place_source_type body(parse_body_.get_allocator(), ptr, size);
+		return parse_varint<packet_id::id_type>(body).bind([&] (auto id) -> parse_result_type {
 			parse_packet_id_.emplace(id, direction_, state_);
 			auto serializer = get(map_, *parse_packet_id_);
 			if (!serializer) return true;
-			auto retr = serializer->parse(parse_body_, parse_pointer_).map([] () noexcept {
+			auto arena = parse_arena();
+			if (arena) arena->claim(this);
+			monotonic_arena_scope scope(arena);
+			auto retr = serializer->parse(body, parse_pointer_).map([] () noexcept {
 				return true;
 			});
-			auto offset = iostreams::offset(parse_body_, std::ios_base::in);
-			assert(offset);
-			if (*offset != n) return boost::make_unexpected(
+			if (body.read() != size) return boost::make_unexpected(
 				make_error_code(error::inconsistent_length)
 			);
 			return retr;
 		});
 	}
+	//	Reads from src until v holds size characters,
+	//	read is the number of characters already held
+	//	and is updated, returns true if v holds size
+	//	characters and false otherwise
+	//
+	//	size is sent by the peer so v is not sized to it
+	//	up front, rather v is grown as characters arrive
+	//	(by at most as many as have already arrived) so
+	//	that memory is only committed in proportion to
+	//	what the peer has actually sent
+	template <typename Source2>
+	bool parse_read (Source2 & src, inner_source_vector_type & v, std::size_t & read, std::size_t size) {
+		while (read != size) {
+			if (v.size() <= read) {
+				std::size_t step(std::min(size - read, std::max(read, parse_chunk_size)));
+				reserve(v, read + step, read, parse_pool_.get());
+			}
+			std::size_t avail(std::min(size, v.size()) - read);
+			auto n = boost::iostreams::read(src, v.data() + read, std::streamsize(avail));
+			if (n <= 0) return false;
+			read += std::size_t(n);
+		}
+		return true;
+	}
+	template <typename Source2>
+	parse_result_type parse_body (Source2 & src, std::size_t size) {
+		if (!parse_read(src, parse_body_, parse_body_read_, size)) return false;
+		return parse_body(parse_body_.data(), size);
+	}
+	//	Checks the data length of a compressed packet, which
+	//	is sent by the peer, before anything is allocated on
+	//	its account
+	std::error_code parse_check_data_length (std::size_t data_length) const noexcept {
+		//	Should have been uncompressed
+		if (data_length < *threshold_) return make_error_code(error::compressed);
+		if (data_length > max_data_length) return make_error_code(error::too_long);
+		return std::error_code();
+	}
+	parse_result_type parse_inflate (const source_char_type * ptr, std::size_t size, std::size_t uncompressed) {
+		assert(uncompressed <= max_data_length);
+		reserve(parse_body_, uncompressed, 0, parse_pool_.get());
+		return parse_inflate_.inflate(
+			ptr,
+			size * sizeof(source_char_type),
+			parse_body_.data(),
+			uncompressed * sizeof(source_char_type)
+		).bind([&] (auto n) -> parse_result_type {
+			if (n != (uncompressed * sizeof(source_char_type))) return boost::make_unexpected(
+				make_error_code(error::end_of_file)
+			);
+			return this->parse_body(parse_body_.data(), uncompressed);
+		});
+	}
+	//	If the entirety of size characters is buffered
+	//	in the get area of src consumes them and returns
+	//	a pointer thereto, otherwise returns a null
+	//	pointer
+	const source_char_type * parse_take (Source & src, std::size_t size, const std::true_type &) noexcept {
+		if (iostreams::get_available(src) < size) return nullptr;
+		auto retr = iostreams::gptr(src);
+		iostreams::gbump(src, size);
+		return retr;
+	}
+	const source_char_type * parse_take (Source &, std::size_t, const std::false_type &) noexcept {
+		return nullptr;
+	}
+	const source_char_type * parse_take (Source & src, std::size_t size) noexcept {
+		std::integral_constant<bool,
+			iostreams::is_streambuf_v<Source> &&
+			(sizeof(source_char_type) == 1)
+		> tag;
+		return parse_take(src, size, tag);
+	}
+	//	As parse_take but only if parsing in place is
+	//	enabled and the body has not been partially
+	//	copied
+	const source_char_type * parse_take_in_place (Source & src, std::size_t size) noexcept {
+		if (!(parse_in_place_ && (parse_body_read_ == 0) && parse_id_.empty())) return nullptr;
+		return parse_take(src, size);
+	}
+	//	Consumes and discards up to size characters from
+	//	src, returns the number of characters discarded
+	std::size_t parse_discard (Source & src, std::size_t size, const std::true_type &) {
+		using traits_type = typename Source::traits_type;
+		std::size_t retr(0);
+		for (;;) {
+			auto n = std::min(size - retr, iostreams::get_available(src));
+			iostreams::gbump(src, n);
+			retr += n;
+			if (retr == size) return retr;
+			//	The get area is exhausted, let the
+			//	streambuf underflow
+			if (traits_type::eq_int_type(src.sgetc(), traits_type::eof())) return retr;
+		}
+	}
+	std::size_t parse_discard (Source & src, std::size_t size, const std::false_type &) {
+		constexpr std::size_t scratch_size = 256;
+		source_char_type scratch [scratch_size];
+		std::size_t retr(0);
+		while (retr != size) {
+			auto n = boost::iostreams::read(src, scratch, std::streamsize(std::min(size - retr, scratch_size)));
+			if (n <= 0) break;
+			retr += std::size_t(n);
+		}
+		return retr;
+	}
+	std::size_t parse_discard (Source & src, std::size_t size) {
+		std::integral_constant<bool, iostreams::is_streambuf_v<Source>> tag;
+		return parse_discard(src, size, tag);
+	}
+	void parse_peeked (packet_id::id_type id) noexcept {
+		parse_peeked_ = true;
+		parse_skipped_ = !get(map_, packet_id(id, direction_, state_));
+	}
+	//	Parses the ID from the start of an uncompressed
+	//	body of size characters drawn from src, if the body
+	//	is not to be skipped the ID is placed at the start
+	//	of parse_body_ so the remainder of the body may be
+	//	read after it
+	template <typename Source2>
+	parse_result_type parse_peek (Source2 & src, std::size_t size) {
+		if (parse_peeked_) return true;
+		auto id = iostreams::make_limiting_source(boost::ref(src), size - parse_id_.cached());
+		return parse_id_.parse(id).bind([&] (auto opt) -> parse_result_type {
+			if (!opt) {
+				if (parse_id_.cached() == size) return boost::make_unexpected(
+					make_error_code(error::end_of_file)
+				);
+				return false;
+			}
+			this->parse_peeked(*opt);
+			parse_body_read_ = parse_id_.cached();
+			if (parse_skipped_) return true;
+			//	Overlong representations are rejected so
+			//	serializing the ID yields exactly the
+			//	characters which were consumed
+			reserve(parse_body_, parse_body_read_, 0, parse_pool_.get());
+			buffer b(parse_body_.data(), parse_body_read_);
+			serialize_varint(*opt, b);
+			assert(b.written() == parse_body_read_);
+			return true;
+		});
+	}
+	//	As parse_peek but the ID is inflated from the
+	//	first size characters of a compressed body,
+	//	complete is true if those are all the characters
+	//	of the compressed body
+	parse_result_type parse_peek (const source_char_type * ptr, std::size_t size, bool complete) {
+		unsigned char id [varint_size<packet_id::id_type>];
+		auto n = parse_inflate_.inflate_prefix(ptr, size * sizeof(source_char_type), id, sizeof(id));
+		//	Inflating from the start of the stream again
+		//	yields the same characters so only those the
+		//	parser has not yet consumed are fed to it
+		span_reader unconsumed(id + parse_id_.cached(), n - parse_id_.cached());
+		return parse_id_.parse(unconsumed).bind([&] (auto opt) -> parse_result_type {
+			if (!opt) {
+				if (complete) return boost::make_unexpected(
+					make_error_code(error::end_of_file)
+				);
+				return false;
+			}
+			this->parse_peeked(*opt);
+			return true;
+		});
+	}
+	//	Discards the remainder of a skipped body of size
+	//	characters of which read have been consumed, read
+	//	is updated, returns true once the body has been
+	//	entirely consumed and false otherwise
+	parse_result_type parse_skip (Source & src, std::size_t & read, std::size_t size) {
+		read += parse_discard(src, size - read);
+		if (read != size) return false;
+		return parse_skip();
+	}
+	parse_result_type parse_skip () {
+		parse_packet_id_.emplace(parse_id_.get(), direction_, state_);
+		return true;
+	}
+	//	Parses an uncompressed body of size characters
+	//	which lies entirely at ptr, in place if parsing in
+	//	place is enabled and otherwise from a copy, unless
+	//	it is to be skipped
+	parse_result_type parse_whole_body (const source_char_type * ptr, std::size_t size) {
+		if (parse_skip_) {
+			span_reader body(ptr, size * sizeof(source_char_type));
+			auto id = parse_varint<packet_id::id_type>(body);
+			if (!id) return boost::make_unexpected(id.error());
+			parse_peeked(*id);
+			if (parse_skipped_) {
+				parse_body_read_ = size;
+				parse_packet_id_.emplace(*id, direction_, state_);
+				return true;
+			}
+		}
+		if (parse_in_place_) {
+			parse_body_in_place_ = true;
+			return parse_body(ptr, size);
+		}
+		reserve(parse_body_, size, 0, parse_pool_.get());
+		std::copy(ptr, ptr + size, parse_body_.data());
+		parse_body_read_ = size;
+		return parse_body(parse_body_.data(), size);
+	}
 	parse_result_type parse_uncompressed (Source & src) {
 		return parse_size_a_.parse(src).bind([&] (auto opt) -> parse_result_type {
 			if (!opt) return false;
-			//	For some reason GCC 6.3 requires
-			//	this->parse_body rather than just
-			//	parse_body
-			return this->parse_body(src, *opt);
+			return checked::cast<std::size_t>(*opt).bind([&] (auto size) -> parse_result_type {
+				if (auto ptr = this->parse_take_in_place(src, size)) return this->parse_whole_body(ptr, size);
+				if (parse_skip_) {
+					auto peeked = this->parse_peek(src, size);
+					if (!(peeked && *peeked)) return peeked;
+					if (parse_skipped_) return this->parse_skip(src, parse_body_read_, size);
+				}
+				//	For some reason GCC 6.3 requires
+				//	this->parse_body rather than just
+				//	parse_body
+				return this->parse_body(src, size);
+			});
 		});
 	}
 	parse_result_type parse_compressed (Source & src) {
 		return parse_size_a_.parse(src).bind([&] (auto opt) -> parse_result_type {
 			if (!opt) return false;
-			//	TODO: Safe conversion to std::size_t?
-			std::size_t size(*opt);
-			auto body = iostreams::make_limiting_source(
-				boost::ref(src),
-				size - parse_body_consumed_
-			);
-			//	TODO: Update parse_body_consumed_ regardless
-			//	of how the method exits
-			auto retr = parse_size_b_.parse(body).bind([&] (auto opt) -> parse_result_type {
-				if (!opt) {
-					return false;
-				}
-				if (parse_body_compressed_size_ == 0) parse_body_compressed_size_ = body.remaining();
-				if (*opt == 0) {
-					//	Data is not compressed
-					std::size_t body_length(size - parse_size_b_.cached());
-					//	Should have been compressed
-					if (body_length >= *threshold_) return boost::make_unexpected(
-						make_error_code(error::uncompressed)
-					);
-					//	For some reason GCC 6.3 requires
-					//	this->parse_body rather than just
-					//	parse_body
-					return this->parse_body(body, std::uint32_t(body_length));
-				}
-				//	Should have been uncompressed
-				if (*opt < *threshold_) return boost::make_unexpected(
-					make_error_code(error::compressed)
+			return checked::cast<std::size_t>(*opt).bind([&] (auto size) -> parse_result_type {
+				auto body = iostreams::make_limiting_source(
+					boost::ref(src),
+					size - parse_body_consumed_
 				);
-				auto composed = boost::iostreams::compose(
-					boost::ref(parse_decompressor_),
-					boost::ref(body)
+				//	Characters of the packet which are consumed
+				//	directly from src rather than by way of body
+				std::size_t bypassed(0);
+				//	TODO: Update parse_body_consumed_ regardless
+				//	of how the method exits
+				auto retr = parse_size_b_.parse(body).bind([&] (auto opt) -> parse_result_type {
+					if (!opt) {
+						return false;
+					}
+					if (parse_body_compressed_size_ == 0) parse_body_compressed_size_ = body.remaining();
+					if (*opt == 0) {
+						//	Data is not compressed
+						std::size_t body_length(size - parse_size_b_.cached());
+						//	Should have been compressed
+						if (body_length >= *threshold_) return boost::make_unexpected(
+							make_error_code(error::uncompressed)
+						);
+						if (auto ptr = this->parse_take_in_place(src, body_length)) {
+							bypassed = body_length;
+							return this->parse_whole_body(ptr, body_length);
+						}
+						if (parse_skip_) {
+							auto peeked = this->parse_peek(body, body_length);
+							if (!(peeked && *peeked)) return peeked;
+							if (parse_skipped_) {
+								auto read = parse_body_read_;
+								auto retr = this->parse_skip(src, parse_body_read_, body_length);
+								bypassed = parse_body_read_ - read;
+								return retr;
+							}
+						}
+						//	For some reason GCC 6.3 requires
+						//	this->parse_body rather than just
+						//	parse_body
+						return this->parse_body(body, body_length);
+					}
+					if (auto ec = this->parse_check_data_length(*opt)) return boost::make_unexpected(ec);
+					//	The compressed data is inflated in a single
+					//	call once it is entirely available, directly
+					//	from the get area of src if possible so that
+					//	it need not be copied
+					std::size_t compressed_length(size - parse_size_b_.cached());
+					const source_char_type * ptr = nullptr;
+					if (parse_compressed_read_ == 0) ptr = this->parse_take(src, compressed_length);
+					if (ptr) {
+						bypassed = compressed_length;
+						if (parse_skip_) {
+							auto peeked = this->parse_peek(ptr, compressed_length, true);
+							if (!peeked) return peeked;
+							if (parse_skipped_) return this->parse_skip();
+						}
+					} else {
+						if (parse_skip_) {
+							//	Only as much of the compressed body as
+							//	is needed to inflate the ID is buffered,
+							//	it is read in increasingly large pieces
+							//	since the amount required is not known
+							while (!parse_peeked_) {
+								if (parse_compressed_read_ != 0) {
+									auto peeked = this->parse_peek(
+										parse_compressed_.data(),
+										parse_compressed_read_,
+										parse_compressed_read_ == compressed_length
+									);
+									if (!peeked) return peeked;
+									if (*peeked) break;
+								}
+								std::size_t target(std::min(compressed_length, std::max<std::size_t>(parse_compressed_read_ * 2, 64)));
+								if (!parse_read(body, parse_compressed_, parse_compressed_read_, target)) return false;
+							}
+							if (parse_skipped_) {
+								auto read = parse_compressed_read_;
+								auto retr = this->parse_skip(src, parse_compressed_read_, compressed_length);
+								bypassed = parse_compressed_read_ - read;
+								return retr;
+							}
+						}
+						if (!parse_read(body, parse_compressed_, parse_compressed_read_, compressed_length)) return false;
+						ptr = parse_compressed_.data();
+					}
+					return this->parse_inflate(ptr, compressed_length, *opt);
+				});
+				parse_body_consumed_ = size - body.remaining() + bypassed;
+				if ((parse_body_consumed_ == size) && retr && !*retr) return boost::make_unexpected(
+					make_error_code(error::end_of_file)
 				);
-				//	For some reason GCC 6.3 requires
-				//	this->parse_body rather than just
-				//	parse_body
-				return this->parse_body(composed, *opt);
+				return retr;
 			});
-			parse_body_consumed_ = size - body.remaining();
-			if ((parse_body_consumed_ == size) && retr && !*retr) return boost::make_unexpected(
+		});
+	}
+	//	Validates a raw frame less its length prefix and
+	//	decodes its packet ID if the body is not compressed
+	parse_result_type parse_raw_frame (const source_char_type * ptr, std::size_t size) {
+		parse_view_ = ptr;
+		parse_view_size_ = size;
+		span_reader body(ptr, size * sizeof(source_char_type));
+		if (threshold_) {
+			auto result = parse_size_b_.parse(body);
+			if (!result) return boost::make_unexpected(result.error());
+			if (!*result) return boost::make_unexpected(
 				make_error_code(error::end_of_file)
 			);
-			return retr;
+			parse_body_compressed_size_ = body.remaining();
+			if (**result == 0) {
+				if (body.remaining() >= *threshold_) return boost::make_unexpected(
+					make_error_code(error::uncompressed)
+				);
+			} else {
+				if (auto ec = parse_check_data_length(**result)) return boost::make_unexpected(ec);
+				//	The ID is not decoded since that would
+				//	require inflating the body
+				parse_raw_ = true;
+				return true;
+			}
+		}
+		return parse_varint<packet_id::id_type>(body).map([&] (auto id) {
+			parse_packet_id_.emplace(id, direction_, state_);
+			parse_raw_ = true;
+			return true;
 		});
 	}
+	//	If a frame is entirely buffered in the get area of
+	//	src consumes it and returns a pointer to the frame
+	//	less its length prefix, the length of which is stored
+	//	in size, otherwise consumes nothing and returns a
+	//	null pointer (including if the length prefix is
+	//	malformed, in which case parse reports the error)
+	const source_char_type * parse_take_frame (Source & src, std::size_t & size, const std::true_type &) noexcept {
+		auto avail = iostreams::get_available(src);
+		//	Too few characters for the length prefix to be
+		//	decided without the byte-wise parse
+		if (avail < varint_size<size_type>) return nullptr;
+		auto ptr = iostreams::gptr(src);
+		std::size_t consumed;
+		auto result = detail::parse_varint_block<size_type>(
+			reinterpret_cast<const unsigned char *>(ptr),
+			avail,
+			consumed
+		);
+		if (!(result && ((avail - consumed) >= *result))) return nullptr;
+		size = *result;
+		iostreams::gbump(src, consumed + size);
+		return ptr + consumed;
+	}
+	const source_char_type * parse_take_frame (Source &, std::size_t &, const std::false_type &) noexcept {
+		return nullptr;
+	}
+	const source_char_type * parse_take_frame (Source & src, std::size_t & size) noexcept {
+		std::integral_constant<bool,
+			iostreams::is_streambuf_v<Source> &&
+			(sizeof(source_char_type) == 1)
+		> tag;
+		return parse_take_frame(src, size, tag);
+	}
+	//	Parses a frame of size characters less its length
+	//	prefix which is entirely available at ptr, exactly
+	//	as parse would but without feeding the incremental
+	//	parsers character by character
+	parse_result_type parse_frame (const source_char_type * ptr, std::size_t size) {
+		if (!threshold_) return parse_whole_body(ptr, size);
+		parse_body_consumed_ = size;
+		span_reader body(ptr, size * sizeof(source_char_type));
+		auto result = parse_size_b_.parse(body);
+		if (!result) return boost::make_unexpected(result.error());
+		if (!*result) return boost::make_unexpected(
+			make_error_code(error::end_of_file)
+		);
+		parse_body_compressed_size_ = body.remaining();
+		std::size_t body_length(size - parse_size_b_.cached());
+		ptr += parse_size_b_.cached();
+		if (**result == 0) {
+			if (body_length >= *threshold_) return boost::make_unexpected(
+				make_error_code(error::uncompressed)
+			);
+			return parse_whole_body(ptr, body_length);
+		}
+		if (auto ec = parse_check_data_length(**result)) return boost::make_unexpected(ec);
+		if (parse_skip_) {
+			auto peeked = parse_peek(ptr, body_length, true);
+			if (!peeked) return peeked;
+			if (parse_skipped_) return parse_skip();
+		}
+		return parse_inflate(ptr, body_length, **result);
+	}
+	template <typename Function>
+	static bool parse_all_invoke (Function & func, stream_serializer & self, const std::true_type &) {
+		func(self);
+		return true;
+	}
+	template <typename Function>
+	static bool parse_all_invoke (Function & func, stream_serializer & self, const std::false_type &) {
+		return bool(func(self));
+	}
+	template <typename Function>
+	bool parse_all_invoke (Function & func) {
+		typename std::is_void<decltype(func(*this))>::type tag;
+		return parse_all_invoke(func, *this, tag);
+	}
 	void parse_reset_if_applicable () noexcept {
-		//	If no packet ID has been extracted then
-		//	the previous parse has not completed
-		if (!parse_packet_id_) return;
-		parse_body_.clear();
+		//	If no packet ID has been extracted and no
+		//	raw frame has been parsed then the previous
+		//	parse has not completed
+		if (!(parse_packet_id_ || parse_raw_)) return;
+		parse_body_read_ = 0;
+		parse_compressed_read_ = 0;
+		parse_view_ = nullptr;
+		parse_view_size_ = 0;
+		parse_body_in_place_ = false;
 		parse_size_a_.reset();
 		parse_size_b_.reset();
 		parse_packet_id_ = nullopt;
-		parse_pointer_.reset();
+		//	The storage of the packet itself may belong
+		//	to the arena so it must not be reused once
+		//	the arena has been rewound
+		if (auto arena = parse_arena()) {
+			parse_pointer_.clear();
+			arena->rewind();
+		} else {
+			parse_pointer_.reset();
+		}
 		parse_body_consumed_ = 0;
 		parse_body_compressed_size_ = 0;
+		parse_id_.reset();
+		parse_peeked_ = false;
+		parse_skipped_ = false;
+		parse_raw_ = false;
+		release(parse_body_, parse_pool_.get());
+		release(parse_compressed_, parse_pool_.get());
 	}
 public:
 	/**
@@ -261,6 +775,170 @@ public:
 		if (threshold_) return parse_compressed(src);
 		return parse_uncompressed(src);
 	}
+	/**
+	 *	Parses every frame available from a `Source`,
+	 *	invoking a callback after each.
+	 *
+	 *	Equivalent to calling \ref parse until it returns
+	 *	\em false or fails and invoking \em func each time
+	 *	it returns \em true. However if \em Source is a
+	 *	`std::basic_streambuf` each frame which lies entirely
+	 *	within its get area is located and parsed directly
+	 *	from there in a single step, only a trailing partial
+	 *	frame is consumed incrementally and carried over to
+	 *	the next call to \ref parse or parse_all. This makes
+	 *	draining many small packets received in a single
+	 *	read much cheaper than calling \ref parse for each.
+	 *
+	 *	Frames are parsed in place only if parsing in place
+	 *	is enabled (see \ref parse_in_place), otherwise the
+	 *	body of each frame located in the get area is copied
+	 *	before it is parsed just as \ref parse would copy it.
+	 *	Likewise bodies are skipped exactly as by \ref parse
+	 *	(see \ref parse_skip_unregistered).
+	 *
+	 *	\em func is invoked before the next frame is parsed
+	 *	and may therefore change the state (see \ref state)
+	 *	or compression settings in which that frame is
+	 *	parsed. Once this method has returned having parsed
+	 *	a partial frame the rule given for \ref parse_raw_frame
+	 *	applies: \ref parse or parse_all must be called until
+	 *	that frame is complete.
+	 *
+	 *	\tparam Function
+	 *		The type of a callable object which accepts a
+	 *		reference to this object, through which the frame
+	 *		just parsed is available exactly as if \ref parse
+	 *		had returned \em true. It may return nothing or
+	 *		a value convertible to \em bool, in the latter case
+	 *		returning \em false stops parsing and leaves any
+	 *		remaining characters in \em src.
+	 *
+	 *	\param [in] src
+	 *		The `Source` from which bytes shall be drawn.
+	 *	\param [in] func
+	 *		The callback.
+	 *
+	 *	\return
+	 *		See \ref parse_all_result_type.
+	 */
+	template <typename Function>
+	parse_all_result_type parse_all (Source & src, Function func) {
+		std::size_t retr(0);
+		for (;;) {
+			parse_reset_if_applicable();
+			const source_char_type * ptr = nullptr;
+			std::size_t size;
+			if (empty()) ptr = parse_take_frame(src, size);
+			auto result = ptr ? parse_frame(ptr, size) : parse(src);
+			if (!result) return boost::make_unexpected(result.error());
+			if (!*result) return retr;
+			++retr;
+			if (!parse_all_invoke(func)) return retr;
+		}
+	}
+	/**
+	 *	Attempts to parse a frame from a `Source` without
+	 *	parsing (or, if compressed, inflating) the packet
+	 *	it contains.
+	 *
+	 *	The frame is validated against the compression
+	 *	settings in effect exactly as by \ref parse but the
+	 *	body is otherwise left intact so that it may be
+	 *	relayed by \ref serialize_raw_frame to a connection
+	 *	with the same compression settings at the cost of a
+	 *	copy.
+	 *
+	 *	Once this method returns \em true the frame is
+	 *	available through \ref parsed_raw_frame, and
+	 *	\ref parsed_compressed and \ref parsed_compressed_size
+	 *	may be invoked. The packet ID is only decoded if
+	 *	doing so is cheap, that is if the body is not
+	 *	compressed, see \ref parsed_has_id. \ref has_packet
+	 *	returns \em false and \ref parsed and related methods
+	 *	may not be invoked.
+	 *
+	 *	Calls to this method and to \ref parse may be freely
+	 *	interleaved except that once either has returned
+	 *	\em false the same method must be called until the
+	 *	frame is complete.
+	 *
+	 *	If parsing in place is enabled (see \ref parse_in_place)
+	 *	frames which are entirely available are not copied.
+	 *
+	 *	\param [in] src
+	 *		The `Source` from which bytes shall be drawn.
+	 *
+	 *	\return
+	 *		See \ref parse_result_type.
+	 */
+	parse_result_type parse_raw_frame (Source & src) {
+		parse_reset_if_applicable();
+		return parse_size_a_.parse(src).bind([&] (auto opt) -> parse_result_type {
+			if (!opt) return false;
+			return checked::cast<std::size_t>(*opt).bind([&] (auto size) -> parse_result_type {
+				auto ptr = this->parse_take_in_place(src, size);
+				if (!ptr) {
+					bool done = parse_read(src, parse_body_, parse_body_read_, size);
+					parse_body_consumed_ = parse_body_read_;
+					if (!done) return false;
+					ptr = parse_body_.data();
+				}
+				parse_body_consumed_ = size;
+				span_writer prefix(parse_raw_prefix_, sizeof(parse_raw_prefix_));
+				serialize_varint(*opt, prefix);
+				parse_raw_prefix_size_ = prefix.written();
+				assert(parse_raw_prefix_size_ == parse_size_a_.cached());
+				return this->parse_raw_frame(ptr, size);
+			});
+		});
+	}
+	/**
+	 *	Obtains the frame parsed by the last call to
+	 *	\ref parse_raw_frame.
+	 *
+	 *	If this method is called and it is not the case
+	 *	that the last call to \ref parse_raw_frame returned
+	 *	\em true and no call to \ref parse has been made
+	 *	since the behavior is undefined.
+	 *
+	 *	\return
+	 *		A \ref const_buffer_sequence which holds the frame
+	 *		exactly as it was received: the length prefix
+	 *		followed by the remainder of the frame. The length
+	 *		prefix refers to memory owned by this object, the
+	 *		remainder to memory owned by this object or, if the
+	 *		frame was parsed in place, by the `Source` passed to
+	 *		\ref parse_raw_frame. Either remains valid until the
+	 *		next call to \ref parse or \ref parse_raw_frame.
+	 */
+	const_buffer_sequence<2> parsed_raw_frame () const noexcept {
+		assert(parse_raw_);
+		const_buffer_sequence<2> retr;
+		retr.push_back(const_buffer(parse_raw_prefix_, parse_raw_prefix_size_));
+		retr.push_back(const_buffer(parse_view_, parse_view_size_ * sizeof(source_char_type)));
+		return retr;
+	}
+	/**
+	 *	Determines whether the ID of the last packet
+	 *	parsed is available.
+	 *
+	 *	This is always the case after \ref parse returns
+	 *	\em true. After \ref parse_raw_frame returns \em true
+	 *	this is the case unless the body of the frame is
+	 *	compressed.
+	 *
+	 *	If neither of the above methods has returned \em true
+	 *	since the last call to either the behavior is undefined.
+	 *
+	 *	\return
+	 *		\em true if \ref id may be invoked, \em false
+	 *		otherwise.
+	 */
+	bool parsed_has_id () const noexcept {
+		assert(parse_packet_id_ || parse_raw_);
+		return bool(parse_packet_id_);
+	}
 	/**
 	 *	Determines whether this object manages a \ref protocol::packet
 	 *	or not.
@@ -284,7 +962,7 @@ public:
 	 *		\em false otherwise.
 	 */
 	bool has_packet () const noexcept {
-		assert(parse_packet_id_);
+		assert(parse_packet_id_ || parse_raw_);
 		return bool(parse_pointer_);
 	}
 	/**
@@ -343,6 +1021,7 @@ public:
 	 *
 	 *	-	\ref parse has been invoked at least once
 	 *	-	The last call to \ref parse returned \em true
+	 *	-	\ref parsed_skipped returns \em false
 	 *
 	 *	the behavior is undefined.
 	 *
@@ -350,6 +1029,19 @@ public:
 	 *	the effect of reading from the returned `Source`
 	 *	thereafter is undefined.
 	 *
+	 *	Strings may be parsed from the returned `Source`
+	 *	without copying by way of \ref parse_string_view.
+	 *	The same is true of the `Source` provided to each
+	 *	\ref packet_serializer, so packets may hold views
+	 *	rather than strings. In both cases the views remain
+	 *	valid until the next call to \ref parse.
+	 *
+	 *	If the body was parsed in place (see \ref parse_in_place)
+	 *	the returned `Source`, and any views, refer to the
+	 *	memory of the `Source` passed to \ref parse and are
+	 *	only valid so long as that memory is neither
+	 *	reused nor released.
+	 *
 	 *	\sa
 	 *		parsed_size, parsed_empty, parsed_compressed,
 	 *		parsed_compressed_size
@@ -360,9 +1052,8 @@ public:
 	 *		packet.
 	 */
 	parsed_source parsed () const {
-		assert(parse_packet_id_);
-		auto && v = parse_body_.vector();
-		return buffer(v.data(), v.size());
+		assert(!(parsed_skipped() || parse_raw_));
+		return buffer(parse_view_, parse_view_size_);
 	}
 	/**
 	 *	Obtains the length of the uncompressed body
@@ -373,6 +1064,7 @@ public:
 	 *
 	 *	-	\ref parse has been invoked at least once
 	 *	-	The last call to \ref parse returned \em true
+	 *	-	\ref parsed_skipped returns \em false
 	 *
 	 *	the behavior is undefined.
 	 *
@@ -384,8 +1076,8 @@ public:
 	 *		The size in characters.
 	 */
 	std::size_t parsed_size () const noexcept {
-		assert(parse_packet_id_);
-		return parse_body_.vector().size();
+		assert(!(parsed_skipped() || parse_raw_));
+		return parse_view_size_;
 	}
 	/**
 	 *	Determines whether the last packet parsed had
@@ -404,6 +1096,31 @@ public:
 	bool parsed_empty () const noexcept {
 		return parsed_size() == 0;
 	}
+	/**
+	 *	Determines whether the body of the last packet
+	 *	parsed was skipped (see \ref parse_skip_unregistered).
+	 *
+	 *	If this method returns \em true \ref parsed and
+	 *	\ref parsed_size (and therefore \ref parsed_empty)
+	 *	may not be invoked. \ref id, \ref parsed_compressed,
+	 *	and \ref parsed_compressed_size may be.
+	 *
+	 *	If this method is called and it is not the
+	 *	case that:
+	 *
+	 *	-	\ref parse has been invoked at least once
+	 *	-	The last call to \ref parse returned \em true
+	 *
+	 *	the behavior is undefined.
+	 *
+	 *	\return
+	 *		\em true if the body was skipped, \em false
+	 *		otherwise.
+	 */
+	bool parsed_skipped () const noexcept {
+		assert(parse_packet_id_ || parse_raw_);
+		return parse_skipped_;
+	}
 	/**
 	 *	Determines if the last packet parsed was
 	 *	compressed.
@@ -432,7 +1149,7 @@ public:
 	 *		was compressed, \em false otherwise.
 	 */
 	bool parsed_compressed () const noexcept {
-		assert(parse_packet_id_);
+		assert(parse_packet_id_ || parse_raw_);
 		if (!threshold_) return false;
 		return parse_size_b_.get() != 0;
 	}
@@ -468,7 +1185,10 @@ public:
 	std::size_t cached () const noexcept {
 		std::size_t retr(parse_size_a_.cached());
 		if (threshold_) return retr + parse_body_consumed_;
-		return retr + parse_body_.vector().size();
+		if (parse_body_in_place_) return retr + parse_view_size_;
+		//	Once the ID has been peeked it is counted by
+		//	parse_body_read_
+		return retr + parse_body_read_ + (parse_peeked_ ? 0 : parse_id_.cached());
 	}
 	/**
 	 *	Determines if this object has no cached
@@ -492,96 +1212,359 @@ public:
 	 *	is returned by \ref serialized.
 	 */
 	using serialized_source = buffer;
+	/**
+	 *	A sequence of buffers which together hold the
+	 *	complete representation of a packet. An instance
+	 *	of this type is returned by \ref serialize.
+	 */
+	using const_buffers_type = const_buffer_sequence<2>;
 private:
-	//	TODO: Make this able to take a stateful allocator
-	using compressor_type = boost::iostreams::zlib_compressor;
 	using size_buffer_type = iostreams::char_type_of_t<Sink> [varint_size<size_type>];
+	using prefix_type = iostreams::char_type_of_t<Sink> [varint_size<size_type> * 2];
 	inner_sink_type serialize_body_;
-	inner_sink_type serialize_compressed_;
-	compressor_type serialize_compressor_;
+	//	The size of the last body serialized, when a pool
+	//	is in use and this is too large for the buffer to
+	//	be retained a buffer of this size is leased for the
+	//	next body since the size of that body is not known
+	//	in advance
+	std::size_t serialize_body_hint_;
+	//	When a leased buffer is used for the body the
+	//	retained buffer is kept here
+	inner_sink_vector_type serialize_body_spare_;
+	//	Grown but never shrunk, see parse_body_
+	inner_sink_vector_type serialize_compressed_;
+	std::size_t serialize_compressed_size_;
+	prefix_type serialize_prefix_;
+	std::size_t serialize_prefix_size_;
+	//	Describes where the prefixes and body of each
+	//	packet in a batch are held, the body is either
+	//	in serialize_body_ or serialize_compressed_ (at
+	//	the given offsets) or belongs to a framed_packet
+	class batch_entry {
+	public:
+		std::size_t prefix_offset;
+		std::size_t prefix_size;
+		const void * framed;
+		std::size_t offset;
+		std::size_t size;
+		bool compressed;
+	};
+	template <typename T>
+	using serialize_vector_type = std::vector<
+		T,
+		typename std::allocator_traits<inner_allocator_type>::template rebind_alloc<T>
+	>;
+	//	The prefixes of each packet in a batch laid
+	//	end to end
+	inner_sink_vector_type serialize_batch_prefixes_;
+	serialize_vector_type<batch_entry> serialize_batch_entries_;
+	serialize_vector_type<const_buffer> serialize_batch_buffers_;
+	deflate_stream serialize_deflate_;
+	protocol::compression_policy serialize_policy_;
+	std::size_t serialize_offload_threshold_;
+	std::shared_ptr<detail::completion_queue> serialize_completions_;
+	std::shared_ptr<serialize_buffer_pool_type> serialize_pool_;
 	bool serialize_is_compressed_;
+	void serialize_release () noexcept {
+		auto pool = serialize_pool_.get();
+		release(serialize_compressed_, pool);
+		auto && body = serialize_body_.vector();
+		//	Nothing has been serialized since the buffers were
+		//	last released, the hint from then still applies
+		if (!body.empty()) serialize_body_hint_ = body.size();
+		if (!(pool && (body.capacity() > pool->private_limit()))) return;
+		serialize_body_.swap_vector(serialize_body_spare_);
+		pool->release(std::move(serialize_body_spare_));
+	}
 	void serialize_reset () noexcept {
+		serialize_release();
 		serialize_body_.clear();
-		serialize_compressed_.clear();
+		serialize_compressed_size_ = 0;
+		serialize_prefix_size_ = 0;
 		serialize_is_compressed_ = false;
 	}
-	void serialize_body (const protocol::packet & p) {
+	//	Appends the body of p to serialize_body_
+	packet_id serialize_append_body (const protocol::packet & p) {
 		auto serializer = get(map_, p);
 		if (!serializer) throw packet_serializer_not_found(p);
 		//	TODO: Check direction/state?
-		serialize_varint(serializer->id().id(), serialize_body_);
+		auto retr = serializer->id();
+		serialize_varint(retr.id(), serialize_body_);
 		serializer->serialize(p, serialize_body_);
+		return retr;
 	}
-	void serialize_uncompressed (const protocol::packet & p, Sink & sink) {
-		serialize_body(p);
-		size_buffer_type size_buffer;
-		buffer out(size_buffer);
-		auto size = serialize_body_.vector().size();
+	packet_id serialize_body (const protocol::packet & p) {
+		if (
+			serialize_pool_ &&
+			(serialize_body_hint_ > serialize_pool_->private_limit()) &&
+			(serialize_body_.vector().capacity() < serialize_body_hint_)
+		) {
+			auto v = serialize_pool_->acquire(serialize_body_hint_);
+			v.clear();
+			serialize_body_.swap_vector(v);
+			serialize_body_spare_ = std::move(v);
+		}
+		return serialize_append_body(p);
+	}
+	//	Writes the length prefix of a packet in uncompressed
+	//	mode whose body is size characters, returns the number
+	//	of characters written
+	static std::size_t serialize_uncompressed_prefix (std::size_t size, prefix_type & out) {
 		auto size_32 = mcpp::checked::cast<size_type>(size);
 		if (!size_32) {
 			std::ostringstream ss;
 			ss << "Packet length " << size << " unrepresentable";
 			throw unrepresentable_error(ss.str());
 		}
-		serialize_varint(*size_32, out);
-		buffer in(size_buffer, out.written());
-		auto full = iostreams::make_proxy_source(
-			iostreams::make_concatenating_source(
-				in,
-				boost::ref(serialize_body_)
-			)
-		);
-		auto proxy_sink = iostreams::make_proxy_sink(boost::ref(sink));
-		boost::iostreams::copy(full, proxy_sink);
-	}
-	void serialize_compressed (const protocol::packet & p, Sink & sink) {
-		serialize_body(p);
-		serialize_is_compressed_ = serialize_body_.vector().size() >= *threshold_;
-		if (serialize_is_compressed_) boost::iostreams::copy(
-			iostreams::make_proxy_source(boost::ref(serialize_body_)),
-			boost::iostreams::compose(
-				boost::ref(serialize_compressor_),
-				iostreams::make_proxy_sink(boost::ref(serialize_compressed_))
-			)
+		buffer b(out);
+		serialize_varint(*size_32, b);
+		return b.written();
+	}
+	void serialize_uncompressed () {
+		serialize_prefix_size_ = serialize_uncompressed_prefix(serialize_body_.vector().size(), serialize_prefix_);
+	}
+	//	Deflates size characters at body into serialize_compressed_
+	//	following the first offset characters thereof, which are
+	//	preserved, returns the number of characters written
+	std::size_t serialize_deflate (const packet_id & id, const iostreams::char_type_of_t<Sink> * body, std::size_t size, std::size_t offset) {
+		using char_type = iostreams::char_type_of_t<Sink>;
+		using clock = std::chrono::steady_clock;
+		std::size_t bytes(size * sizeof(char_type));
+		auto params = serialize_policy_.select(id, bytes);
+		serialize_deflate_.params(params.level, params.strategy);
+		std::size_t bound(serialize_deflate_.bound(bytes));
+		std::size_t chars((bound + sizeof(char_type) - 1) / sizeof(char_type));
+		reserve(serialize_compressed_, offset + chars, offset, serialize_pool_.get());
+		//	Only packets which are actually deflated tell
+		//	the policy anything about the cost and benefit
+		//	of deflating
+		bool timed = serialize_policy_.adaptive() && (params.level != boost::iostreams::zlib::no_compression);
+		clock::time_point start;
+		if (timed) start = clock::now();
+		std::size_t compressed(serialize_deflate_.deflate(
+			body,
+			bytes,
+			serialize_compressed_.data() + offset,
+			bound
+		));
+		if (timed) serialize_policy_.record(
+			bytes,
+			compressed,
+			std::chrono::duration<double, std::nano>(clock::now() - start).count()
 		);
-		size_buffer_type uncompressed_size_buffer;
-		buffer uncompressed_size_out(uncompressed_size_buffer);
-		optional<size_type> uncompressed_size_32(0);
-		if (serialize_is_compressed_) {
-			auto uncompressed_size = serialize_body_.vector().size();
-			uncompressed_size_32 = mcpp::checked::cast<size_type>(uncompressed_size);
-			if (!uncompressed_size_32) {
-				std::ostringstream ss;
-				ss << "Compressed data length " << uncompressed_size << " unrepresentable";
-				throw unrepresentable_error(ss.str());
-			}
+		return compressed / sizeof(char_type);
+	}
+	//	Writes the length prefixes of a packet in compressed
+	//	mode whose data length field is data_length (zero if
+	//	the body is not compressed) and whose body (compressed
+	//	as applicable) is body_size characters, returns the
+	//	number of characters written
+	static std::size_t serialize_compressed_prefix (std::size_t data_length, std::size_t body_size, prefix_type & out) {
+		auto data_length_32 = mcpp::checked::cast<size_type>(data_length);
+		if (!data_length_32) {
+			std::ostringstream ss;
+			ss << "Compressed data length " << data_length << " unrepresentable";
+			throw unrepresentable_error(ss.str());
 		}
-		serialize_varint(*uncompressed_size_32, uncompressed_size_out);
-		size_buffer_type compressed_size_buffer;
-		buffer compressed_size_out(compressed_size_buffer);
-		std::size_t compressed_size = (
-			serialize_is_compressed_ ? serialize_compressed_ : serialize_body_
-		).vector().size() + uncompressed_size_out.written();
-		auto compressed_size_32 = mcpp::checked::cast<size_type>(compressed_size);
-		if (!compressed_size_32) {
+		size_buffer_type data_length_buffer;
+		buffer data_length_out(data_length_buffer);
+		serialize_varint(*data_length_32, data_length_out);
+		std::size_t size = body_size + data_length_out.written();
+		auto size_32 = mcpp::checked::cast<size_type>(size);
+		if (!size_32) {
 			std::ostringstream ss;
-			ss << "Packet length " << compressed_size << " unrepresentable";
+			ss << "Packet length " << size << " unrepresentable";
 			throw unrepresentable_error(ss.str());
 		}
-		serialize_varint(*compressed_size_32, compressed_size_out);
-		buffer compressed_size_in(compressed_size_buffer, compressed_size_out.written());
-		buffer uncompressed_size_in(uncompressed_size_buffer, uncompressed_size_out.written());
-		auto full = iostreams::make_proxy_source(
-			iostreams::make_concatenating_source(
-				compressed_size_in,
-				uncompressed_size_in,
-				boost::ref(serialize_is_compressed_ ? serialize_compressed_ : serialize_body_)
-			)
+		buffer size_out(out);
+		serialize_varint(*size_32, size_out);
+		std::memcpy(out + size_out.written(), data_length_buffer, data_length_out.written() * sizeof(data_length_buffer[0]));
+		return size_out.written() + data_length_out.written();
+	}
+	void serialize_compressed (const packet_id & id) {
+		auto size = serialize_body_.vector().size();
+		serialize_is_compressed_ = size >= *threshold_;
+		if (serialize_is_compressed_) serialize_compressed_size_ = serialize_deflate(
+			id,
+			serialize_body_.vector().data(),
+			size,
+			0
+		);
+		serialize_prefix_size_ = serialize_compressed_prefix(
+			serialize_is_compressed_ ? size : 0,
+			serialize_is_compressed_ ? serialize_compressed_size_ : size,
+			serialize_prefix_
 		);
-		auto proxy_sink = iostreams::make_proxy_sink(boost::ref(sink));
-		boost::iostreams::copy(full, proxy_sink);
+	}
+	//	Frames the body in serialize_body_
+	void serialize_frame (const packet_id & id) {
+		if (threshold_) serialize_compressed(id);
+		else serialize_uncompressed();
+	}
+	const_buffers_type serialize_buffers () const noexcept {
+		auto && body = serialize_body_.vector();
+		const_buffers_type retr;
+		retr.push_back(const_buffer(serialize_prefix_, serialize_prefix_size_ * sizeof(serialize_prefix_[0])));
+		if (serialize_is_compressed_) retr.push_back(const_buffer(
+			serialize_compressed_.data(),
+			serialize_compressed_size_ * sizeof(serialize_compressed_[0])
+		));
+		else retr.push_back(const_buffer(body.data(), body.size() * sizeof(body[0])));
+		return retr;
+	}
+	std::size_t serialize_body_offset () {
+		return std::size_t(serialize_body_.pubseekoff(0, std::ios_base::cur, std::ios_base::out));
+	}
+	void serialize_batch_prefix (batch_entry & e, std::size_t n) {
+		e.prefix_offset = serialize_batch_prefixes_.size();
+		e.prefix_size = n;
+		serialize_batch_prefixes_.insert(serialize_batch_prefixes_.end(), serialize_prefix_, serialize_prefix_ + n);
+	}
+	//	Serializes the body of p directly after the body of
+	//	the previous packet in the batch, deflating it directly
+	//	after the previous compressed body if applicable, so
+	//	that no body is copied
+	void serialize_batch_append (const protocol::packet & p) {
+		batch_entry e;
+		e.framed = nullptr;
+		e.offset = serialize_body_offset();
+		auto id = serialize_append_body(p);
+		e.size = serialize_body_offset() - e.offset;
+		e.compressed = threshold_ && (e.size >= *threshold_);
+		if (!threshold_) {
+			serialize_batch_prefix(e, serialize_uncompressed_prefix(e.size, serialize_prefix_));
+		} else if (!e.compressed) {
+			serialize_batch_prefix(e, serialize_compressed_prefix(0, e.size, serialize_prefix_));
+		} else {
+			auto && body = serialize_body_.vector();
+			auto n = serialize_deflate(id, body.data() + e.offset, e.size, serialize_compressed_size_);
+			serialize_batch_prefix(e, serialize_compressed_prefix(e.size, n, serialize_prefix_));
+			//	The uncompressed body is no longer required and
+			//	is overwritten by the next body in the batch
+			serialize_body_.pubseekoff(
+				typename inner_sink_type::off_type(e.offset),
+				std::ios_base::beg,
+				std::ios_base::out
+			);
+			e.offset = serialize_compressed_size_;
+			e.size = n;
+			serialize_compressed_size_ += n;
+		}
+		serialize_batch_entries_.push_back(e);
+	}
+	void serialize_batch_append (const framed_packet & p) {
+		using char_type = iostreams::char_type_of_t<Sink>;
+		//	Checks that the packet was framed with the
+		//	compression settings in effect
+		auto b = *serialize(p).begin();
+		batch_entry e;
+		e.prefix_offset = serialize_batch_prefixes_.size();
+		e.prefix_size = 0;
+		e.framed = b.data();
+		e.offset = 0;
+		e.size = b.size() / sizeof(char_type);
+		e.compressed = false;
+		serialize_batch_entries_.push_back(e);
+	}
+	const_buffer_range serialize_batch_buffers () {
+		using char_type = iostreams::char_type_of_t<Sink>;
+		serialize_batch_buffers_.clear();
+		auto && body = serialize_body_.vector();
+		for (auto && e : serialize_batch_entries_) {
+			if (e.prefix_size != 0) serialize_batch_buffers_.push_back(const_buffer(
+				serialize_batch_prefixes_.data() + e.prefix_offset,
+				e.prefix_size * sizeof(char_type)
+			));
+			const void * ptr;
+			if (e.framed) ptr = e.framed;
+			else if (e.compressed) ptr = serialize_compressed_.data() + e.offset;
+			else ptr = body.data() + e.offset;
+			if (e.size != 0) serialize_batch_buffers_.push_back(const_buffer(ptr, e.size * sizeof(char_type)));
+		}
+		auto begin = serialize_batch_buffers_.data();
+		return const_buffer_range(begin, begin + serialize_batch_buffers_.size());
+	}
+	//	Examines only the prefixes of a raw frame, which
+	//	suffices to determine whether it could have been
+	//	produced with the compression settings in effect
+	template <std::size_t N>
+	void serialize_check_raw_frame (const const_buffer_sequence<N> & frame) const {
+		unsigned char head [varint_size<size_type> * 2];
+		std::size_t head_size(0);
+		for (auto && b : frame) {
+			auto n = std::min(b.size(), sizeof(head) - head_size);
+			std::memcpy(head + head_size, b.data(), n);
+			head_size += n;
+			if (head_size == sizeof(head)) break;
+		}
+		auto fail = [&] (const char * why) {
+			std::ostringstream ss;
+			ss << "Raw frame " << why << " (";
+			if (threshold_) ss << "compression threshold is " << *threshold_;
+			else ss << "compression is disabled";
+			ss << ")";
+			throw framing_mismatch_error(ss.str());
+		};
+		span_reader r(head, head_size);
+		auto length = parse_varint<size_type>(r);
+		if (!length) fail("has malformed length");
+		if (*length != (frame.bytes() - r.consumed())) fail("has inconsistent length");
+		if (!threshold_) return;
+		std::size_t body(*length);
+		auto before = r.consumed();
+		auto data_length = parse_varint<size_type>(r);
+		if (!data_length) fail("has malformed data length");
+		body -= r.consumed() - before;
+		if (*data_length == 0) {
+			if (body >= *threshold_) fail("should have been compressed");
+		} else if (*data_length < *threshold_) {
+			fail("should not have been compressed");
+		}
+	}
+	template <typename ConstBufferSequence>
+	static void serialize_write (const ConstBufferSequence & buffers, Sink & sink) {
+		using char_type = iostreams::char_type_of_t<Sink>;
+		for (auto && b : buffers) {
+			std::size_t size(b.size() / sizeof(char_type));
+			std::size_t written(boost::iostreams::write(
+				sink,
+				static_cast<const char_type *>(b.data()),
+				std::streamsize(size)
+			));
+			if (written != size) throw write_overflow_error(size, written);
+		}
 	}
 public:
+	/**
+	 *	Serializes a \ref protocol::packet without writing
+	 *	it to a `Sink`.
+	 *
+	 *	Rather than copying the representation of \em p
+	 *	into a `Sink` this method returns the buffers in
+	 *	which it was assembled: the length prefix (or
+	 *	prefixes in the case of compressed mode) followed
+	 *	by the body (compressed as applicable). These may
+	 *	be handed directly to `writev` or to Asio's
+	 *	`async_write`.
+	 *
+	 *	If no \ref packet_serializer for \em p could be
+	 *	found in the managed \ref packet_serializer_map_type
+	 *	then an exception shall be thrown.
+	 *
+	 *	\param [in] p
+	 *		The \ref protocol::packet to serialize.
+	 *
+	 *	\return
+	 *		A \ref const_buffer_sequence which refers to
+	 *		memory owned by this object. The referenced
+	 *		memory remains valid and unchanged until the
+	 *		next call to \ref serialize.
+	 */
+	const_buffers_type serialize (const protocol::packet & p) {
+		serialize_reset();
+		serialize_frame(serialize_body(p));
+		return serialize_buffers();
+	}
 	/**
 	 *	Serializes a \ref protocol::packet if possible.
 	 *
@@ -589,6 +1572,9 @@ public:
 	 *	found in the managed \ref packet_serializer_map_type
 	 *	then an exception shall be thrown.
 	 *
+	 *	If \em sink does not accept the entire representation
+	 *	of \em p \ref write_overflow_error is thrown.
+	 *
 	 *	\param [in] p
 	 *		The \ref protocol::packet to serialize.
 	 *	\param [in] sink
@@ -596,9 +1582,361 @@ public:
 	 *		\em p shall be written.
 	 */
 	void serialize (const protocol::packet & p, Sink & sink) {
+		serialize_write(serialize(p), sink);
+	}
+	/**
+	 *	Serializes a \ref protocol::packet once so that it
+	 *	may be written many times.
+	 *
+	 *	The returned \ref framed_packet may be written by this
+	 *	object or any other stream_serializer with the same
+	 *	compression settings (see \ref serialize(const framed_packet &)).
+	 *	This is intended for packets broadcast to many
+	 *	connections.
+	 *
+	 *	After this method returns \ref serialized and related
+	 *	methods describe \em p.
+	 *
+	 *	If no \ref packet_serializer for \em p could be
+	 *	found in the managed \ref packet_serializer_map_type
+	 *	then an exception shall be thrown.
+	 *
+	 *	\param [in] p
+	 *		The \ref protocol::packet to serialize.
+	 *
+	 *	\return
+	 *		A \ref framed_packet whose representation is
+	 *		allocated by way of the allocator of the managed
+	 *		\ref packet_serializer_map_type.
+	 */
+	framed_packet frame (const protocol::packet & p) {
+		return framed_packet(std::allocator_arg, map_.get_allocator(), serialize(p), threshold_);
+	}
+	/**
+	 *	Obtains the buffers which hold the representation
+	 *	of a \ref framed_packet without serializing it again.
+	 *
+	 *	This method does not affect \ref serialized and
+	 *	related methods.
+	 *
+	 *	If compression was enabled when \em p was framed but
+	 *	not for this object, or vice versa, or the compression
+	 *	thresholds differ, \ref framing_mismatch_error is
+	 *	thrown.
+	 *
+	 *	\param [in] p
+	 *		The \ref framed_packet. If \ref framed_packet::empty
+	 *		returns \em true the behavior is undefined.
+	 *
+	 *	\return
+	 *		A \ref const_buffer_sequence which refers to memory
+	 *		owned by \em p.
+	 */
+	const_buffers_type serialize (const framed_packet & p) {
+		if ((p.compressed() != compressed()) || (p.compressed() && (p.compression_threshold() != *threshold_))) {
+			std::ostringstream ss;
+			ss << "Packet framed ";
+			if (p.compressed()) ss << "with compression threshold " << p.compression_threshold();
+			else ss << "without compression";
+			ss << " but ";
+			if (threshold_) ss << "compression threshold is " << *threshold_;
+			else ss << "compression is disabled";
+			throw framing_mismatch_error(ss.str());
+		}
+		const_buffers_type retr;
+		retr.push_back(p.buffer());
+		return retr;
+	}
+	/**
+	 *	Writes a \ref framed_packet to a `Sink` without
+	 *	serializing it again.
+	 *
+	 *	See the overload which does not accept a `Sink`
+	 *	for details.
+	 *
+	 *	If \em sink does not accept the entire representation
+	 *	of \em p \ref write_overflow_error is thrown.
+	 *
+	 *	\param [in] p
+	 *		The \ref framed_packet.
+	 *	\param [in] sink
+	 *		The `Sink` into which the representation of
+	 *		\em p shall be written.
+	 */
+	void serialize (const framed_packet & p, Sink & sink) {
+		serialize_write(serialize(p), sink);
+	}
+	/**
+	 *	Writes a frame obtained from \ref parse_raw_frame,
+	 *	possibly of another stream_serializer, to a `Sink`
+	 *	unchanged.
+	 *
+	 *	This allows packets to be relayed between connections
+	 *	with the same compression settings without being
+	 *	parsed, inflated, serialized, or deflated.
+	 *
+	 *	Only the prefixes of the frame are examined. If they
+	 *	are inconsistent with the length of the frame, or
+	 *	describe a body which could not have been framed with
+	 *	the compression settings in effect, \ref framing_mismatch_error
+	 *	is thrown. Not every mismatch is detectable (a frame
+	 *	from a connection with a lower compression threshold
+	 *	which happens not to be compressed, for example, is
+	 *	indistinguishable from a valid frame) so the caller
+	 *	is responsible for relaying frames only between
+	 *	connections whose settings match.
+	 *
+	 *	This method does not affect \ref serialized and
+	 *	related methods.
+	 *
+	 *	If \em sink does not accept the entire frame
+	 *	\ref write_overflow_error is thrown.
+	 *
+	 *	\tparam N
+	 *		The maximum number of buffers in \em frame.
+	 *
+	 *	\param [in] frame
+	 *		The buffers which together hold exactly one
+	 *		frame.
+	 *	\param [in] sink
+	 *		The `Sink` into which the frame shall be written.
+	 */
+	template <std::size_t N>
+	void serialize_raw_frame (const const_buffer_sequence<N> & frame, Sink & sink) {
+		serialize_check_raw_frame(frame);
+		serialize_write(frame, sink);
+	}
+	/**
+	 *	The type of the callbacks accepted by \ref serialize_async.
+	 *
+	 *	The first argument is null unless framing the packet
+	 *	failed in which case it holds the exception which
+	 *	was thrown. Otherwise the second argument holds the
+	 *	framed packet.
+	 */
+	using async_callback_type = detail::completion_queue::callback;
+	/**
+	 *	Serializes a \ref protocol::packet, compressing it
+	 *	on a \ref compression_pool if it is large.
+	 *
+	 *	The body of \em p is always serialized before this
+	 *	method returns. If compression is enabled and the
+	 *	body is at least the compression threshold and at
+	 *	least \ref offload_threshold characters it is then
+	 *	compressed and framed by one of the threads of \em pool,
+	 *	otherwise it is framed immediately.
+	 *
+	 *	Callbacks are invoked in the order in which the
+	 *	packets were passed to this method so that the order
+	 *	of a connection's output is preserved while large
+	 *	packets do not delay the thread performing I/O. A
+	 *	callback may therefore be invoked from within this
+	 *	method, or from one of the threads of \em pool, and
+	 *	the caller must synchronize accordingly (for example
+	 *	by posting to their own event loop). Callbacks must
+	 *	not throw, if a callback invoked from one of the
+	 *	threads of \em pool throws `std::terminate` is
+	 *	called.
+	 *
+	 *	Packets should not be written to the same connection
+	 *	by any other means while callbacks are pending (see
+	 *	\ref async_pending).
+	 *
+	 *	Settings are chosen by \ref compression_policy as
+	 *	usual but packets compressed by \em pool are not
+	 *	recorded in adaptive mode. The allocator of the managed
+	 *	\ref packet_serializer_map_type is used from the
+	 *	threads of \em pool and must therefore be thread
+	 *	safe.
+	 *
+	 *	If no \ref packet_serializer for \em p could be
+	 *	found in the managed \ref packet_serializer_map_type
+	 *	then an exception shall be thrown and \em callback
+	 *	shall never be invoked.
+	 *
+	 *	The body of a packet which is compressed by \em pool
+	 *	is handed to \em pool rather than copied, after this
+	 *	method returns \ref serialized and the related methods
+	 *	are then unspecified. Otherwise \ref serialized
+	 *	describes \em p but \ref serialized_compressed and
+	 *	\ref serialized_compressed_size are unspecified.
+	 *
+	 *	\param [in] p
+	 *		The \ref protocol::packet to serialize.
+	 *	\param [in] pool
+	 *		The \ref compression_pool which shall compress
+	 *		\em p if it is large. Must outlive all pending
+	 *		callbacks.
+	 *	\param [in] callback
+	 *		A callable object which shall be invoked with
+	 *		the result. See \ref async_callback_type.
+	 */
+	void serialize_async (const protocol::packet & p, compression_pool & pool, async_callback_type callback) {
+		using char_type = iostreams::char_type_of_t<Sink>;
+		if (!serialize_completions_) serialize_completions_ = std::make_shared<detail::completion_queue>();
+		serialize_reset();
+		auto id = serialize_body(p);
+		auto completions = serialize_completions_;
+		auto && body = serialize_body_.vector();
+		if (!(threshold_ && (body.size() >= *threshold_) && (body.size() >= serialize_offload_threshold_))) {
+			serialize_frame(id);
+			framed_packet f(std::allocator_arg, map_.get_allocator(), serialize_buffers(), threshold_);
+			completions->complete(completions->push(std::move(callback)), nullptr, std::move(f));
+			return;
+		}
+		auto params = serialize_policy_.select(id, body.size() * sizeof(char_type));
+		//	The body is moved rather than copied, the buffer
+		//	retained for the next body (if a leased buffer
+		//	was in use) takes its place, otherwise the hint
+		//	leases one for the next body if it is large
+		serialize_body_hint_ = body.size();
+		auto moved = std::allocate_shared<inner_sink_vector_type>(body.get_allocator(), body.get_allocator());
+		serialize_body_.swap_vector(*moved);
+		serialize_body_.swap_vector(serialize_body_spare_);
+		auto seq = completions->push(std::move(callback));
+		auto alloc = map_.get_allocator();
+		auto buffers = serialize_pool_;
+		std::size_t threshold(*threshold_);
+		try {
+			//	A callback which throws on one of the threads
+			//	of pool has nowhere to report the exception
+			//	to and therefore calls std::terminate
+			pool.post([completions, seq, moved, buffers, params, alloc, threshold] (compression_worker & w) noexcept {
+				std::exception_ptr ex;
+				framed_packet f;
+				try {
+					std::size_t bytes(moved->size() * sizeof(char_type));
+					w.deflate.params(params.level, params.strategy);
+					std::size_t bound(w.deflate.bound(bytes));
+					if (w.buffer.size() < bound) w.buffer.resize(bound);
+					std::size_t compressed(w.deflate.deflate(moved->data(), bytes, w.buffer.data(), bound));
+					prefix_type prefix;
+					auto prefix_size = serialize_compressed_prefix(moved->size(), compressed / sizeof(char_type), prefix);
+					const_buffers_type frame;
+					frame.push_back(const_buffer(prefix, prefix_size * sizeof(char_type)));
+					frame.push_back(const_buffer(w.buffer.data(), compressed));
+					f = framed_packet(std::allocator_arg, alloc, frame, threshold);
+				} catch (...) {
+					ex = std::current_exception();
+				}
+				//	The pool is safe to use from any thread
+				release(*moved, buffers.get());
+				completions->complete(seq, std::move(ex), std::move(f));
+			});
+		} catch (...) {
+			completions->complete(seq, std::current_exception(), framed_packet());
+		}
+	}
+	/**
+	 *	Determines the number of callbacks passed to
+	 *	\ref serialize_async which have not yet been
+	 *	invoked.
+	 *
+	 *	\return
+	 *		The number of callbacks.
+	 */
+	std::size_t async_pending () const {
+		if (!serialize_completions_) return 0;
+		return serialize_completions_->pending();
+	}
+	/**
+	 *	Retrieves the size in characters of the smallest
+	 *	uncompressed body \ref serialize_async compresses
+	 *	on a \ref compression_pool.
+	 *
+	 *	\return
+	 *		The size. Defaults to 16384.
+	 */
+	std::size_t offload_threshold () const noexcept {
+		return serialize_offload_threshold_;
+	}
+	/**
+	 *	Sets the size in characters of the smallest
+	 *	uncompressed body \ref serialize_async compresses
+	 *	on a \ref compression_pool.
+	 *
+	 *	\param [in] threshold
+	 *		The size.
+	 */
+	void offload_threshold (std::size_t threshold) noexcept {
+		serialize_offload_threshold_ = threshold;
+	}
+	/**
+	 *	Serializes many \ref protocol::packet objects without
+	 *	writing them to a `Sink`.
+	 *
+	 *	The body of each packet is serialized (and deflated
+	 *	if it meets the compression threshold) directly after
+	 *	that of the previous packet in memory owned by this
+	 *	object, and its length prefixes are gathered separately.
+	 *	Rather than copying these into a contiguous buffer this
+	 *	method returns buffers which refer to them in order, so
+	 *	that a burst of packets may be sent with a single
+	 *	gathering write (e.g. `writev` or Asio's `async_write`).
+	 *	The memory used is reused from call to call so that once
+	 *	it has grown to accommodate typical traffic no memory is
+	 *	allocated.
+	 *
+	 *	If an exception is thrown the partially serialized
+	 *	batch is discarded. After
+	 *	this method returns the values returned by \ref serialized
+	 *	and related methods are unspecified until the next call
+	 *	to \ref serialize.
+	 *
+	 *	\tparam InputIterator
+	 *		An input iterator type which dereferences to
+	 *		`const protocol::packet &` or `const framed_packet &`.
+	 *		In the latter case the framed representation is
+	 *		referred to rather than copied and the
+	 *		\ref framed_packet (or a copy thereof) must
+	 *		remain alive so long as the returned buffers are
+	 *		used.
+	 *
+	 *	\param [in] begin
+	 *		An iterator to the first packet.
+	 *	\param [in] end
+	 *		An iterator to one past the last packet.
+	 *
+	 *	\return
+	 *		A \ref const_buffer_range which refers to memory
+	 *		owned by this object. The referenced memory remains
+	 *		valid and unchanged until the next call to
+	 *		serialize_batch, \ref serialize, or any other method
+	 *		which serializes.
+	 */
+	template <typename InputIterator>
+	const_buffer_range serialize_batch (InputIterator begin, InputIterator end) {
 		serialize_reset();
-		if (threshold_) serialize_compressed(p, sink);
-		else serialize_uncompressed(p, sink);
+		serialize_batch_prefixes_.clear();
+		serialize_batch_entries_.clear();
+		for (; begin != end; ++begin) serialize_batch_append(*begin);
+		return serialize_batch_buffers();
+	}
+	/**
+	 *	Serializes many \ref protocol::packet objects and
+	 *	writes them to a `Sink`.
+	 *
+	 *	See the overload which does not accept a `Sink`
+	 *	for details.
+	 *
+	 *	If \em sink does not accept the entire batch
+	 *	\ref write_overflow_error is thrown.
+	 *
+	 *	\tparam InputIterator
+	 *		An input iterator type which dereferences to
+	 *		`const protocol::packet &`.
+	 *
+	 *	\param [in] begin
+	 *		An iterator to the first packet.
+	 *	\param [in] end
+	 *		An iterator to one past the last packet.
+	 *	\param [in] sink
+	 *		The `Sink` into which the batch shall be
+	 *		written.
+	 */
+	template <typename InputIterator>
+	void serialize_batch (InputIterator begin, InputIterator end, Sink & sink) {
+		serialize_write(serialize_batch(begin, end), sink);
 	}
 	/**
 	 *	Obtains a `Source` which manages a character sequence
@@ -672,19 +2010,43 @@ public:
 	 */
 	std::size_t serialized_compressed_size () const noexcept {
 		assert(serialized_compressed());
-		return serialize_compressed_.vector().size();
+		return serialize_compressed_size_;
 	}
 //
 //	Shared
 //
 private:
+	//	Ensures v holds at least size characters preserving
+	//	the first preserve, when a pool is in use the larger
+	//	buffer is leased therefrom and v is returned thereto
+	template <typename Vector>
+	static void reserve (Vector & v, std::size_t size, std::size_t preserve, buffer_pool<Vector> * pool) {
+		if (v.size() >= size) return;
+		if (!pool) {
+			v.resize(size);
+			return;
+		}
+		auto leased = pool->acquire(size);
+		std::copy(v.begin(), v.begin() + preserve, leased.begin());
+		pool->release(std::move(v));
+		v = std::move(leased);
+	}
+	//	Returns v to the pool if one is in use and v is
+	//	too large to be kept
+	template <typename Vector>
+	static void release (Vector & v, buffer_pool<Vector> * pool) noexcept {
+		if (pool && (v.capacity() > pool->private_limit())) pool->release(std::move(v));
+	}
 	void check_no_parse_in_progress () const noexcept {
 		assert(
 			parse_packet_id_ ||
+			parse_raw_ ||
 			(
-				parse_body_.vector().empty() &&
+				(parse_body_read_ == 0) &&
+				(parse_compressed_read_ == 0) &&
 				parse_size_a_.empty() &&
 				parse_size_b_.empty() &&
+				parse_id_.empty() &&
 				(parse_body_consumed_ == 0) &&
 				(parse_body_compressed_size_ == 0)
 			)
@@ -709,7 +2071,14 @@ public:
 	 *		`get_allocator` method of this object shall be
 	 *		used to obtain `Allocator` objects as needed
 	 *		to allocate memory throughout the newly-constructed
-	 *		stream_serializer object's lifetime.
+	 *		stream_serializer object's lifetime. If `Allocator`
+	 *		is an \ref arena_allocator packets are parsed into
+	 *		its \ref monotonic_arena, which must outlive the
+	 *		newly-constructed stream_serializer. Since the
+	 *		arena is rewound before each parse no other
+	 *		stream_serializer may parse into it (though any
+	 *		number may use it to serialize), this is asserted
+	 *		by way of \ref monotonic_arena::claim.
 	 *	\param [in] d
 	 *		The protocol direction for which the newly-constructed
 	 *		serializer shall initially parse packets.
@@ -732,15 +2101,40 @@ public:
 	)	:	map_(std::move(map)),
 			direction_(d),
 			state_(s),
-			parse_body_(inner_source_vector_type(inner_source_allocator_type(map_.get_allocator()))),
-			parse_decompressor_(zlib),
+			parse_body_(inner_source_allocator_type(map_.get_allocator())),
+			parse_body_read_(0),
+			parse_compressed_(inner_source_allocator_type(map_.get_allocator())),
+			parse_compressed_read_(0),
+			parse_view_(nullptr),
+			parse_view_size_(0),
+			parse_in_place_(false),
+			parse_body_in_place_(false),
+			parse_pointer_(map_.get_allocator()),
+			parse_inflate_(std::allocator_arg, map_.get_allocator(), zlib),
 			parse_body_consumed_(0),
 			parse_body_compressed_size_(0),
+			parse_skip_(false),
+			parse_peeked_(false),
+			parse_skipped_(false),
+			parse_raw_(false),
+			parse_raw_prefix_size_(0),
 			serialize_body_(inner_sink_vector_type(inner_sink_allocator_type(map_.get_allocator()))),
-			serialize_compressed_(inner_sink_vector_type(inner_sink_allocator_type(map_.get_allocator()))),
-			serialize_compressor_(zlib),
+			serialize_body_hint_(0),
+			serialize_body_spare_(inner_sink_allocator_type(map_.get_allocator())),
+			serialize_compressed_(inner_sink_allocator_type(map_.get_allocator())),
+			serialize_compressed_size_(0),
+			serialize_prefix_size_(0),
+			serialize_batch_prefixes_(inner_sink_allocator_type(map_.get_allocator())),
+			serialize_batch_entries_(map_.get_allocator()),
+			serialize_batch_buffers_(map_.get_allocator()),
+			serialize_deflate_(std::allocator_arg, map_.get_allocator(), zlib),
+			serialize_policy_(zlib),
+			serialize_offload_threshold_(16384),
 			serialize_is_compressed_(false)
 	{	}
+	~stream_serializer () noexcept {
+		if (auto arena = parse_arena()) arena->release(this);
+	}
 	/**
 	 *	Enables compression and sets the compression
 	 *	threshold.
@@ -778,6 +2172,171 @@ public:
 		check_no_parse_in_progress();
 		threshold_ = nullopt;
 	}
+	/**
+	 *	Enables or disables parsing in place.
+	 *
+	 *	By default the body of each packet is copied
+	 *	into memory owned by this object before it is
+	 *	parsed. When parsing in place is enabled and
+	 *	\em Source is a `std::basic_streambuf` whose get
+	 *	area holds the entirety of an uncompressed body
+	 *	that body is instead parsed directly from the get
+	 *	area. Bodies which are split across calls to
+	 *	\ref parse or which are compressed are copied as
+	 *	usual.
+	 *
+	 *	When a body is parsed in place the `Source`
+	 *	returned by \ref parsed, and any views held by the
+	 *	parsed \ref protocol::packet, refer to memory owned
+	 *	by the `Source` passed to \ref parse. The caller
+	 *	must keep that memory intact until the next call
+	 *	to \ref parse.
+	 *
+	 *	\param [in] enable
+	 *		\em true to parse in place, \em false
+	 *		otherwise.
+	 */
+	void parse_in_place (bool enable) noexcept {
+		parse_in_place_ = enable;
+	}
+	/**
+	 *	Determines whether parsing in place is enabled
+	 *	or not.
+	 *
+	 *	\return
+	 *		\em true if parsing in place is enabled,
+	 *		\em false otherwise.
+	 */
+	bool parse_in_place () const noexcept {
+		return parse_in_place_;
+	}
+	/**
+	 *	Enables or disables skipping the bodies of packets
+	 *	for which there is no \ref packet_serializer.
+	 *
+	 *	By default the entire body of every packet is
+	 *	buffered (and inflated if compressed) before its
+	 *	ID is examined. When skipping is enabled the ID is
+	 *	parsed first (inflating only as much of a compressed
+	 *	body as is necessary to obtain it) and if there is
+	 *	no \ref packet_serializer for that ID the remainder
+	 *	of the body is consumed and discarded without being
+	 *	buffered or inflated. This makes packets which are
+	 *	of no interest, as is the case for most packets which
+	 *	pass through a proxy, nearly free to parse.
+	 *
+	 *	The body of a skipped packet is not available,
+	 *	see \ref parsed_skipped. Bodies which are parsed in
+	 *	place (see \ref parse_in_place) are never skipped
+	 *	since they are not copied in any case.
+	 *
+	 *	Invoking this method after a call to \ref parse
+	 *	has returned \em false or a `std::error_code`
+	 *	causes an subsequent invocations of \ref parse
+	 *	to have undefined behavior.
+	 *
+	 *	\param [in] enable
+	 *		\em true to skip, \em false otherwise.
+	 */
+	void parse_skip_unregistered (bool enable) noexcept {
+		check_no_parse_in_progress();
+		parse_skip_ = enable;
+	}
+	/**
+	 *	Determines whether skipping the bodies of packets
+	 *	for which there is no \ref packet_serializer is
+	 *	enabled or not.
+	 *
+	 *	\return
+	 *		\em true if skipping is enabled, \em false
+	 *		otherwise.
+	 */
+	bool parse_skip_unregistered () const noexcept {
+		return parse_skip_;
+	}
+	/**
+	 *	Sets the \ref buffer_pool from which buffers used
+	 *	to hold the bodies of packets being parsed are
+	 *	leased.
+	 *
+	 *	By default each stream_serializer owns its buffers
+	 *	which grow to accommodate the largest packet parsed
+	 *	and are never shrunk.
+	 *
+	 *	Invoking this method after a call to \ref parse
+	 *	has returned \em false or a `std::error_code`
+	 *	causes an subsequent invocations of \ref parse
+	 *	to have undefined behavior.
+	 *
+	 *	\param [in] pool
+	 *		The pool or a null pointer to stop using a
+	 *		pool. The pool may be shared with any number
+	 *		of other stream_serializer objects.
+	 */
+	void parse_buffer_pool (std::shared_ptr<parse_buffer_pool_type> pool) noexcept {
+		check_no_parse_in_progress();
+		parse_pool_ = std::move(pool);
+	}
+	/**
+	 *	Retrieves the \ref buffer_pool set by the last call
+	 *	to \ref parse_buffer_pool(std::shared_ptr<parse_buffer_pool_type>).
+	 *
+	 *	\return
+	 *		The pool, or a null pointer if there is none.
+	 */
+	const std::shared_ptr<parse_buffer_pool_type> & parse_buffer_pool () const noexcept {
+		return parse_pool_;
+	}
+	/**
+	 *	Sets the \ref buffer_pool from which buffers used
+	 *	to hold the bodies of packets being serialized
+	 *	are leased.
+	 *
+	 *	By default each stream_serializer owns its buffers
+	 *	which grow to accommodate the largest packet
+	 *	serialized and are never shrunk.
+	 *
+	 *	\param [in] pool
+	 *		The pool or a null pointer to stop using a
+	 *		pool. The pool may be shared with any number
+	 *		of other stream_serializer objects.
+	 */
+	void serialize_buffer_pool (std::shared_ptr<serialize_buffer_pool_type> pool) noexcept {
+		serialize_pool_ = std::move(pool);
+	}
+	/**
+	 *	Retrieves the \ref buffer_pool set by the last call
+	 *	to \ref serialize_buffer_pool(std::shared_ptr<serialize_buffer_pool_type>).
+	 *
+	 *	\return
+	 *		The pool, or a null pointer if there is none.
+	 */
+	const std::shared_ptr<serialize_buffer_pool_type> & serialize_buffer_pool () const noexcept {
+		return serialize_pool_;
+	}
+	/**
+	 *	Returns buffers which are too large to be retained
+	 *	(see \ref buffer_pool::private_limit) to the pools
+	 *	from which they were leased.
+	 *
+	 *	This happens in any case at the start of the next
+	 *	call to \ref parse or \ref serialize, this method
+	 *	allows a connection which is about to become idle
+	 *	to return them immediately.
+	 *
+	 *	After this method is invoked the last packet parsed
+	 *	and the last packet serialized, and all views thereof
+	 *	and buffers which refer thereto, may not be used.
+	 *
+	 *	If this method is invoked after a call to \ref parse
+	 *	has returned \em false or a `std::error_code` the
+	 *	behavior is undefined.
+	 */
+	void release_buffers () noexcept {
+		check_no_parse_in_progress();
+		parse_reset_if_applicable();
+		serialize_reset();
+	}
 	/**
 	 *	Determines whether compression is enabled or
 	 *	not.
@@ -802,6 +2361,48 @@ public:
 		assert(compressed());
 		return *threshold_;
 	}
+	/**
+	 *	Retrieves the policy which chooses the settings
+	 *	with which each packet that must be compressed is
+	 *	compressed.
+	 *
+	 *	The policy is initially constructed from the
+	 *	`boost::iostreams::zlib_params` passed to the
+	 *	constructor and may be modified through the
+	 *	returned reference.
+	 *
+	 *	The policy only affects serialization. It never
+	 *	changes which packets are compressed, that is
+	 *	governed solely by the compression threshold.
+	 *
+	 *	\return
+	 *		A reference to a \ref protocol::compression_policy.
+	 */
+	protocol::compression_policy & compression_policy () noexcept {
+		return serialize_policy_;
+	}
+	/**
+	 *	Retrieves the policy which chooses the settings
+	 *	with which each packet that must be compressed is
+	 *	compressed.
+	 *
+	 *	\return
+	 *		A reference to a \ref protocol::compression_policy.
+	 */
+	const protocol::compression_policy & compression_policy () const noexcept {
+		return serialize_policy_;
+	}
+	/**
+	 *	Replaces the policy which chooses the settings
+	 *	with which each packet that must be compressed is
+	 *	compressed.
+	 *
+	 *	\param [in] policy
+	 *		The new policy.
+	 */
+	void compression_policy (protocol::compression_policy policy) noexcept {
+		serialize_policy_ = std::move(policy);
+	}
 	/**
 	 *	Retrieves the protocol direction for which the object
 	 *	is parsing packets.
@@ -854,5 +2455,10 @@ public:
 	}
 };
 
+template <typename Source, typename Sink, typename Allocator>
+constexpr std::size_t stream_serializer<Source, Sink, Allocator>::max_data_length;
+template <typename Source, typename Sink, typename Allocator>
+constexpr std::size_t stream_serializer<Source, Sink, Allocator>::parse_chunk_size;
+
 }
 }
@@ -7,28 +7,31 @@
 #include "checked.hpp"
 #include "error.hpp"
 #include "exception.hpp"
+#include "span.hpp"
 #include "varint.hpp"
-#include <boost/core/ref.hpp>
 #include <boost/expected/expected.hpp>
-#include <boost/iostreams/code_converter.hpp>
-#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/read.hpp>
 #include <boost/iostreams/write.hpp>
 #include <mcpp/checked.hpp>
-#include <mcpp/iostreams/limiting_source.hpp>
-#include <mcpp/iostreams/proxy_sink.hpp>
+#include <mcpp/iostreams/streambuf_area.hpp>
 #include <mcpp/iostreams/traits.hpp>
-#include <codecvt>
+#include <mcpp/string_view.hpp>
+#include <mcpp/utf8.hpp>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cwchar>
 #include <ios>
+#include <limits>
 #include <locale>
 #include <memory>
 #include <sstream>
+#include <streambuf>
 #include <string>
 #include <system_error>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace mcpp {
 namespace protocol {
@@ -42,16 +45,6 @@ class select_codecvt {
 public:
 	using type = std::codecvt<InternT, ExternT, std::mbstate_t>;
 };
-template <>
-class select_codecvt<char16_t, char> {
-public:
-	using type = std::codecvt_utf8_utf16<char16_t>;
-};
-template <>
-class select_codecvt<char32_t, char> {
-public:
-	using type = std::codecvt_utf8<char32_t>;
-};
 
 template <typename InternT, typename ExternT>
 using select_codecvt_t = typename select_codecvt<InternT, ExternT>::type;
@@ -62,19 +55,176 @@ using codecvt_t = std::conditional_t<std::is_same<Codecvt, default_codecvt>::val
 	Codecvt
 >;
 
-template <typename Codecvt, typename Device, typename Allocator>
-boost::iostreams::code_converter<Device, Codecvt, Allocator> make_code_converter (const Device & device, const Allocator &, const std::false_type &) {
-	//	TODO: Use the allocator?
-	return boost::iostreams::code_converter<std::decay_t<Device>, Codecvt, Allocator>(device);
+//	std::codecvt specializations have protected
+//	destructors and are therefore obtained from the
+//	global locale, other facets are default constructed
+template <typename Codecvt>
+class codecvt_holder {
+private:
+	Codecvt codecvt_;
+public:
+	const Codecvt & get () const noexcept {
+		return codecvt_;
+	}
+};
+template <typename InternT, typename ExternT>
+class codecvt_holder<std::codecvt<InternT, ExternT, std::mbstate_t>> {
+private:
+	using codecvt_type = std::codecvt<InternT, ExternT, std::mbstate_t>;
+	std::locale loc_;
+	const codecvt_type * codecvt_;
+public:
+	codecvt_holder () : codecvt_(&std::use_facet<codecvt_type>(loc_)) {	}
+	const codecvt_type & get () const noexcept {
+		return *codecvt_;
+	}
+};
+
+//	Converts text through a std::codecvt facet directly
+//	into a string rather than through boost::iostreams::code_converter
+//	since the latter default constructs its Allocator
+//	and therefore cannot allocate its buffers through
+//	the allocator of the string. The string grows as
+//	necessary and is resized to the length of the result.
+//	Returns false if the facet reports an error or if
+//	the input ends partway through a character
+template <typename Codecvt, typename From, typename String, typename Function>
+bool convert (const Codecvt & cvt, const From * begin, const From * end, std::size_t estimate, String & str, Function func) {
+	using to_type = typename String::value_type;
+	std::mbstate_t state{};
+	str.resize(std::max<std::size_t>(estimate, 1));
+	std::size_t written(0);
+	for (;;) {
+		const From * from_next;
+		to_type * to = &str[0];
+		to_type * to_next;
+		auto result = func(cvt, state, begin, end, from_next, to + written, to + str.size(), to_next);
+		if (result == std::codecvt_base::noconv) {
+			str.assign(begin, end);
+			return true;
+		}
+		if (result == std::codecvt_base::error) return false;
+		written = std::size_t(to_next - to);
+		begin = from_next;
+		if ((result == std::codecvt_base::ok) && (begin == end)) break;
+		//	A partial result without the output being full
+		//	means the input ended partway through a character
+		if (written != str.size()) return false;
+		str.resize(str.size() * 2);
+	}
+	str.resize(written);
+	return true;
+}
+
+//	UTF-16 and UTF-32 are transcoded to and from
+//	UTF-8 directly rather than through std::codecvt
+//	unless a facet is explicitly requested
+template <typename CharT, typename Codecvt, typename Device>
+using use_transcoder_t = std::integral_constant<bool,
+	std::is_same<Codecvt, default_codecvt>::value &&
+	(std::is_same<CharT, char16_t>::value || std::is_same<CharT, char32_t>::value) &&
+	std::is_same<iostreams::char_type_of_t<Device>, char>::value
+>;
+
+//	The length of a string is sent by the peer and
+//	therefore the buffer into which it is copied is
+//	grown by at most this many bytes ahead of what
+//	has actually been read
+constexpr std::size_t string_chunk_size = 4096;
+
+//	Invokes a function with a pointer to the next
+//	size bytes of a Source, consuming them. If they
+//	are not contiguous in memory they are first
+//	copied
+template <typename Allocator, typename Source, typename Function>
+auto with_string_bytes (Source & src, std::size_t size, const Allocator & a, Function func, const std::false_type &) -> decltype(func(nullptr)) {
+	using allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+	std::vector<char, allocator> buffer(allocator{a});
+	std::size_t read(0);
+	while (read != size) {
+		if (buffer.size() == read) buffer.resize(read + std::min(size - read, std::max(read, string_chunk_size)));
+		auto num = boost::iostreams::read(src, buffer.data() + read, std::streamsize(buffer.size() - read));
+		if (num <= 0) return boost::make_unexpected(make_error_code(error::end_of_file));
+		read += std::size_t(num);
+	}
+	return func(reinterpret_cast<const unsigned char *>(buffer.data()));
 }
-template <typename, typename Device, typename Allocator>
-typename boost::unwrap_reference<Device>::type & make_code_converter (Device & device, const Allocator &, const std::true_type &) {
-	return boost::unwrap_ref(device);
+template <typename Allocator, typename Source, typename Function>
+auto with_string_bytes (Source & src, std::size_t size, const Allocator & a, Function func, const std::true_type &) -> decltype(func(nullptr)) {
+	if (iostreams::get_available(src) < size) return detail::with_string_bytes(src, size, a, func, std::false_type{});
+	auto ptr = reinterpret_cast<const unsigned char *>(iostreams::gptr(src));
+	iostreams::gbump(src, size);
+	return func(ptr);
 }
-template <typename CharT, typename Codecvt, typename Device, typename Allocator>
-decltype(auto) make_code_converter (Device & device, const Allocator & a) {
-	typename std::is_same<CharT, iostreams::char_type_of_t<Device>>::type tag;
-	return detail::make_code_converter<codecvt_t<CharT, Codecvt, Device>>(device, a, tag);
+template <typename Allocator, typename Function>
+auto with_string_bytes (span_reader & src, std::size_t size, const Allocator &, Function func) -> decltype(func(nullptr)) {
+	if (src.remaining() < size) return boost::make_unexpected(make_error_code(error::end_of_file));
+	auto ptr = src.current();
+	src.advance(size);
+	return func(ptr);
+}
+template <typename Allocator, typename Source, typename Function>
+auto with_string_bytes (Source & src, std::size_t size, const Allocator & a, Function func) -> decltype(func(nullptr)) {
+	iostreams::is_streambuf_t<Source> tag;
+	return detail::with_string_bytes(src, size, a, func, tag);
+}
+
+template <typename CharT, typename Traits, typename Codecvt, typename Source, typename Allocator>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> convert_string (const unsigned char * ptr, std::size_t size, const Allocator & a, const std::false_type &) {
+	using string = std::basic_string<CharT, Traits, Allocator>;
+	using codecvt = codecvt_t<CharT, Codecvt, Source>;
+	using extern_type = typename codecvt::extern_type;
+	auto begin = reinterpret_cast<const extern_type *>(ptr);
+	codecvt_holder<codecvt> holder;
+	string retr(a);
+	bool converted = detail::convert(holder.get(), begin, begin + size, size, retr, [] (const auto & facet, auto && ... args) {
+		return facet.in(args...);
+	});
+	if (!converted) return boost::make_unexpected(make_error_code(error::encoding));
+	return retr;
+}
+template <typename CharT, typename Traits, typename Codecvt, typename Source, typename Allocator>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> convert_string (const unsigned char * ptr, std::size_t size, const Allocator & a, const std::true_type &) {
+	using string = std::basic_string<CharT, Traits, Allocator>;
+	//	UTF-8 never occupies fewer bytes than
+	//	code units
+	string retr(size, CharT(), a);
+	auto units = decode_utf8(ptr, size, &retr[0]);
+	if (!units) return boost::make_unexpected(make_error_code(error::encoding));
+	retr.resize(*units);
+	return retr;
+}
+template <typename CharT, typename Traits, typename Codecvt, typename Source, typename Allocator>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> convert_string (const unsigned char * ptr, std::size_t size, const Allocator & a) {
+	use_transcoder_t<CharT, Codecvt, Source> tag;
+	return detail::convert_string<CharT, Traits, Codecvt, Source>(ptr, size, a, tag);
+}
+template <typename CharT, typename Traits, typename Codecvt, typename Allocator, typename Source>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> parse_string (Source & src, const Allocator & a) {
+	using string = std::basic_string<CharT, Traits, Allocator>;
+	using result = boost::expected<string, std::error_code>;
+	return protocol::parse_varint<std::uint32_t>(src).bind([&] (auto num) {
+		return checked::cast<std::size_t>(num).bind([&] (auto size) -> result {
+			return detail::with_string_bytes(src, size, a, [&] (const unsigned char * ptr) {
+				return detail::convert_string<CharT, Traits, Codecvt, Source>(ptr, size, a);
+			});
+		});
+	});
+}
+
+//	Validates UTF-8 and checks the number of code points
+//	it encodes against a maximum in a single pass
+inline boost::expected<void, std::error_code> check_string_length (const unsigned char * ptr, std::size_t size, std::size_t max_length) noexcept {
+	auto count = count_utf8(ptr, size);
+	if (!count) return boost::make_unexpected(make_error_code(error::encoding));
+	if (*count > max_length) return boost::make_unexpected(make_error_code(error::too_long));
+	return boost::expected<void, std::error_code>{};
+}
+//	Each code point occupies at most four bytes
+//	therefore representations which are too long
+//	may be rejected before they are read
+inline bool string_size_exceeds (std::size_t size, std::size_t max_length) noexcept {
+	return ((size / 4) + std::size_t((size % 4) != 0)) > max_length;
 }
 
 }
@@ -96,7 +246,11 @@ decltype(auto) make_code_converter (Device & device, const Allocator & a) {
  *		the case where @em CharT is `wchar_t`, `char16_t`,
  *		or `char32_t` conversion is necessary and will
  *		be performed to UTF-16 or UTF-32 as appropriate
- *		based no the width of @em CharT.
+ *		based no the width of @em CharT. For `char16_t`
+ *		and `char32_t` the default template parameter
+ *		causes the text to be validated and transcoded
+ *		directly rather than through a `std::codecvt`
+ *		facet.
  *	\tparam Allocator
  *		A type which models `Allocator`.
  *	\tparam Source
@@ -111,27 +265,70 @@ decltype(auto) make_code_converter (Device & device, const Allocator & a) {
  *	\return
  *		A string if the parse succeeds. Otherwise a
  *		`std::error_code` object encapsulating the cause of
- *		the failure. Note that failures from the conversion
- *		process are transmitted as exceptions not
- *		`std::error_code` objects.
+ *		the failure. Malformed UTF-8 transcoded to `char16_t`
+ *		or `char32_t` is reported as \ref error::encoding,
+ *		as is text which a `std::codecvt` facet fails to
+ *		convert.
  */
 template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename Codecvt = detail::default_codecvt, typename Allocator = std::allocator<CharT>, typename Source>
 boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> parse_string (Source & src, const Allocator & a = Allocator{}) {
+	return detail::parse_string<CharT, Traits, Codecvt>(src, a);
+}
+
+namespace detail {
+
+template <typename CharT, typename Traits, typename Codecvt, typename Allocator>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> parse_string (span_reader & src, const Allocator & a, const std::true_type &) {
 	using string = std::basic_string<CharT, Traits, Allocator>;
-	using stringbuf = std::basic_stringbuf<CharT, Traits, Allocator>;
 	using result = boost::expected<string, std::error_code>;
 	return protocol::parse_varint<std::uint32_t>(src).bind([&] (auto num) {
 		return checked::cast<std::size_t>(num).bind([&] (auto size) -> result {
-			auto limiting = iostreams::make_limiting_source(boost::ref(src), size);
-			auto && converting = detail::make_code_converter<CharT, Codecvt>(boost::ref(limiting), a);
-			string s(a);
-			stringbuf buf(s, std::ios_base::out);
-			std::size_t num(boost::iostreams::copy(boost::ref(converting), buf));
-			if (num != size) return boost::make_unexpected(make_error_code(error::end_of_file));
-			return buf.str();
+			if (src.remaining() < size) return boost::make_unexpected(make_error_code(error::end_of_file));
+			string retr(reinterpret_cast<const CharT *>(src.current()), size, a);
+			src.advance(size);
+			return retr;
 		});
 	});
 }
+template <typename CharT, typename Traits, typename Codecvt, typename Allocator>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> parse_string (span_reader & src, const Allocator & a, const std::false_type &) {
+	return detail::parse_string<CharT, Traits, Codecvt>(src, a);
+}
+
+}
+
+/**
+ *	Parses a Unicode string directly from the memory
+ *	managed by a \ref span_reader.
+ *
+ *	When no conversion is necessary the string is
+ *	constructed from the managed memory in a single
+ *	step.
+ *
+ *	\tparam CharT
+ *		See \ref parse_string.
+ *	\tparam Traits
+ *		See \ref parse_string.
+ *	\tparam Codecvt
+ *		See \ref parse_string.
+ *	\tparam Allocator
+ *		See \ref parse_string.
+ *
+ *	\param [in] src
+ *		The \ref span_reader from which data shall be
+ *		read.
+ *	\param [in] a
+ *		The `Allocator` to use. Defaults to a default
+ *		constructed object of type \em Allocator.
+ *
+ *	\return
+ *		See \ref parse_string.
+ */
+template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename Codecvt = detail::default_codecvt, typename Allocator = std::allocator<CharT>>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> parse_string (span_reader & src, const Allocator & a = Allocator{}) {
+	typename std::is_same<CharT, span_reader::char_type>::type tag;
+	return detail::parse_string<CharT, Traits, Codecvt>(src, a, tag);
+}
 /**
  *	Functions identically to \ref parse_string except
  *	the result of the parse shall be assigned to an out
@@ -217,6 +414,215 @@ auto make_string_parser (Source & src, std::basic_string<CharT, Traits, Allocato
 	return [&] () {	return protocol::parse_string<Codecvt>(src, str);	};
 }
 
+/**
+ *	Parses a Unicode string from a binary buffer
+ *	rejecting it if it encodes more than a certain
+ *	number of code points.
+ *
+ *	The representation is validated as UTF-8 and its
+ *	code points counted in a single pass before it is
+ *	converted. Representations which occupy more bytes
+ *	than \em max_length code points possibly could are
+ *	rejected before they are read.
+ *
+ *	\tparam CharT
+ *		See \ref parse_string.
+ *	\tparam Traits
+ *		See \ref parse_string.
+ *	\tparam Codecvt
+ *		See \ref parse_string.
+ *	\tparam Allocator
+ *		See \ref parse_string.
+ *	\tparam Source
+ *		A type which models `Source`.
+ *
+ *	\param [in] src
+ *		The `Source` from which data shall be read.
+ *	\param [in] max_length
+ *		The maximum number of code points.
+ *	\param [in] a
+ *		The `Allocator` to use. Defaults to a default
+ *		constructed object of type \em Allocator.
+ *
+ *	\return
+ *		See \ref parse_string. Strings which encode
+ *		more than \em max_length code points are
+ *		reported as \ref error::too_long.
+ */
+template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename Codecvt = detail::default_codecvt, typename Allocator = std::allocator<CharT>, typename Source>
+boost::expected<std::basic_string<CharT, Traits, Allocator>, std::error_code> parse_bounded_string (Source & src, std::size_t max_length, const Allocator & a = Allocator{}) {
+	using string = std::basic_string<CharT, Traits, Allocator>;
+	using result = boost::expected<string, std::error_code>;
+	return protocol::parse_varint<std::uint32_t>(src).bind([&] (auto num) {
+		return checked::cast<std::size_t>(num).bind([&] (auto size) -> result {
+			if (detail::string_size_exceeds(size, max_length)) return boost::make_unexpected(make_error_code(error::too_long));
+			return detail::with_string_bytes(src, size, a, [&] (const unsigned char * ptr) {
+				return detail::check_string_length(ptr, size, max_length).bind([&] () {
+					return detail::convert_string<CharT, Traits, Codecvt, Source>(ptr, size, a);
+				});
+			});
+		});
+	});
+}
+/**
+ *	Functions identically to \ref parse_bounded_string
+ *	except the result of the parse shall be assigned to
+ *	an out parameter rather than being returned.
+ *
+ *	\tparam Codecvt
+ *		See \ref parse_string.
+ *	\tparam Source
+ *		A model of `Source`.
+ *	\tparam CharT
+ *		The character type of the string to parse.
+ *	\tparam Traits
+ *		The traits type of the string to parse.
+ *	\tparam Allocator
+ *		A model of `Allocator` which is used to allocate
+ *		memory for the string to parse.
+ *
+ *	\param [in] src
+ *		The `Source` from which the representation of the
+ *		string shall be read.
+ *	\param [out] val
+ *		A string which shall be assigned the result of the
+ *		parse. If the parse fails the value of this string
+ *		is unspecified except that it shall be safe to
+ *		destroy and assign to.
+ *	\param [in] max_length
+ *		The maximum number of code points.
+ *
+ *	\return
+ *		Nothing on success. A `std::error_code` on failure.
+ */
+template <typename Codecvt = detail::default_codecvt, typename Source, typename CharT, typename Traits, typename Allocator>
+boost::expected<void, std::error_code> parse_bounded_string (Source & src, std::basic_string<CharT, Traits, Allocator> & val, std::size_t max_length) {
+	return protocol::parse_bounded_string<CharT, Traits, Codecvt>(src, max_length, val.get_allocator()).map(
+		[&] (auto && str) {	val = std::move(str);	}
+	);
+}
+/**
+ *	Creates a function which when invoked parses a
+ *	string from a `Source` as if by \ref parse_bounded_string.
+ *
+ *	\tparam Codecvt
+ *		See \ref parse_string.
+ *	\tparam Source
+ *		A model of `Source`.
+ *	\tparam CharT
+ *		The character type of the string to parse.
+ *	\tparam Traits
+ *		The traits type of the string to parse.
+ *	\tparam Allocator
+ *		A model of `Allocator` which is used to allocate
+ *		memory for the string to parse.
+ *
+ *	\param [in] src
+ *		See \ref make_string_parser.
+ *	\param [in] str
+ *		See \ref make_string_parser.
+ *	\param [in] max_length
+ *		The maximum number of code points.
+ *
+ *	\return
+ *		A function which behaves as described.
+ */
+template <typename Codecvt = detail::default_codecvt, typename Source, typename CharT, typename Traits, typename Allocator>
+auto make_bounded_string_parser (Source & src, std::basic_string<CharT, Traits, Allocator> & str, std::size_t max_length) noexcept {
+	return [&src, &str, max_length] () {	return protocol::parse_bounded_string<Codecvt>(src, str, max_length);	};
+}
+
+/**
+ *	Parses a string without copying it, the result
+ *	refers directly to the bytes of the representation.
+ *
+ *	The bytes are validated as UTF-8 but are not
+ *	otherwise converted.
+ *
+ *	\param [in] src
+ *		The \ref span_reader from which the
+ *		representation shall be read.
+ *	\param [in] max_length
+ *		The maximum number of code points. Strings
+ *		which encode more are reported as
+ *		\ref error::too_long. Defaults to no maximum.
+ *
+ *	\return
+ *		A view of the string if the parse succeeds.
+ *		The view remains valid so long as the memory
+ *		managed by \em src does. Otherwise a
+ *		`std::error_code` encapsulating the cause of
+ *		the failure.
+ */
+inline boost::expected<string_view, std::error_code> parse_string_view (span_reader & src, std::size_t max_length = std::numeric_limits<std::size_t>::max()) {
+	using result = boost::expected<string_view, std::error_code>;
+	return protocol::parse_varint<std::uint32_t>(src).bind([&] (auto num) {
+		return checked::cast<std::size_t>(num).bind([&] (auto size) -> result {
+			if (detail::string_size_exceeds(size, max_length)) return boost::make_unexpected(make_error_code(error::too_long));
+			if (src.remaining() < size) return boost::make_unexpected(make_error_code(error::end_of_file));
+			auto ptr = src.current();
+			return detail::check_string_length(ptr, size, max_length).map([&] () {
+				src.advance(size);
+				return string_view(reinterpret_cast<const char *>(ptr), size);
+			});
+		});
+	});
+}
+/**
+ *	Parses a string without copying it from the get
+ *	area of a `std::basic_streambuf`.
+ *
+ *	This is intended for buffers which hold an entire
+ *	packet body such as the `Source` \ref stream_serializer
+ *	provides to each \ref packet_serializer or the
+ *	result of \ref stream_serializer::parsed. Views
+ *	obtained from those remain valid until the next
+ *	call to \ref stream_serializer::parse.
+ *
+ *	If the representation extends past the end of the
+ *	get area the parse fails as if EOF were encountered.
+ *
+ *	\tparam Traits
+ *		The traits type of \em src.
+ *
+ *	\param [in] src
+ *		The `std::basic_streambuf`.
+ *	\param [in] max_length
+ *		See \ref parse_string_view.
+ *
+ *	\return
+ *		See above.
+ */
+template <typename Traits>
+boost::expected<string_view, std::error_code> parse_string_view (std::basic_streambuf<char, Traits> & src, std::size_t max_length = std::numeric_limits<std::size_t>::max()) {
+	span_reader span(iostreams::gptr(src), iostreams::egptr(src));
+	auto retr = protocol::parse_string_view(span, max_length);
+	iostreams::gbump(src, span.consumed());
+	return retr;
+}
+/**
+ *	Functions identically to \ref parse_string_view
+ *	except the result of the parse shall be assigned to
+ *	an out parameter rather than being returned.
+ *
+ *	\tparam Source
+ *		A \ref span_reader or a `std::basic_streambuf`.
+ *
+ *	\param [in] src
+ *		The object from which the representation shall
+ *		be read.
+ *	\param [out] val
+ *		A view which shall be assigned the result of the
+ *		parse. If the parse fails this view is not modified.
+ *
+ *	\return
+ *		Nothing on success. A `std::error_code` on failure.
+ */
+template <typename Source>
+boost::expected<void, std::error_code> parse_string_view (Source & src, string_view & val) {
+	return protocol::parse_string_view(src).map([&] (auto str) noexcept {	val = str;	});
+}
+
 namespace detail {
 
 template <typename SizeType, typename Sink>
@@ -245,50 +651,85 @@ void serialize_string (const std::basic_string<CharT, Traits, Allocator> & val,
 }
 
 template <typename Codecvt, typename CharT, typename Traits, typename Allocator, typename Sink>
-void serialize_string (const std::basic_string<CharT, Traits, Allocator> & val, Sink & sink, const std::false_type &) {
-	using char_type = iostreams::char_type_of_t<Sink>;
-	using traits = std::char_traits<char_type>;
-	using allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<char_type>;
-	using string = std::basic_string<char_type, traits, allocator>;
-	using stringbuf = std::basic_stringbuf<char_type, traits, allocator>;
+void serialize_converted (const std::basic_string<CharT, Traits, Allocator> & val, Sink & sink, const std::false_type &) {
+	using codecvt = codecvt_t<CharT, Codecvt, Sink>;
+	using extern_type = typename codecvt::extern_type;
+	using allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<extern_type>;
+	using string = std::basic_string<extern_type, std::char_traits<extern_type>, allocator>;
+	codecvt_holder<codecvt> holder;
+	auto && cvt = holder.get();
 	string str(allocator(val.get_allocator()));
-	stringbuf buf(str, std::ios_base::out);
-	//	Not sure why this proxy is necessary, if I don't
-	//	use it I get a bunch of compile time errors I suspect
-	//	because the boost::iostreams::code_converter isn't
-	//	writable when templated on basic_stringbuf
-	auto proxy = iostreams::make_proxy_sink(boost::ref(buf));
-	//	TODO: Use the allocator?
-	boost::iostreams::code_converter<boost::reference_wrapper<decltype(proxy)>, Codecvt, Allocator> converter(boost::ref(proxy));
-	auto str_size = val.size();
-	std::size_t written(boost::iostreams::write(converter, val.data(), std::streamsize(str_size)));
-	if (written != str_size) throw write_overflow_error(str_size, written);
-	//	Calling boost::iostreams::close isn't sufficient,
-	//	neither is just calling converter.close(). This is
-	//	because boost::iostreams::code_converter::close has
-	//	its parameter defaulted to std::ios_base::out |
-	//	std::ios_base::in but internally checks that parameter
-	//	directly using == (both of these checks are clearly
-	//	false when the parameter is a bitwise combination).
-	//
-	//	Calling just converter.close(std::ios_base::out) (which
-	//	is all we care about) causes the destructor to crash.
-	//	Calling converter.close(std::ios_base::in) after
-	//	converter.close(std::ios_base::out) has the same effect.
-	//	Both of these are caused by the fact that
-	//	converter.close(std::ios_base::out) destroys a boost::
-	//	optional the boost::iostreams::code_converter maintains
-	//	internally whereas converter.close(std::ios_base::in)
-	//	blindly accesses this optional (which fails with an assert
-	//	in debug mode).
-	//
-	//	None of this is documented and I suspect it's two
-	//	separate bugs.
-	//
-	//	This was discovered with Boost 1.61.0 specifically.
-	converter.close(std::ios_base::in);
-	converter.close(std::ios_base::out);
-	detail::serialize_string(buf.str(), sink);
+	auto begin = val.data();
+	bool converted = detail::convert(cvt, begin, begin + val.size(), val.size() * std::size_t(std::max(cvt.max_length(), 1)), str, [] (const auto & facet, auto && ... args) {
+		return facet.out(args...);
+	});
+	if (!converted) throw unrepresentable_error("String cannot be represented by the std::codecvt facet");
+	detail::serialize_string(str, sink);
+}
+//	Transcodes valid UTF-16 or UTF-32 which occupies
+//	size bytes as UTF-8 into a Sink
+template <typename CharT, typename Sink>
+void write_utf8 (const CharT * ptr, std::size_t n, std::size_t, Sink & sink, const std::false_type &) {
+	//	Each code unit occupies at most this many
+	//	bytes of UTF-8
+	constexpr std::size_t max = (sizeof(CharT) == 2) ? 3 : 4;
+	unsigned char buffer [256];
+	constexpr std::size_t chunk = sizeof(buffer) / max;
+	while (n != 0) {
+		auto units = std::min(n, chunk);
+		//	Never split a surrogate pair between chunks
+		if ((units != n) && (ptr[units - 1] >= 0xD800) && (ptr[units - 1] <= 0xDBFF)) --units;
+		std::size_t size(*encode_utf8(ptr, units, buffer));
+		auto out = reinterpret_cast<const iostreams::char_type_of_t<Sink> *>(buffer);
+		std::size_t written(boost::iostreams::write(sink, out, std::streamsize(size)));
+		if (written != size) throw write_overflow_error(size, written);
+		ptr += units;
+		n -= units;
+	}
+}
+template <typename CharT, typename Sink>
+void write_utf8 (const CharT * ptr, std::size_t n, std::size_t size, Sink & sink, const std::true_type &) {
+	if (iostreams::put_available(sink) < size) {
+		detail::write_utf8(ptr, n, size, sink, std::false_type{});
+		return;
+	}
+	encode_utf8(ptr, n, iostreams::pptr(sink));
+	iostreams::pbump(sink, size);
+}
+template <typename CharT>
+void write_utf8 (const CharT * ptr, std::size_t n, std::size_t size, span_writer & sink) {
+	if (sink.remaining() < size) {
+		detail::write_utf8(ptr, n, size, sink, std::false_type{});
+		return;
+	}
+	encode_utf8(ptr, n, sink.current());
+	sink.advance(size);
+}
+template <typename CharT, typename Sink>
+void write_utf8 (const CharT * ptr, std::size_t n, std::size_t size, Sink & sink) {
+	std::integral_constant<bool,
+		iostreams::is_streambuf_v<Sink> &&
+		(sizeof(iostreams::char_type_of_t<Sink>) == 1)
+	> tag;
+	detail::write_utf8(ptr, n, size, sink, tag);
+}
+
+//	The length of the UTF-8 is determined before
+//	anything is written so that the prefix may be
+//	written first and the text transcoded straight
+//	into the Sink after it
+template <typename Codecvt, typename CharT, typename Traits, typename Allocator, typename Sink>
+void serialize_converted (const std::basic_string<CharT, Traits, Allocator> & val, Sink & sink, const std::true_type &) {
+	auto size = utf8_size(val.data(), val.size());
+	if (!size) throw unrepresentable_error("String contains invalid code units");
+	detail::serialize_string_size(*size, sink);
+	detail::write_utf8(val.data(), val.size(), *size, sink);
+}
+
+template <typename Codecvt, typename CharT, typename Traits, typename Allocator, typename Sink>
+void serialize_string (const std::basic_string<CharT, Traits, Allocator> & val, Sink & sink, const std::false_type &) {
+	use_transcoder_t<CharT, Codecvt, Sink> tag;
+	detail::serialize_converted<Codecvt>(val, sink, tag);
 }
 
 }
@@ -303,7 +744,13 @@ void serialize_string (const std::basic_string<CharT, Traits, Allocator> & val,
  *		the character type of \em Sink are identical.
  *		By default an appropriate `std::codecvt` facet
  *		is chosen based on the type of \em CharT and
- *		the character type of \em Sink.
+ *		the character type of \em Sink except that
+ *		`char16_t` and `char32_t` strings are transcoded
+ *		to UTF-8 directly. If such a string contains an
+ *		unpaired surrogate or a value beyond U+10FFFF
+ *		\ref unrepresentable_error is thrown, as it is
+ *		if a `std::codecvt` facet fails to convert the
+ *		string.
  *	\tparam CharT
  *		The character type of the string.
  *	\tparam Traits
@@ -325,7 +772,7 @@ void serialize_string (const std::basic_string<CharT, Traits, Allocator> & val,
 template <typename Codecvt = detail::default_codecvt, typename CharT, typename Traits, typename Allocator, typename Sink>
 void serialize_string (const std::basic_string<CharT, Traits, Allocator> & val, Sink & sink) {
 	typename std::is_same<iostreams::char_type_of_t<Sink>, CharT>::type tag;
-	detail::serialize_string<detail::codecvt_t<CharT, Codecvt, Sink>>(val, sink, tag);
+	detail::serialize_string<Codecvt>(val, sink, tag);
 }
 
 }
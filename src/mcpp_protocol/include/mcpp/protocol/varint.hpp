@@ -6,11 +6,24 @@
 
 #include "error.hpp"
 #include "exception.hpp"
+#include "span.hpp"
+//	In Boost 1.61.0 including boost/endian/endian.hpp
+//	is an error whereas in Boost 1.55.0 boost/endian/conversion.hpp
+//	doesn't exist apparently
+#ifdef MCPP_HAS_BOOST_ENDIAN_CONVERSION
+#include <boost/endian/conversion.hpp>
+#else
+#include <boost/endian/endian.hpp>
+#endif
 #include <boost/expected/expected.hpp>
 #include <boost/iostreams/get.hpp>
 #include <boost/iostreams/write.hpp>
+#include <mcpp/bit.hpp>
+#include <mcpp/iostreams/streambuf_area.hpp>
 #include <mcpp/iostreams/traits.hpp>
+#include <mcpp/simd.hpp>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <ios>
 #include <type_traits>
@@ -62,7 +75,7 @@ constexpr std::size_t varint_size = detail::varint_whole_bytes<T> + detail::vari
 namespace detail {
 
 template <typename T, typename Source>
-boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_raw (Source & src) {
+boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_raw (Source & src, const std::false_type &) {
 	constexpr std::size_t max = varint_size<T>;
 	using type = std::make_unsigned_t<T>;
 	type retr(0);
@@ -93,6 +106,119 @@ boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_raw (Sour
 	return boost::make_unexpected(make_error_code(error::unrepresentable));
 }
 
+//	Varints of types at most 64 bits wide fit in
+//	two 64 bit words which allows them to be decoded
+//	and encoded a word at a time
+template <typename T>
+constexpr bool varint_blockwise = number_of_bits<T> <= 64;
+constexpr std::uint64_t varint_continuation_bits = 0x8080808080808080;
+
+//	Selects the continuation bits of the first n
+//	bytes of a word
+constexpr std::uint64_t varint_window (std::size_t n) noexcept {
+	return (n == 0) ? 0 : ((n >= 8) ? varint_continuation_bits : (varint_continuation_bits >> (8 * (8 - n))));
+}
+
+inline std::uint64_t varint_load (const unsigned char * ptr, std::size_t avail) noexcept {
+	std::uint64_t retr(0);
+	if (avail >= sizeof(retr)) std::memcpy(&retr, ptr, sizeof(retr));
+	else std::memcpy(&retr, ptr, avail);
+	return boost::endian::little_to_native(retr);
+}
+
+//	Gathers the low seven bits of each byte of a
+//	word into the low 56 bits of the result
+inline std::uint64_t varint_compact (std::uint64_t word) noexcept {
+	word &= 0x7f7f7f7f7f7f7f7f;
+	word = ((word & 0x7f007f007f007f00) >> 1) | (word & 0x007f007f007f007f);
+	word = ((word & 0x3fff00003fff0000) >> 2) | (word & 0x00003fff00003fff);
+	word = ((word & 0x0fffffff00000000) >> 4) | (word & 0x000000000fffffff);
+	return word;
+}
+
+//	Requires that at least varint_size<T> bytes be
+//	available, under that condition the result is
+//	always decided by the bytes at hand. The number
+//	of bytes the byte-wise parse would have consumed
+//	(whether or not it succeeds) is stored in consumed
+template <typename T>
+boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_block (const unsigned char * ptr, std::size_t avail, std::size_t & consumed) noexcept {
+	constexpr std::size_t max = varint_size<T>;
+	using type = std::make_unsigned_t<T>;
+	auto lo = detail::varint_load(ptr, avail);
+	auto hi = (max > 8) ? detail::varint_load(ptr + 8, avail - 8) : std::uint64_t(0);
+	//	The terminating byte is the first whose
+	//	continuation bit is clear
+	std::uint64_t lo_stop = ~lo & detail::varint_window(max);
+	std::uint64_t hi_stop = ~hi & detail::varint_window((max > 8) ? (max - 8) : 0);
+	if ((lo_stop | hi_stop) == 0) {
+		consumed = max;
+		return boost::make_unexpected(make_error_code(error::unrepresentable));
+	}
+	std::uint64_t val;
+	std::size_t last;
+	//	x ^ (x - 1) sets all bits up to and including
+	//	the lowest set bit of x which selects every byte
+	//	up to and including the terminating byte
+	if (lo_stop != 0) {
+		last = mcpp::count_trailing_zeros(lo_stop) / 8;
+		val = detail::varint_compact(lo & (lo_stop ^ (lo_stop - 1)));
+	} else {
+		last = 8 + (mcpp::count_trailing_zeros(hi_stop) / 8);
+		val = detail::varint_compact(lo) | (detail::varint_compact(hi & (hi_stop ^ (hi_stop - 1))) << 56);
+	}
+	consumed = last + 1;
+	type curr(ptr[last]);
+	//	Check for overflow on final byte
+	if ((last == (max - 1)) && (curr & varint_overflow_mask<T>)) {
+		return boost::make_unexpected(make_error_code(error::unrepresentable));
+	}
+	//	Reject overlong encodings
+	if ((last != 0) && (curr == 0)) {
+		return boost::make_unexpected(make_error_code(error::overlong));
+	}
+	return type(val);
+}
+
+template <typename T, typename Source>
+boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_raw (Source & src, const std::true_type &) {
+	auto avail = iostreams::get_available(src);
+	//	Not enough bytes buffered to decide the
+	//	result, the byte-wise parse will underflow
+	//	as necessary
+	if (avail < varint_size<T>) return detail::parse_varint_raw<T>(src, std::false_type{});
+	auto ptr = reinterpret_cast<const unsigned char *>(iostreams::gptr(src));
+	std::size_t consumed;
+	auto retr = detail::parse_varint_block<T>(ptr, avail, consumed);
+	iostreams::gbump(src, consumed);
+	return retr;
+}
+
+template <typename T, typename Source>
+boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_raw (Source & src) {
+	std::integral_constant<bool,
+		iostreams::is_streambuf_v<Source> &&
+		(sizeof(iostreams::char_type_of_t<Source>) == 1) &&
+		varint_blockwise<T>
+	> tag;
+	return detail::parse_varint_raw<T>(src, tag);
+}
+
+template <typename T>
+boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_raw (span_reader & src, const std::true_type &) {
+	auto avail = src.remaining();
+	if (avail < varint_size<T>) return detail::parse_varint_raw<T>(src, std::false_type{});
+	std::size_t consumed;
+	auto retr = detail::parse_varint_block<T>(src.current(), avail, consumed);
+	src.advance(consumed);
+	return retr;
+}
+template <typename T>
+boost::expected<std::make_unsigned_t<T>, std::error_code> parse_varint_raw (span_reader & src) {
+	std::integral_constant<bool, varint_blockwise<T>> tag;
+	return detail::parse_varint_raw<T>(src, tag);
+}
+
 template <typename T, typename Source>
 boost::expected<T, std::error_code> parse_varint (Source & src, const std::true_type &) {
 	return detail::parse_varint_raw<T>(src).map([] (auto i) noexcept {
@@ -126,6 +252,13 @@ std::make_signed_t<T> from_zigzag (T val) noexcept {
 /**
  *	Parses a varint from a `Source`.
  *
+ *	If \em Source is a `std::basic_streambuf` whose get
+ *	area contains enough bytes to hold the longest
+ *	representation of \em T the varint is decoded in
+ *	place a word at a time rather than a byte at a time.
+ *	The same is true of a \ref span_reader which is
+ *	bounds checked directly against its pointers.
+ *
  *	\tparam T
  *		The type of integer to parse.
  *	\tparam Source
@@ -298,12 +431,278 @@ auto make_varint_zigzag_parser (Source & src, T & val) noexcept {
 
 namespace detail {
 
-template <typename T, typename Sink>
-void serialize_varint_raw (T val, Sink & sink) {
-	//	We create a buffer first to reduce
-	//	the number of calls we need to make
-	//	to the streambuf
-	unsigned char buffer [varint_size<T>];
+//	Bulk varint operations examine windows of this
+//	many integers or bytes at once looking for runs
+//	of varints whose representations are a single
+//	byte (i.e. integers less than 128)
+constexpr std::size_t varint_run = 16;
+
+template <typename T>
+T varint_cast (std::make_unsigned_t<T> u) noexcept {
+	//	Assumption: This machine represents
+	//	signed numbers using two's complement
+	T retr;
+	std::memcpy(&retr, &u, sizeof(retr));
+	return retr;
+}
+
+//	Determines how many of the next varint_run bytes
+//	have their continuation bit clear before the first
+//	which has it set
+inline std::size_t varint_single_byte_run (const unsigned char * ptr) noexcept {
+#ifdef MCPP_SSE2
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+	unsigned mask(_mm_movemask_epi8(v));
+	return mcpp::count_trailing_zeros(mask | (1U << varint_run));
+#else
+	auto lo = detail::varint_load(ptr, varint_run) & varint_continuation_bits;
+	if (lo != 0) return mcpp::count_trailing_zeros(lo) / 8;
+	auto hi = detail::varint_load(ptr + 8, varint_run - 8) & varint_continuation_bits;
+	if (hi != 0) return 8 + (mcpp::count_trailing_zeros(hi) / 8);
+	return varint_run;
+#endif
+}
+
+template <typename T, std::size_t Size>
+void varint_widen_run (const unsigned char * ptr, T * out, const std::integral_constant<std::size_t, Size> &) noexcept {
+	for (std::size_t i = 0; i < varint_run; ++i) out[i] = T(ptr[i]);
+}
+#ifdef MCPP_SSE2
+template <typename T>
+void varint_widen_run (const unsigned char * ptr, T * out, const std::integral_constant<std::size_t, 4> &) noexcept {
+	auto zero = _mm_setzero_si128();
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+	auto lo = _mm_unpacklo_epi8(v, zero);
+	auto hi = _mm_unpackhi_epi8(v, zero);
+	auto out_ptr = reinterpret_cast<__m128i *>(out);
+	_mm_storeu_si128(out_ptr, _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128(out_ptr + 1, _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128(out_ptr + 2, _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128(out_ptr + 3, _mm_unpackhi_epi16(hi, zero));
+}
+#endif
+//	Converts all varint_run bytes to integers, only
+//	those counted by varint_single_byte_run are
+//	meaningful
+template <typename T>
+void varint_widen_run (const unsigned char * ptr, T * out) noexcept {
+	std::integral_constant<std::size_t, sizeof(T)> tag;
+	detail::varint_widen_run(ptr, out, tag);
+}
+
+template <typename T, std::size_t Size>
+std::size_t varint_narrow_run (const T * in, unsigned char * out, const std::integral_constant<std::size_t, Size> &) noexcept {
+	using type = std::make_unsigned_t<T>;
+	std::size_t i = 0;
+	for (; (i < varint_run) && (type(in[i]) < 128); ++i) out[i] = static_cast<unsigned char>(in[i]);
+	return i;
+}
+#ifdef MCPP_SSE2
+template <typename T>
+std::size_t varint_narrow_run (const T * in, unsigned char * out, const std::integral_constant<std::size_t, 4> &) noexcept {
+	auto in_ptr = reinterpret_cast<const __m128i *>(in);
+	auto a = _mm_loadu_si128(in_ptr);
+	auto b = _mm_loadu_si128(in_ptr + 1);
+	auto c = _mm_loadu_si128(in_ptr + 2);
+	auto d = _mm_loadu_si128(in_ptr + 3);
+	auto high = _mm_set1_epi32(~0x7f);
+	auto zero = _mm_setzero_si128();
+	//	Each lane becomes all ones if it is less
+	//	than 128 and zero otherwise, which survives
+	//	the saturating packs below
+	auto small = _mm_packs_epi16(
+		_mm_packs_epi32(
+			_mm_cmpeq_epi32(_mm_and_si128(a, high), zero),
+			_mm_cmpeq_epi32(_mm_and_si128(b, high), zero)
+		),
+		_mm_packs_epi32(
+			_mm_cmpeq_epi32(_mm_and_si128(c, high), zero),
+			_mm_cmpeq_epi32(_mm_and_si128(d, high), zero)
+		)
+	);
+	unsigned mask(_mm_movemask_epi8(small));
+	//	Lanes not less than 128 are saturated but
+	//	are not counted
+	auto packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out), packed);
+	return mcpp::count_trailing_zeros(~mask);
+}
+#endif
+//	Writes the representations of the leading integers
+//	among the next varint_run which are less than 128
+//	and returns how many there were, up to varint_run
+//	bytes may be written
+template <typename T>
+std::size_t varint_narrow_run (const T * in, unsigned char * out) noexcept {
+	std::integral_constant<std::size_t, sizeof(T)> tag;
+	return detail::varint_narrow_run(in, out, tag);
+}
+
+template <typename T, typename Source>
+boost::expected<void, std::error_code> parse_varint_array (Source & src, T * ptr, std::size_t n, const std::false_type &) {
+	for (; n != 0; --n, ++ptr) {
+		auto result = protocol::parse_varint<T>(src);
+		if (!result) return result.get_unexpected();
+		*ptr = *result;
+	}
+	return boost::expected<void, std::error_code>{};
+}
+template <typename T, typename Source>
+boost::expected<void, std::error_code> parse_varint_array (Source & src, T * ptr, std::size_t n, const std::true_type &) {
+	auto curr = reinterpret_cast<const unsigned char *>(iostreams::gptr(src));
+	auto end = reinterpret_cast<const unsigned char *>(iostreams::egptr(src));
+	auto commit = [&] () noexcept {
+		auto begin = reinterpret_cast<const unsigned char *>(iostreams::gptr(src));
+		iostreams::gbump(src, std::size_t(curr - begin));
+	};
+	while (n != 0) {
+		std::size_t avail(end - curr);
+		if ((n >= varint_run) && (avail >= varint_run)) {
+			auto run = detail::varint_single_byte_run(curr);
+			detail::varint_widen_run(curr, ptr);
+			curr += run;
+			ptr += run;
+			n -= run;
+			avail -= run;
+			if ((run == varint_run) || (n == 0)) continue;
+		}
+		if (avail >= varint_size<T>) {
+			std::size_t consumed;
+			auto result = detail::parse_varint_block<T>(curr, avail, consumed);
+			curr += consumed;
+			if (!result) {
+				commit();
+				return result.get_unexpected();
+			}
+			*(ptr++) = detail::varint_cast<T>(*result);
+			--n;
+			continue;
+		}
+		//	The get area may not hold the entire
+		//	representation, let the streambuf
+		//	underflow
+		commit();
+		auto result = protocol::parse_varint<T>(src);
+		if (!result) return result.get_unexpected();
+		*(ptr++) = *result;
+		--n;
+		curr = reinterpret_cast<const unsigned char *>(iostreams::gptr(src));
+		end = reinterpret_cast<const unsigned char *>(iostreams::egptr(src));
+	}
+	commit();
+	return boost::expected<void, std::error_code>{};
+}
+
+}
+
+/**
+ *	Parses a sequence of varints from a `Source`.
+ *
+ *	The number of varints is not read from \em src,
+ *	it is the responsibility of the caller to parse
+ *	any length prefix.
+ *
+ *	The result is identical to invoking \ref parse_varint
+ *	\em n times. However if \em src is a `std::basic_streambuf`
+ *	varints are decoded directly from its get area and
+ *	runs of single byte representations are converted
+ *	many at a time.
+ *
+ *	\tparam Source
+ *		A type which models `Source`.
+ *	\tparam T
+ *		The type of integer to parse.
+ *
+ *	\param [in] src
+ *		The `Source` from which to read.
+ *	\param [out] ptr
+ *		A pointer to the first of \em n integers to
+ *		which the parsed values shall be assigned. If
+ *		the parse fails the values of these integers
+ *		are unspecified.
+ *	\param [in] n
+ *		The number of varints to parse.
+ *
+ *	\return
+ *		Nothing on success. A `std::error_code` on failure.
+ */
+template <typename Source, typename T>
+boost::expected<void, std::error_code> parse_varint_array (Source & src, T * ptr, std::size_t n) {
+	std::integral_constant<bool,
+		iostreams::is_streambuf_v<Source> &&
+		(sizeof(iostreams::char_type_of_t<Source>) == 1) &&
+		detail::varint_blockwise<T>
+	> tag;
+	return detail::parse_varint_array(src, ptr, n, tag);
+}
+
+namespace detail {
+
+//	Inverse of varint_compact, distributes the low
+//	56 bits of a word into the low seven bits of
+//	each byte
+inline std::uint64_t varint_spread (std::uint64_t word) noexcept {
+	word = (word & 0x000000000fffffff) | ((word & 0x00fffffff0000000) << 4);
+	word = (word & 0x00003fff00003fff) | ((word & 0x0fffc0000fffc000) << 2);
+	word = (word & 0x007f007f007f007f) | ((word & 0x3f803f803f803f80) << 1);
+	return word;
+}
+
+//	Selects the low n bytes of a word, shifting in
+//	two steps keeps n == 8 (which selects the whole
+//	word) well defined
+constexpr std::uint64_t varint_bytes (std::size_t n) noexcept {
+	return ~((~std::uint64_t(0) << (4 * n)) << (4 * n));
+}
+
+inline void varint_store (unsigned char * ptr, std::uint64_t word) noexcept {
+	word = boost::endian::native_to_little(word);
+	std::memcpy(ptr, &word, sizeof(word));
+}
+//	Only the selected bytes are changed, this allows
+//	a full word to be stored into a put area where
+//	characters past the representation may be part
+//	of the sequence (e.g. after seeking backwards)
+inline void varint_store (unsigned char * ptr, std::uint64_t word, std::uint64_t keep) noexcept {
+	auto existing = detail::varint_load(ptr, sizeof(word));
+	detail::varint_store(ptr, (word & keep) | (existing & ~keep));
+}
+
+//	The number of bytes written when encoding an
+//	integer of type T, representations of blockwise
+//	types are written as whole words
+template <typename T>
+constexpr std::size_t varint_store_size = varint_blockwise<T> ? ((varint_size<T> <= 8) ? 8 : 16) : varint_size<T>;
+
+//	Computes the representation of an unsigned integer
+//	as two little endian words (the second is only
+//	meaningful for representations longer than eight
+//	bytes) and returns its length without branching
+//	on the value
+template <typename T>
+std::size_t varint_encode_words (T val, std::uint64_t & lo, std::uint64_t & hi) noexcept {
+	std::uint64_t u(val);
+	//	Zero is represented by a single byte
+	std::size_t bits = 64 - mcpp::count_leading_zeros(u | 1);
+	std::size_t size = (bits + (varint_bits_per_byte - 1)) / varint_bits_per_byte;
+	//	Every byte but the last has its continuation
+	//	bit set
+	lo = detail::varint_spread(u & 0x00ffffffffffffff) | (varint_continuation_bits & detail::varint_bytes(size - 1));
+	hi = detail::varint_spread(u >> 56) | (varint_continuation_bits & detail::varint_bytes((size > 9) ? (size - 9) : 0));
+	return size;
+}
+
+template <typename T>
+std::size_t encode_varint (T val, unsigned char * buffer, const std::true_type &) noexcept {
+	std::uint64_t lo;
+	std::uint64_t hi;
+	auto retr = detail::varint_encode_words(val, lo, hi);
+	detail::varint_store(buffer, lo);
+	if (varint_store_size<T> > 8) detail::varint_store(buffer + 8, hi);
+	return retr;
+}
+template <typename T>
+std::size_t encode_varint (T val, unsigned char * buffer, const std::false_type &) noexcept {
 	std::size_t i = 0;
 	for (;;) {
 		buffer[i] = val & 127;
@@ -315,10 +714,83 @@ void serialize_varint_raw (T val, Sink & sink) {
 		++i;
 		break;
 	}
+	return i;
+}
+//	Writes the representation of an unsigned integer
+//	to memory which must have room for at least
+//	varint_store_size<T> bytes and returns the length
+//	of the representation
+template <typename T>
+std::size_t encode_varint (T val, unsigned char * buffer) noexcept {
+	std::integral_constant<bool, varint_blockwise<T>> tag;
+	return detail::encode_varint(val, buffer, tag);
+}
+
+//	As encode_varint except that bytes past the
+//	representation are left unchanged, requires that
+//	T be blockwise
+template <typename T>
+std::size_t encode_varint_in_place (T val, unsigned char * ptr) noexcept {
+	std::uint64_t lo;
+	std::uint64_t hi;
+	auto retr = detail::varint_encode_words(val, lo, hi);
+	detail::varint_store(ptr, lo, detail::varint_bytes(retr));
+	if (varint_store_size<T> > 8) detail::varint_store(ptr + 8, hi, detail::varint_bytes((retr > 8) ? (retr - 8) : 0));
+	return retr;
+}
+
+template <typename Sink>
+void serialize_varint_bytes (const unsigned char * buffer, std::size_t size, Sink & sink) {
 	using pointer_type = const iostreams::char_type_of_t<Sink> *;
 	auto ptr = reinterpret_cast<pointer_type>(buffer);
-	std::size_t written(boost::iostreams::write(sink, ptr, std::streamsize(i)));
-	if (written != i) throw write_overflow_error(i, written);
+	std::size_t written(boost::iostreams::write(sink, ptr, std::streamsize(size)));
+	if (written != size) throw write_overflow_error(size, written);
+}
+
+template <typename T, typename Sink>
+void serialize_varint_raw (T val, Sink & sink, const std::false_type &) {
+	//	We create a buffer first to reduce
+	//	the number of calls we need to make
+	//	to the streambuf
+	unsigned char buffer [varint_store_size<T>];
+	auto i = detail::encode_varint(val, buffer);
+	detail::serialize_varint_bytes(buffer, i, sink);
+}
+template <typename T, typename Sink>
+void serialize_varint_raw (T val, Sink & sink, const std::true_type &) {
+	//	If the put area has room for whole words the
+	//	representation is stored directly into it,
+	//	otherwise the streambuf must be allowed to
+	//	overflow
+	if (iostreams::put_available(sink) < varint_store_size<T>) {
+		detail::serialize_varint_raw(val, sink, std::false_type{});
+		return;
+	}
+	auto ptr = reinterpret_cast<unsigned char *>(iostreams::pptr(sink));
+	iostreams::pbump(sink, detail::encode_varint_in_place(val, ptr));
+}
+template <typename T, typename Sink>
+void serialize_varint_raw (T val, Sink & sink) {
+	std::integral_constant<bool,
+		iostreams::is_streambuf_v<Sink> &&
+		(sizeof(iostreams::char_type_of_t<Sink>) == 1) &&
+		varint_blockwise<T>
+	> tag;
+	detail::serialize_varint_raw(val, sink, tag);
+}
+
+template <typename T>
+void serialize_varint_raw (T val, span_writer & sink, const std::true_type &) {
+	if (sink.remaining() < varint_store_size<T>) {
+		detail::serialize_varint_raw(val, sink, std::false_type{});
+		return;
+	}
+	sink.advance(detail::encode_varint_in_place(val, sink.current()));
+}
+template <typename T>
+void serialize_varint_raw (T val, span_writer & sink) {
+	std::integral_constant<bool, varint_blockwise<T>> tag;
+	detail::serialize_varint_raw(val, sink, tag);
 }
 
 template <typename T, typename Sink>
@@ -349,6 +821,12 @@ std::make_unsigned_t<T> to_zigzag (T val) noexcept {
 /**
  *	Serializes an integer encoded as a varint.
  *
+ *	If \em Sink is a `std::basic_streambuf` whose put
+ *	area has room the representation is computed
+ *	without branching on the value and stored directly
+ *	into the put area. The same is true of a
+ *	\ref span_writer.
+ *
  *	\tparam T
  *		The type of integer to serialize.
  *	\tparam Sink
@@ -387,5 +865,63 @@ void serialize_varint_zigzag (T val, Sink & sink) {
 	protocol::serialize_varint(u, sink);
 }
 
+/**
+ *	Serializes a sequence of integers each encoded
+ *	as a varint.
+ *
+ *	The number of integers is not written, it is the
+ *	responsibility of the caller to serialize any
+ *	length prefix.
+ *
+ *	The bytes written are identical to those which
+ *	would be written by invoking \ref serialize_varint
+ *	\em n times. However representations are accumulated
+ *	and written to \em sink in large chunks and runs
+ *	of integers less than 128 are converted many at
+ *	a time.
+ *
+ *	\tparam T
+ *		The type of integer to serialize.
+ *	\tparam Sink
+ *		A type which models `Sink`.
+ *
+ *	\param [in] ptr
+ *		A pointer to the first of \em n integers to
+ *		serialize.
+ *	\param [in] n
+ *		The number of integers to serialize.
+ *	\param [in] sink
+ *		An object which models `Sink` to which
+ *		binary data shall be written.
+ */
+template <typename T, typename Sink>
+void serialize_varint_array (const T * ptr, std::size_t n, Sink & sink) {
+	using type = std::make_unsigned_t<T>;
+	//	Room for either a run or a single varint
+	constexpr std::size_t reserve = (detail::varint_store_size<T> > detail::varint_run) ? detail::varint_store_size<T> : detail::varint_run;
+	unsigned char buffer [256];
+	std::size_t size = 0;
+	while (n != 0) {
+		if ((sizeof(buffer) - size) < reserve) {
+			detail::serialize_varint_bytes(buffer, size, sink);
+			size = 0;
+		}
+		if (n >= detail::varint_run) {
+			auto run = detail::varint_narrow_run(ptr, buffer + size);
+			size += run;
+			ptr += run;
+			n -= run;
+			if (run == detail::varint_run) continue;
+		}
+		if ((sizeof(buffer) - size) < detail::varint_store_size<T>) {
+			detail::serialize_varint_bytes(buffer, size, sink);
+			size = 0;
+		}
+		size += detail::encode_varint(type(*(ptr++)), buffer + size);
+		--n;
+	}
+	if (size != 0) detail::serialize_varint_bytes(buffer, size, sink);
+}
+
 }
 }
@@ -0,0 +1,314 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <boost/expected/expected.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <mcpp/checked.hpp>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <type_traits>
+
+//	Declared by zlib.h, which is deliberately not
+//	included here
+struct z_stream_s;
+
+namespace mcpp {
+namespace protocol {
+
+namespace detail {
+
+//	The memory zlib allocates for its internal state
+//	is obtained through an object of this type when
+//	one is supplied so that a stateful Allocator may
+//	be used without zlib.cpp being a template
+class zlib_allocator {
+protected:
+	~zlib_allocator () noexcept = default;
+public:
+	virtual void * allocate (std::size_t size) = 0;
+	virtual void deallocate (void * ptr) noexcept = 0;
+	//	Destroys this object and deallocates the memory
+	//	it occupies through the wrapped Allocator
+	virtual void destroy () noexcept = 0;
+};
+
+template <typename Allocator>
+class basic_zlib_allocator final : public zlib_allocator {
+private:
+	//	Each allocation is preceded by a unit which
+	//	records its size in units since zlib does not
+	//	supply the size when freeing
+	using unit = std::aligned_storage_t<sizeof(std::max_align_t), alignof(std::max_align_t)>;
+	using unit_allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<unit>;
+	using unit_traits = std::allocator_traits<unit_allocator_type>;
+	using self_allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<basic_zlib_allocator>;
+	using self_traits = std::allocator_traits<self_allocator_type>;
+	unit_allocator_type alloc_;
+	static_assert(sizeof(std::size_t) <= sizeof(unit), "Size does not fit in a unit");
+public:
+	explicit basic_zlib_allocator (const Allocator & a) : alloc_(a) {	}
+	virtual void * allocate (std::size_t size) override {
+		auto n = checked::add(size / sizeof(unit), std::size_t((size % sizeof(unit)) != 0), std::size_t(1));
+		if (!n) throw std::bad_alloc();
+		auto ptr = unit_traits::allocate(alloc_, *n);
+		*reinterpret_cast<std::size_t *>(ptr) = *n;
+		return ptr + 1;
+	}
+	virtual void deallocate (void * ptr) noexcept override {
+		if (!ptr) return;
+		auto u = static_cast<unit *>(ptr) - 1;
+		unit_traits::deallocate(alloc_, u, *reinterpret_cast<std::size_t *>(u));
+	}
+	virtual void destroy () noexcept override {
+		self_allocator_type a(alloc_);
+		self_traits::destroy(a, this);
+		self_traits::deallocate(a, this, 1);
+	}
+};
+
+class zlib_allocator_deleter {
+public:
+	void operator () (zlib_allocator * alloc) const noexcept {
+		alloc->destroy();
+	}
+};
+
+using zlib_allocator_ptr = std::unique_ptr<zlib_allocator, zlib_allocator_deleter>;
+
+template <typename Allocator>
+zlib_allocator_ptr make_zlib_allocator (const Allocator & a) {
+	using type = basic_zlib_allocator<Allocator>;
+	using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<type>;
+	using traits = std::allocator_traits<allocator_type>;
+	allocator_type alloc(a);
+	auto ptr = traits::allocate(alloc, 1);
+	try {
+		traits::construct(alloc, ptr, a);
+	} catch (...) {
+		traits::deallocate(alloc, ptr, 1);
+		throw;
+	}
+	return zlib_allocator_ptr(ptr);
+}
+
+class deflate_stream_deleter {
+public:
+	zlib_allocator * alloc;
+	void operator () (z_stream_s *) const noexcept;
+};
+
+class inflate_stream_deleter {
+public:
+	zlib_allocator * alloc;
+	void operator () (z_stream_s *) const noexcept;
+};
+
+}
+
+/**
+ *	Compresses complete buffers to the zlib format.
+ *
+ *	The underlying zlib stream is initialized once, when
+ *	the object is constructed, and is merely reset before
+ *	each buffer is compressed. This avoids reallocating
+ *	the compressor's internal state (several hundred
+ *	kilobytes at the default settings) for each packet.
+ *
+ *	Exceptions thrown on error are the same as those
+ *	thrown by `boost::iostreams::zlib_compressor`.
+ */
+class deflate_stream {
+private:
+	detail::zlib_allocator_ptr alloc_;
+	std::unique_ptr<z_stream_s, detail::deflate_stream_deleter> stream_;
+	int level_;
+	int strategy_;
+	bool params_pending_;
+	deflate_stream (detail::zlib_allocator_ptr alloc, const boost::iostreams::zlib_params & params);
+public:
+	deflate_stream (const deflate_stream &) = delete;
+	deflate_stream & operator = (const deflate_stream &) = delete;
+	/**
+	 *	Creates a deflate_stream.
+	 *
+	 *	\param [in] params
+	 *		The parameters to pass to zlib. Defaults to
+	 *		the default settings.
+	 */
+	explicit deflate_stream (const boost::iostreams::zlib_params & params = boost::iostreams::zlib_params{});
+	/**
+	 *	Creates a deflate_stream which allocates all
+	 *	memory, including zlib's internal state, through
+	 *	a certain allocator.
+	 *
+	 *	\tparam Allocator
+	 *		A type which models `Allocator`.
+	 *
+	 *	\param [in] a
+	 *		The allocator.
+	 *	\param [in] params
+	 *		The parameters to pass to zlib. Defaults to
+	 *		the default settings.
+	 */
+	template <typename Allocator>
+	deflate_stream (std::allocator_arg_t, const Allocator & a, const boost::iostreams::zlib_params & params = boost::iostreams::zlib_params{})
+		:	deflate_stream(detail::make_zlib_allocator(a), params)
+	{	}
+	/**
+	 *	Determines the maximum number of bytes which
+	 *	\ref deflate may produce for a certain number of
+	 *	input bytes.
+	 *
+	 *	Accounts for a level and strategy set by \ref params
+	 *	but not yet applied by \ref deflate.
+	 *
+	 *	\param [in] size
+	 *		The number of input bytes.
+	 *
+	 *	\return
+	 *		The number of bytes.
+	 */
+	std::size_t bound (std::size_t size) const noexcept;
+	/**
+	 *	Sets the compression level and strategy which
+	 *	shall be used by subsequent calls to \ref deflate.
+	 *
+	 *	The window size and memory level chosen when the
+	 *	object was constructed cannot be changed.
+	 *
+	 *	\param [in] level
+	 *		The compression level, see
+	 *		`boost::iostreams::zlib_params::level`.
+	 *	\param [in] strategy
+	 *		The compression strategy, see
+	 *		`boost::iostreams::zlib_params::strategy`.
+	 */
+	void params (int level, int strategy) noexcept;
+	/**
+	 *	Compresses a buffer in its entirety in a single
+	 *	call to zlib.
+	 *
+	 *	\param [in] src
+	 *		A pointer to the bytes to compress.
+	 *	\param [in] size
+	 *		The number of bytes to compress.
+	 *	\param [out] dst
+	 *		A pointer to the buffer into which the compressed
+	 *		representation shall be written.
+	 *	\param [in] dst_size
+	 *		The size of the buffer pointed to by \em dst.
+	 *		Must be at least `bound(size)`.
+	 *
+	 *	\return
+	 *		The number of bytes written to \em dst.
+	 */
+	std::size_t deflate (const void * src, std::size_t size, void * dst, std::size_t dst_size);
+};
+
+/**
+ *	Decompresses complete zlib streams.
+ *
+ *	Like \ref deflate_stream the underlying zlib stream
+ *	is initialized once and reset before each stream is
+ *	decompressed.
+ *
+ *	Malformed input causes the same exceptions as are
+ *	thrown by `boost::iostreams::zlib_decompressor`,
+ *	input which is well formed but whose length disagrees
+ *	with that expected is reported by way of a `std::error_code`.
+ */
+class inflate_stream {
+private:
+	detail::zlib_allocator_ptr alloc_;
+	std::unique_ptr<z_stream_s, detail::inflate_stream_deleter> stream_;
+	inflate_stream (detail::zlib_allocator_ptr alloc, const boost::iostreams::zlib_params & params);
+public:
+	inflate_stream (const inflate_stream &) = delete;
+	inflate_stream & operator = (const inflate_stream &) = delete;
+	/**
+	 *	Creates an inflate_stream.
+	 *
+	 *	\param [in] params
+	 *		The parameters to pass to zlib. Defaults to
+	 *		the default settings.
+	 */
+	explicit inflate_stream (const boost::iostreams::zlib_params & params = boost::iostreams::zlib_params{});
+	/**
+	 *	Creates an inflate_stream which allocates all
+	 *	memory, including zlib's internal state, through
+	 *	a certain allocator.
+	 *
+	 *	\tparam Allocator
+	 *		A type which models `Allocator`.
+	 *
+	 *	\param [in] a
+	 *		The allocator.
+	 *	\param [in] params
+	 *		The parameters to pass to zlib. Defaults to
+	 *		the default settings.
+	 */
+	template <typename Allocator>
+	inflate_stream (std::allocator_arg_t, const Allocator & a, const boost::iostreams::zlib_params & params = boost::iostreams::zlib_params{})
+		:	inflate_stream(detail::make_zlib_allocator(a), params)
+	{	}
+	/**
+	 *	Decompresses a complete zlib stream in a single
+	 *	call to zlib.
+	 *
+	 *	\param [in] src
+	 *		A pointer to the compressed stream.
+	 *	\param [in] size
+	 *		The number of bytes in the compressed stream.
+	 *	\param [out] dst
+	 *		A pointer to the buffer into which the decompressed
+	 *		bytes shall be written.
+	 *	\param [in] dst_size
+	 *		The size of the buffer pointed to by \em dst.
+	 *
+	 *	\return
+	 *		The number of bytes written to \em dst if the
+	 *		stream ended within \em size bytes and its
+	 *		decompressed representation fit within \em dst_size
+	 *		bytes. \ref error::end_of_file if \em size bytes
+	 *		did not contain the entire stream.
+	 *		\ref error::inconsistent_length if the stream
+	 *		did not consume all \em size bytes or would
+	 *		decompress to more than \em dst_size bytes.
+	 */
+	boost::expected<std::size_t, std::error_code> inflate (const void * src, std::size_t size, void * dst, std::size_t dst_size);
+	/**
+	 *	Decompresses as much of the start of a zlib stream
+	 *	as fits in a buffer.
+	 *
+	 *	Unlike \ref inflate neither the stream nor \em src
+	 *	need be complete, and decompression stops as soon as
+	 *	\em dst is full. This allows the first few bytes of
+	 *	a large stream to be examined without decompressing
+	 *	the remainder.
+	 *
+	 *	\param [in] src
+	 *		A pointer to some prefix of the compressed stream.
+	 *	\param [in] size
+	 *		The number of bytes pointed to by \em src.
+	 *	\param [out] dst
+	 *		A pointer to the buffer into which the decompressed
+	 *		bytes shall be written.
+	 *	\param [in] dst_size
+	 *		The size of the buffer pointed to by \em dst.
+	 *
+	 *	\return
+	 *		The number of bytes written to \em dst. This is
+	 *		less than \em dst_size only if \em src ends, or
+	 *		the stream ends, before \em dst_size bytes have
+	 *		been decompressed.
+	 */
+	std::size_t inflate_prefix (const void * src, std::size_t size, void * dst, std::size_t dst_size);
+};
+
+}
+}
@@ -0,0 +1,175 @@
+#include <mcpp/protocol/arena.hpp>
+#include <mcpp/test/allocator.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace protocol {
+namespace tests {
+namespace {
+
+SCENARIO("mcpp::protocol::monotonic_arena objects bump allocate memory which is reclaimed all at once", "[mcpp][protocol][arena]") {
+	GIVEN("A monotonic_arena") {
+		monotonic_arena arena(64);
+		CHECK(arena.capacity() == 0);
+		CHECK(!arena.active());
+		WHEN("Memory is allocated") {
+			auto a = arena.allocate(1, 1);
+			auto b = arena.allocate(8, 8);
+			THEN("It is obtained from a single block") {
+				CHECK(arena.capacity() == 64);
+				CHECK(arena.owns(a));
+				CHECK(arena.owns(b));
+				CHECK(b != a);
+				CHECK((reinterpret_cast<std::uintptr_t>(b) % 8) == 0);
+			}
+			AND_WHEN("More memory than a block holds is allocated") {
+				auto c = arena.allocate(100, 1);
+				THEN("A block large enough is obtained") {
+					CHECK(arena.capacity() == 164);
+					CHECK(arena.owns(c));
+				}
+				AND_WHEN("The arena is rewound and the same allocations are made") {
+					arena.rewind();
+					auto a2 = arena.allocate(1, 1);
+					auto b2 = arena.allocate(8, 8);
+					auto c2 = arena.allocate(100, 1);
+					THEN("The same memory is reused") {
+						CHECK(a2 == a);
+						CHECK(b2 == b);
+						CHECK(c2 == c);
+						CHECK(arena.capacity() == 164);
+					}
+				}
+			}
+		}
+		THEN("It does not own memory it did not allocate") {
+			int i;
+			CHECK(!arena.owns(&i));
+		}
+		WHEN("It is activated more than once") {
+			arena.activate();
+			arena.activate();
+			arena.deactivate();
+			THEN("It remains active until each activation is undone") {
+				CHECK(arena.active());
+				arena.deactivate();
+				CHECK(!arena.active());
+			}
+		}
+		WHEN("A monotonic_arena_scope is created") {
+			{
+				monotonic_arena_scope scope(&arena);
+				CHECK(arena.active());
+			}
+			THEN("The arena is active only for its lifetime") {
+				CHECK(!arena.active());
+			}
+		}
+	}
+}
+
+SCENARIO("mcpp::protocol::monotonic_arena objects obtain blocks through their Allocator", "[mcpp][protocol][arena]") {
+	GIVEN("A monotonic_arena which uses a stateful Allocator") {
+		test::allocator_state state;
+		WHEN("Memory is allocated and the arena is destroyed") {
+			std::size_t allocations;
+			std::size_t capacity;
+			{
+				monotonic_arena arena(64, test::allocator<char>(state));
+				allocations = state.allocations;
+				arena.allocate(1, 1);
+				arena.allocate(100, 1);
+				capacity = arena.capacity();
+			}
+			THEN("Each block is obtained from the Allocator") {
+				CHECK(state.allocations == (allocations + 2));
+				CHECK(state.allocated >= capacity);
+			}
+			THEN("All memory is returned to the Allocator") {
+				CHECK(state.deallocations == state.allocations);
+				CHECK(state.deallocated == state.allocated);
+			}
+		}
+	}
+}
+
+SCENARIO("mcpp::protocol::monotonic_arena objects may be claimed by one object at a time", "[mcpp][protocol][arena]") {
+	GIVEN("A monotonic_arena") {
+		monotonic_arena arena;
+		int a;
+		int b;
+		CHECK(arena.owner() == nullptr);
+		WHEN("It is claimed") {
+			arena.claim(&a);
+			arena.claim(&a);
+			THEN("The claimant is its owner") {
+				CHECK(arena.owner() == &a);
+			}
+			AND_WHEN("Another object attempts to release it") {
+				arena.release(&b);
+				THEN("Nothing happens") {
+					CHECK(arena.owner() == &a);
+				}
+			}
+			AND_WHEN("It is released") {
+				arena.release(&a);
+				THEN("Another object may claim it") {
+					CHECK(arena.owner() == nullptr);
+					arena.claim(&b);
+					CHECK(arena.owner() == &b);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("mcpp::protocol::arena_allocator objects allocate from their arena only while it is active", "[mcpp][protocol][arena]") {
+	GIVEN("An arena_allocator") {
+		test::allocator_state state;
+		monotonic_arena arena;
+		using allocator_type = arena_allocator<char, test::allocator<char>>;
+		allocator_type a(arena, test::allocator<char>(state));
+		using string_type = std::basic_string<char, std::char_traits<char>, allocator_type>;
+		WHEN("Memory is allocated and deallocated while the arena is active") {
+			{
+				monotonic_arena_scope scope(&arena);
+				string_type s(100, 'a', a);
+				CHECK(arena.owns(s.data()));
+			}
+			THEN("It belongs to the arena and the upstream allocator is not involved") {
+				CHECK(state.allocations == 0);
+				CHECK(state.deallocations == 0);
+				CHECK(arena.capacity() != 0);
+			}
+		}
+		WHEN("Memory is allocated and deallocated while the arena is not active") {
+			{
+				string_type s(100, 'a', a);
+				CHECK(!arena.owns(s.data()));
+			}
+			THEN("It is obtained from and returned to the upstream allocator") {
+				CHECK(state.allocations == 1);
+				CHECK(state.deallocations == 1);
+				CHECK(state.deallocated == state.allocated);
+				CHECK(arena.capacity() == 0);
+			}
+		}
+		THEN("Rebound copies compare equal") {
+			arena_allocator<int, test::allocator<int>> b(a);
+			CHECK(b == a);
+			CHECK(&b.arena() == &arena);
+			monotonic_arena other;
+			allocator_type c(other, test::allocator<char>(state));
+			CHECK(c != a);
+		}
+	}
+}
+
+}
+}
+}
+}
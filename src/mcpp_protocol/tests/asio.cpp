@@ -0,0 +1,334 @@
+#include <mcpp/protocol/asio.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/flat_buffer.hpp>
+#include <beast/test/string_iostream.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_service.hpp>
+#include <mcpp/buffer.hpp>
+#include <mcpp/optional.hpp>
+#include <mcpp/protocol/cfb8.hpp>
+#include <mcpp/protocol/direction.hpp>
+#include <mcpp/protocol/error.hpp>
+#include <mcpp/protocol/handshaking.hpp>
+#include <mcpp/protocol/packet_serializer_map.hpp>
+#include <mcpp/protocol/state.hpp>
+#include <mcpp/protocol/stream_serializer.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace protocol {
+namespace tests {
+namespace {
+
+using stream_serializer_type = stream_serializer<buffer, buffer>;
+
+auto make_map () {
+	return packet_serializer_map<
+		stream_serializer_type::inner_source_type,
+		stream_serializer_type::inner_sink_type
+	>();
+}
+
+handshaking::serverbound::handshake make_handshake (std::string address) {
+	handshaking::serverbound::handshake retr;
+	retr.protocol_version = 316;
+	retr.server_address = std::move(address);
+	retr.server_port = 25565;
+	retr.next_state = state::status;
+	return retr;
+}
+
+std::string serialize (stream_serializer_type & ser, const packet & p) {
+	std::string retr;
+	for (auto && b : ser.serialize(p)) retr.append(static_cast<const char *>(b.data()), b.size());
+	return retr;
+}
+
+const unsigned char key [] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+	0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+SCENARIO("Packets may be read from a model of AsyncReadStream", "[mcpp][protocol][asio]") {
+	GIVEN("A model of AsyncReadStream which yields several frames") {
+		boost::asio::io_service io_service;
+		stream_serializer_type out(make_map(), direction::serverbound);
+		auto a = make_handshake("a");
+		auto b = make_handshake(std::string(1000, 'b'));
+		auto c = make_handshake("c");
+		auto wire = serialize(out, a) + serialize(out, b) + serialize(out, c);
+		stream_serializer_type in(make_map(), direction::serverbound);
+		optional<beast::error_code> result;
+		auto handler = [&] (auto ec) {
+			result.emplace(ec);
+		};
+		auto check = [&] (beast::test::string_iostream & ios, auto & buffer) {
+			std::vector<std::string> addresses;
+			for (;;) {
+				result = nullopt;
+				io_service.reset();
+				async_read_packet(ios, buffer, in, handler);
+				//	Even if the packet is already buffered
+				//	the handler is not invoked immediately
+				CHECK_FALSE(result);
+				do io_service.run_one();
+				while (!result);
+				if (*result) break;
+				REQUIRE(in.has_packet());
+				addresses.push_back(dynamic_cast<const handshaking::serverbound::handshake &>(in.packet()).server_address);
+			}
+			THEN("Each packet is parsed in turn") {
+				REQUIRE(addresses.size() == 3);
+				CHECK(addresses[0] == a.server_address);
+				CHECK(addresses[1] == b.server_address);
+				CHECK(addresses[2] == c.server_address);
+			}
+			THEN("The end of the stream is reported") {
+				CHECK(*result == boost::asio::error::eof);
+			}
+		};
+		WHEN("The frames are read all at once") {
+			beast::test::string_iostream ios(io_service, wire);
+			beast::flat_buffer buffer;
+			check(ios, buffer);
+		}
+		WHEN("The frames are read a few bytes at a time") {
+			beast::test::string_iostream ios(io_service, wire, 7);
+			beast::flat_buffer buffer;
+			check(ios, buffer);
+		}
+		WHEN("The frames are read through a connection_state and parsed in place") {
+			in.parse_in_place(true);
+			connection_state<beast::flat_buffer> connection;
+			beast::test::string_iostream ios(io_service, wire, 7);
+			check(ios, connection);
+			THEN("Parsing in place remains enabled") {
+				CHECK(in.parse_in_place());
+			}
+		}
+	}
+	GIVEN("A connection_state and a model of AsyncReadStream which yields several frames at once") {
+		boost::asio::io_service io_service;
+		stream_serializer_type out(make_map(), direction::serverbound);
+		auto a = serialize(out, make_handshake("a"));
+		auto b = serialize(out, make_handshake("b"));
+		beast::test::string_iostream ios(io_service, a + b);
+		stream_serializer_type in(make_map(), direction::serverbound);
+		in.parse_in_place(true);
+		connection_state<beast::flat_buffer> connection;
+		optional<beast::error_code> result;
+		auto read = [&] () {
+			result = nullopt;
+			io_service.reset();
+			async_read_packet(ios, connection, in, [&] (auto ec) {	result.emplace(ec);	});
+			do io_service.run_one();
+			while (!result);
+			REQUIRE_FALSE(*result);
+		};
+		WHEN("A packet is read") {
+			read();
+			THEN("Its frame remains in the buffer") {
+				CHECK(connection.buffer().size() == (a.size() + b.size()));
+			}
+			AND_WHEN("Another packet is read") {
+				read();
+				THEN("Only the frame of the packet previously read is consumed") {
+					CHECK(connection.buffer().size() == b.size());
+				}
+			}
+		}
+	}
+	GIVEN("A model of AsyncReadStream which yields a malformed frame") {
+		boost::asio::io_service io_service;
+		//	A length prefix which overflows
+		beast::test::string_iostream ios(io_service, std::string("\xFF\xFF\xFF\xFF\xFF\x01", 6));
+		stream_serializer_type in(make_map(), direction::serverbound);
+		beast::flat_buffer buffer;
+		optional<beast::error_code> result;
+		WHEN("A packet is read") {
+			async_read_packet(ios, buffer, in, [&] (auto ec) {	result.emplace(ec);	});
+			do io_service.run_one();
+			while (!result);
+			THEN("The error encountered while parsing is reported") {
+				REQUIRE(*result);
+				CHECK(result->category() == detail::boost_error_category());
+			}
+		}
+	}
+	GIVEN("A model of AsyncReadStream which yields a compressed frame whose body is not a zlib stream") {
+		boost::asio::io_service io_service;
+		//	A data length of 16 followed by bytes which
+		//	zlib rejects
+		beast::test::string_iostream ios(io_service, std::string("\x05\x10\xFF\xFF\xFF\xFF", 6));
+		stream_serializer_type in(make_map(), direction::serverbound);
+		in.enable_compression(0);
+		beast::flat_buffer buffer;
+		optional<beast::error_code> result;
+		WHEN("A packet is read") {
+			async_read_packet(ios, buffer, in, [&] (auto ec) {	result.emplace(ec);	});
+			do io_service.run_one();
+			while (!result);
+			THEN("The exception thrown while parsing is reported as malformed data") {
+				CHECK(*result == beast::error_code(int(error::malformed), detail::boost_error_category()));
+			}
+		}
+	}
+}
+
+SCENARIO("Packets may be written to a model of AsyncWriteStream", "[mcpp][protocol][asio]") {
+	GIVEN("A model of AsyncWriteStream and a stream_serializer") {
+		boost::asio::io_service io_service;
+		beast::test::string_iostream ios(io_service, std::string());
+		stream_serializer_type out(make_map(), direction::serverbound);
+		stream_serializer_type expected(make_map(), direction::serverbound);
+		auto a = make_handshake("a");
+		auto b = make_handshake(std::string(1000, 'b'));
+		optional<beast::error_code> result;
+		std::size_t written(0);
+		auto handler = [&] (auto ec, auto n) {
+			result.emplace(ec);
+			written = n;
+		};
+		auto run = [&] () {
+			do io_service.run_one();
+			while (!result);
+			REQUIRE_FALSE(*result);
+		};
+		WHEN("A packet is written") {
+			async_write_packet(ios, out, b, handler);
+			run();
+			THEN("Its representation is written") {
+				auto str = serialize(expected, b);
+				CHECK(ios.str == str);
+				CHECK(written == str.size());
+			}
+		}
+		WHEN("Many packets are written") {
+			std::vector<handshaking::serverbound::handshake> ps{a, b, a};
+			async_write_packets(ios, out, ps.begin(), ps.end(), handler);
+			run();
+			THEN("Their representations are written in order") {
+				auto str = serialize(expected, a) + serialize(expected, b) + serialize(expected, a);
+				CHECK(ios.str == str);
+				CHECK(written == str.size());
+			}
+		}
+	}
+}
+
+SCENARIO("Packets may be read from and written to an encrypted connection", "[mcpp][protocol][asio]") {
+	GIVEN("A connection_state on which encryption has been enabled") {
+		boost::asio::io_service io_service;
+		stream_serializer_type out(make_map(), direction::serverbound);
+		auto a = make_handshake("a");
+		auto b = make_handshake(std::string(1000, 'b'));
+		auto plaintext = serialize(out, a) + serialize(out, b) + serialize(out, a);
+		connection_state<beast::flat_buffer> connection;
+		connection.enable_encryption(key);
+		CHECK(connection.encrypted());
+		WHEN("Packets are read from a stream encrypted with CFB8") {
+			auto wire = plaintext;
+			cfb8_encryptor encryptor(key);
+			encryptor.encrypt(&wire[0], wire.size());
+			beast::test::string_iostream ios(io_service, wire, 7);
+			stream_serializer_type in(make_map(), direction::serverbound);
+			in.parse_in_place(true);
+			std::vector<std::string> addresses;
+			optional<beast::error_code> result;
+			for (;;) {
+				result = nullopt;
+				io_service.reset();
+				async_read_packet(ios, connection, in, [&] (auto ec) {	result.emplace(ec);	});
+				do io_service.run_one();
+				while (!result);
+				if (*result) break;
+				addresses.push_back(dynamic_cast<const handshaking::serverbound::handshake &>(in.packet()).server_address);
+			}
+			THEN("Each byte is decrypted once and each packet is parsed in turn") {
+				REQUIRE(addresses.size() == 3);
+				CHECK(addresses[0] == a.server_address);
+				CHECK(addresses[1] == b.server_address);
+				CHECK(addresses[2] == a.server_address);
+				CHECK(*result == boost::asio::error::eof);
+			}
+		}
+		WHEN("Packets are written") {
+			beast::test::string_iostream ios(io_service, std::string());
+			optional<beast::error_code> result;
+			std::size_t written(0);
+			auto write = [&] (auto && f) {
+				result = nullopt;
+				io_service.reset();
+				f([&] (auto ec, auto n) {
+					result.emplace(ec);
+					written += n;
+				});
+				do io_service.run_one();
+				while (!result);
+				REQUIRE_FALSE(*result);
+			};
+			write([&] (auto handler) {	async_write_packet(ios, connection, out, a, handler);	});
+			std::vector<handshaking::serverbound::handshake> ps{b, a};
+			write([&] (auto handler) {	async_write_packets(ios, connection, out, ps.begin(), ps.end(), handler);	});
+			THEN("Their representations are encrypted with CFB8 as one stream") {
+				REQUIRE(ios.str.size() == plaintext.size());
+				CHECK(written == plaintext.size());
+				CHECK(ios.str != plaintext);
+				auto decrypted = ios.str;
+				cfb8_decryptor decryptor(key);
+				decryptor.decrypt(&decrypted[0], decrypted.size());
+				CHECK(decrypted == plaintext);
+			}
+		}
+	}
+	GIVEN("A model of AsyncReadStream which yields a plaintext frame followed by encrypted frames in the same read") {
+		boost::asio::io_service io_service;
+		stream_serializer_type out(make_map(), direction::serverbound);
+		auto a = make_handshake("a");
+		auto b = make_handshake(std::string(1000, 'b'));
+		auto ciphertext = serialize(out, b) + serialize(out, a);
+		cfb8_encryptor encryptor(key);
+		encryptor.encrypt(&ciphertext[0], ciphertext.size());
+		beast::test::string_iostream ios(io_service, serialize(out, a) + ciphertext);
+		stream_serializer_type in(make_map(), direction::serverbound);
+		in.parse_in_place(true);
+		connection_state<beast::flat_buffer> connection;
+		optional<beast::error_code> result;
+		auto read = [&] () {
+			result = nullopt;
+			io_service.reset();
+			async_read_packet(ios, connection, in, [&] (auto ec) {	result.emplace(ec);	});
+			do io_service.run_one();
+			while (!result);
+		};
+		WHEN("Encryption is enabled after the plaintext packet is read") {
+			read();
+			REQUIRE_FALSE(*result);
+			auto first = dynamic_cast<const handshaking::serverbound::handshake &>(in.packet()).server_address;
+			connection.enable_encryption(key);
+			std::vector<std::string> addresses;
+			for (;;) {
+				read();
+				if (*result) break;
+				addresses.push_back(dynamic_cast<const handshaking::serverbound::handshake &>(in.packet()).server_address);
+			}
+			THEN("The plaintext packet is parsed") {
+				CHECK(first == a.server_address);
+			}
+			THEN("The bytes already buffered are decrypted and each encrypted packet is parsed in turn") {
+				REQUIRE(addresses.size() == 2);
+				CHECK(addresses[0] == b.server_address);
+				CHECK(addresses[1] == a.server_address);
+				CHECK(*result == boost::asio::error::eof);
+			}
+		}
+	}
+}
+
+}
+}
+}
+}
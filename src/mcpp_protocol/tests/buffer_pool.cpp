@@ -0,0 +1,99 @@
+#include <mcpp/protocol/buffer_pool.hpp>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace protocol {
+namespace tests {
+namespace {
+
+using buffer_pool_type = buffer_pool<std::vector<char>>;
+
+SCENARIO("mcpp::protocol::buffer_pool objects lend buffers by size class", "[mcpp][protocol][buffer_pool]") {
+	GIVEN("A buffer_pool") {
+		buffer_pool_type pool(1 << 16, 256, 4096);
+		CHECK(pool.high_water() == (1 << 16));
+		CHECK(pool.private_limit() == 256);
+		CHECK(pool.max_size() == 4096);
+		WHEN("A buffer is acquired") {
+			auto v = pool.acquire(1000);
+			THEN("Its capacity is the next power of two and its size that requested") {
+				CHECK(v.capacity() == 1024);
+				CHECK(v.size() == 1000);
+				CHECK(pool.retained() == 0);
+			}
+			AND_WHEN("It is released") {
+				auto ptr = v.data();
+				pool.release(std::move(v));
+				THEN("The pool holds it") {
+					CHECK(v.empty());
+					CHECK(pool.retained() == 1024);
+					AND_WHEN("A buffer of the same size class is acquired") {
+						auto again = pool.acquire(600);
+						THEN("The same buffer is lent without being resized") {
+							CHECK(again.data() == ptr);
+							CHECK(again.capacity() == 1024);
+							CHECK(again.size() == 1000);
+							CHECK(pool.retained() == 0);
+						}
+					}
+					AND_WHEN("A much smaller buffer is acquired") {
+						auto small = pool.acquire(100);
+						THEN("A new buffer is allocated") {
+							CHECK(small.data() != ptr);
+							CHECK(small.capacity() == 128);
+							CHECK(small.size() == 100);
+							CHECK(pool.retained() == 1024);
+						}
+					}
+				}
+			}
+		}
+		WHEN("A buffer which was not acquired from the pool is released") {
+			std::vector<char> v;
+			v.reserve(3000);
+			v.resize(10);
+			pool.release(std::move(v));
+			THEN("It is lent for requests it satisfies and only resized as requested") {
+				auto again = pool.acquire(2048);
+				CHECK(again.capacity() >= 3000);
+				CHECK(again.size() == 2048);
+			}
+		}
+		WHEN("A buffer larger than the maximum size is acquired") {
+			auto v = pool.acquire(5000);
+			THEN("It is not rounded up to a size class") {
+				CHECK(v.size() == 5000);
+				CHECK(v.capacity() < 8192);
+			}
+			AND_WHEN("It is released") {
+				pool.release(std::move(v));
+				THEN("The pool does not hold it") {
+					CHECK(pool.retained() == 0);
+				}
+			}
+		}
+		WHEN("More than the high water mark is released") {
+			for (std::size_t i = 0; i < 80; ++i) pool.release(pool.acquire(1024));
+			std::vector<std::vector<char>> held;
+			for (std::size_t i = 0; i < 80; ++i) held.push_back(pool.acquire(1024));
+			for (auto && v : held) pool.release(std::move(v));
+			THEN("The excess is freed") {
+				CHECK(pool.retained() == (1 << 16));
+			}
+			AND_WHEN("The pool is trimmed") {
+				pool.trim(1000);
+				THEN("It retains no more than requested") {
+					CHECK(pool.retained() <= 1000);
+				}
+			}
+		}
+	}
+}
+
+}
+}
+}
+}
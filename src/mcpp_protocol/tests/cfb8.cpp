@@ -0,0 +1,101 @@
+#include <mcpp/protocol/cfb8.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace protocol {
+namespace tests {
+namespace {
+
+//	From NIST SP 800-38A, F.3.7
+const unsigned char key [] = {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C};
+const unsigned char iv [] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+const unsigned char plaintext [] = {
+	0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9,
+	0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A, 0xAE, 0x2D
+};
+const unsigned char ciphertext [] = {
+	0x3B, 0x79, 0x42, 0x4C, 0x9C, 0x0D, 0xD4, 0x36, 0xBA,
+	0xCE, 0x9E, 0x0E, 0xD4, 0x58, 0x6A, 0x4F, 0x32, 0xB9
+};
+
+std::vector<unsigned char> make_input () {
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<unsigned> dist(0, 255);
+	std::vector<unsigned char> retr(1000);
+	for (auto && c : retr) c = static_cast<unsigned char>(dist(gen));
+	return retr;
+}
+
+SCENARIO("Byte streams may be encrypted and decrypted with AES-128 in CFB8 mode", "[mcpp][protocol][cfb8]") {
+	GIVEN("A cfb8_encryptor and a cfb8_decryptor") {
+		cfb8_encryptor e(key, iv);
+		cfb8_decryptor d(key, iv);
+		WHEN("The plaintext of a known answer test is encrypted") {
+			std::vector<unsigned char> buf(std::begin(plaintext), std::end(plaintext));
+			e.encrypt(buf.data(), buf.size());
+			THEN("The expected ciphertext is produced") {
+				CHECK(std::equal(buf.begin(), buf.end(), std::begin(ciphertext), std::end(ciphertext)));
+			}
+		}
+		WHEN("The ciphertext of a known answer test is decrypted") {
+			std::vector<unsigned char> buf(std::begin(ciphertext), std::end(ciphertext));
+			d.decrypt(buf.data(), buf.size());
+			THEN("The expected plaintext is produced") {
+				CHECK(std::equal(buf.begin(), buf.end(), std::begin(plaintext), std::end(plaintext)));
+			}
+		}
+		WHEN("A stream is encrypted and decrypted in pieces of differing sizes") {
+			auto in = make_input();
+			auto buf = in;
+			std::size_t pieces [] = {1, 15, 16, 17, 127, 128, 129, 300};
+			std::size_t offset(0);
+			for (auto n : pieces) {
+				e.encrypt(buf.data() + offset, n);
+				offset += n;
+			}
+			e.encrypt(buf.data() + offset, buf.size() - offset);
+			REQUIRE(buf != in);
+			//	Decrypted in pieces which straddle those in
+			//	which the stream was encrypted
+			offset = 0;
+			std::reverse(std::begin(pieces), std::end(pieces));
+			for (auto n : pieces) {
+				d.decrypt(buf.data() + offset, n);
+				offset += n;
+			}
+			d.decrypt(buf.data() + offset, buf.size() - offset);
+			THEN("The original stream is recovered") {
+				CHECK(buf == in);
+			}
+		}
+	}
+	GIVEN("A cfb8_encryptor and a cfb8_decryptor whose initialization vector is their key") {
+		cfb8_encryptor e(key);
+		cfb8_decryptor d(key);
+		WHEN("A stream is encrypted") {
+			auto in = make_input();
+			auto buf = in;
+			e.encrypt(buf.data(), buf.size());
+			THEN("It differs from the stream encrypted with another initialization vector") {
+				cfb8_encryptor other(key, iv);
+				auto o = in;
+				other.encrypt(o.data(), o.size());
+				CHECK(o != buf);
+			}
+			THEN("It may be decrypted") {
+				d.decrypt(buf.data(), buf.size());
+				CHECK(buf == in);
+			}
+		}
+	}
+}
+
+}
+}
+}
+}
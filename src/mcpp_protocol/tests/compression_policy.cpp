@@ -0,0 +1,100 @@
+#include <mcpp/protocol/compression_policy.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <mcpp/protocol/direction.hpp>
+#include <mcpp/protocol/packet_id.hpp>
+#include <mcpp/protocol/state.hpp>
+#include <cstddef>
+#include <limits>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace protocol {
+namespace tests {
+namespace {
+
+SCENARIO("mcpp::protocol::compression_policy objects choose settings per packet ID", "[mcpp][protocol][compression_policy]") {
+	GIVEN("A compression_policy with settings for one packet ID") {
+		compression_params fast{boost::iostreams::zlib::best_speed, boost::iostreams::zlib::default_strategy};
+		compression_params stored{boost::iostreams::zlib::no_compression, boost::iostreams::zlib::default_strategy};
+		compression_policy policy(fast);
+		packet_id a(0x20, direction::clientbound, state::play);
+		packet_id b(0x21, direction::clientbound, state::play);
+		policy.set(a, stored);
+		WHEN("Settings are selected for that packet ID") {
+			auto params = policy.select(a, 1000);
+			THEN("They are the settings for that packet ID") {
+				CHECK(params == stored);
+			}
+		}
+		WHEN("Settings are selected for another packet ID") {
+			auto params = policy.select(b, 1000);
+			THEN("They are the default settings") {
+				CHECK(params == fast);
+			}
+		}
+		WHEN("The settings for that packet ID are unset") {
+			policy.unset(a);
+			THEN("It uses the default settings") {
+				CHECK(policy.get(a) == fast);
+			}
+		}
+		THEN("Adaptive mode is not enabled") {
+			CHECK_FALSE(policy.adaptive());
+			CHECK(policy.effective_threshold() == 0);
+		}
+	}
+}
+
+SCENARIO("mcpp::protocol::compression_policy objects adapt the effective threshold", "[mcpp][protocol][compression_policy]") {
+	GIVEN("A compression_policy in adaptive mode which requires 10 bytes be saved per microsecond") {
+		compression_policy policy;
+		policy.enable_adaptive(10);
+		REQUIRE(policy.adaptive());
+		packet_id id(0x20, direction::clientbound, state::play);
+		auto stored = [&] (std::size_t size) {
+			return policy.select(id, size).level == boost::iostreams::zlib::no_compression;
+		};
+		WHEN("Compression halves packets at a cost of 1000ns plus 1ns per byte") {
+			for (std::size_t i = 0; i < 100; ++i) {
+				std::size_t size(100 + ((i % 10) * 100));
+				policy.record(size, size / 2, 1000.0 + double(size));
+			}
+			//	0.5n >= 0.01(1000 + n) => n >= 20.4
+			THEN("The effective threshold reflects the break even point") {
+				CHECK(policy.effective_threshold() == 21);
+				AND_THEN("Larger packets are deflated") {
+					CHECK_FALSE(stored(21));
+				}
+				AND_THEN("Most smaller packets are stored") {
+					std::size_t deflated(0);
+					for (std::size_t i = 0; i < 64; ++i) if (!stored(20)) ++deflated;
+					CHECK(deflated == 2);
+				}
+			}
+		}
+		WHEN("Compression does not make packets smaller") {
+			for (std::size_t i = 0; i < 100; ++i) policy.record(100 + i, 110 + i, 1000);
+			THEN("No packet is expected to be worth deflating") {
+				CHECK(policy.effective_threshold() == std::numeric_limits<std::size_t>::max());
+			}
+			AND_WHEN("Adaptive mode is disabled") {
+				policy.disable_adaptive();
+				THEN("All packets are deflated") {
+					CHECK(policy.effective_threshold() == 0);
+					CHECK_FALSE(stored(1000));
+				}
+			}
+		}
+		WHEN("Only a few packets have been observed") {
+			for (std::size_t i = 0; i < 4; ++i) policy.record(100, 110, 1000);
+			THEN("All packets are deflated") {
+				CHECK(policy.effective_threshold() == 0);
+			}
+		}
+	}
+}
+
+}
+}
+}
+}
@@ -1,7 +1,13 @@
 #include <mcpp/protocol/incremental_varint_parser.hpp>
+#include <boost/core/ref.hpp>
 #include <mcpp/buffer.hpp>
+#include <mcpp/iostreams/limiting_source.hpp>
+#include <mcpp/protocol/error.hpp>
+#include <mcpp/protocol/span.hpp>
+#include <mcpp/protocol/varint.hpp>
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 #include <catch.hpp>
 
 namespace mcpp {
@@ -9,6 +15,96 @@ namespace protocol {
 namespace tests {
 namespace {
 
+enum class feed_kind {
+	streambuf,
+	source,
+	span
+};
+
+//	Feeds bytes to an incremental_varint_parser one
+//	call at a time and checks the outcome matches
+//	parsing all of them at once with parse_varint
+template <typename T>
+void check_incremental (const std::vector<unsigned char> & bytes, feed_kind kind) {
+	INFO("Type is " << sizeof(T) * 8 << " bits, first byte is " << unsigned(bytes.front()) << ", length is " << bytes.size());
+	auto v = bytes;
+	buffer whole(v.data(), v.size());
+	auto expected = parse_varint<T>(whole);
+	incremental_varint_parser<T> parser;
+	typename incremental_varint_parser<T>::parse_result_type result = optional<T>{};
+	std::size_t consumed = 0;
+	for (; consumed < v.size(); ++consumed) {
+		auto ptr = v.data() + consumed;
+		switch (kind) {
+		case feed_kind::streambuf:{
+			buffer b(ptr, 1);
+			result = parser.parse(b);
+			REQUIRE(b.read() == 1);
+		}break;
+		case feed_kind::source:{
+			buffer b(ptr, 1);
+			auto limiting = iostreams::make_limiting_source(boost::ref(b), 1);
+			result = parser.parse(limiting);
+			REQUIRE(b.read() == 1);
+		}break;
+		default:{
+			span_reader r(ptr, 1);
+			result = parser.parse(r);
+			REQUIRE(r.empty());
+		}break;
+		}
+		if (!result || *result) {
+			++consumed;
+			break;
+		}
+		CHECK(parser.cached() == (consumed + 1));
+	}
+	if (expected) {
+		REQUIRE(result);
+		REQUIRE(*result);
+		CHECK(**result == *expected);
+		CHECK(parser.get() == *expected);
+		CHECK(parser.cached() == whole.read());
+	} else if (expected.error() == make_error_code(error::end_of_file)) {
+		REQUIRE(result);
+		CHECK_FALSE(*result);
+	} else {
+		REQUIRE_FALSE(result);
+		CHECK(result.error() == expected.error());
+		//	The error persists until the parser is reset
+		unsigned char next [] = {1};
+		buffer b(next);
+		auto again = parser.parse(b);
+		REQUIRE_FALSE(again);
+		CHECK(again.error() == expected.error());
+		CHECK(b.read() == 0);
+	}
+	CHECK(consumed == parser.cached());
+}
+
+template <typename T>
+void check_incremental (feed_kind kind) {
+	const std::vector<std::vector<unsigned char>> cases = {
+		{0},
+		{1},
+		{127},
+		{128, 1},
+		{172, 2},
+		{255, 255, 3},
+		{255, 255, 255, 255, 7},
+		{255, 255, 255, 255, 15},
+		{255, 255, 255, 255, 16},
+		{128, 0},
+		{128, 128, 0},
+		{255, 255, 255, 255, 255, 255, 255, 255, 255, 1},
+		{255, 255, 255, 255, 255, 255, 255, 255, 255, 2},
+		{255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 1},
+		{128},
+		{128, 128, 128}
+	};
+	for (auto && c : cases) check_incremental<T>(c, kind);
+}
+
 SCENARIO("mcpp::protocol::incremental_varint_parser may be used to parse a Varint in multiple passes", "[mcpp][protocol][incremental_varint_parser]") {
 	GIVEN("An mcpp::protocol::incremental_varint_parser") {
 		incremental_varint_parser<std::uint16_t> parser;
@@ -81,6 +177,56 @@ SCENARIO("mcpp::protocol::incremental_varint_parser may be used to parse a Varin
 	}
 }
 
+SCENARIO("mcpp::protocol::incremental_varint_parser reports the same results and errors as mcpp::protocol::parse_varint", "[mcpp][protocol][incremental_varint_parser]") {
+	GIVEN("Representations of valid, overlong, unrepresentable, and incomplete varints") {
+		WHEN("They are fed one byte at a time from a std::basic_streambuf") {
+			THEN("The results match") {
+				check_incremental<std::uint8_t>(feed_kind::streambuf);
+				check_incremental<std::uint16_t>(feed_kind::streambuf);
+				check_incremental<std::uint32_t>(feed_kind::streambuf);
+				check_incremental<std::int32_t>(feed_kind::streambuf);
+				check_incremental<std::uint64_t>(feed_kind::streambuf);
+				check_incremental<std::int64_t>(feed_kind::streambuf);
+			}
+		}
+		WHEN("They are fed one byte at a time from some other Source") {
+			THEN("The results match") {
+				check_incremental<std::uint8_t>(feed_kind::source);
+				check_incremental<std::uint16_t>(feed_kind::source);
+				check_incremental<std::uint32_t>(feed_kind::source);
+				check_incremental<std::int32_t>(feed_kind::source);
+				check_incremental<std::uint64_t>(feed_kind::source);
+				check_incremental<std::int64_t>(feed_kind::source);
+			}
+		}
+		WHEN("They are fed one byte at a time from a span_reader") {
+			THEN("The results match") {
+				check_incremental<std::uint8_t>(feed_kind::span);
+				check_incremental<std::uint16_t>(feed_kind::span);
+				check_incremental<std::uint32_t>(feed_kind::span);
+				check_incremental<std::int32_t>(feed_kind::span);
+				check_incremental<std::uint64_t>(feed_kind::span);
+				check_incremental<std::int64_t>(feed_kind::span);
+			}
+		}
+	}
+	GIVEN("A buffer containing a varint followed by other bytes") {
+		unsigned char buf [] = {172, 2, 5};
+		buffer b(buf);
+		incremental_varint_parser<std::uint32_t> parser;
+		WHEN("It is parsed") {
+			auto result = parser.parse(b);
+			THEN("Only the representation of the varint is consumed") {
+				REQUIRE(result);
+				REQUIRE(*result);
+				CHECK(**result == 300);
+				CHECK(b.read() == 2);
+				CHECK(parser.cached() == 2);
+			}
+		}
+	}
+}
+
 }
 }
 }
@@ -1,8 +1,16 @@
 #include <mcpp/protocol/int.hpp>
+#include <boost/core/ref.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
 #include <mcpp/buffer.hpp>
+#include <mcpp/iostreams/limiting_source.hpp>
 #include <mcpp/protocol/error.hpp>
 #include <mcpp/protocol/exception.hpp>
+#include <mcpp/protocol/span.hpp>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
 #include <catch.hpp>
 
 namespace mcpp {
@@ -10,6 +18,78 @@ namespace protocol {
 namespace tests {
 namespace {
 
+using vectorbuf = boost::interprocess::basic_vectorbuf<std::vector<char>>;
+
+//	Counts chosen to leave every possible remainder
+//	after whole SIMD blocks
+const std::size_t array_counts [] = {0, 1, 3, 7, 8, 15, 16, 17, 31, 33, 63, 65, 100};
+
+template <typename T>
+std::vector<T> make_int_array (std::size_t n) {
+	std::vector<T> retr;
+	std::uint64_t x = 0x0123456789ABCDEFULL;
+	for (std::size_t i = 0; i < n; ++i) {
+		x = (x * 6364136223846793005ULL) + 1442695040888963407ULL;
+		retr.push_back(T(x >> 7));
+	}
+	return retr;
+}
+
+template <typename T>
+std::vector<char> serialize_each (const std::vector<T> & values) {
+	vectorbuf out;
+	for (auto i : values) serialize_int(i, out);
+	return out.vector();
+}
+
+template <typename T>
+void check_parse_int_array () {
+	INFO("Type is " << sizeof(T) * 8 << " bits");
+	for (auto n : array_counts) {
+		INFO("Count is " << n);
+		auto values = make_int_array<T>(n);
+		auto v = serialize_each(values);
+		std::vector<T> result(n);
+		buffer b(v.data(), v.size());
+		REQUIRE(parse_int_array(b, result.data(), n));
+		CHECK(result == values);
+		CHECK(b.read() == v.size());
+		std::vector<T> bytewise(n);
+		buffer inner(v.data(), v.size());
+		auto limiting = iostreams::make_limiting_source(boost::ref(inner), v.size());
+		REQUIRE(parse_int_array(limiting, bytewise.data(), n));
+		CHECK(bytewise == values);
+		std::vector<T> spanned(n);
+		span_reader r(v.data(), v.size());
+		REQUIRE(parse_int_array(r, spanned.data(), n));
+		CHECK(spanned == values);
+		CHECK(r.empty());
+	}
+}
+
+template <typename T>
+void check_serialize_int_array () {
+	INFO("Type is " << sizeof(T) * 8 << " bits");
+	for (auto n : array_counts) {
+		INFO("Count is " << n);
+		auto values = make_int_array<T>(n);
+		auto expected = serialize_each(values);
+		vectorbuf out;
+		serialize_int_array(values.data(), n, out);
+		CHECK(out.vector() == expected);
+		std::vector<char> v(expected.size());
+		buffer b(v.data(), v.size());
+		serialize_int_array(values.data(), n, b);
+		CHECK(b.written() == v.size());
+		CHECK(v == expected);
+		std::vector<char> spanned(expected.size());
+		span_writer w(spanned.data(), spanned.size());
+		serialize_int_array(values.data(), n, w);
+		CHECK(w.written() == spanned.size());
+		CHECK(spanned == expected);
+	}
+}
+
 SCENARIO("Integers may be parsed", "[mcpp][protocol][int]") {
 	GIVEN("A buffer containing a representation of an unsigned integer") {
 		unsigned char buf [] = {0, 16};
@@ -137,6 +217,158 @@ SCENARIO("Integers may be serialized", "[mcpp][protocol][int]") {
 	}
 }
 
+SCENARIO("Arrays of integers may be parsed", "[mcpp][protocol][int]") {
+	GIVEN("Buffers containing the representations of many integers") {
+		THEN("Parsing them as an array gives the same result as parsing them one at a time") {
+			check_parse_int_array<std::uint8_t>();
+			check_parse_int_array<std::int16_t>();
+			check_parse_int_array<std::uint16_t>();
+			check_parse_int_array<std::int32_t>();
+			check_parse_int_array<std::uint32_t>();
+			check_parse_int_array<std::int64_t>();
+			check_parse_int_array<std::uint64_t>();
+		}
+	}
+	GIVEN("A buffer which is too short to contain the requested number of integers") {
+		unsigned char buf [] = {0, 1, 0, 2, 0};
+		buffer b(buf);
+		WHEN("An attempt is made to parse an array") {
+			std::uint16_t arr [3];
+			auto result = parse_int_array(b, arr, 3);
+			THEN("The parse fails") {
+				REQUIRE_FALSE(result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+			}
+		}
+		WHEN("An attempt is made to parse an array from a span_reader") {
+			span_reader r(buf, sizeof(buf));
+			std::uint16_t arr [3];
+			auto result = parse_int_array(r, arr, 3);
+			THEN("The parse fails") {
+				REQUIRE_FALSE(result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+				AND_THEN("Nothing is consumed") {
+					CHECK(r.consumed() == 0);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Arrays of integers may be serialized", "[mcpp][protocol][int]") {
+	GIVEN("Many integers") {
+		THEN("Serializing them as an array gives the same result as serializing them one at a time") {
+			check_serialize_int_array<std::uint8_t>();
+			check_serialize_int_array<std::int16_t>();
+			check_serialize_int_array<std::uint16_t>();
+			check_serialize_int_array<std::int32_t>();
+			check_serialize_int_array<std::uint32_t>();
+			check_serialize_int_array<std::int64_t>();
+			check_serialize_int_array<std::uint64_t>();
+		}
+	}
+	GIVEN("A buffer which is too small") {
+		unsigned char buf [5];
+		std::uint32_t arr [] = {1, 2};
+		WHEN("An array is serialized") {
+			buffer b(buf);
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(serialize_int_array(arr, 2, b), write_overflow_error);
+			}
+		}
+		WHEN("An array is serialized to a span_writer") {
+			span_writer w(buf, sizeof(buf));
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(serialize_int_array(arr, 2, w), write_overflow_error);
+				AND_THEN("Nothing is written") {
+					CHECK(w.written() == 0);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Floating point numbers may be parsed and serialized", "[mcpp][protocol][int]") {
+	GIVEN("A buffer containing the representation of a float") {
+		unsigned char buf [] = {0x3F, 0xC0, 0, 0};
+		buffer b(buf);
+		WHEN("It is parsed") {
+			auto result = parse_float<float>(b);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The correct number is parsed") {
+					CHECK(*result == 1.5f);
+				}
+			}
+		}
+	}
+	GIVEN("A buffer containing the representation of a double") {
+		unsigned char buf [] = {0xC0, 0, 0, 0, 0, 0, 0, 0};
+		buffer b(buf);
+		WHEN("It is parsed") {
+			double d;
+			auto result = parse_float(b, d);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The correct number is parsed") {
+					CHECK(d == -2.0);
+				}
+			}
+		}
+	}
+	GIVEN("A sufficiently sized buffer") {
+		unsigned char buf [8];
+		buffer b(buf);
+		WHEN("A double is serialized") {
+			serialize_float(1.0, b);
+			THEN("The correct bytes are written") {
+				REQUIRE(b.written() == 8);
+				CHECK(buf[0] == 0x3F);
+				CHECK(buf[1] == 0xF0);
+				for (std::size_t i = 2; i < 8; ++i) CHECK(buf[i] == 0);
+			}
+		}
+	}
+	GIVEN("Arrays of floats and doubles including special values") {
+		std::vector<float> fs = {0.0f, -0.0f, 1.5f, -3.25f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::max()};
+		std::vector<double> ds = {0.0, -0.0, 1.5, -3.25, std::numeric_limits<double>::infinity(), std::numeric_limits<double>::denorm_min(), std::numeric_limits<double>::lowest()};
+		for (std::size_t i = 0; i < 50; ++i) {
+			fs.push_back(float(i) / 7.0f);
+			ds.push_back(double(i) / 7.0);
+		}
+		WHEN("They are serialized as arrays and parsed one at a time") {
+			vectorbuf out;
+			serialize_float_array(fs.data(), fs.size(), out);
+			serialize_float_array(ds.data(), ds.size(), out);
+			auto && v = out.vector();
+			buffer b(v.data(), v.size());
+			THEN("The same numbers are parsed") {
+				for (auto f : fs) {
+					auto result = parse_float<float>(b);
+					REQUIRE(result);
+					CHECK(std::memcmp(&*result, &f, sizeof(f)) == 0);
+				}
+				for (auto d : ds) {
+					auto result = parse_float<double>(b);
+					REQUIRE(result);
+					CHECK(std::memcmp(&*result, &d, sizeof(d)) == 0);
+				}
+				CHECK(b.read() == v.size());
+			}
+			AND_WHEN("They are parsed as arrays") {
+				std::vector<float> pfs(fs.size());
+				std::vector<double> pds(ds.size());
+				REQUIRE(parse_float_array(b, pfs.data(), pfs.size()));
+				REQUIRE(parse_float_array(b, pds.data(), pds.size()));
+				THEN("The same numbers are parsed") {
+					CHECK(std::memcmp(pfs.data(), fs.data(), fs.size() * sizeof(float)) == 0);
+					CHECK(std::memcmp(pds.data(), ds.data(), ds.size() * sizeof(double)) == 0);
+				}
+			}
+		}
+	}
+}
+
 }
 }
 }
@@ -0,0 +1,187 @@
+#include <mcpp/protocol/span.hpp>
+#include <mcpp/buffer.hpp>
+#include <mcpp/protocol/error.hpp>
+#include <mcpp/protocol/exception.hpp>
+#include <mcpp/protocol/int.hpp>
+#include <mcpp/protocol/string.hpp>
+#include <mcpp/protocol/varint.hpp>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace protocol {
+namespace tests {
+namespace {
+
+SCENARIO("Values may be parsed from a span_reader", "[mcpp][protocol][span]") {
+	GIVEN("A span_reader over the representation of several values") {
+		unsigned char buf [] = {0, 16, 172, 2, 3, 'f', 'o', 'o', 255, 255, 255, 255, 15};
+		span_reader r(buf, sizeof(buf));
+		WHEN("The values are parsed") {
+			std::uint16_t i;
+			std::int32_t v;
+			std::string str;
+			std::uint32_t u;
+			auto result = parse_int(r, i).bind([&] () {
+				return parse_varint(r, v);
+			}).bind([&] () {
+				return parse_string(r, str);
+			}).bind([&] () {
+				return parse_varint(r, u);
+			});
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The correct values are parsed") {
+					CHECK(i == 16);
+					CHECK(v == 300);
+					CHECK(str == "foo");
+					CHECK(u == std::numeric_limits<std::uint32_t>::max());
+				}
+				AND_THEN("The entire span is consumed") {
+					CHECK(r.empty());
+					CHECK(r.consumed() == sizeof(buf));
+				}
+			}
+		}
+	}
+	GIVEN("A span_reader which is too short to contain an integer") {
+		unsigned char buf [] = {0};
+		span_reader r(buf, sizeof(buf));
+		WHEN("An attempt is made to parse an integer") {
+			auto result = parse_int<std::uint16_t>(r);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+				AND_THEN("Nothing is consumed") {
+					CHECK(r.consumed() == 0);
+				}
+			}
+		}
+	}
+	GIVEN("A span_reader containing a truncated varint") {
+		unsigned char buf [] = {128, 128};
+		span_reader r(buf, sizeof(buf));
+		WHEN("An attempt is made to parse a varint") {
+			auto result = parse_varint<std::uint32_t>(r);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+			}
+		}
+	}
+	GIVEN("A span_reader containing an overlong varint followed by other bytes") {
+		unsigned char buf [] = {128, 0, 0, 0, 0, 0, 0, 0};
+		span_reader r(buf, sizeof(buf));
+		WHEN("An attempt is made to parse a varint") {
+			auto result = parse_varint<std::uint32_t>(r);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::overlong));
+			}
+		}
+	}
+	GIVEN("A span_reader containing a string whose length prefix exceeds the span") {
+		unsigned char buf [] = {4, 'f', 'o', 'o'};
+		span_reader r(buf, sizeof(buf));
+		WHEN("An attempt is made to parse a string") {
+			auto result = parse_string(r);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+			}
+		}
+	}
+	GIVEN("A span_reader containing a string") {
+		unsigned char buf [] = {3, 'f', 'o', 'o'};
+		span_reader r(buf, sizeof(buf));
+		WHEN("It is parsed as a UTF-16 string") {
+			auto result = parse_string<char16_t>(r);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The string is converted") {
+					CHECK(*result == u"foo");
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Values may be written to a span_writer", "[mcpp][protocol][span]") {
+	GIVEN("A span_writer") {
+		unsigned char buf [32];
+		span_writer w(buf, sizeof(buf));
+		WHEN("Several values are serialized") {
+			serialize_int(std::uint16_t(16), w);
+			serialize_varint(std::int32_t(300), w);
+			serialize_string(std::string("foo"), w);
+			THEN("The correct bytes are written") {
+				REQUIRE(w.written() == 8);
+				CHECK(buf[0] == 0);
+				CHECK(buf[1] == 16);
+				CHECK(buf[2] == 172);
+				CHECK(buf[3] == 2);
+				CHECK(buf[4] == 3);
+				CHECK(buf[5] == 'f');
+				CHECK(buf[6] == 'o');
+				CHECK(buf[7] == 'o');
+			}
+		}
+	}
+	GIVEN("A span_writer which is too small") {
+		unsigned char buf [3];
+		span_writer w(buf, sizeof(buf));
+		WHEN("An attempt is made to serialize an integer which does not fit") {
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(serialize_int(std::uint32_t(0), w), write_overflow_error);
+			}
+		}
+		WHEN("An attempt is made to serialize a varint which does not fit") {
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(serialize_varint(std::numeric_limits<std::uint32_t>::max(), w), write_overflow_error);
+			}
+		}
+		WHEN("A varint which fits is serialized") {
+			serialize_varint(std::uint32_t(300), w);
+			THEN("It is written") {
+				REQUIRE(w.written() == 2);
+				CHECK(buf[0] == 172);
+				CHECK(buf[1] == 2);
+			}
+		}
+	}
+}
+
+SCENARIO("Cursors may be created over the areas of a std::basic_streambuf", "[mcpp][protocol][span]") {
+	GIVEN("A buffer containing the representation of an integer") {
+		unsigned char buf [] = {0, 16, 1};
+		buffer b(buf);
+		WHEN("A span_reader is created over its get area and used to parse the integer") {
+			auto r = make_span_reader(b);
+			auto result = parse_int<std::uint16_t>(r);
+			REQUIRE(result);
+			CHECK(*result == 16);
+			iostreams::gbump(b, r.consumed());
+			THEN("Once consumed the remaining characters may be read from the buffer") {
+				CHECK(b.read() == 2);
+				CHECK(b.sgetc() == 1);
+			}
+		}
+		WHEN("A span_writer is created over its put area and used to serialize an integer") {
+			auto w = make_span_writer(b);
+			serialize_int(std::uint16_t(258), w);
+			iostreams::pbump(b, w.written());
+			THEN("The integer is written and committed") {
+				CHECK(b.written() == 2);
+				CHECK(buf[0] == 1);
+				CHECK(buf[1] == 2);
+			}
+		}
+	}
+}
+
+}
+}
+}
+}
@@ -7,17 +7,30 @@
 #include <mcpp/buffer.hpp>
 #include <mcpp/iostreams/concatenating_source.hpp>
 #include <mcpp/iostreams/proxy_sink.hpp>
+#include <mcpp/iostreams/streambuf_area.hpp>
+#include <mcpp/protocol/arena.hpp>
+#include <mcpp/protocol/compression_pool.hpp>
 #include <mcpp/protocol/direction.hpp>
 #include <mcpp/protocol/error.hpp>
 #include <mcpp/protocol/exception.hpp>
+#include <mcpp/protocol/framed_packet.hpp>
 #include <mcpp/protocol/handshaking.hpp>
 #include <mcpp/protocol/packet.hpp>
+#include <mcpp/protocol/packet_parameters.hpp>
 #include <mcpp/protocol/packet_serializer_map.hpp>
 #include <mcpp/protocol/state.hpp>
 #include <mcpp/protocol/varint.hpp>
+#include <mcpp/test/allocator.hpp>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <typeinfo>
 #include <vector>
 #include <catch.hpp>
 
@@ -26,16 +39,37 @@ namespace protocol {
 namespace tests {
 namespace {
 
+template <typename ConstBufferSequence>
+std::vector<unsigned char> flatten (const ConstBufferSequence & buffers) {
+	std::vector<unsigned char> retr;
+	for (auto && b : buffers) {
+		auto ptr = static_cast<const unsigned char *>(b.data());
+		retr.insert(retr.end(), ptr, ptr + b.size());
+	}
+	return retr;
+}
+
+using stream_serializer_type = stream_serializer<buffer, buffer>;
+
+auto make_map () {
+	return packet_serializer_map<
+		stream_serializer_type::inner_source_type,
+		stream_serializer_type::inner_sink_type
+	>();
+}
+
+handshaking::serverbound::handshake make_handshake (std::string address) {
+	handshaking::serverbound::handshake retr;
+	retr.protocol_version = 316;
+	retr.server_address = std::move(address);
+	retr.server_port = 25565;
+	retr.next_state = state::status;
+	return retr;
+}
+
 SCENARIO("Uncompressed packets may be parsed", "[mcpp][protocol][stream_serializer]") {
 	GIVEN("An mcpp::protocol::stream_serializer") {
-		using stream_serializer_type = stream_serializer<buffer, buffer>;
-		stream_serializer_type ser(
-			packet_serializer_map<
-				stream_serializer_type::inner_source_type,
-				stream_serializer_type::inner_sink_type
-			>(),
-			direction::serverbound
-		);
+		stream_serializer_type ser(make_map(), direction::serverbound);
 		WHEN("A packet is parsed") {
 			unsigned char buf [] = {
 				11,
@@ -424,20 +458,9 @@ SCENARIO("Compressed packets may be parsed", "[mcpp][protocol][stream_serializer
 
 SCENARIO("mcpp::protocol::packet objects may be serialized to an uncompressed representation", "[mcpp][protocol][stream_serializer]") {
 	GIVEN("An mcpp::protocol::stream_serializer") {
-		using stream_serializer_type = stream_serializer<buffer, buffer>;
-		stream_serializer_type ser(
-			packet_serializer_map<
-				stream_serializer_type::inner_source_type,
-				stream_serializer_type::inner_sink_type
-			>(),
-			direction::serverbound
-		);
+		stream_serializer_type ser(make_map(), direction::serverbound);
 		WHEN("An mcpp::protocol::packet is serialized") {
-			handshaking::serverbound::handshake p;
-			p.protocol_version = 316;
-			p.server_address = "test";
-			p.server_port = 25565;
-			p.next_state = state::status;
+			auto p = make_handshake("test");
 			unsigned char buf [128];
 			buffer b(buf);
 			ser.serialize(p, b);
@@ -468,21 +491,10 @@ SCENARIO("mcpp::protocol::packet objects may be serialized to an uncompressed re
 
 SCENARIO("mcpp::protocol::packet objects may be serialized to a compressed representation", "[mcpp][protocol][stream_serializer]") {
 	GIVEN("An mcpp::protocol::stream_serializer") {
-		using stream_serializer_type = stream_serializer<buffer, buffer>;
-		stream_serializer_type ser(
-			packet_serializer_map<
-				stream_serializer_type::inner_source_type,
-				stream_serializer_type::inner_sink_type
-			>(),
-			direction::serverbound
-		);
+		stream_serializer_type ser(make_map(), direction::serverbound);
 		WHEN("A packet whose length is below the threshold is serialized") {
 			ser.enable_compression(12);
-			handshaking::serverbound::handshake p;
-			p.protocol_version = 316;
-			p.server_address = "test";
-			p.server_port = 25565;
-			p.next_state = state::status;
+			auto p = make_handshake("test");
 			unsigned char buf [128];
 			buffer b(buf);
 			ser.serialize(p, b);
@@ -527,11 +539,7 @@ SCENARIO("mcpp::protocol::packet objects may be serialized to a compressed repre
 		}
 		WHEN("A packet whose length is equal to or above the threshold is serialized") {
 			ser.enable_compression(11);
-			handshaking::serverbound::handshake p;
-			p.protocol_version = 316;
-			p.server_address = "test";
-			p.server_port = 25565;
-			p.next_state = state::status;
+			auto p = make_handshake("test");
 			unsigned char buf [128];
 			buffer b(buf);
 			ser.serialize(p, b);
@@ -606,6 +614,1293 @@ SCENARIO("mcpp::protocol::packet objects may be serialized to a compressed repre
 	}
 }
 
+SCENARIO("Consecutive compressed packets may be parsed", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer with compression enabled and the compressed representations of two packets") {
+		stream_serializer_type out(make_map(), direction::serverbound);
+		out.enable_compression(0);
+		auto p = make_handshake("test");
+		unsigned char buf [128];
+		buffer b(buf);
+		out.serialize(p, b);
+		p.server_address = "example";
+		out.serialize(p, b);
+		stream_serializer_type ser(make_map(), direction::serverbound);
+		ser.enable_compression(0);
+		WHEN("They are parsed one after the other") {
+			buffer in(buf, b.written());
+			auto a = ser.parse(in);
+			REQUIRE(a);
+			REQUIRE(*a);
+			REQUIRE(ser.parsed_compressed());
+			CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(ser.packet()).server_address == "test");
+			auto result = ser.parse(in);
+			THEN("The second parse completes successfully") {
+				REQUIRE(result);
+				REQUIRE(*result);
+				AND_THEN("The second packet is parsed") {
+					REQUIRE(ser.has_packet());
+					CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(ser.packet()).server_address == "example");
+				}
+				AND_THEN("All bytes are consumed") {
+					CHECK(in.read() == b.written());
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Compressed packets split across several parses may be parsed", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer with compression enabled and the compressed representation of a packet") {
+		stream_serializer_type out(make_map(), direction::serverbound);
+		out.enable_compression(0);
+		auto p = make_handshake("test");
+		unsigned char buf [128];
+		buffer b(buf);
+		out.serialize(p, b);
+		REQUIRE(out.serialized_compressed());
+		stream_serializer_type ser(make_map(), direction::serverbound);
+		ser.enable_compression(0);
+		auto check = [&] () {
+			REQUIRE(ser.has_packet());
+			CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(ser.packet()).server_address == "test");
+			CHECK(ser.parsed_compressed());
+			CHECK(ser.parsed_compressed_size() == out.serialized_compressed_size());
+			CHECK(ser.parsed_size() == out.serialized_size());
+			CHECK(ser.cached() == b.written());
+		};
+		WHEN("Every split point is tried") {
+			THEN("Each parse completes successfully") {
+				for (std::size_t i = 1; i < b.written(); ++i) {
+					buffer first(buf, i);
+					auto a = ser.parse(first);
+					REQUIRE(a);
+					REQUIRE_FALSE(*a);
+					CHECK(ser.cached() == i);
+					buffer second(buf + i, b.written() - i);
+					auto result = ser.parse(second);
+					REQUIRE(result);
+					REQUIRE(*result);
+					check();
+				}
+			}
+		}
+		WHEN("The compressed data is truncated") {
+			//	Claim the packet is one byte shorter than
+			//	it is and drop the last byte
+			unsigned char copy [128];
+			std::copy(buf, buf + b.written(), copy);
+			REQUIRE(copy[0] < 128);
+			--copy[0];
+			buffer in(copy, b.written() - 1);
+			auto result = ser.parse(in);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+			}
+		}
+	}
+}
+
+SCENARIO("The settings with which packets are compressed may be chosen per packet ID", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer with compression enabled and a packet") {
+		stream_serializer_type out(make_map(), direction::serverbound);
+		out.enable_compression(0);
+		auto p = make_handshake("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+		unsigned char buf [256];
+		buffer b(buf);
+		out.serialize(p, b);
+		REQUIRE(out.serialized_compressed());
+		auto deflated = out.serialized_compressed_size();
+		WHEN("Its packet ID is set to be stored rather than deflated and it is serialized") {
+			out.compression_policy().set(
+				packet_id(0, direction::serverbound, state::handshaking),
+				compression_params{boost::iostreams::zlib::no_compression, boost::iostreams::zlib::default_strategy}
+			);
+			buffer stored(buf);
+			out.serialize(p, stored);
+			THEN("It is still compressed") {
+				REQUIRE(out.serialized_compressed());
+				AND_THEN("Its compressed body is larger than its uncompressed body") {
+					CHECK(out.serialized_compressed_size() > out.serialized_size());
+					CHECK(out.serialized_compressed_size() > deflated);
+				}
+				AND_THEN("It may be parsed") {
+					stream_serializer_type ser(make_map(), direction::serverbound);
+					ser.enable_compression(0);
+					buffer in(buf, stored.written());
+					auto result = ser.parse(in);
+					REQUIRE(result);
+					REQUIRE(*result);
+					REQUIRE(ser.has_packet());
+					CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(ser.packet()).server_address == p.server_address);
+				}
+				AND_THEN("Other packets are unaffected once it is unset") {
+					out.compression_policy().unset(packet_id(0, direction::serverbound, state::handshaking));
+					buffer again(buf);
+					out.serialize(p, again);
+					CHECK(out.serialized_compressed_size() == deflated);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("mcpp::protocol::packet objects may be framed once and written many times", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("Two mcpp::protocol::stream_serializer objects with the same compression threshold and a packet") {
+		stream_serializer_type a(make_map(), direction::serverbound);
+		stream_serializer_type b(make_map(), direction::serverbound);
+		a.enable_compression(16);
+		b.enable_compression(16);
+		auto p = make_handshake("example.com");
+		unsigned char expected [128];
+		buffer e(expected);
+		a.serialize(p, e);
+		WHEN("The packet is framed") {
+			auto f = a.frame(p);
+			THEN("The framed representation is the serialized representation") {
+				REQUIRE_FALSE(f.empty());
+				CHECK(f.compressed());
+				CHECK(f.compression_threshold() == 16);
+				auto buf = f.buffer();
+				REQUIRE(buf.size() == e.written());
+				CHECK(std::memcmp(buf.data(), expected, buf.size()) == 0);
+			}
+			THEN("Copies share the representation") {
+				auto copy = f;
+				CHECK(copy.buffer().data() == f.buffer().data());
+			}
+			AND_WHEN("It is written by the other stream_serializer") {
+				unsigned char out [128];
+				buffer o(out);
+				b.serialize(f, o);
+				THEN("The serialized representation is written") {
+					REQUIRE(o.written() == e.written());
+					CHECK(std::memcmp(out, expected, o.written()) == 0);
+				}
+			}
+			AND_WHEN("It is written as part of a batch") {
+				std::vector<framed_packet> packets{f, f};
+				auto batch = b.serialize_batch(packets.begin(), packets.end());
+				THEN("Each representation is referred to rather than copied") {
+					REQUIRE(batch.size() == 2);
+					CHECK(batch.begin()->data() == f.buffer().data());
+					auto buf = flatten(batch);
+					REQUIRE(buf.size() == (e.written() * 2));
+					CHECK(std::memcmp(buf.data(), expected, e.written()) == 0);
+					CHECK(std::memcmp(buf.data() + e.written(), expected, e.written()) == 0);
+				}
+			}
+			AND_WHEN("It is written by a stream_serializer with a different compression threshold") {
+				b.enable_compression(17);
+				THEN("An exception is thrown") {
+					CHECK_THROWS_AS(b.serialize(f), framing_mismatch_error);
+				}
+			}
+			AND_WHEN("It is written by a stream_serializer without compression") {
+				b.disable_compression();
+				THEN("An exception is thrown") {
+					CHECK_THROWS_AS(b.serialize(f), framing_mismatch_error);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("mcpp::protocol::packet objects may be serialized asynchronously", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer with compression enabled and packets of various sizes") {
+		stream_serializer_type ser(make_map(), direction::serverbound);
+		ser.enable_compression(64);
+		ser.offload_threshold(256);
+		std::vector<handshaking::serverbound::handshake> packets(64);
+		for (std::size_t i = 0; i < packets.size(); ++i) {
+			auto && p = packets[i];
+			p = make_handshake(std::string(((i % 3) == 0) ? (1000 + i) : (8 + (i * 2)), char('a' + (i % 26))));
+			p.server_port = std::uint16_t(i);
+		}
+		auto run = [&] () {
+			std::mutex m;
+			std::vector<framed_packet> results;
+			std::size_t errors(0);
+			std::size_t offloaded(0);
+			{
+				compression_pool pool(2);
+				for (auto && p : packets) {
+					ser.serialize_async(p, pool, [&] (std::exception_ptr ex, framed_packet f) {
+						std::lock_guard<std::mutex> lock(m);
+						if (ex) ++errors;
+						else results.push_back(std::move(f));
+					});
+					//	The body of an offloaded packet is handed to
+					//	pool so serialized no longer describes it
+					if (p.server_address.size() >= 256) ++offloaded;
+				}
+			}
+			REQUIRE(offloaded != 0);
+			THEN("All callbacks are invoked") {
+				CHECK(ser.async_pending() == 0);
+				CHECK(errors == 0);
+				REQUIRE(results.size() == packets.size());
+				AND_THEN("They are invoked in order with the representation of each packet") {
+					stream_serializer_type expected(make_map(), direction::serverbound);
+					expected.enable_compression(64);
+					for (std::size_t i = 0; i < packets.size(); ++i) {
+						std::vector<unsigned char> e;
+						for (auto && b : expected.serialize(packets[i])) {
+							auto ptr = static_cast<const unsigned char *>(b.data());
+							e.insert(e.end(), ptr, ptr + b.size());
+						}
+						auto buf = results[i].buffer();
+						REQUIRE(buf.size() == e.size());
+						CHECK(std::memcmp(buf.data(), e.data(), e.size()) == 0);
+					}
+				}
+			}
+		};
+		WHEN("They are serialized asynchronously") {
+			run();
+		}
+		WHEN("They are serialized asynchronously with a buffer pool") {
+			auto buffers = std::make_shared<stream_serializer_type::serialize_buffer_pool_type>(1 << 20, 64);
+			ser.serialize_buffer_pool(buffers);
+			run();
+		}
+	}
+}
+
+SCENARIO("Packets may be parsed in place", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer which parses in place") {
+		stream_serializer_type ser(make_map(), direction::serverbound);
+		ser.parse_in_place(true);
+		REQUIRE(ser.parse_in_place());
+		auto check = [&] () {
+			REQUIRE(ser.has_packet());
+			auto && p = dynamic_cast<const handshaking::serverbound::handshake &>(ser.packet());
+			CHECK(p.protocol_version == 316);
+			CHECK(p.server_address == "test");
+			CHECK(p.server_port == 25565);
+			CHECK(p.next_state == state::status);
+		};
+		WHEN("An uncompressed packet which is entirely available is parsed") {
+			unsigned char buf [] = {
+				11,
+				0,
+				0b10111100, 0b00000010,
+				4, 't', 'e', 's', 't',
+				0b01100011, 0b11011101,
+				1
+			};
+			buffer b(buf);
+			auto result = ser.parse(b);
+			THEN("The parse completes successfully") {
+				REQUIRE(result);
+				REQUIRE(*result);
+				check();
+				CHECK(ser.cached() == sizeof(buf));
+				AND_THEN("The parsed body is the caller's memory") {
+					auto parsed = ser.parsed();
+					CHECK(ser.parsed_size() == 11);
+					CHECK(iostreams::gptr(parsed) == reinterpret_cast<char *>(buf + 1));
+					CHECK(iostreams::get_available(parsed) == 11);
+				}
+			}
+		}
+		WHEN("An uncompressed packet which is split across two parses is parsed") {
+			unsigned char a [] = {
+				11,
+				0,
+				0b10111100, 0b00000010,
+				4, 't'
+			};
+			unsigned char b [] = {
+				'e', 's', 't',
+				0b01100011, 0b11011101,
+				1
+			};
+			buffer ba(a);
+			auto first = ser.parse(ba);
+			REQUIRE(first);
+			REQUIRE_FALSE(*first);
+			buffer bb(b);
+			auto result = ser.parse(bb);
+			THEN("The parse completes successfully") {
+				REQUIRE(result);
+				REQUIRE(*result);
+				check();
+				CHECK(ser.cached() == (sizeof(a) + sizeof(b)));
+				AND_THEN("The parsed body is a copy") {
+					auto parsed = ser.parsed();
+					CHECK(iostreams::gptr(parsed) != reinterpret_cast<char *>(a + 1));
+					CHECK(iostreams::get_available(parsed) == 11);
+				}
+			}
+		}
+		WHEN("Compression is enabled and a packet below the threshold which is entirely available is parsed") {
+			ser.enable_compression(256);
+			unsigned char buf [] = {
+				12,
+				0,
+				0,
+				0b10111100, 0b00000010,
+				4, 't', 'e', 's', 't',
+				0b01100011, 0b11011101,
+				1
+			};
+			buffer b(buf);
+			auto result = ser.parse(b);
+			THEN("The parse completes successfully") {
+				REQUIRE(result);
+				REQUIRE(*result);
+				check();
+				CHECK_FALSE(ser.parsed_compressed());
+				CHECK(ser.cached() == sizeof(buf));
+				CHECK(b.read() == sizeof(buf));
+				AND_THEN("The parsed body is the caller's memory") {
+					auto parsed = ser.parsed();
+					CHECK(iostreams::gptr(parsed) == reinterpret_cast<char *>(buf + 2));
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Every registered mcpp::protocol::packet_serializer parses through the Source interface alone", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("The default mcpp::protocol::packet_serializer_map and a representative of each packet it may parse") {
+		using serializer_type = stream_serializer_type::packet_serializer_map_type::value_type::element_type;
+		auto map = make_map();
+		std::vector<std::unique_ptr<packet>> packets;
+		packets.push_back(std::make_unique<handshaking::serverbound::handshake>(make_handshake("test")));
+		auto find = [&] (const serializer_type & serializer) -> const packet & {
+			auto iter = std::find_if(packets.begin(), packets.end(), [&] (const auto & p) {
+				return typeid(*p) == serializer.type();
+			});
+			REQUIRE(iter != packets.end());
+			return **iter;
+		};
+		THEN("Each packet has a representative") {
+			CHECK(map.size() == packets.size());
+		}
+		WHEN("The body of each representative is parsed from an mcpp::protocol::stream_serializer::in_place_source_type") {
+			for (auto && serializer : map) {
+				auto && p = find(*serializer);
+				stream_serializer_type::inner_sink_type sink;
+				serializer->serialize(p, sink);
+				auto && body = sink.vector();
+				stream_serializer_type::in_place_source_type src(body.get_allocator(), body.data(), body.size());
+				serializer_type::pointer ptr;
+				auto result = serializer->parse(src, ptr);
+				THEN("The parse succeeds without the vector of the Source") {
+					CHECK(src.vector().empty());
+					REQUIRE(result);
+					CHECK(src.read() == body.size());
+					AND_THEN("The packet parsed is the representative") {
+						REQUIRE(ptr);
+						stream_serializer_type::inner_sink_type reserialized;
+						serializer->serialize(*ptr, reserialized);
+						CHECK(reserialized.vector() == body);
+					}
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("The bodies of packets for which there is no serializer may be skipped", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("Representations of a packet, and mcpp::protocol::stream_serializer objects which skip the bodies of unregistered packets") {
+		//	Long enough that the compressed body is not
+		//	buffered all at once when it is split
+		std::string address;
+		for (std::size_t i = 0; i < 32; ++i) address += std::to_string(i);
+		auto p = make_handshake(std::move(address));
+		//	There are no clientbound packets in the
+		//	handshaking state
+		stream_serializer_type skip(make_map(), direction::clientbound);
+		skip.parse_skip_unregistered(true);
+		REQUIRE(skip.parse_skip_unregistered());
+		stream_serializer_type keep(make_map(), direction::serverbound);
+		keep.parse_skip_unregistered(true);
+		stream_serializer_type out(make_map(), direction::serverbound);
+		std::vector<unsigned char> buf(1024);
+		auto serialize = [&] () {
+			buffer b(buf.data(), buf.size());
+			out.serialize(p, b);
+			return b.written();
+		};
+		auto check_skipped = [&] (std::size_t written) {
+			CHECK_FALSE(skip.has_packet());
+			CHECK(skip.parsed_skipped());
+			CHECK(skip.id().id() == 0);
+			CHECK(skip.cached() == written);
+		};
+		auto check_kept = [&] (std::size_t written) {
+			REQUIRE(keep.has_packet());
+			CHECK_FALSE(keep.parsed_skipped());
+			CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(keep.packet()).server_address == p.server_address);
+			CHECK(keep.parsed_size() == out.serialized_size());
+			CHECK(keep.cached() == written);
+		};
+		auto parse_split = [&] (stream_serializer_type & ser, std::size_t written, std::size_t i) {
+			buffer first(buf.data(), i);
+			auto a = ser.parse(first);
+			REQUIRE(a);
+			REQUIRE_FALSE(*a);
+			CHECK(ser.cached() == i);
+			buffer second(buf.data() + i, written - i);
+			auto result = ser.parse(second);
+			REQUIRE(result);
+			REQUIRE(*result);
+			CHECK(second.read() == (written - i));
+		};
+		WHEN("Compression is not enabled") {
+			auto written = serialize();
+			THEN("An unregistered packet which is entirely available is skipped") {
+				buffer b(buf.data(), written);
+				auto result = skip.parse(b);
+				REQUIRE(result);
+				REQUIRE(*result);
+				CHECK(b.read() == written);
+				check_skipped(written);
+			}
+			THEN("An unregistered packet split at any point is skipped") {
+				for (std::size_t i = 1; i < written; ++i) {
+					parse_split(skip, written, i);
+					check_skipped(written);
+				}
+			}
+			THEN("A registered packet split at any point is parsed") {
+				for (std::size_t i = 1; i < written; ++i) {
+					parse_split(keep, written, i);
+					check_kept(written);
+				}
+			}
+		}
+		WHEN("Compression is enabled") {
+			out.enable_compression(0);
+			skip.enable_compression(0);
+			keep.enable_compression(0);
+			auto written = serialize();
+			REQUIRE(out.serialized_compressed());
+			THEN("An unregistered packet which is entirely available is skipped") {
+				buffer b(buf.data(), written);
+				auto result = skip.parse(b);
+				REQUIRE(result);
+				REQUIRE(*result);
+				CHECK(b.read() == written);
+				check_skipped(written);
+				CHECK(skip.parsed_compressed());
+				CHECK(skip.parsed_compressed_size() == out.serialized_compressed_size());
+			}
+			THEN("An unregistered packet split at any point is skipped") {
+				for (std::size_t i = 1; i < written; ++i) {
+					parse_split(skip, written, i);
+					check_skipped(written);
+					CHECK(skip.parsed_compressed());
+				}
+			}
+			THEN("A registered packet split at any point is parsed") {
+				for (std::size_t i = 1; i < written; ++i) {
+					parse_split(keep, written, i);
+					check_kept(written);
+				}
+			}
+		}
+		WHEN("Compression is enabled and the packet is below the threshold") {
+			out.enable_compression(1024);
+			skip.enable_compression(1024);
+			keep.enable_compression(1024);
+			auto written = serialize();
+			REQUIRE_FALSE(out.serialized_compressed());
+			THEN("An unregistered packet split at any point is skipped") {
+				for (std::size_t i = 1; i < written; ++i) {
+					parse_split(skip, written, i);
+					check_skipped(written);
+					CHECK_FALSE(skip.parsed_compressed());
+				}
+			}
+			THEN("A registered packet split at any point is parsed") {
+				for (std::size_t i = 1; i < written; ++i) {
+					parse_split(keep, written, i);
+					check_kept(written);
+				}
+			}
+		}
+	}
+	GIVEN("An mcpp::protocol::stream_serializer whose Source is not a streambuf which skips the bodies of unregistered packets") {
+		using stream_serializer_type = stream_serializer<
+			iostreams::concatenating_source<boost::reference_wrapper<buffer>>,
+			buffer
+		>;
+		stream_serializer_type ser(
+			packet_serializer_map<
+				stream_serializer_type::inner_source_type,
+				stream_serializer_type::inner_sink_type
+			>(),
+			direction::clientbound
+		);
+		ser.parse_skip_unregistered(true);
+		WHEN("Two consecutive unregistered packets are parsed") {
+			std::vector<unsigned char> buf;
+			for (std::size_t i = 0; i < 2; ++i) {
+				buf.push_back(0b10000000 | 0);
+				buf.push_back(4);
+				buf.push_back(0);
+				buf.resize(buf.size() + 511, 'a');
+			}
+			buffer b(buf.data(), buf.size());
+			auto src = iostreams::make_concatenating_source(boost::ref(b));
+			auto first = ser.parse(src);
+			REQUIRE(first);
+			REQUIRE(*first);
+			CHECK(ser.parsed_skipped());
+			CHECK(ser.cached() == 514);
+			auto second = ser.parse(src);
+			THEN("Both are skipped") {
+				REQUIRE(second);
+				REQUIRE(*second);
+				CHECK(ser.parsed_skipped());
+				CHECK(ser.cached() == 514);
+				CHECK(b.read() == buf.size());
+			}
+		}
+	}
+}
+
+SCENARIO("Frames may be relayed without being parsed", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("mcpp::protocol::stream_serializer objects and a packet") {
+		auto p = make_handshake("test");
+		stream_serializer_type out(make_map(), direction::serverbound);
+		stream_serializer_type relay(make_map(), direction::serverbound);
+		stream_serializer_type in(make_map(), direction::serverbound);
+		unsigned char buf [128];
+		auto serialize = [&] () {
+			buffer b(buf);
+			out.serialize(p, b);
+			return b.written();
+		};
+		//	Relays the frame last parsed by relay to in
+		//	and checks that it arrives unchanged
+		auto forward = [&] (std::size_t written) {
+			auto frame = relay.parsed_raw_frame();
+			REQUIRE(frame.bytes() == written);
+			unsigned char copy [128];
+			buffer c(copy);
+			relay.serialize_raw_frame(frame, c);
+			REQUIRE(c.written() == written);
+			CHECK(std::equal(copy, copy + written, buf));
+			buffer r(copy, written);
+			auto result = in.parse(r);
+			REQUIRE(result);
+			REQUIRE(*result);
+			REQUIRE(in.has_packet());
+			CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(in.packet()).server_address == "test");
+		};
+		WHEN("Compression is disabled and a frame is parsed raw") {
+			auto written = serialize();
+			buffer b(buf, written);
+			auto result = relay.parse_raw_frame(b);
+			THEN("The frame is parsed and its ID decoded") {
+				REQUIRE(result);
+				REQUIRE(*result);
+				CHECK(relay.cached() == written);
+				CHECK_FALSE(relay.has_packet());
+				REQUIRE(relay.parsed_has_id());
+				CHECK(relay.id().id() == 0);
+				AND_THEN("It may be relayed unchanged") {
+					forward(written);
+				}
+			}
+		}
+		WHEN("Compression is enabled and a compressed frame split at any point is parsed raw") {
+			out.enable_compression(0);
+			relay.enable_compression(0);
+			in.enable_compression(0);
+			auto written = serialize();
+			REQUIRE(out.serialized_compressed());
+			THEN("The frame is parsed without its ID being decoded and may be relayed unchanged") {
+				for (std::size_t i = 1; i < written; ++i) {
+					buffer first(buf, i);
+					auto a = relay.parse_raw_frame(first);
+					REQUIRE(a);
+					REQUIRE_FALSE(*a);
+					CHECK(relay.cached() == i);
+					buffer second(buf + i, written - i);
+					auto result = relay.parse_raw_frame(second);
+					REQUIRE(result);
+					REQUIRE(*result);
+					CHECK(relay.cached() == written);
+					CHECK_FALSE(relay.parsed_has_id());
+					CHECK(relay.parsed_compressed());
+					CHECK(relay.parsed_compressed_size() == out.serialized_compressed_size());
+					forward(written);
+				}
+			}
+		}
+		WHEN("Parsing in place is enabled and a frame which is entirely available is parsed raw") {
+			relay.parse_in_place(true);
+			auto written = serialize();
+			buffer b(buf, written);
+			auto result = relay.parse_raw_frame(b);
+			THEN("The frame refers to the caller's memory") {
+				REQUIRE(result);
+				REQUIRE(*result);
+				auto frame = relay.parsed_raw_frame();
+				REQUIRE(frame.size() == 2);
+				CHECK(frame.begin()[1].data() == (buf + 1));
+				forward(written);
+			}
+		}
+		WHEN("A compressed frame which should not have been compressed is parsed raw") {
+			out.enable_compression(0);
+			relay.enable_compression(1024);
+			auto written = serialize();
+			buffer b(buf, written);
+			auto result = relay.parse_raw_frame(b);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::compressed));
+			}
+		}
+		WHEN("A compressed frame whose data length exceeds the maximum is parsed raw") {
+			relay.enable_compression(0);
+			//	A data length of 2^21 + 1
+			unsigned char frame [] = {5, 0x81, 0x80, 0x80, 0x01, 0};
+			buffer b(frame, sizeof(frame));
+			auto result = relay.parse_raw_frame(b);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::too_long));
+			}
+		}
+		WHEN("A frame is relayed to a connection with different compression settings") {
+			auto written = serialize();
+			const_buffer_sequence<1> frame;
+			frame.push_back(const_buffer(buf, written));
+			unsigned char copy [128];
+			buffer c(copy);
+			relay.enable_compression(0);
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(relay.serialize_raw_frame(frame, c), framing_mismatch_error);
+			}
+		}
+		WHEN("A frame whose length is inconsistent is relayed") {
+			auto written = serialize();
+			const_buffer_sequence<1> frame;
+			frame.push_back(const_buffer(buf, written - 1));
+			unsigned char copy [128];
+			buffer c(copy);
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(relay.serialize_raw_frame(frame, c), framing_mismatch_error);
+			}
+		}
+	}
+}
+
+SCENARIO("Every frame in a buffer may be parsed in a single call", "[mcpp][protocol][stream_serializer][parse_all]") {
+	GIVEN("The representations of many packets in a single buffer") {
+		using handshake = handshaking::serverbound::handshake;
+		stream_serializer_type out(make_map(), direction::serverbound);
+		stream_serializer_type in(make_map(), direction::serverbound);
+		//	Sizes either side of the compression threshold
+		std::vector<handshake> packets;
+		for (std::size_t i = 0; i < 24; ++i) packets.push_back(make_handshake(std::string(((i % 3) == 0) ? (i * 20) : i, char('a' + i))));
+		std::vector<char> v;
+		auto serialize = [&] () {
+			v.clear();
+			for (auto && p : packets) for (auto && b : out.serialize(p)) {
+				auto ptr = static_cast<const char *>(b.data());
+				v.insert(v.end(), ptr, ptr + b.size());
+			}
+		};
+		std::vector<std::string> addresses;
+		auto record = [&] (stream_serializer_type & ser) {
+			REQUIRE(ser.has_packet());
+			addresses.push_back(dynamic_cast<const handshake &>(ser.packet()).server_address);
+		};
+		auto check = [&] () {
+			REQUIRE(addresses.size() == packets.size());
+			for (std::size_t i = 0; i < packets.size(); ++i) CHECK(addresses[i] == packets[i].server_address);
+		};
+		auto run = [&] () {
+			serialize();
+			THEN("Every packet is parsed in one call") {
+				buffer b(v.data(), v.size());
+				auto result = in.parse_all(b, record);
+				REQUIRE(result);
+				CHECK(*result == packets.size());
+				CHECK(b.read() == v.size());
+				CHECK(in.empty());
+				check();
+			}
+			THEN("Every packet is parsed when the buffer is received in pieces of any size") {
+				for (std::size_t piece = 1; piece < 64; piece += 7) {
+					addresses.clear();
+					std::size_t total(0);
+					for (std::size_t offset = 0; offset < v.size(); offset += piece) {
+						auto size = std::min(piece, v.size() - offset);
+						buffer b(v.data() + offset, size);
+						auto result = in.parse_all(b, record);
+						REQUIRE(result);
+						total += *result;
+						//	The trailing partial frame is carried over
+						CHECK(b.read() == size);
+					}
+					CHECK(total == packets.size());
+					CHECK(in.empty());
+					check();
+				}
+			}
+			THEN("Parsing stops once the callback returns false") {
+				buffer b(v.data(), v.size());
+				auto result = in.parse_all(b, [&] (auto & ser) {
+					record(ser);
+					return addresses.size() != 10;
+				});
+				REQUIRE(result);
+				CHECK(*result == 10);
+				CHECK(b.read() < v.size());
+				AND_THEN("The remaining packets may be parsed by the next call") {
+					result = in.parse_all(b, record);
+					REQUIRE(result);
+					CHECK(*result == (packets.size() - 10));
+					check();
+				}
+			}
+		};
+		WHEN("Compression is disabled") {
+			run();
+		}
+		WHEN("Compression is enabled") {
+			out.enable_compression(256);
+			in.enable_compression(256);
+			run();
+		}
+		WHEN("The bodies of unregistered packets are skipped") {
+			out.enable_compression(256);
+			serialize();
+			stream_serializer_type skip(make_map(), direction::clientbound);
+			skip.enable_compression(256);
+			skip.parse_skip_unregistered(true);
+			buffer b(v.data(), v.size());
+			std::size_t skipped(0);
+			auto result = skip.parse_all(b, [&] (auto & ser) {
+				CHECK_FALSE(ser.has_packet());
+				if (ser.parsed_skipped()) ++skipped;
+			});
+			THEN("Every frame is consumed without a packet being parsed") {
+				REQUIRE(result);
+				CHECK(*result == packets.size());
+				CHECK(skipped != 0);
+				CHECK(b.read() == v.size());
+			}
+		}
+		WHEN("The same frames are parsed by parse and by parse_all") {
+			struct outcome {
+				bool has_packet;
+				bool skipped;
+				std::uint32_t id;
+				bool in_place;
+				bool compressed;
+			};
+			auto outcome_of = [&] (stream_serializer_type & ser) {
+				outcome retr;
+				retr.has_packet = ser.has_packet();
+				retr.skipped = ser.parsed_skipped();
+				retr.id = ser.id().id();
+				retr.in_place = false;
+				retr.compressed = false;
+				if (retr.has_packet) {
+					retr.compressed = ser.parsed_compressed();
+					auto parsed = ser.parsed();
+					auto ptr = reinterpret_cast<const char *>(iostreams::gptr(parsed));
+					retr.in_place = (ptr >= v.data()) && (ptr < (v.data() + v.size()));
+				}
+				return retr;
+			};
+			auto compare = [&] (direction d, bool in_place, bool skip) {
+				serialize();
+				stream_serializer_type a(make_map(), d);
+				stream_serializer_type b(make_map(), d);
+				for (auto ser : {&a, &b}) {
+					if (out.compressed()) ser->enable_compression(out.compression_threshold());
+					ser->parse_in_place(in_place);
+					ser->parse_skip_unregistered(skip);
+				}
+				std::vector<outcome> by_parse;
+				buffer ba(v.data(), v.size());
+				for (std::size_t i = 0; i < packets.size(); ++i) {
+					auto result = a.parse(ba);
+					REQUIRE(result);
+					REQUIRE(*result);
+					by_parse.push_back(outcome_of(a));
+				}
+				std::vector<outcome> by_parse_all;
+				buffer bb(v.data(), v.size());
+				auto result = b.parse_all(bb, [&] (auto & ser) {	by_parse_all.push_back(outcome_of(ser));	});
+				REQUIRE(result);
+				REQUIRE(by_parse_all.size() == by_parse.size());
+				for (std::size_t i = 0; i < by_parse.size(); ++i) {
+					CHECK(by_parse_all[i].has_packet == by_parse[i].has_packet);
+					CHECK(by_parse_all[i].skipped == by_parse[i].skipped);
+					CHECK(by_parse_all[i].id == by_parse[i].id);
+					CHECK(by_parse_all[i].in_place == by_parse[i].in_place);
+					CHECK(by_parse_all[i].skipped == (skip && (d == direction::clientbound)));
+					CHECK(by_parse_all[i].in_place == (in_place && by_parse_all[i].has_packet && !by_parse_all[i].compressed));
+				}
+			};
+			auto run_all = [&] () {
+				for (auto d : {direction::serverbound, direction::clientbound}) {
+					for (bool in_place : {false, true}) for (bool skip : {false, true}) compare(d, in_place, skip);
+				}
+			};
+			THEN("The results agree when compression is disabled") {
+				run_all();
+			}
+			THEN("The results agree when compression is enabled") {
+				out.enable_compression(256);
+				run_all();
+			}
+		}
+	}
+	GIVEN("A buffer which contains a malformed frame after a valid one") {
+		stream_serializer_type ser(make_map(), direction::serverbound);
+		auto p = make_handshake("localhost");
+		std::vector<unsigned char> v(64);
+		buffer out(v.data(), v.size());
+		ser.serialize(p, out);
+		std::size_t written(out.written());
+		//	A length prefix which overflows
+		for (std::size_t i = 0; i < 5; ++i) v[written + i] = 0xFF;
+		v[written + 5] = 0x01;
+		WHEN("Every frame is parsed") {
+			buffer b(v.data(), written + 6);
+			std::size_t invoked(0);
+			auto result = ser.parse_all(b, [&] (auto &) {	++invoked;	});
+			THEN("The valid frame is parsed and the error is reported") {
+				CHECK(invoked == 1);
+				REQUIRE_FALSE(result);
+				CHECK(result.error() == make_error_code(error::unrepresentable));
+			}
+		}
+	}
+}
+
+SCENARIO("The buffers used by mcpp::protocol::stream_serializer objects may be leased from a shared pool", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("Two mcpp::protocol::stream_serializer objects which share a buffer pool") {
+		auto pool = std::make_shared<stream_serializer_type::parse_buffer_pool_type>(1 << 20, 256);
+		stream_serializer_type out(make_map(), direction::serverbound);
+		stream_serializer_type in(make_map(), direction::serverbound);
+		out.serialize_buffer_pool(pool);
+		in.parse_buffer_pool(pool);
+		REQUIRE(out.serialize_buffer_pool() == pool);
+		REQUIRE(in.parse_buffer_pool() == pool);
+		auto small = make_handshake("test");
+		auto large = small;
+		large.server_address.assign(8000, 'a');
+		std::vector<unsigned char> buf(1 << 14);
+		auto relay = [&] (const handshaking::serverbound::handshake & p) {
+			buffer b(buf.data(), buf.size());
+			out.serialize(p, b);
+			buffer r(buf.data(), b.written());
+			auto result = in.parse(r);
+			REQUIRE(result);
+			REQUIRE(*result);
+			REQUIRE(in.has_packet());
+			CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(in.packet()).server_address == p.server_address);
+		};
+		auto check = [&] () {
+			THEN("Packets are serialized and parsed correctly") {
+				relay(large);
+				AND_THEN("The large buffers are returned to the pool once small packets are processed") {
+					//	The size of the next body is not known
+					//	when serializing so a large buffer is
+					//	used for one packet more than necessary
+					relay(small);
+					relay(small);
+					CHECK(pool->retained() >= 16384);
+					AND_THEN("They are leased again for the next large packet") {
+						auto retained = pool->retained();
+						relay(large);
+						CHECK(pool->retained() < retained);
+					}
+				}
+				AND_THEN("The large buffers are returned to the pool when released") {
+					in.release_buffers();
+					out.release_buffers();
+					CHECK(pool->retained() >= 16384);
+					relay(small);
+					relay(large);
+				}
+			}
+		};
+		WHEN("Compression is disabled") {
+			check();
+		}
+		WHEN("Compression is enabled") {
+			out.enable_compression(256);
+			in.enable_compression(256);
+			check();
+		}
+	}
+}
+
+class test_packet_parameters : public packet_parameters {
+public:
+	using allocator_type = test::allocator<packet>;
+};
+
+SCENARIO("mcpp::protocol::stream_serializer objects allocate only through their Allocator and only for the fields of packets once warmed up", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer which uses a stateful Allocator") {
+		using allocator_type = test::allocator<packet>;
+		using stream_serializer_type = stream_serializer<buffer, buffer, allocator_type>;
+		using handshake = handshaking::serverbound::basic_handshake<test_packet_parameters>;
+		test::allocator_state alloc_state;
+		allocator_type a(alloc_state);
+		auto make = [&] () {
+			return packet_serializer_map<
+				stream_serializer_type::inner_source_type,
+				stream_serializer_type::inner_sink_type,
+				test_packet_parameters
+			>(a);
+		};
+		auto allocated = alloc_state.allocated;
+		stream_serializer_type out(make(), direction::serverbound);
+		stream_serializer_type in(make(), direction::serverbound);
+		THEN("The internal state of zlib is obtained through the Allocator") {
+			//	At the default settings zlib's compressor
+			//	requires several hundred kilobytes
+			CHECK((alloc_state.allocated - allocated) > 262144);
+		}
+		handshake tiny(a);
+		tiny.protocol_version = 316;
+		tiny.server_address = "test";
+		tiny.server_port = 25565;
+		tiny.next_state = state::status;
+		//	Long enough that the short string optimization
+		//	cannot hide an allocation
+		auto small = tiny;
+		small.server_address.assign(64, 'a');
+		auto large = tiny;
+		large.server_address.assign(4096, 'a');
+		std::vector<unsigned char> buf(1 << 13);
+		std::size_t written(0);
+		auto serialize = [&] (const handshake & p) {
+			buffer b(buf.data(), buf.size());
+			out.serialize(p, b);
+			written = b.written();
+		};
+		auto parse = [&] () {
+			buffer b(buf.data(), written);
+			auto result = in.parse(b);
+			REQUIRE(result);
+			REQUIRE(*result);
+		};
+		auto check = [&] () {
+			for (std::size_t i = 0; i < 4; ++i) {
+				for (auto && p : {&large, &small, &tiny}) {
+					serialize(*p);
+					parse();
+				}
+			}
+			THEN("Serializing packets does not allocate") {
+				auto allocations = alloc_state.allocations;
+				serialize(large);
+				serialize(small);
+				serialize(tiny);
+				CHECK(alloc_state.allocations == allocations);
+			}
+			THEN("Parsing a packet whose fields need no memory of their own does not allocate") {
+				serialize(tiny);
+				auto allocations = alloc_state.allocations;
+				parse();
+				CHECK(alloc_state.allocations == allocations);
+			}
+			THEN("Parsing a packet whose fields need memory of their own allocates only that memory through the Allocator") {
+				serialize(large);
+				auto allocations = alloc_state.allocations;
+				auto deallocations = alloc_state.deallocations;
+				parse();
+				CHECK(alloc_state.allocations == (allocations + 1));
+				CHECK(alloc_state.deallocations == deallocations);
+				auto && p = dynamic_cast<const handshake &>(in.packet());
+				CHECK(p.server_address == large.server_address);
+				CHECK(p.server_address.get_allocator() == large.server_address.get_allocator());
+			}
+		};
+		WHEN("Compression is disabled") {
+			check();
+		}
+		WHEN("Compression is enabled") {
+			out.enable_compression(256);
+			in.enable_compression(256);
+			check();
+		}
+	}
+}
+
+SCENARIO("mcpp::protocol::stream_serializer objects commit memory only as the characters of a frame arrive", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer which uses a stateful Allocator") {
+		using allocator_type = test::allocator<packet>;
+		using stream_serializer_type = stream_serializer<buffer, buffer, allocator_type>;
+		test::allocator_state alloc_state;
+		allocator_type a(alloc_state);
+		stream_serializer_type ser(
+			packet_serializer_map<
+				stream_serializer_type::inner_source_type,
+				stream_serializer_type::inner_sink_type,
+				test_packet_parameters
+			>(a),
+			direction::serverbound
+		);
+		auto allocated = alloc_state.allocated;
+		WHEN("Only the start of a frame whose length prefix claims a gigabyte is parsed") {
+			unsigned char buf [] = {0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x00};
+			buffer b(buf);
+			auto result = ser.parse(b);
+			THEN("More characters are required") {
+				REQUIRE(result);
+				CHECK_FALSE(*result);
+			}
+			THEN("Memory is not allocated in proportion to the length prefix") {
+				CHECK((alloc_state.allocated - allocated) < 65536);
+			}
+		}
+		WHEN("A compressed frame whose data length exceeds the maximum is parsed") {
+			ser.enable_compression(256);
+			//	Data length of 2^21 + 1
+			unsigned char buf [] = {5, 0x81, 0x80, 0x80, 0x01, 0x00};
+			buffer b(buf);
+			auto result = ser.parse(b);
+			THEN("The parse fails") {
+				REQUIRE_FALSE(result);
+				CHECK(result.error() == make_error_code(error::too_long));
+			}
+			THEN("Memory is not allocated in proportion to the data length") {
+				CHECK((alloc_state.allocated - allocated) < 65536);
+			}
+		}
+	}
+}
+
+class arena_packet_parameters : public packet_parameters {
+public:
+	using allocator_type = arena_allocator<packet, test::allocator<packet>>;
+};
+
+SCENARIO("mcpp::protocol::stream_serializer objects whose Allocator is an mcpp::protocol::arena_allocator parse packets into the arena", "[mcpp][protocol][stream_serializer][arena]") {
+	GIVEN("An mcpp::protocol::stream_serializer which uses an mcpp::protocol::arena_allocator") {
+		using allocator_type = arena_packet_parameters::allocator_type;
+		using stream_serializer_type = stream_serializer<buffer, buffer, allocator_type>;
+		using handshake = handshaking::serverbound::basic_handshake<arena_packet_parameters>;
+		test::allocator_state alloc_state;
+		monotonic_arena arena;
+		allocator_type a(arena, test::allocator<packet>(alloc_state));
+		auto make = [&] () {
+			return packet_serializer_map<
+				stream_serializer_type::inner_source_type,
+				stream_serializer_type::inner_sink_type,
+				arena_packet_parameters
+			>(a);
+		};
+		stream_serializer_type out(make(), direction::serverbound);
+		stream_serializer_type in(make(), direction::serverbound);
+		handshake small(a);
+		small.protocol_version = 316;
+		small.server_address.assign(64, 'a');
+		small.server_port = 25565;
+		small.next_state = state::status;
+		auto large = small;
+		large.server_address.assign(4096, 'b');
+		std::vector<unsigned char> buf(1 << 13);
+		std::size_t written(0);
+		auto serialize = [&] (const handshake & p) {
+			buffer b(buf.data(), buf.size());
+			out.serialize(p, b);
+			written = b.written();
+		};
+		auto parse = [&] () -> const handshake & {
+			buffer b(buf.data(), written);
+			auto result = in.parse(b);
+			REQUIRE(result);
+			REQUIRE(*result);
+			return dynamic_cast<const handshake &>(in.packet());
+		};
+		auto check = [&] () {
+			for (std::size_t i = 0; i < 4; ++i) {
+				for (auto && p : {&large, &small}) {
+					serialize(*p);
+					parse();
+				}
+			}
+			auto capacity = arena.capacity();
+			REQUIRE(capacity != 0);
+			THEN("The fields of parsed packets are allocated from the arena") {
+				serialize(large);
+				auto && p = parse();
+				CHECK(p.server_address == large.server_address);
+				CHECK(arena.owns(p.server_address.data()));
+				CHECK(!arena.active());
+			}
+			THEN("Only the stream_serializer which parses claims the arena") {
+				CHECK(arena.owner() == &in);
+			}
+			THEN("Once warmed up parsing packets neither allocates through the upstream Allocator nor grows the arena") {
+				auto allocations = alloc_state.allocations;
+				auto deallocations = alloc_state.deallocations;
+				for (std::size_t i = 0; i < 16; ++i) {
+					for (auto && p : {&small, &large}) {
+						serialize(*p);
+						CHECK(parse().server_address == p->server_address);
+					}
+				}
+				CHECK(alloc_state.allocations == allocations);
+				CHECK(alloc_state.deallocations == deallocations);
+				CHECK(arena.capacity() == capacity);
+			}
+		};
+		WHEN("Compression is disabled") {
+			check();
+		}
+		WHEN("Compression is enabled") {
+			out.enable_compression(256);
+			in.enable_compression(256);
+			check();
+		}
+	}
+}
+
+//	Stands in for boost::asio::const_buffer and
+//	the like
+class foreign_buffer {
+public:
+	const void * data;
+	std::size_t size;
+	foreign_buffer (const void * data, std::size_t size) noexcept
+		:	data(data),
+			size(size)
+	{	}
+};
+
+SCENARIO("mcpp::protocol::packet objects may be serialized to a sequence of buffers", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer and a packet") {
+		stream_serializer_type ser(make_map(), direction::serverbound);
+		auto p = make_handshake("test");
+		auto check = [&] () {
+			unsigned char buf [128];
+			buffer b(buf);
+			ser.serialize(p, b);
+			std::vector<unsigned char> expected(buf, buf + b.written());
+			auto seq = ser.serialize(p);
+			REQUIRE(seq.size() == 2);
+			CHECK(seq.bytes() == expected.size());
+			std::vector<unsigned char> joined;
+			for (auto && buffer : seq) {
+				foreign_buffer f = buffer;
+				CHECK(f.data == buffer.data());
+				CHECK(f.size == buffer.size());
+				auto ptr = static_cast<const unsigned char *>(buffer.data());
+				joined.insert(joined.end(), ptr, ptr + buffer.size());
+			}
+			CHECK(joined == expected);
+			AND_THEN("The body is not copied") {
+				auto && body = *(seq.begin() + 1);
+				if (ser.serialized_compressed()) {
+					CHECK(body.size() == ser.serialized_compressed_size());
+				} else {
+					auto serialized = ser.serialized();
+					CHECK(body.data() == iostreams::gptr(serialized));
+				}
+			}
+		};
+		WHEN("It is serialized to a sequence of buffers without compression") {
+			THEN("The buffers hold the same bytes as would be written to a Sink") {
+				check();
+			}
+		}
+		WHEN("It is serialized to a sequence of buffers with compression but below the threshold") {
+			ser.enable_compression(256);
+			THEN("The buffers hold the same bytes as would be written to a Sink") {
+				check();
+			}
+		}
+		WHEN("It is serialized to a sequence of buffers with compression") {
+			ser.enable_compression(0);
+			THEN("The buffers hold the same bytes as would be written to a Sink") {
+				check();
+			}
+		}
+		WHEN("It is serialized to a Sink which is too small") {
+			unsigned char buf [4];
+			buffer b(buf);
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(ser.serialize(p, b), write_overflow_error);
+			}
+		}
+	}
+}
+
+SCENARIO("Batches of mcpp::protocol::packet objects may be serialized into a single sequence of buffers", "[mcpp][protocol][stream_serializer]") {
+	GIVEN("An mcpp::protocol::stream_serializer and several packets") {
+		stream_serializer_type ser(make_map(), direction::serverbound);
+		std::vector<handshaking::serverbound::handshake> packets{
+			make_handshake("a"),
+			make_handshake(std::string(64, 'b')),
+			make_handshake("c")
+		};
+		for (auto && p : packets) p.next_state = state::login;
+		auto check = [&] () {
+			unsigned char buf [512];
+			buffer b(buf);
+			for (auto && p : packets) ser.serialize(p, b);
+			std::vector<unsigned char> expected(buf, buf + b.written());
+			auto batch = ser.serialize_batch(packets.begin(), packets.end());
+			//	A length prefix (or pair thereof) and a body
+			//	for each packet
+			CHECK(batch.size() == (packets.size() * 2));
+			auto result = flatten(batch);
+			CHECK(result == expected);
+			stream_serializer_type parser(make_map(), direction::serverbound);
+			if (ser.compressed()) parser.enable_compression(ser.compression_threshold());
+			buffer in(result.data(), result.size());
+			for (auto && p : packets) {
+				auto r = parser.parse(in);
+				REQUIRE(r);
+				REQUIRE(*r);
+				REQUIRE(parser.has_packet());
+				CHECK(dynamic_cast<const handshaking::serverbound::handshake &>(parser.packet()).server_address == p.server_address);
+			}
+			CHECK(in.read() == result.size());
+			unsigned char out_buf [512];
+			buffer out(out_buf);
+			ser.serialize_batch(packets.begin(), packets.end(), out);
+			CHECK(std::vector<unsigned char>(out_buf, out_buf + out.written()) == expected);
+		};
+		WHEN("They are serialized as a batch without compression") {
+			THEN("The batch holds each packet's representation in order") {
+				check();
+			}
+		}
+		WHEN("They are serialized as a batch with compression") {
+			ser.enable_compression(32);
+			THEN("The batch holds each packet's representation in order") {
+				check();
+			}
+		}
+		WHEN("An empty batch is serialized") {
+			auto batch = ser.serialize_batch(packets.begin(), packets.begin());
+			THEN("There are no buffers") {
+				CHECK(batch.size() == 0);
+				CHECK(batch.bytes() == 0);
+			}
+		}
+		WHEN("A batch is serialized to a Sink which is too small") {
+			unsigned char buf [8];
+			buffer b(buf);
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(ser.serialize_batch(packets.begin(), packets.end(), b), write_overflow_error);
+			}
+		}
+	}
+}
+
 }
 }
 }
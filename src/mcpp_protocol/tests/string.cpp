@@ -1,10 +1,18 @@
 #include <mcpp/protocol/string.hpp>
+#include <boost/core/ref.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
+#include <boost/iostreams/stream_buffer.hpp>
 #include <mcpp/buffer.hpp>
+#include <mcpp/iostreams/limiting_source.hpp>
 #include <mcpp/protocol/error.hpp>
 #include <mcpp/protocol/exception.hpp>
+#include <mcpp/protocol/span.hpp>
+#include <mcpp/string_view.hpp>
+#include <mcpp/test/allocator.hpp>
 #include <algorithm>
 #include <iterator>
 #include <string>
+#include <vector>
 #include <catch.hpp>
 
 namespace mcpp {
@@ -12,6 +20,24 @@ namespace protocol {
 namespace tests {
 namespace {
 
+//	A surrogate pair falls on the boundary at which
+//	long strings are transcoded in pieces
+std::u16string make_long_utf16 () {
+	std::u16string retr(84, u'a');
+	for (std::size_t i = 0; i < 20; ++i) retr += u"\U0001F600bc\u00E9\u20AC";
+	return retr;
+}
+std::vector<char> make_long_utf8 () {
+	std::string str(84, 'a');
+	for (std::size_t i = 0; i < 20; ++i) str += "\xF0\x9F\x98\x80" "bc" "\xC3\xA9" "\xE2\x82\xAC";
+	std::vector<char> retr;
+	//	Length prefix
+	retr.push_back(char(128 | (str.size() & 127)));
+	retr.push_back(char(str.size() >> 7));
+	retr.insert(retr.end(), str.begin(), str.end());
+	return retr;
+}
+
 SCENARIO("Strings may be parsed", "[mcpp][protocol][string]") {
 	GIVEN("An empty buffer") {
 		buffer b;
@@ -116,6 +142,264 @@ SCENARIO("Functors which parse strings may be created", "[mcpp][protocol][string
 	}
 }
 
+SCENARIO("Strings may be transcoded to UTF-16 and UTF-32 when parsed", "[mcpp][protocol][string]") {
+	GIVEN("A buffer containing the representation of a string with characters of every length") {
+		unsigned char buf [] = {12, 'f', 'o', 'o', 0xC3, 0xA9, 0xE2, 0x82, 0xAC, 0xF0, 0x9F, 0x98, 0x80};
+		buffer b(buf);
+		WHEN("It is parsed as UTF-16") {
+			auto result = parse_string<char16_t>(b);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The correct string is parsed") {
+					CHECK(*result == u"foo\u00E9\u20AC\U0001F600");
+				}
+			}
+		}
+		WHEN("It is parsed as UTF-32") {
+			auto result = parse_string<char32_t>(b);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The correct string is parsed") {
+					CHECK(*result == U"foo\u00E9\u20AC\U0001F600");
+				}
+			}
+		}
+		WHEN("It is parsed as UTF-16 from a Source whose characters are not contiguous") {
+			auto limiting = iostreams::make_limiting_source(boost::ref(b), sizeof(buf));
+			auto result = parse_string<char16_t>(limiting);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The correct string is parsed") {
+					CHECK(*result == u"foo\u00E9\u20AC\U0001F600");
+				}
+			}
+		}
+	}
+	GIVEN("A buffer containing the representation of a string which is not UTF-8") {
+		unsigned char buf [] = {2, 0xC0, 0x80};
+		buffer b(buf);
+		WHEN("It is parsed as UTF-16") {
+			auto result = parse_string<char16_t>(b);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::encoding));
+			}
+		}
+	}
+}
+
+SCENARIO("Strings converted by a std::codecvt facet obtain memory from the supplied allocator", "[mcpp][protocol][string]") {
+	GIVEN("An allocator") {
+		using allocator_type = test::allocator<wchar_t>;
+		using string = std::basic_string<wchar_t, std::char_traits<wchar_t>, allocator_type>;
+		test::allocator_state state;
+		allocator_type a(state);
+		WHEN("A string is parsed as wchar_t") {
+			unsigned char buf [] = {6, 'f', 'o', 'o', 'b', 'a', 'r'};
+			buffer b(buf);
+			auto result = parse_string<wchar_t, std::char_traits<wchar_t>, detail::default_codecvt, allocator_type>(b, a);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				CHECK(*result == string(L"foobar", a));
+				AND_THEN("Memory is obtained from the allocator") {
+					CHECK(state.allocations != 0);
+				}
+			}
+		}
+		WHEN("A string of wchar_t is serialized") {
+			//	Long enough that the converted string cannot
+			//	fit in the string object itself
+			string str(32, L'a', a);
+			auto allocations = state.allocations;
+			unsigned char buf [64];
+			buffer b(buf);
+			serialize_string(str, b);
+			THEN("The correct representation is written") {
+				REQUIRE(b.written() == 33);
+				CHECK(buf[0] == 32);
+				CHECK(std::all_of(buf + 1, buf + 33, [] (unsigned char c) noexcept {	return c == 'a';	}));
+				AND_THEN("Memory is obtained from the allocator") {
+					CHECK(state.allocations != allocations);
+				}
+			}
+		}
+	}
+	GIVEN("A buffer containing the representation of a string which the facet cannot convert") {
+		unsigned char buf [] = {2, 0xC0, 0x80};
+		buffer b(buf);
+		WHEN("It is parsed as wchar_t") {
+			auto result = parse_string<wchar_t>(b);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::encoding));
+			}
+		}
+	}
+}
+
+SCENARIO("Strings may be parsed without being copied", "[mcpp][protocol][string]") {
+	GIVEN("A buffer containing the representation of a UTF-8 string followed by another byte") {
+		unsigned char buf [] = {6, 'f', 'o', 'o', 0xE2, 0x82, 0xAC, 1};
+		buffer b(buf);
+		WHEN("It is parsed") {
+			auto result = parse_string_view(b);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The view refers to the bytes of the representation") {
+					CHECK(result->data() == reinterpret_cast<const char *>(buf + 1));
+					CHECK(result->size() == 6);
+				}
+				AND_THEN("Only the representation is consumed") {
+					CHECK(b.read() == 7);
+				}
+			}
+		}
+		WHEN("It is parsed from a span_reader and assigned to a view") {
+			span_reader r(buf, sizeof(buf));
+			string_view str;
+			auto result = parse_string_view(r, str);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				AND_THEN("The correct string is parsed") {
+					CHECK(str == string_view("foo\xE2\x82\xAC"));
+				}
+			}
+		}
+	}
+	GIVEN("A buffer containing the representation of a string which is not UTF-8") {
+		unsigned char buf [] = {2, 0xC0, 0x80};
+		buffer b(buf);
+		WHEN("It is parsed") {
+			auto result = parse_string_view(b);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::encoding));
+			}
+		}
+	}
+	GIVEN("A buffer whose length prefix exceeds the remaining bytes") {
+		unsigned char buf [] = {4, 'f', 'o', 'o'};
+		buffer b(buf);
+		WHEN("It is parsed") {
+			auto result = parse_string_view(b);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+			}
+		}
+	}
+}
+
+SCENARIO("Strings may be parsed from a std::streambuf whose get area is smaller than the string", "[mcpp][protocol][string]") {
+	GIVEN("A boost::iostreams::stream_buffer with a 16 byte buffer over the representation of a 100 character string") {
+		std::vector<char> buf(101, 'a');
+		buf[0] = 100;
+		buffer b(buf.data(), buf.size());
+		auto limiting = iostreams::make_limiting_source(boost::ref(b), buf.size());
+		boost::iostreams::stream_buffer<decltype(limiting)> sb(limiting, 16);
+		WHEN("It is parsed") {
+			auto result = parse_string(sb);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				CHECK(*result == std::string(100, 'a'));
+			}
+		}
+		WHEN("It is parsed as UTF-16") {
+			auto result = parse_string<char16_t>(sb);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				CHECK(*result == std::u16string(100, u'a'));
+			}
+		}
+	}
+}
+
+SCENARIO("Strings whose length exceeds the data available are not allocated for", "[mcpp][protocol][string]") {
+	GIVEN("A buffer containing a length prefix of 2^32 - 16 followed by two bytes") {
+		using allocator_type = test::allocator<char16_t>;
+		test::allocator_state state;
+		allocator_type a(state);
+		unsigned char buf [] = {0xF0, 0xFF, 0xFF, 0xFF, 0x0F, 'a', 'b'};
+		buffer b(buf);
+		WHEN("It is parsed as UTF-16") {
+			auto result = parse_string<char16_t, std::char_traits<char16_t>, detail::default_codecvt, allocator_type>(b, a);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+				AND_THEN("No more than a single chunk is allocated") {
+					CHECK(state.allocated <= detail::string_chunk_size);
+				}
+			}
+		}
+		WHEN("It is parsed as UTF-16 from a Source whose characters are not contiguous") {
+			auto limiting = iostreams::make_limiting_source(boost::ref(b), sizeof(buf));
+			auto result = parse_string<char16_t, std::char_traits<char16_t>, detail::default_codecvt, allocator_type>(limiting, a);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+				AND_THEN("No more than a single chunk is allocated") {
+					CHECK(state.allocated <= detail::string_chunk_size);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Strings may be parsed subject to a maximum length", "[mcpp][protocol][string]") {
+	GIVEN("A buffer containing the representation of a string of four code points in seven bytes") {
+		unsigned char buf [] = {7, 'f', 'o', 0xE2, 0x82, 0xAC, 0xC3, 0xA9, 1};
+		buffer b(buf);
+		WHEN("It is parsed with a maximum of four code points") {
+			auto result = parse_bounded_string(b, 4);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				CHECK(*result == "fo\xE2\x82\xAC\xC3\xA9");
+			}
+		}
+		WHEN("It is parsed as UTF-16 with a maximum of four code points") {
+			auto result = parse_bounded_string<char16_t>(b, 4);
+			THEN("The parse succeeds") {
+				REQUIRE(result);
+				CHECK(*result == u"fo\u20AC\u00E9");
+			}
+		}
+		WHEN("It is parsed with a maximum of three code points") {
+			std::string str;
+			auto result = parse_bounded_string(b, str, 3);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::too_long));
+			}
+		}
+		WHEN("It is parsed without being copied with a maximum of three code points") {
+			auto result = parse_string_view(b, 3);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::too_long));
+			}
+		}
+		WHEN("It is parsed with a maximum of one code point") {
+			auto result = parse_bounded_string(b, 1);
+			THEN("The parse fails without the representation being read") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::too_long));
+				CHECK(b.read() == 1);
+			}
+		}
+	}
+	GIVEN("A buffer containing the representation of a string which is not UTF-8") {
+		unsigned char buf [] = {2, 0xC0, 0x80};
+		buffer b(buf);
+		WHEN("It is parsed subject to a maximum length") {
+			auto result = parse_bounded_string(b, 16);
+			THEN("The parse fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::encoding));
+			}
+		}
+	}
+}
+
 SCENARIO("Strings may be serialized", "[mcpp][protocol][string]") {
 	GIVEN("An empty string") {
 		std::string str;
@@ -175,6 +459,70 @@ SCENARIO("Strings may be serialized", "[mcpp][protocol][string]") {
 			}
 		}
 	}
+	GIVEN("A UTF-32 string with characters of every length") {
+		std::u32string str(U"a\u00E9\u20AC\U0001F600");
+		unsigned char buf [11];
+		buffer b(buf);
+		WHEN("It is serialized") {
+			serialize_string(str, b);
+			THEN("The correct number of bytes are written") {
+				REQUIRE(b.written() == 11);
+				AND_THEN("The correct bytes are written") {
+					unsigned char expected [] = {10, 'a', 0xC3, 0xA9, 0xE2, 0x82, 0xAC, 0xF0, 0x9F, 0x98, 0x80};
+					using std::begin;
+					using std::end;
+					CHECK(std::equal(begin(buf), end(buf), begin(expected), end(expected)));
+				}
+			}
+		}
+	}
+	GIVEN("A long UTF-16 string") {
+		auto str = make_long_utf16();
+		auto expected = make_long_utf8();
+		WHEN("It is serialized to a buffer with room for it") {
+			std::vector<char> out(expected.size());
+			buffer b(out.data(), out.size());
+			serialize_string(str, b);
+			THEN("The correct bytes are written") {
+				CHECK(b.written() == expected.size());
+				CHECK(out == expected);
+			}
+		}
+		WHEN("It is serialized to a std::basic_streambuf which must overflow") {
+			boost::interprocess::basic_vectorbuf<std::vector<char>> vb;
+			serialize_string(str, vb);
+			THEN("The correct bytes are written") {
+				CHECK(vb.vector() == expected);
+			}
+		}
+		WHEN("It is serialized to a span_writer") {
+			std::vector<char> out(expected.size());
+			span_writer w(out.data(), out.size());
+			serialize_string(str, w);
+			THEN("The correct bytes are written") {
+				CHECK(w.written() == expected.size());
+				CHECK(out == expected);
+			}
+		}
+		WHEN("An attempt is made to serialize it to a buffer which is too small") {
+			std::vector<char> out(expected.size() - 1);
+			buffer b(out.data(), out.size());
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(serialize_string(str, b), write_overflow_error);
+			}
+		}
+	}
+	GIVEN("A UTF-16 string containing an unpaired surrogate") {
+		std::u16string str(u"a");
+		str[0] = char16_t(0xDC00);
+		char buf [8];
+		buffer b(buf);
+		WHEN("An attempt is made to serialize it") {
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(serialize_string(str, b), unrepresentable_error);
+			}
+		}
+	}
 }
 
 }
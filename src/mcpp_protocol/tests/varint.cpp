@@ -1,10 +1,16 @@
 #include <mcpp/protocol/varint.hpp>
+#include <boost/core/ref.hpp>
+#include <boost/interprocess/streams/vectorstream.hpp>
 #include <mcpp/buffer.hpp>
+#include <mcpp/iostreams/limiting_source.hpp>
 #include <mcpp/protocol/error.hpp>
 #include <mcpp/protocol/exception.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <string>
+#include <vector>
 #include <catch.hpp>
 
 namespace mcpp {
@@ -12,6 +18,54 @@ namespace protocol {
 namespace tests {
 namespace {
 
+using vectorbuf = boost::interprocess::basic_vectorbuf<std::vector<char>>;
+
+//	Mixes runs of small integers with integers of
+//	every representation length
+template <typename T>
+std::vector<T> make_varint_array () {
+	std::vector<T> retr;
+	for (std::size_t i = 0; i < 100; ++i) retr.push_back(T(i % 128));
+	for (std::size_t i = 0; i < 64; ++i) {
+		retr.push_back(T((std::uint64_t(1) << (i % std::numeric_limits<std::make_unsigned_t<T>>::digits)) + i));
+		retr.push_back(T(i));
+	}
+	for (std::size_t i = 0; i < 40; ++i) retr.push_back(T(-T(i)));
+	retr.push_back(std::numeric_limits<T>::max());
+	retr.push_back(std::numeric_limits<T>::min());
+	return retr;
+}
+
+template <typename T>
+void check_parse_varint_array (bool bytewise) {
+	INFO("Type is " << sizeof(T) * 8 << " bits");
+	auto values = make_varint_array<T>();
+	vectorbuf out;
+	for (auto i : values) serialize_varint(i, out);
+	auto && v = out.vector();
+	std::vector<T> result(values.size());
+	buffer b(v.data(), v.size());
+	if (bytewise) {
+		auto limiting = iostreams::make_limiting_source(boost::ref(b), v.size());
+		REQUIRE(parse_varint_array(limiting, result.data(), result.size()));
+	} else {
+		REQUIRE(parse_varint_array(b, result.data(), result.size()));
+	}
+	CHECK(result == values);
+	CHECK(b.read() == v.size());
+}
+
+template <typename T>
+void check_serialize_varint_array () {
+	INFO("Type is " << sizeof(T) * 8 << " bits");
+	auto values = make_varint_array<T>();
+	vectorbuf expected;
+	for (auto i : values) serialize_varint(i, expected);
+	vectorbuf out;
+	serialize_varint_array(values.data(), values.size(), out);
+	CHECK(out.vector() == expected.vector());
+}
+
 static_assert(detail::number_of_bits<std::uint16_t> == 16, "Incorrect number of bits for 16 bit unsigned integer");
 static_assert(detail::number_of_bits<std::int16_t> == 16, "Incorrect number of bits for 16 bit signed integer");
 static_assert(detail::number_of_bits<std::uint32_t> == 32, "Incorrect number of bits for 32 bit unsigned integer");
@@ -26,6 +80,31 @@ static_assert(detail::varint_whole_bytes<std::int32_t> == 4, "Incorrect number o
 static_assert(detail::varint_whole_bytes<std::uint64_t> == 9, "Incorrect number of whole bytes for 64 bit unsigned integer");
 static_assert(detail::varint_whole_bytes<std::int64_t> == 9, "Incorrect number of whole bytes for 64 bit signed integer");
 
+//	Writes each value into the middle of a larger
+//	buffer and compares against a representation
+//	built a byte at a time
+template <typename T>
+void check_serialize_varint_in_place () {
+	INFO("Type is " << sizeof(T) * 8 << " bits");
+	for (auto i : make_varint_array<T>()) {
+		INFO("Value is " << std::uint64_t(std::make_unsigned_t<T>(i)));
+		std::vector<unsigned char> expected;
+		for (auto u = std::make_unsigned_t<T>(i); ; u >>= 7) {
+			expected.push_back((u & 127) | ((u > 127) ? 128 : 0));
+			if (u <= 127) break;
+		}
+		unsigned char buf [32];
+		std::fill(std::begin(buf), std::end(buf), 0xAA);
+		buffer b(buf);
+		REQUIRE(b.sputn(reinterpret_cast<const char *>(buf), 3) == 3);
+		serialize_varint(i, b);
+		REQUIRE(b.written() == (expected.size() + 3));
+		CHECK(std::equal(expected.begin(), expected.end(), buf + 3));
+		CHECK(std::all_of(buf, buf + 3, [] (auto c) noexcept { return c == 0xAA; }));
+		CHECK(std::all_of(buf + 3 + expected.size(), std::end(buf), [] (auto c) noexcept { return c == 0xAA; }));
+	}
+}
+
 using no_incomplete_bytes_t = char [56 / 8];
 
 static_assert(detail::varint_remaining_bits<std::uint16_t> == 2, "Incorrect number of bits in last byte for 16 bit unsigned integer");
@@ -148,6 +227,152 @@ SCENARIO("Unsigned varints may be parsed", "[mcpp][protocol][varint]") {
 	}
 }
 
+SCENARIO("Varints may be parsed from contiguous buffers a word at a time", "[mcpp][protocol][varint]") {
+	GIVEN("The longest representation of a 64 bit integer followed by other bytes") {
+		unsigned char buf [] = {255, 255, 255, 255, 255, 255, 255, 255, 255, 1, 0, 0, 0, 0, 0, 0};
+		buffer b(buf);
+		WHEN("It is parsed") {
+			auto result = parse_varint<std::uint64_t>(b);
+			THEN("It is parsed successfully") {
+				REQUIRE(result);
+				AND_THEN("The correct integer is parsed") {
+					CHECK(result.value() == std::numeric_limits<std::uint64_t>::max());
+				}
+				AND_THEN("Only the representation is consumed") {
+					CHECK(b.read() == 10);
+				}
+			}
+		}
+	}
+	GIVEN("A buffer containing the representations of several varints") {
+		unsigned char buf [] = {0b10101100, 0b00000010, 0, 255, 255, 255, 255, 0b00001111, 1, 0, 0, 0};
+		buffer b(buf);
+		WHEN("They are parsed") {
+			auto a = parse_varint<std::uint32_t>(b);
+			auto c = parse_varint<std::uint32_t>(b);
+			auto d = parse_varint<std::int32_t>(b);
+			auto e = parse_varint<std::uint32_t>(b);
+			THEN("They are all parsed successfully") {
+				REQUIRE(a);
+				REQUIRE(c);
+				REQUIRE(d);
+				REQUIRE(e);
+				AND_THEN("The correct integers are parsed") {
+					CHECK(*a == 300);
+					CHECK(*c == 0);
+					CHECK(*d == -1);
+					CHECK(*e == 1);
+				}
+				AND_THEN("The correct number of bytes are consumed") {
+					CHECK(b.read() == 9);
+				}
+			}
+		}
+	}
+	GIVEN("Valid and invalid representations of varints") {
+		std::vector<std::vector<unsigned char>> reprs = {
+			{0},
+			{127},
+			{128, 1},
+			{255, 255, 3},
+			{255, 255, 4},
+			{255, 255, 255, 255, 15},
+			{255, 255, 255, 255, 16},
+			{255, 255, 255, 255, 128},
+			{255, 0},
+			{128, 128, 0},
+			{255, 255, 255, 255, 255, 255, 255, 255, 127},
+			{255, 255, 255, 255, 255, 255, 255, 255, 255, 1},
+			{255, 255, 255, 255, 255, 255, 255, 255, 255, 2},
+			{255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+			{128, 128, 128, 128, 128, 128, 128, 128, 128, 0}
+		};
+		WHEN("They are parsed both from a contiguous buffer and byte-wise") {
+			THEN("The results and the number of bytes consumed are identical") {
+				auto check = [&] (auto tag) {
+					using type = decltype(tag);
+					for (auto && repr : reprs) {
+						auto padded = repr;
+						padded.resize(repr.size() + 16, 0);
+						buffer contiguous(padded.data(), padded.size());
+						buffer inner(padded.data(), padded.size());
+						auto bytewise = iostreams::make_limiting_source(boost::ref(inner), padded.size());
+						auto expected = parse_varint<type>(bytewise);
+						auto result = parse_varint<type>(contiguous);
+						INFO("Type is " << sizeof(type) * 8 << " bits, representation is " << repr.size() << " bytes");
+						REQUIRE(bool(result) == bool(expected));
+						if (result) CHECK(*result == *expected);
+						else CHECK(result.error() == expected.error());
+						CHECK(contiguous.read() == inner.read());
+					}
+				};
+				check(std::uint16_t{});
+				check(std::uint32_t{});
+				check(std::int32_t{});
+				check(std::uint64_t{});
+				check(std::int64_t{});
+			}
+		}
+	}
+}
+
+SCENARIO("Arrays of varints may be parsed", "[mcpp][protocol][varint]") {
+	GIVEN("The representations of many integers") {
+		WHEN("They are parsed as an array from a contiguous buffer") {
+			THEN("The parse succeeds, consumes the entire representation, and the parsed integers are the same as those parsed one at a time") {
+				check_parse_varint_array<std::uint16_t>(false);
+				check_parse_varint_array<std::uint32_t>(false);
+				check_parse_varint_array<std::int32_t>(false);
+				check_parse_varint_array<std::uint64_t>(false);
+				check_parse_varint_array<std::int64_t>(false);
+			}
+		}
+		WHEN("They are parsed as an array from a Source which is not contiguous") {
+			THEN("The parse succeeds and the parsed integers are the same as those parsed one at a time") {
+				check_parse_varint_array<std::uint16_t>(true);
+				check_parse_varint_array<std::uint32_t>(true);
+				check_parse_varint_array<std::int32_t>(true);
+				check_parse_varint_array<std::uint64_t>(true);
+				check_parse_varint_array<std::int64_t>(true);
+			}
+		}
+		WHEN("More integers are parsed than are represented") {
+			std::vector<std::uint32_t> values(40, 300);
+			vectorbuf out;
+			serialize_varint_array(values.data(), values.size(), out);
+			auto && v = out.vector();
+			buffer b(v.data(), v.size());
+			values.push_back(0);
+			auto r = parse_varint_array(b, values.data(), values.size());
+			THEN("The parse fails") {
+				REQUIRE_FALSE(r);
+				CHECK(r.error() == make_error_code(error::end_of_file));
+			}
+		}
+	}
+	GIVEN("A run of single byte representations followed by an overlong representation") {
+		std::vector<unsigned char> v(32, 1);
+		v.push_back(128);
+		v.push_back(0);
+		v.resize(v.size() + 16, 1);
+		WHEN("It is parsed as an array") {
+			buffer b(v.data(), v.size());
+			std::vector<std::uint32_t> result(40);
+			auto r = parse_varint_array(b, result.data(), result.size());
+			THEN("The parse fails") {
+				REQUIRE_FALSE(r);
+				CHECK(r.error() == make_error_code(error::overlong));
+				AND_THEN("The preceding integers are parsed") {
+					CHECK(std::all_of(result.begin(), result.begin() + 32, [] (auto i) noexcept {	return i == 1;	}));
+				}
+				AND_THEN("The same number of bytes are consumed as when parsing one at a time") {
+					CHECK(b.read() == 34);
+				}
+			}
+		}
+	}
+}
+
 SCENARIO("Signed varints may be parsed", "[mcpp][protocol][varint]") {
 	GIVEN("The representation of a positive varint") {
 		unsigned char buf [] = {1};
@@ -349,6 +574,37 @@ SCENARIO("Unsigned varints may be written", "[mcpp][protocol][varint]") {
 	}
 }
 
+SCENARIO("Varints may be written directly into the put area of a std::basic_streambuf", "[mcpp][protocol][varint]") {
+	GIVEN("A buffer with room for whole words past the representation") {
+		WHEN("Integers of every representation length are serialized") {
+			THEN("The correct bytes are written and no others are changed") {
+				check_serialize_varint_in_place<std::uint8_t>();
+				check_serialize_varint_in_place<std::uint16_t>();
+				check_serialize_varint_in_place<std::uint32_t>();
+				check_serialize_varint_in_place<std::int32_t>();
+				check_serialize_varint_in_place<std::uint64_t>();
+				check_serialize_varint_in_place<std::int64_t>();
+			}
+		}
+	}
+	GIVEN("A boost::interprocess::basic_vectorbuf whose put position has been moved backwards") {
+		vectorbuf vb;
+		vb.reserve(32);
+		for (char c = 0; c < 20; ++c) vb.sputc(c);
+		vb.pubseekpos(2, std::ios_base::out);
+		WHEN("A varint is serialized") {
+			serialize_varint(std::uint32_t(300), vb);
+			THEN("Only the bytes of its representation are overwritten") {
+				std::vector<char> expected;
+				for (char c = 0; c < 20; ++c) expected.push_back(c);
+				expected[2] = char(172);
+				expected[3] = 2;
+				CHECK(vb.vector() == expected);
+			}
+		}
+	}
+}
+
 SCENARIO("Signed varints may be written", "[mcpp][protocol][varint]") {
 	GIVEN("A sufficiently large buffer") {
 		unsigned char buf [5];
@@ -380,6 +636,30 @@ SCENARIO("Signed varints may be written", "[mcpp][protocol][varint]") {
 	}
 }
 
+SCENARIO("Arrays of varints may be written", "[mcpp][protocol][varint]") {
+	GIVEN("Many integers") {
+		WHEN("They are serialized as an array") {
+			THEN("The representation is the same as that produced by serializing them one at a time") {
+				check_serialize_varint_array<std::uint16_t>();
+				check_serialize_varint_array<std::uint32_t>();
+				check_serialize_varint_array<std::int32_t>();
+				check_serialize_varint_array<std::uint64_t>();
+				check_serialize_varint_array<std::int64_t>();
+			}
+		}
+	}
+	GIVEN("A buffer which is too small") {
+		unsigned char buf [20];
+		buffer b(buf);
+		WHEN("An attempt is made to serialize an array of varints whose representation is larger than the buffer") {
+			std::vector<std::uint32_t> values(21, 1);
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(serialize_varint_array(values.data(), values.size(), b), write_overflow_error);
+			}
+		}
+	}
+}
+
 SCENARIO("ZigZag encoded signed varints may be written", "[mcpp][protocol][varint]") {
 	GIVEN("A sufficiently large buffer") {
 		unsigned char buf [3];
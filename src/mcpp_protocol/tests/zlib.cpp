@@ -0,0 +1,159 @@
+#include <mcpp/protocol/zlib.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <mcpp/protocol/error.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+namespace mcpp {
+namespace protocol {
+namespace tests {
+namespace {
+
+std::string make_input () {
+	std::string retr;
+	for (std::size_t i = 0; i < 1000; ++i) retr += std::to_string(i);
+	return retr;
+}
+
+//	Literals of 144 and above take nine bits when
+//	encoded with the fixed Huffman codes
+std::string make_incompressible_input () {
+	std::string retr(1 << 16, '\0');
+	unsigned x(1);
+	for (auto && c : retr) {
+		x = (x * 1103515245U) + 12345U;
+		c = char(144 + ((x >> 24) % 112));
+	}
+	return retr;
+}
+
+std::vector<char> deflate (deflate_stream & d, const std::string & in) {
+	std::vector<char> retr(d.bound(in.size()));
+	retr.resize(d.deflate(in.data(), in.size(), retr.data(), retr.size()));
+	return retr;
+}
+
+SCENARIO("Buffers may be compressed and decompressed with deflate_stream and inflate_stream", "[mcpp][protocol][zlib]") {
+	GIVEN("A deflate_stream, an inflate_stream, and the compressed representation of a buffer") {
+		deflate_stream d;
+		inflate_stream i;
+		auto in = make_input();
+		auto compressed = deflate(d, in);
+		REQUIRE(compressed.size() < in.size());
+		WHEN("It is decompressed into a buffer of exactly the right size") {
+			std::vector<char> out(in.size());
+			auto result = i.inflate(compressed.data(), compressed.size(), out.data(), out.size());
+			THEN("The original buffer is recovered") {
+				REQUIRE(result);
+				CHECK(*result == in.size());
+				CHECK(std::equal(out.begin(), out.end(), in.begin(), in.end()));
+			}
+		}
+		WHEN("It is decompressed into a buffer which is too large") {
+			std::vector<char> out(in.size() + 1);
+			auto result = i.inflate(compressed.data(), compressed.size(), out.data(), out.size());
+			THEN("The number of bytes actually decompressed is reported") {
+				REQUIRE(result);
+				CHECK(*result == in.size());
+			}
+		}
+		WHEN("It is decompressed into a buffer which is too small") {
+			std::vector<char> out(in.size() - 1);
+			auto result = i.inflate(compressed.data(), compressed.size(), out.data(), out.size());
+			THEN("The decompression fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::inconsistent_length));
+			}
+		}
+		WHEN("A truncated representation is decompressed") {
+			std::vector<char> out(in.size());
+			auto result = i.inflate(compressed.data(), compressed.size() - 1, out.data(), out.size());
+			THEN("The decompression fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::end_of_file));
+			}
+		}
+		WHEN("A representation followed by trailing bytes is decompressed") {
+			compressed.push_back(0);
+			std::vector<char> out(in.size());
+			auto result = i.inflate(compressed.data(), compressed.size(), out.data(), out.size());
+			THEN("The decompression fails") {
+				REQUIRE(!result);
+				CHECK(result.error() == make_error_code(error::inconsistent_length));
+			}
+		}
+		WHEN("A corrupt representation is decompressed") {
+			compressed[0] = 0;
+			std::vector<char> out(in.size());
+			THEN("An exception is thrown") {
+				CHECK_THROWS_AS(i.inflate(compressed.data(), compressed.size(), out.data(), out.size()), boost::iostreams::zlib_error);
+			}
+		}
+		WHEN("Only a prefix is decompressed") {
+			char out [5];
+			auto n = i.inflate_prefix(compressed.data(), compressed.size(), out, sizeof(out));
+			THEN("The start of the original buffer is recovered") {
+				REQUIRE(n == sizeof(out));
+				CHECK(std::equal(out, out + n, in.begin()));
+			}
+		}
+		WHEN("A prefix is decompressed from a truncated representation") {
+			std::vector<char> out(in.size());
+			auto n = i.inflate_prefix(compressed.data(), compressed.size() / 2, out.data(), out.size());
+			THEN("As much of the original buffer as possible is recovered") {
+				CHECK(n != 0);
+				CHECK(n < in.size());
+				CHECK(std::equal(out.begin(), out.begin() + n, in.begin()));
+			}
+		}
+		WHEN("The objects are used again") {
+			std::vector<char> out(in.size());
+			REQUIRE(i.inflate(compressed.data(), compressed.size(), out.data(), out.size()));
+			std::string other("hello world");
+			auto again = deflate(d, other);
+			auto result = i.inflate(again.data(), again.size(), out.data(), out.size());
+			THEN("They behave as if newly constructed") {
+				REQUIRE(result);
+				REQUIRE(*result == other.size());
+				CHECK(std::equal(other.begin(), other.end(), out.begin(), out.begin() + other.size()));
+				CHECK(deflate(d, in) == compressed);
+			}
+		}
+	}
+}
+
+SCENARIO("The level of a deflate_stream whose window size and memory level are not the default may be changed", "[mcpp][protocol][zlib]") {
+	GIVEN("A deflate_stream which does not compress and whose window size is not the default") {
+		boost::iostreams::zlib_params params(boost::iostreams::zlib::no_compression);
+		params.window_bits = 9;
+		deflate_stream d(params);
+		auto in = make_incompressible_input();
+		WHEN("The level is raised") {
+			d.params(boost::iostreams::zlib::best_compression, boost::iostreams::zlib::default_strategy);
+			params.level = boost::iostreams::zlib::best_compression;
+			deflate_stream expected(params);
+			THEN("The bound covers the new level") {
+				CHECK(d.bound(in.size()) >= expected.bound(in.size()));
+			}
+			AND_WHEN("A buffer is compressed into a buffer of the size of the bound") {
+				auto compressed = deflate(d, in);
+				THEN("The original buffer may be recovered") {
+					inflate_stream i(params);
+					std::vector<char> out(in.size());
+					auto result = i.inflate(compressed.data(), compressed.size(), out.data(), out.size());
+					REQUIRE(result);
+					CHECK(*result == in.size());
+					CHECK(std::equal(out.begin(), out.end(), in.begin(), in.end()));
+				}
+			}
+		}
+	}
+}
+
+}
+}
+}
+}
@@ -0,0 +1,252 @@
+#include <mcpp/checked.hpp>
+#include <mcpp/protocol/error.hpp>
+#include <mcpp/protocol/zlib.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <utility>
+#include <zlib.h>
+
+namespace mcpp {
+namespace protocol {
+
+namespace {
+
+//	zlib describes the size of its buffers with
+//	uInt, larger buffers are supplied in pieces
+constexpr std::size_t max_chunk = std::numeric_limits<uInt>::max();
+
+void refill (uInt & avail, std::size_t & left) noexcept {
+	if (avail != 0) return;
+	auto n = std::min(left, max_chunk);
+	avail = uInt(n);
+	left -= n;
+}
+
+int window_bits (const boost::iostreams::zlib_params & params) noexcept {
+	return params.noheader ? -params.window_bits : params.window_bits;
+}
+
+//	Unlike boost::iostreams::zlib_error::check this
+//	does not accept Z_STREAM_END since the callers
+//	handle it themselves
+[[noreturn]] void throw_zlib_error (int error) {
+	if (error == Z_MEM_ERROR) throw std::bad_alloc();
+	throw boost::iostreams::zlib_error(error);
+}
+
+voidpf zlib_alloc (voidpf opaque, uInt items, uInt size) noexcept {
+	auto bytes = checked::multiply(std::size_t(items), std::size_t(size));
+	if (!bytes) return Z_NULL;
+	try {
+		return static_cast<detail::zlib_allocator *>(opaque)->allocate(*bytes);
+	} catch (...) {	}
+	return Z_NULL;
+}
+
+void zlib_free (voidpf opaque, voidpf ptr) noexcept {
+	static_cast<detail::zlib_allocator *>(opaque)->deallocate(ptr);
+}
+
+//	Creates a z_stream which, if an allocator is supplied,
+//	both occupies memory obtained through that allocator
+//	and directs zlib to obtain its internal state through
+//	that allocator
+z_stream * make_stream (detail::zlib_allocator * alloc) {
+	if (!alloc) return new z_stream();
+	auto retr = new (alloc->allocate(sizeof(z_stream))) z_stream();
+	retr->zalloc = &zlib_alloc;
+	retr->zfree = &zlib_free;
+	retr->opaque = alloc;
+	return retr;
+}
+
+void free_stream (z_stream * stream, detail::zlib_allocator * alloc) noexcept {
+	if (!alloc) {
+		delete stream;
+		return;
+	}
+	stream->~z_stream();
+	alloc->deallocate(stream);
+}
+
+//	Frees a z_stream whose initialization did not
+//	succeed, deflateEnd and inflateEnd may not be
+//	called on such a stream
+class stream_guard {
+private:
+	z_stream * stream_;
+	detail::zlib_allocator * alloc_;
+public:
+	stream_guard (const stream_guard &) = delete;
+	stream_guard & operator = (const stream_guard &) = delete;
+	stream_guard (z_stream * stream, detail::zlib_allocator * alloc) noexcept
+		:	stream_(stream),
+			alloc_(alloc)
+	{	}
+	~stream_guard () noexcept {
+		if (stream_) free_stream(stream_, alloc_);
+	}
+	void release () noexcept {
+		stream_ = nullptr;
+	}
+};
+
+}
+
+namespace detail {
+
+void deflate_stream_deleter::operator () (z_stream_s * stream) const noexcept {
+	deflateEnd(stream);
+	free_stream(stream, alloc);
+}
+
+void inflate_stream_deleter::operator () (z_stream_s * stream) const noexcept {
+	inflateEnd(stream);
+	free_stream(stream, alloc);
+}
+
+}
+
+deflate_stream::deflate_stream (const boost::iostreams::zlib_params & params)
+	:	deflate_stream(nullptr, params)
+{	}
+
+deflate_stream::deflate_stream (detail::zlib_allocator_ptr alloc, const boost::iostreams::zlib_params & params)
+	:	alloc_(std::move(alloc)),
+		level_(params.level),
+		strategy_(params.strategy),
+		params_pending_(false)
+{
+	auto ptr = make_stream(alloc_.get());
+	stream_guard g(ptr, alloc_.get());
+	int result = deflateInit2(
+		ptr,
+		params.level,
+		params.method,
+		window_bits(params),
+		params.mem_level,
+		params.strategy
+	);
+	if (result != Z_OK) throw_zlib_error(result);
+	g.release();
+	stream_ = decltype(stream_)(ptr, detail::deflate_stream_deleter{alloc_.get()});
+}
+
+std::size_t deflate_stream::bound (std::size_t size) const noexcept {
+	std::size_t retr(deflateBound(stream_.get(), uLong(size)));
+	//	Until deflate applies a pending level and strategy
+	//	zlib computes the bound for the previous level, which
+	//	need not cover the new one when the window size or
+	//	memory level are not the default. The bound zlib
+	//	computes without a stream covers every level.
+	if (params_pending_) retr = std::max(retr, std::size_t(deflateBound(Z_NULL, uLong(size))));
+	return retr;
+}
+
+void deflate_stream::params (int level, int strategy) noexcept {
+	if ((level == level_) && (strategy == strategy_)) return;
+	level_ = level;
+	strategy_ = strategy;
+	params_pending_ = true;
+}
+
+std::size_t deflate_stream::deflate (const void * src, std::size_t size, void * dst, std::size_t dst_size) {
+	auto && s = *stream_;
+	deflateReset(&s);
+	s.next_in = static_cast<Bytef *>(const_cast<void *>(src));
+	s.avail_in = 0;
+	s.next_out = static_cast<Bytef *>(dst);
+	s.avail_out = 0;
+	refill(s.avail_out, dst_size);
+	//	Changing parameters is deferred until the output
+	//	buffer is available since some versions of zlib
+	//	emit the stream header when doing so
+	if (params_pending_) {
+		int result = deflateParams(&s, level_, strategy_);
+		if (result != Z_OK) throw_zlib_error(result);
+		params_pending_ = false;
+	}
+	for (;;) {
+		refill(s.avail_in, size);
+		refill(s.avail_out, dst_size);
+		int result = ::deflate(&s, ((size == 0) ? Z_FINISH : Z_NO_FLUSH));
+		if (result == Z_STREAM_END) break;
+		//	Z_BUF_ERROR means no progress was possible,
+		//	since all input is supplied before Z_FINISH
+		//	this means the output buffer is too small
+		if (result != Z_OK) throw_zlib_error(result);
+	}
+	return std::size_t(s.next_out - static_cast<Bytef *>(dst));
+}
+
+inflate_stream::inflate_stream (const boost::iostreams::zlib_params & params)
+	:	inflate_stream(nullptr, params)
+{	}
+
+inflate_stream::inflate_stream (detail::zlib_allocator_ptr alloc, const boost::iostreams::zlib_params & params)
+	:	alloc_(std::move(alloc))
+{
+	auto ptr = make_stream(alloc_.get());
+	stream_guard g(ptr, alloc_.get());
+	int result = inflateInit2(ptr, window_bits(params));
+	if (result != Z_OK) throw_zlib_error(result);
+	g.release();
+	stream_ = decltype(stream_)(ptr, detail::inflate_stream_deleter{alloc_.get()});
+}
+
+boost::expected<std::size_t, std::error_code> inflate_stream::inflate (const void * src, std::size_t size, void * dst, std::size_t dst_size) {
+	auto && s = *stream_;
+	inflateReset(&s);
+	s.next_in = static_cast<Bytef *>(const_cast<void *>(src));
+	s.avail_in = 0;
+	s.next_out = static_cast<Bytef *>(dst);
+	s.avail_out = 0;
+	for (;;) {
+		refill(s.avail_in, size);
+		refill(s.avail_out, dst_size);
+		int result = ::inflate(&s, Z_NO_FLUSH);
+		if (result == Z_STREAM_END) {
+			if ((s.avail_in != 0) || (size != 0)) break;
+			return std::size_t(s.next_out - static_cast<Bytef *>(dst));
+		}
+		if (result == Z_OK) continue;
+		if (result != Z_BUF_ERROR) throw_zlib_error(result);
+		//	No progress was possible, either because
+		//	the input ended before the stream did or
+		//	because there was no room for the output
+		if ((s.avail_in == 0) && (size == 0)) return boost::make_unexpected(
+			make_error_code(error::end_of_file)
+		);
+		break;
+	}
+	return boost::make_unexpected(make_error_code(error::inconsistent_length));
+}
+
+std::size_t inflate_stream::inflate_prefix (const void * src, std::size_t size, void * dst, std::size_t dst_size) {
+	auto && s = *stream_;
+	inflateReset(&s);
+	s.next_in = static_cast<Bytef *>(const_cast<void *>(src));
+	s.avail_in = 0;
+	s.next_out = static_cast<Bytef *>(dst);
+	s.avail_out = 0;
+	for (;;) {
+		refill(s.avail_in, size);
+		refill(s.avail_out, dst_size);
+		int result = ::inflate(&s, Z_NO_FLUSH);
+		if (result == Z_OK) {
+			if ((s.avail_out == 0) && (dst_size == 0)) break;
+			continue;
+		}
+		//	Z_BUF_ERROR means either the input or the
+		//	output was exhausted, both of which are
+		//	expected
+		if ((result != Z_STREAM_END) && (result != Z_BUF_ERROR)) throw_zlib_error(result);
+		break;
+	}
+	return std::size_t(s.next_out - static_cast<Bytef *>(dst));
+}
+
+}
+}
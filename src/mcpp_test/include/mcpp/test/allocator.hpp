@@ -125,11 +125,16 @@ public:
 	 *	The rebound allocator will use the same \ref state
 	 *	object.
 	 *
+	 *	Not explicit, like the converting constructor of
+	 *	`std::allocator`, since some containers (e.g.
+	 *	`boost::multi_index_container`) rely on implicit
+	 *	conversion.
+	 *
 	 *	\param [in] other
 	 *		The allocator to rebind.
 	 */
 	template <typename U>
-	explicit allocator (const allocator<U> & other) noexcept : state_(other.state_) {	}
+	allocator (const allocator<U> & other) noexcept : state_(other.state_) {	}
 	T * allocate (std::size_t n) {
 		++state_->allocations;
 		try {